@@ -14,6 +14,7 @@
 #include "dg_exploration.hpp"
 #include "dg_utils.hpp"
 #include <chrono>
+#include <sys/stat.h>
 #ifdef VPSSERVER
     #include <jsoncpp/json/json.h>
     #include <curl/curl.h>
@@ -55,12 +56,15 @@ protected:
     std::string m_srcdir = "./../src";              // path of deepguider/src (required for python embedding)
 
     bool m_use_high_gps = false;             // use high-precision gps (novatel)
+    bool m_enable_map_tiles = false;         // load the map of the localizer as tiles around the current pose
 
     bool m_data_logging = false;
     bool m_enable_tts = false;
     bool m_recording = false;
     int m_recording_fps = 30;
     std::string m_map_image_path = "data/NaverMap_ETRI(Satellite)_191127.png";
+    std::string m_map_cache_path = "data/ETRI_default_map.dgmap";   // binary cache of the default map (download if not exist)
+    double m_map_cache_max_days = 7;        // maximum age of the map cache [day] (download again if older; no limit if <= 0)
     std::string m_gps_input = "data/191115_ETRI_asen_fix.csv";
     std::string m_video_input = "data/191115_ETRI.avi";
     std::string m_recording_header_name = "dg_simple_";
@@ -89,6 +93,7 @@ protected:
 
     // internal api's
     bool initializeDefaultMap();
+    bool isMapCacheValid();
     bool setDeepGuiderDestination(dg::LatLon gps_dest);
     bool updateDeepGuiderPath(dg::TopometricPose pose_topo, dg::LatLon gps_start, dg::LatLon gps_dest);
     void drawGuiDisplay(cv::Mat& gui_image);
@@ -98,6 +103,7 @@ protected:
     void drawIntersection(cv::Mat image, IntersectionResult r, cv::Size original_image_size);
     void procGpsData(dg::LatLon gps_datum, dg::Timestamp ts);
     void procGuidance(dg::Timestamp ts);
+    void procPathBlocked();
     bool procIntersectionClassifier();
     bool procLogo();
     bool procOcr();
@@ -175,6 +181,7 @@ protected:
     dg::RoadDirectionRecognizer m_roadtheta;
     dg::GuidanceManager m_guider;
     dg::ActiveNavigation m_active_nav;
+    dg::PathReplanner m_replanner;      // local re-planner toward the current destination (guarded by m_map_mutex)
 
     // guidance icons
     cv::Mat m_icon_forward;
@@ -238,12 +245,15 @@ bool DeepGuider::loadConfig(std::string config_file)
     LOAD_PARAM_VALUE(fn, "dg_srcdir", m_srcdir);
 
     LOAD_PARAM_VALUE(fn, "use_high_gps", m_use_high_gps);
+    LOAD_PARAM_VALUE(fn, "enable_map_tiles", m_enable_map_tiles);
 
     LOAD_PARAM_VALUE(fn, "enable_data_logging", m_data_logging);
     LOAD_PARAM_VALUE(fn, "enable_tts", m_enable_tts);
     LOAD_PARAM_VALUE(fn, "video_recording", m_recording);
     LOAD_PARAM_VALUE(fn, "video_recording_fps", m_recording_fps);
     LOAD_PARAM_VALUE(fn, "map_image_path", m_map_image_path);
+    LOAD_PARAM_VALUE(fn, "map_cache_path", m_map_cache_path);
+    LOAD_PARAM_VALUE(fn, "map_cache_max_days", m_map_cache_max_days);
     LOAD_PARAM_VALUE(fn, "gps_input", m_gps_input);
     LOAD_PARAM_VALUE(fn, "video_input", m_video_input);
     LOAD_PARAM_VALUE(fn, "recording_header_name", m_recording_header_name);
@@ -318,8 +328,8 @@ bool DeepGuider::initialize(std::string config_file)
     m_map_info = m_painter.getCanvasInfo(m_map_image);
 
     // draw topology of default map
-    dg::Map& map = m_map_manager.getMap();
-    VVS_CHECK_TRUE(m_painter.drawMap(m_map_image, m_map_info, map));
+    dg::MapSnapshot map = m_map_manager.getMapSnapshot();
+    VVS_CHECK_TRUE(map != nullptr && m_painter.drawMap(m_map_image, m_map_info, *map));
 
     // load icon images
     m_icon_forward = cv::imread("data/forward.png");
@@ -393,6 +403,20 @@ bool DeepGuider::initialize(std::string config_file)
     return true;
 }
 
+bool DeepGuider::isMapCacheValid()
+{
+    if (m_map_cache_path.empty()) return false;
+    struct stat info;
+    if (stat(m_map_cache_path.c_str(), &info) != 0) return false;
+    double age = difftime(time(nullptr), info.st_mtime) / 86400;
+    if (m_map_cache_max_days > 0 && age > m_map_cache_max_days)
+    {
+        printf("\tDefault map cache is expired (%.1f days old), %s\n", age, m_map_cache_path.c_str());
+        return false;
+    }
+    return true;
+}
+
 bool DeepGuider::initializeDefaultMap()
 {
     // load map
@@ -401,16 +425,27 @@ bool DeepGuider::initializeDefaultMap()
     double lon_center = 127.372893;     // center of deepguider background map
     double radius = 1000;               // radius of deepguider background map
     m_map_mutex.lock();
-    VVS_CHECK_TRUE(m_map_manager.getMap(lat_center, lon_center, radius, map));
+    bool is_cached = isMapCacheValid() && m_map_manager.getMap(m_map_cache_path.c_str(), map); // Also fail if the file format is old
     m_map_mutex.unlock();
-    printf("\tDefault map is downloaded, n_nodes=%d\n", (int)map.nodes.size());
-
-    // download streetview map
-    std::vector<StreetView> sv_list;
-    m_map_mutex.lock();
-    m_map_manager.getStreetView(lat_center, lon_center, radius, sv_list);
-    m_map_mutex.unlock();
-    printf("\tStreetviews are downloaded! nViews = %d\n", (int)map.views.size());
+    if (is_cached)
+    {
+        printf("\tDefault map is loaded from %s, n_nodes=%d, nViews = %d\n", m_map_cache_path.c_str(), (int)map.nodes.size(), (int)map.views.size());
+    }
+    else
+    {
+        m_map_mutex.lock();
+        VVS_CHECK_TRUE(m_map_manager.getMap(lat_center, lon_center, radius, map));
+        m_map_mutex.unlock();
+        printf("\tDefault map is downloaded, n_nodes=%d\n", (int)map.nodes.size());
+
+        // download streetview map
+        std::vector<StreetView> sv_list;
+        m_map_mutex.lock();
+        m_map_manager.getStreetView(lat_center, lon_center, radius, sv_list);
+        if (!m_map_cache_path.empty()) m_map_manager.saveMap(m_map_cache_path.c_str());
+        m_map_mutex.unlock();
+        printf("\tStreetviews are downloaded! nViews = %d\n", (int)map.views.size());
+    }
 
     // localizer: set default map to localizer
     dg::LatLon ref_node(36.383837659737, 127.367880828442);
@@ -420,6 +455,11 @@ bool DeepGuider::initializeDefaultMap()
     m_localizer.setParamValue("offset_gps", {1., 0.});
     VVS_CHECK_TRUE(m_localizer.setReference(ref_node));
     VVS_CHECK_TRUE(m_localizer.loadMap(map));
+    if (m_enable_map_tiles)
+    {
+        // tiles are loaded without changing the map of the map manager
+        VVS_CHECK_TRUE(m_localizer.setMapTileLoader([this](const cv::Point2i& tile, dg::Map& tile_map) { return m_map_manager.loadMapTile(tile, tile_map); }));
+    }
     m_localizer_mutex.unlock();
     printf("\tDefault map is appyed to Localizer!\n");
 
@@ -519,6 +559,7 @@ int DeepGuider::run()
         if (key == cx::KEY_SPACE) key = cv::waitKey(0);
         if (key == cx::KEY_ESC) break;
         if (key == 83) itr += 30;   // Right Key
+        if (key == 'b' || key == 'B') procPathBlocked();    // Report the current edge as blocked
 
         dg::Timestamp t2 = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() / 1000.0;
         printf("Iteration: %d (it took %lf seconds)\n", itr, t2 - t1);
@@ -550,9 +591,12 @@ void DeepGuider::procGpsData(dg::LatLon gps_datum, dg::Timestamp ts)
     // apply gps to localizer
     m_localizer_mutex.lock();
     VVS_CHECK_TRUE(m_localizer.applyGPS(gps_datum, ts));
-    double pose_confidence = m_localizer.getPoseConfidence();
     m_localizer_mutex.unlock();    
 
+    // move the map tiles of the localizer (tiles are loaded on a worker thread only when the pose moves to another tile)
+    if (m_enable_map_tiles && m_localizer.requestMapTiles()) printf("[Localizer] Map tiles are updated!\n");
+    double pose_confidence = m_localizer.getPoseSnapshot().confidence;
+
     // check pose initialization
     m_gps_update_cnt++;
     if (!m_pose_initialized && pose_confidence > 0.2 && m_gps_update_cnt > 10)
@@ -606,10 +650,9 @@ bool DeepGuider::setDeepGuiderDestination(dg::LatLon gps_dest)
     }
 
     // get current pose
-    m_localizer_mutex.lock();
-    dg::LatLon pose_gps = m_localizer.getPoseGPS();
-    dg::TopometricPose pose_topo = m_localizer.getPoseTopometric();
-    m_localizer_mutex.unlock();
+    dg::PoseSnapshot pose = m_localizer.getPoseSnapshot();
+    dg::LatLon pose_gps = m_localizer.toLatLon(pose.pose);
+    dg::TopometricPose pose_topo = pose.topo;
 
     // generate & apply new path
     bool ok = updateDeepGuiderPath(pose_topo, pose_gps, gps_dest);
@@ -627,23 +670,27 @@ bool DeepGuider::updateDeepGuiderPath(dg::TopometricPose pose_topo, dg::LatLon g
 {
     // set start position to nearest node position
     m_map_mutex.lock();
-    dg::Map& tmpmap = m_map_manager.getMap();    
+    dg::MapSnapshot map = m_map_manager.getMapSnapshot();
+    m_map_mutex.unlock();
+    VVS_CHECK_TRUE(map != nullptr);
     dg::LatLon pose_gps = gps_start;
-    dg::Node* node = tmpmap.findNode(pose_topo.node_id);
+    const dg::Node* node = map->findNode(pose_topo.node_id);
     if(node)
     {
         pose_gps.lat = node->lat;
         pose_gps.lon = node->lon;
     }
-    m_map_mutex.unlock();
 
-    // generate path to destination
+    // generate path to destination (re-plan locally without the server if only the start is changed)
     dg::Path path;
     m_map_mutex.lock();
-    bool ok = m_map_manager.getPath_expansion(pose_gps.lat, pose_gps.lon, gps_dest.lat, gps_dest.lon, path);
+    bool replanned = false;
+    if (node && m_path_initialized && gps_dest == m_gps_dest && m_replanner.isBuilt(*map))
+    {
+        replanned = m_replanner.findPath(pose_topo.node_id, path);
+    }
+    bool ok = replanned || m_map_manager.getPath_expansion(pose_gps.lat, pose_gps.lon, gps_dest.lat, gps_dest.lon, path);
     m_map_mutex.unlock();
-    path.start_pos = gps_start;
-    path.dest_pos = gps_dest;
     if(!ok)
     {
         printf("[MapManager] fail to find path to (lat=%lf, lon=%lf)\n", gps_dest.lat, gps_dest.lon);
@@ -651,22 +698,55 @@ bool DeepGuider::updateDeepGuiderPath(dg::TopometricPose pose_topo, dg::LatLon g
     }
     dg::ID nid_start = path.pts.front().node_id;
     dg::ID nid_dest = path.pts.back().node_id;
-    printf("[MapManager] New path generated! start=%zu, dest=%zu\n", nid_start, nid_dest);    
+
+    // keep the search tree toward the destination for later re-planning (e.g. GUIDE_OOP and GUIDE_PATH_BLOCKED)
+    if (!replanned)
+    {
+        m_map_mutex.lock();
+        map = m_map_manager.getMapSnapshot();
+        if (!map || !m_replanner.build(*map) || !m_replanner.setGoal(nid_dest)) m_replanner.clear();
+        else
+        {
+            // re-plan locally if the path passes blocked edges (which the routing server does not know)
+            const std::set<dg::ID>& blocked = m_replanner.getBlockedEdges();
+            bool passes_blocked = false;
+            for (auto pt = path.pts.begin(); pt != path.pts.end() && !passes_blocked; pt++)
+                passes_blocked = (blocked.find(pt->edge_id) != blocked.end());
+            if (passes_blocked && m_replanner.findPath(nid_start, path)) replanned = true;
+        }
+        m_map_mutex.unlock();
+    }
+
+    // share the re-planned path with the map manager (the path from the server is already kept)
+    if (replanned)
+    {
+        m_map_mutex.lock();
+        m_map_manager.setPath(path);
+        m_map_mutex.unlock();
+    }
+    path.start_pos = gps_start;
+    path.dest_pos = gps_dest;
+    printf("[MapManager] New path generated%s! start=%zu, dest=%zu\n", replanned ? " (re-planned)" : "", nid_start, nid_dest);    
 
     // check if the generated path is valid on the map
+    // (a snapshot is shared by the localizer, guidance, and GUI without copying the map for each)
     m_map_mutex.lock();
-    dg::Map& map = m_map_manager.getMap();    
-    dg::Node* node_start = map.findNode(nid_start);
-    dg::Node* node_dest = map.findNode(nid_dest);
+    map = m_map_manager.getMapSnapshot();
     m_map_mutex.unlock();
+    VVS_CHECK_TRUE(map != nullptr);
+    const dg::Node* node_start = map->findNode(nid_start);
+    const dg::Node* node_dest = map->findNode(nid_dest);
     VVS_CHECK_TRUE(node_start != nullptr);
     VVS_CHECK_TRUE(node_dest != nullptr);
 
-    // localizer: set map to localizer
-    m_localizer_mutex.lock();
-    VVS_CHECK_TRUE(m_localizer.loadMap(map));
-    m_localizer_mutex.unlock();
-    printf("\tLocalizer is updated with new map!\n");
+    // localizer: set map to localizer (map tiles are kept if enabled)
+    if (!m_enable_map_tiles)
+    {
+        m_localizer_mutex.lock();
+        VVS_CHECK_TRUE(m_localizer.loadMap(*map));
+        m_localizer_mutex.unlock();
+        printf("\tLocalizer is updated with new map!\n");
+    }
 
     // guidance: init map and path for guidance
     m_guider_mutex.lock();
@@ -676,8 +756,8 @@ bool DeepGuider::updateDeepGuiderPath(dg::TopometricPose pose_topo, dg::LatLon g
 
     // draw map
     m_map_image_original.copyTo(m_map_image);
-    m_painter.drawMap(m_map_image, m_map_info, map);
-    m_painter.drawPath(m_map_image, m_map_info, map, path);
+    m_painter.drawMap(m_map_image, m_map_info, *map);
+    m_painter.drawPath(m_map_image, m_map_info, *map, path);
     for(auto itr = m_gps_history_novatel.begin(); itr != m_gps_history_novatel.end(); itr++)
     {
         m_painter.drawNode(m_map_image, m_map_info, *itr, 2, 0, cv::Vec3b(0, 0, 255));
@@ -864,12 +944,11 @@ void DeepGuider::drawGuiDisplay(cv::Mat& image)
     }
 
     // current localization
-    m_localizer_mutex.lock();
-    dg::Pose2 pose_metric = m_localizer.getPose();
-    dg::TopometricPose pose_topo = m_localizer.getPoseTopometric();
-    dg::LatLon pose_gps = m_localizer.getPoseGPS();
-    double pose_confidence = m_localizer.getPoseConfidence();
-    m_localizer_mutex.unlock();
+    dg::PoseSnapshot pose = m_localizer.getPoseSnapshot();
+    dg::Pose2 pose_metric = pose.pose;
+    dg::TopometricPose pose_topo = pose.topo;
+    dg::LatLon pose_gps = m_localizer.toLatLon(pose_metric);
+    double pose_confidence = pose.confidence;
 
     // draw robot on the map
     m_painter.drawNode(image, m_map_info, pose_gps, 10, 0, cx::COLOR_YELLOW);
@@ -1051,24 +1130,37 @@ void DeepGuider::drawIntersection(cv::Mat image, IntersectionResult r, cv::Size
 }
 
 
+void DeepGuider::procPathBlocked()
+{
+    // report the current edge as blocked (e.g. a closed road found by the robot)
+    dg::TopometricPose pose_topo = m_localizer.getPoseSnapshot().topo;
+    dg::MapSnapshot map = m_map_manager.getSharedMap().get(); // the latest snapshot is read without locking the map manager
+    const dg::Node* node = (map) ? map->findNode(pose_topo.node_id) : nullptr;
+    if (node == nullptr || pose_topo.edge_idx < 0 || pose_topo.edge_idx >= (int)node->edge_ids.size()) return;
+    dg::ID eid = node->edge_ids[pose_topo.edge_idx];
+    m_guider_mutex.lock();
+    bool on_path = m_guider.applyPathBlocked(eid);
+    m_guider_mutex.unlock();
+    printf("[Guidance] Edge %zu is reported as blocked%s\n", eid, on_path ? " on the path" : "");
+}
+
+
 void DeepGuider::procGuidance(dg::Timestamp ts)
 {
     if(!m_path_initialized || !m_dest_defined) return;
 
     // get updated pose & localization confidence
-    m_localizer_mutex.lock();
-    dg::TopometricPose pose_topo = m_localizer.getPoseTopometric();
-    dg::Pose2 pose_metric = m_localizer.getPose();
-    dg::LatLon pose_gps = m_localizer.getPoseGPS();
-    double pose_confidence = m_localizer.getPoseConfidence();
-    m_localizer_mutex.unlock();
+    dg::PoseSnapshot pose = m_localizer.getPoseSnapshot();
+    dg::TopometricPose pose_topo = pose.topo;
+    dg::Pose2 pose_metric = pose.pose;
+    dg::LatLon pose_gps = m_localizer.toLatLon(pose_metric);
+    double pose_confidence = pose.confidence;
 
     // Guidance: generate navigation guidance
     dg::GuidanceManager::GuideStatus cur_status;
     dg::GuidanceManager::Guidance cur_guide;
-    m_map_mutex.lock();
-    dg::Node* node = m_map_manager.getMap().findNode(pose_topo.node_id);
-    m_map_mutex.unlock();
+    dg::MapSnapshot map = m_map_manager.getSharedMap().get(); // the latest snapshot is read without locking the map manager
+    const dg::Node* node = (map) ? map->findNode(pose_topo.node_id) : nullptr;
     if(node==nullptr)
     {
         printf("[Guidance] Error - Undefined localization node: %zu!\n", pose_topo.node_id);
@@ -1122,6 +1214,20 @@ void DeepGuider::procGuidance(dg::Timestamp ts)
             if (m_enable_tts) putTTS("Arrived to destination!");
         }
 
+        // check blocked path (the reported edges are excluded from re-planning)
+        if (cur_status == GuidanceManager::GuideStatus::GUIDE_PATH_BLOCKED)
+        {
+            printf("GUIDANCE: blocked path detected!\n");
+            if (m_enable_tts) putTTS("Regenerate path!");
+            m_guider_mutex.lock();
+            std::set<dg::ID> blocked = m_guider.getBlockedEdges();
+            m_guider_mutex.unlock();
+            m_map_mutex.lock();
+            for (auto eid = blocked.begin(); eid != blocked.end(); eid++) m_replanner.blockEdge(*eid);
+            m_map_mutex.unlock();
+            VVS_CHECK_TRUE(updateDeepGuiderPath(pose_topo, pose_gps, m_gps_dest));
+        }
+
         // check out of path
         if (cur_status == GuidanceManager::GuideStatus::GUIDE_OOP || cur_status == GuidanceManager::GuideStatus::GUIDE_LOST)
         {
@@ -1,4 +1,5 @@
 #include "test_core_type.hpp"
+#include "test_core_map.hpp"
 #include "test_localizer_graph.hpp"
 #include "test_localizer_gps2utm.hpp"
 #include "test_localizer_road.hpp"
@@ -8,6 +9,8 @@
 
 int main()
 {
+    // Benchmarks ('*Bench') run only if the environment variable 'DG_RUN_BENCH' is set (e.g. DG_RUN_BENCH=1)
+
     // Test 'core' module
     // 1. Test basic data structures
     VVS_RUN_TEST(testCoreLatLon());
@@ -20,6 +23,34 @@ int main()
     VVS_RUN_TEST(testCoreMap());
     VVS_RUN_TEST(testCorePath());
 
+    // 3. Test performance-related structures of 'dg::Map'
+    VVS_RUN_TEST(testCoreLookupTable());
+    DG_RUN_BENCH(testCoreMapLookupBench());
+    VVS_RUN_TEST(testCoreFrozenMap());
+    DG_RUN_BENCH(testCoreFrozenMapBench());
+    VVS_RUN_TEST(testCoreMapAdjacency());
+    VVS_RUN_TEST(testCoreMapUnion());
+    DG_RUN_BENCH(testCoreMapUnionBench());
+    VVS_RUN_TEST(testCoreMapPatch());
+    DG_RUN_BENCH(testCoreMapPatchBench());
+    VVS_RUN_TEST(testCoreMapFile());
+    DG_RUN_BENCH(testCoreMapFileBench());
+    VVS_RUN_TEST(testCoreSpatialIndex());
+    DG_RUN_BENCH(testCoreSpatialIndexBench());
+    VVS_RUN_TEST(testCoreStringPool());
+    VVS_RUN_TEST(testCorePOINameIndex());
+    DG_RUN_BENCH(testCorePOINameIndexBench());
+    VVS_RUN_TEST(testCoreSharedMap());
+    DG_RUN_BENCH(testCoreSharedMapBench());
+    VVS_RUN_TEST(testCorePathFinder());
+    DG_RUN_BENCH(testCorePathFinderBench());
+    VVS_RUN_TEST(testCorePathFinderKShortest());
+    DG_RUN_BENCH(testCorePathFinderKShortestBench());
+    VVS_RUN_TEST(testCoreContractionHierarchy(getETRISyntheticMap()));
+    DG_RUN_BENCH(testCoreContractionHierarchyBench());
+    VVS_RUN_TEST(testCorePathReplanner());
+    DG_RUN_BENCH(testCorePathReplannerBench());
+
 
     // Test 'localizer' module
     // 1. Test GPS and UTM conversion
@@ -33,13 +64,25 @@ int main()
     // 2. Test 'dg::DirectedGraph'
     VVS_RUN_TEST(testDirectedGraphPtr());
     VVS_RUN_TEST(testDirectedGraphItr());
+    VVS_RUN_TEST(testDirectedGraphPtr<dg::VectorStorage>("test_directed_graph_vector.txt"));
+    VVS_RUN_TEST(testDirectedGraphItr<dg::VectorStorage>());
 
     // 3. Test 'dg::RoadMap' and 'dg::GraphPainter'
     VVS_RUN_TEST(testLocRoadMap());
+    VVS_RUN_TEST(testLocRoadMapProfile());
+    VVS_RUN_TEST(testLocRoadTileMap());
+    VVS_RUN_TEST(testLocBaseMapTiles());
     VVS_RUN_TEST(testLocRoadPainter());
+    DG_RUN_BENCH(testLocRoadMapBench());
+    DG_RUN_BENCH(testLocBaseNearestBench());
+    DG_RUN_BENCH(testLocRoadMapEditBench());
+    DG_RUN_BENCH(testLocRoadMapFileBench());
+    DG_RUN_BENCH(testLocRoadTileMapBench());
 
     // 4. Test localizers
     VVS_RUN_TEST(testLocBaseDist2());
+    VVS_RUN_TEST(testLocSegmentKernel());
+    DG_RUN_BENCH(testLocSegmentKernelBench());
     VVS_RUN_TEST(testLocBaseNearest());
     VVS_RUN_TEST(testLocBaseTrack());
     VVS_RUN_TEST(testLocSimple());
@@ -47,6 +90,12 @@ int main()
     VVS_RUN_TEST(testLocEKFGPS());
     VVS_RUN_TEST(testLocEKFGyroGPS());
     VVS_RUN_TEST(testLocEKFLocClue());
+    VVS_RUN_TEST(testLocEKFLocClueBatch());
+    DG_RUN_BENCH(testLocEKFLocClueBatchBench());
+    VVS_RUN_TEST(testLocEKFFixed());
+    DG_RUN_BENCH(testLocEKFFixedBench());
+    VVS_RUN_TEST(testLocPoseSnapshot());
+    DG_RUN_BENCH(testLocPoseSnapshotBench());
 
     VVS_RUN_TEST(testLocETRIMap2RoadMap());
     VVS_RUN_TEST(testLocETRISyntheticMap());
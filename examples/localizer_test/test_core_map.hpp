@@ -0,0 +1,1979 @@
+#ifndef __TEST_CORE_MAP__
+#define __TEST_CORE_MAP__
+
+#include "vvs.h"
+#include "dg_core.hpp"
+#include "core/map_file.hpp"
+#include "localizer/utm_converter.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <set>
+#include <thread>
+
+/**
+ * Check whether benchmarks are enabled or not<br>
+ * Benchmarks are slow, so they run only if the environment variable 'DG_RUN_BENCH' is set as non-zero (e.g. DG_RUN_BENCH=1).
+ * @return True if enabled (false if not)
+ */
+inline bool isBenchEnabled()
+{
+    const char* value = std::getenv("DG_RUN_BENCH");
+    return value != nullptr && value[0] != '\0' && value[0] != '0';
+}
+
+/**
+ * Run the given benchmark only if benchmarks are enabled (see isBenchEnabled())
+ */
+#define DG_RUN_BENCH(EXP) \
+    { \
+        if (isBenchEnabled()) VVS_RUN_TEST(EXP); \
+    }
+
+/**
+ * Get the current time for benchmarks (Unit: [sec])
+ * @return The current time
+ */
+inline double getBenchTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() / 1e6;
+}
+
+/**
+ * Generate random IDs similar to the ETRI map server (e.g. 559562564900154)
+ * @param n The number of IDs
+ * @param seed The seed of the random number generator
+ * @return The generated IDs (unique)
+ */
+inline std::vector<dg::ID> genBenchIDs(size_t n, unsigned int seed = 2019)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<dg::ID> dist(100000000000000ULL, 999999999999999ULL);
+    std::set<dg::ID> unique;
+    std::vector<dg::ID> ids;
+    ids.reserve(n);
+    while (ids.size() < n)
+    {
+        dg::ID id = dist(rng);
+        if (unique.insert(id).second) ids.push_back(id);
+    }
+    return ids;
+}
+
+/**
+ * Generate a grid-shaped map similar to city blocks
+ * @param rows The number of rows of nodes
+ * @param cols The number of columns of nodes
+ * @param spacing The distance between two adjacent nodes (Unit: [deg])
+ * @return The generated map whose node and edge IDs are large as the ETRI map server
+ */
+inline dg::Map genBenchGridMap(size_t rows, size_t cols, double spacing = 0.0005)
+{
+    const dg::ID node_base = 559562564900000, edge_base = 559562564910000000;
+    dg::Map map;
+    map.nodes.reserve(rows * cols);
+    map.edges.reserve(2 * rows * cols);
+    for (size_t r = 0; r < rows; r++)
+        for (size_t c = 0; c < cols; c++)
+            map.addNode(dg::Node(node_base + r * cols + c, 36.38 + r * spacing, 127.36 + c * spacing));
+    dg::ID edge_id = edge_base;
+    for (size_t r = 0; r < rows; r++)
+    {
+        for (size_t c = 0; c < cols; c++)
+        {
+            dg::ID id = node_base + r * cols + c;
+            if (c + 1 < cols) map.addEdge(id, id + 1, dg::Edge(edge_id++, spacing * 1e5, (r % 4 == 0) ? dg::Edge::EDGE_CROSSWALK : dg::Edge::EDGE_SIDEWALK));
+            if (r + 1 < rows) map.addEdge(id, id + cols, dg::Edge(edge_id++, spacing * 1e5));
+        }
+    }
+    return map;
+}
+
+/**
+ * Check whether two maps have the same elements (their orders can be different) and valid adjacency
+ * @param a The first map
+ * @param b The second map
+ * @return True if two maps are same (false if not)
+ */
+inline bool isSameMap(const dg::Map& a, const dg::Map& b)
+{
+    if (a.nodes.size() != b.nodes.size() || a.edges.size() != b.edges.size() || a.pois.size() != b.pois.size() || a.views.size() != b.views.size()) return false;
+    for (auto node = a.nodes.begin(); node != a.nodes.end(); node++)
+    {
+        const dg::Node* other = b.findNode(node->id);
+        if (other == nullptr || other->lat != node->lat || other->lon != node->lon || other->type != node->type || other->floor != node->floor) return false;
+        std::multiset<dg::ID> ids1(node->edge_ids.begin(), node->edge_ids.end()), ids2(other->edge_ids.begin(), other->edge_ids.end());
+        if (ids1 != ids2) return false;
+    }
+    for (auto edge = a.edges.begin(); edge != a.edges.end(); edge++)
+    {
+        const dg::Edge* other = b.findEdge(edge->id);
+        if (other == nullptr || other->length != edge->length || other->type != edge->type || other->directed != edge->directed) return false;
+        if (other->node_id1 != edge->node_id1 || other->node_id2 != edge->node_id2) return false;
+        if (a.findEdge(edge->node_id1, edge->node_id2) == nullptr || b.findEdge(edge->node_id1, edge->node_id2) == nullptr) return false;
+    }
+    for (auto poi = a.pois.begin(); poi != a.pois.end(); poi++)
+    {
+        const dg::POI* other = b.findPOI(poi->id);
+        if (other == nullptr || other->name != poi->name || other->lat != poi->lat || other->lon != poi->lon || other->floor != poi->floor) return false;
+    }
+    for (auto view = a.views.begin(); view != a.views.end(); view++)
+    {
+        const dg::StreetView* other = b.findView(view->id);
+        if (other == nullptr || other->date != view->date || other->heading != view->heading || other->lat != view->lat || other->lon != view->lon) return false;
+    }
+    return true;
+}
+
+int testCoreLookupTable()
+{
+    // Check default values
+    dg::LookupTable table;
+    VVS_CHECK_TRUE(table.empty());
+    VVS_CHECK_TRUE(table.size() == 0);
+    VVS_CHECK_TRUE(table.find(3) == dg::LookupTable::npos);
+
+    // Check insertion and duplication
+    VVS_CHECK_TRUE(table.insert(3, 0));
+    VVS_CHECK_TRUE(table.insert(0, 1)); // ID 0 is also a valid key
+    VVS_CHECK_TRUE(table.insert(559562564900154, 2));
+    VVS_CHECK_FALSE(table.insert(3, 9));
+    VVS_CHECK_TRUE(table.size() == 3);
+    VVS_CHECK_TRUE(table.find(3) == 0);
+    VVS_CHECK_TRUE(table.find(0) == 1);
+    VVS_CHECK_TRUE(table.find(559562564900154) == 2);
+    VVS_CHECK_TRUE(table.count(29) == 0);
+
+    // Check update and removal
+    VVS_CHECK_TRUE(table.update(3, 9));
+    VVS_CHECK_TRUE(table.find(3) == 9);
+    VVS_CHECK_FALSE(table.update(29, 9));
+    VVS_CHECK_TRUE(table.erase(0));
+    VVS_CHECK_FALSE(table.erase(0));
+    VVS_CHECK_TRUE(table.find(0) == dg::LookupTable::npos);
+    VVS_CHECK_TRUE(table.size() == 2);
+
+    // Check consistency with 'std::map' under many insertions (with rehashing) and removals
+    std::vector<dg::ID> ids = genBenchIDs(10000);
+    std::map<dg::ID, size_t> truth;
+    table.clear();
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        table.insert(ids[i], i);
+        truth.insert(std::make_pair(ids[i], i));
+    }
+    for (size_t i = 0; i < ids.size(); i += 3)
+    {
+        table.erase(ids[i]);
+        truth.erase(ids[i]);
+    }
+    bool is_consistent = (table.size() == truth.size());
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        auto found = truth.find(ids[i]);
+        if (found == truth.end()) is_consistent &= (table.find(ids[i]) == dg::LookupTable::npos);
+        else is_consistent &= (table.find(ids[i]) == found->second);
+    }
+    VVS_CHECK_TRUE(is_consistent);
+
+    return 0;
+}
+
+int testCoreMapLookupBench(size_t n_nodes = 1000000, size_t n_queries = 1000000)
+{
+    std::vector<dg::ID> ids = genBenchIDs(n_nodes);
+    std::mt19937 rng(3335);
+    std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+    std::vector<dg::ID> queries(n_queries);
+    for (size_t i = 0; i < queries.size(); i++) queries[i] = ids[pick(rng)];
+
+    // Benchmark the previous lookup ('std::map')
+    double time_start = getBenchTime();
+    std::map<dg::ID, size_t> tree;
+    for (size_t i = 0; i < ids.size(); i++) tree.insert(std::make_pair(ids[i], i));
+    double time_tree_build = getBenchTime() - time_start;
+    size_t sum_tree = 0;
+    time_start = getBenchTime();
+    for (auto q = queries.begin(); q != queries.end(); q++) sum_tree += tree.find(*q)->second;
+    double time_tree_find = getBenchTime() - time_start;
+
+    // Benchmark the lookup table
+    time_start = getBenchTime();
+    dg::LookupTable table;
+    for (size_t i = 0; i < ids.size(); i++) table.insert(ids[i], i);
+    double time_table_build = getBenchTime() - time_start;
+    size_t sum_table = 0;
+    time_start = getBenchTime();
+    for (auto q = queries.begin(); q != queries.end(); q++) sum_table += table.find(*q);
+    double time_table_find = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(sum_tree == sum_table);
+
+    // Benchmark 'dg::Map::findNode'
+    dg::Map map;
+    for (size_t i = 0; i < ids.size(); i++) map.addNode(dg::Node(ids[i]));
+    size_t n_found = 0;
+    time_start = getBenchTime();
+    for (auto q = queries.begin(); q != queries.end(); q++)
+        if (map.findNode(*q) != nullptr) n_found++;
+    double time_map_find = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(n_found == queries.size());
+
+    printf("| Lookup (%zd IDs, %zd queries) | Build [sec] | Find [sec] | Find [Mops/sec] |\n", n_nodes, n_queries);
+    printf("| ------------------------------ | ----------- | ---------- | --------------- |\n");
+    printf("| std::map                       | %.6f | %.6f | %.3f |\n", time_tree_build, time_tree_find, n_queries / time_tree_find / 1e6);
+    printf("| dg::LookupTable                | %.6f | %.6f | %.3f |\n", time_table_build, time_table_find, n_queries / time_table_find / 1e6);
+    printf("| dg::Map::findNode              | -           | %.6f | %.3f |\n", time_map_find, n_queries / time_map_find / 1e6);
+
+    return 0;
+}
+
+int testCoreFrozenMap()
+{
+    // An example map
+    // 2 --- 3 --- 5 --> 6
+    // |     |     |     |
+    // |     |     |     |
+    // 1 --- 4     7 --- 8
+    dg::Map map;
+    map.addNode(dg::Node(1, 0, 0));
+    map.addNode(dg::Node(2, 0, 1));
+    map.addNode(dg::Node(3, 1, 1));
+    map.addNode(dg::Node(4, 1, 0));
+    map.addNode(dg::Node(5, 2, 1));
+    map.addNode(dg::Node(6, 3, 1));
+    map.addNode(dg::Node(7, 2, 0));
+    map.addNode(dg::Node(8, 3, 0));
+    map.addEdge(1, 2, dg::Edge(12, 1.2));
+    map.addEdge(1, 4, dg::Edge(14));
+    map.addEdge(2, 3, dg::Edge(23));
+    map.addEdge(3, 4, dg::Edge(34));
+    map.addEdge(3, 5, dg::Edge(35));
+    map.addEdge(5, 6, dg::Edge(56, 1, dg::Edge::EDGE_CROSSWALK, true));
+    map.addEdge(5, 7, dg::Edge(57));
+    map.addEdge(6, 8, dg::Edge(68));
+    map.addEdge(7, 8, dg::Edge(78));
+
+    // Check the frozen map
+    dg::FrozenMap frozen;
+    VVS_CHECK_TRUE(frozen.build(map));
+    VVS_CHECK_TRUE(frozen.countNodes() == 8);
+    VVS_CHECK_TRUE(frozen.countEdges() == 9);
+    VVS_CHECK_TRUE(frozen.adj_offsets.size() == 9);
+    VVS_CHECK_TRUE(frozen.adj_nodes.size() == 17);
+
+    size_t n1 = frozen.findNode(1), n2 = frozen.findNode(2), n5 = frozen.findNode(5), n6 = frozen.findNode(6);
+    VVS_CHECK_TRUE(n1 == 0 && n2 == 1 && n5 == 4 && n6 == 5);
+    VVS_CHECK_TRUE(frozen.findNode(9) == dg::FrozenMap::npos);
+    VVS_CHECK_TRUE(frozen.countAdjs(n1) == 2);
+    VVS_CHECK_TRUE(frozen.adj_nodes[frozen.adj_offsets[n1]] == n2);
+    VVS_CHECK_TRUE(frozen.edge_ids[frozen.adj_edges[frozen.adj_offsets[n1]]] == 12);
+    VVS_CHECK_TRUE(frozen.edge_lengths[frozen.findEdge(12)] == 1.2);
+    VVS_CHECK_TRUE(frozen.findEdge(n2, n1) == frozen.findEdge(12));
+    VVS_CHECK_TRUE(frozen.findEdge(n5, n6) == frozen.findEdge(56));
+    VVS_CHECK_TRUE(frozen.findEdge(n6, n5) == dg::FrozenMap::npos); // A directed edge
+    VVS_CHECK_TRUE(frozen.edge_types[frozen.findEdge(56)] == dg::Edge::EDGE_CROSSWALK);
+
+    // Check the same adjacency order with 'dg::Node::edge_ids'
+    bool is_same_order = true;
+    for (size_t i = 0; i < map.nodes.size(); i++)
+        for (size_t j = 0; j < map.nodes[i].edge_ids.size(); j++)
+            is_same_order &= (frozen.edge_ids[frozen.adj_edges[frozen.adj_offsets[i] + j]] == map.nodes[i].edge_ids[j]);
+    VVS_CHECK_TRUE(is_same_order);
+
+    // Check failure with an unknown node
+    map.edges.push_back(dg::Edge(19, 1, 0, false, 1, 9));
+    VVS_CHECK_FALSE(frozen.build(map));
+    VVS_CHECK_TRUE(frozen.isEmpty());
+
+    return 0;
+}
+
+int testCoreFrozenMapBench(size_t rows = 500, size_t cols = 500, int n_trials = 10)
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+    double time_start = getBenchTime();
+    dg::FrozenMap frozen(map);
+    double time_build = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(frozen.countNodes() == rows * cols);
+
+    // Benchmark BFS over 'dg::Map' (edge ID -> 'findEdge' -> 'findNode')
+    size_t n_visit_map = 0;
+    time_start = getBenchTime();
+    for (int t = 0; t < n_trials; t++)
+    {
+        std::vector<bool> visit(map.nodes.size(), false);
+        std::deque<dg::Node*> queue;
+        queue.push_back(&map.nodes.front());
+        visit.front() = true;
+        while (!queue.empty())
+        {
+            dg::Node* node = queue.front();
+            queue.pop_front();
+            n_visit_map++;
+            for (auto edge_id = node->edge_ids.begin(); edge_id != node->edge_ids.end(); edge_id++)
+            {
+                dg::Edge* edge = map.findEdge(*edge_id);
+                dg::Node* next = map.findNode((edge->node_id1 == node->id) ? edge->node_id2 : edge->node_id1);
+                size_t idx = next - &map.nodes.front();
+                if (visit[idx]) continue;
+                visit[idx] = true;
+                queue.push_back(next);
+            }
+        }
+    }
+    double time_map = getBenchTime() - time_start;
+
+    // Benchmark BFS over 'dg::Map' with adjacency indices
+    size_t n_visit_index = 0;
+    time_start = getBenchTime();
+    for (int t = 0; t < n_trials; t++)
+    {
+        std::vector<bool> visit(map.nodes.size(), false);
+        std::vector<size_t> queue;
+        queue.reserve(map.nodes.size());
+        queue.push_back(0);
+        visit.front() = true;
+        for (size_t q = 0; q < queue.size(); q++)
+        {
+            const dg::Node& node = map.nodes[queue[q]];
+            n_visit_index++;
+            for (auto next = node.adj_node_idxs.begin(); next != node.adj_node_idxs.end(); next++)
+            {
+                if (visit[*next]) continue;
+                visit[*next] = true;
+                queue.push_back(*next);
+            }
+        }
+    }
+    double time_index = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(n_visit_map == n_visit_index);
+
+    // Benchmark BFS over 'dg::FrozenMap'
+    size_t n_visit_frozen = 0;
+    time_start = getBenchTime();
+    for (int t = 0; t < n_trials; t++)
+    {
+        std::vector<bool> visit(frozen.countNodes(), false);
+        std::vector<uint32_t> queue;
+        queue.reserve(frozen.countNodes());
+        queue.push_back(0);
+        visit.front() = true;
+        for (size_t q = 0; q < queue.size(); q++)
+        {
+            uint32_t node = queue[q];
+            n_visit_frozen++;
+            for (uint32_t i = frozen.adj_offsets[node]; i < frozen.adj_offsets[node + 1]; i++)
+            {
+                uint32_t next = frozen.adj_nodes[i];
+                if (visit[next]) continue;
+                visit[next] = true;
+                queue.push_back(next);
+            }
+        }
+    }
+    double time_frozen = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(n_visit_map == n_visit_frozen);
+
+    printf("| BFS (%zd nodes, %d trials) | Time [sec] |\n", frozen.countNodes(), n_trials);
+    printf("| ---------------------------- | ---------- |\n");
+    printf("| dg::Map                      | %.6f |\n", time_map);
+    printf("| dg::Map (adjacency indices)  | %.6f |\n", time_index);
+    printf("| dg::FrozenMap (+ build)      | %.6f (+ %.6f) |\n", time_frozen, time_build);
+
+    return 0;
+}
+
+int testCoreMapAdjacency()
+{
+    // An example map
+    // 1 --> 2 --- 3
+    dg::Map map;
+    map.addNode(dg::Node(1, 0, 0));
+    map.addNode(dg::Node(2, 0, 1));
+    map.addNode(dg::Node(3, 0, 2));
+    map.addEdge(1, 2, dg::Edge(12, 1, 0, true));
+    map.addEdge(2, 3, dg::Edge(23));
+
+    // Check adjacency indices and accessors
+    dg::Node* node1 = map.findNode(1);
+    dg::Node* node2 = map.findNode(2);
+    VVS_CHECK_TRUE(map.findNodeIndex(2) == 1);
+    VVS_CHECK_TRUE(map.findEdgeIndex(23) == 1);
+    VVS_CHECK_TRUE(map.findNodeIndex(4) == dg::LookupTable::npos);
+    VVS_CHECK_TRUE(node1->edge_idxs.size() == 1 && node1->adj_node_idxs.size() == 1);
+    VVS_CHECK_TRUE(node2->edge_idxs.size() == 1 && node2->edge_idxs[0] == 1 && node2->adj_node_idxs[0] == 2);
+    VVS_CHECK_TRUE(map.getAdjEdge(node1, 0) == map.findEdge(12));
+    VVS_CHECK_TRUE(map.getAdjNode(node1, 0) == node2);
+    VVS_CHECK_TRUE(map.getAdjNode(node2, 0) == map.findNode(3));
+    VVS_CHECK_TRUE(map.getAdjEdge(node2, 1) == nullptr);
+    VVS_CHECK_TRUE(map.getAdjNode(nullptr, 0) == nullptr);
+    VVS_CHECK_TRUE(map.findEdge(2, 3) == map.findEdge(23));
+    VVS_CHECK_TRUE(map.findEdge(2, 1) == nullptr); // Directed
+
+    // Check adjacency after adding a node which refers an existing edge
+    dg::Map map2;
+    dg::Node node4(4, 1, 1), node5(5, 1, 2);
+    node4.edge_ids.push_back(45);
+    map2.addNode(node4);
+    map2.edges.push_back(dg::Edge(45, 1, 0, false, 4, 5));
+    map2.rebuildLookup();
+    VVS_CHECK_TRUE(map2.findNode(4)->edge_idxs[0] == 0);
+    VVS_CHECK_TRUE(map2.getAdjNode(map2.findNode(4), 0) == nullptr); // Node 5 is unknown
+    node5.edge_ids.push_back(45);
+    map2.addNode(node5);
+    VVS_CHECK_TRUE(map2.getAdjNode(map2.findNode(4), 0) == map2.findNode(5));
+    VVS_CHECK_TRUE(map2.getAdjNode(map2.findNode(5), 0) == map2.findNode(4));
+
+    // Check adjacency after union
+    dg::Map map3;
+    map3.addNode(dg::Node(3, 0, 2));
+    map3.addNode(dg::Node(4, 1, 1));
+    map3.addEdge(3, 4, dg::Edge(34));
+    map.set_union(map2);
+    map.set_union(map3);
+    dg::Node* node3 = map.findNode(3);
+    VVS_CHECK_TRUE(node3->edge_ids.size() == 2 && node3->edge_idxs.size() == 2 && node3->adj_node_idxs.size() == 2);
+    VVS_CHECK_TRUE(map.getAdjNode(node3, 1) == map.findNode(4));
+    VVS_CHECK_TRUE(map.getAdjEdge(node3, 1) == map.findEdge(34));
+    VVS_CHECK_TRUE(map.getAdjNode(map.findNode(4), 0) == map.findNode(5));
+    bool is_consistent = true;
+    for (auto node = map.nodes.begin(); node != map.nodes.end(); node++)
+    {
+        for (size_t i = 0; i < node->edge_ids.size(); i++)
+        {
+            dg::Edge* edge = map.getAdjEdge(&(*node), i);
+            is_consistent &= (edge != nullptr && edge->id == node->edge_ids[i]);
+            is_consistent &= (map.getAdjNode(&(*node), i) == map.findNode((edge->node_id1 == node->id) ? edge->node_id2 : edge->node_id1));
+        }
+    }
+    VVS_CHECK_TRUE(is_consistent);
+
+    return 0;
+}
+
+int testCoreMapUnion()
+{
+    // Two example maps
+    // 1 --- 2 --- 3    +    3 --- 4
+    //                       |
+    //                       5
+    dg::Map map1, map2;
+    map1.addNode(dg::Node(1, 0, 0));
+    map1.addNode(dg::Node(2, 0, 1));
+    map1.addNode(dg::Node(3, 0, 2));
+    map1.addEdge(1, 2, dg::Edge(12));
+    map1.addEdge(2, 3, dg::Edge(23));
+    dg::POI poi;
+    poi.id = 100;
+    poi.name = L"POI";
+    map1.addPOI(poi);
+
+    map2.addNode(dg::Node(3, 0, 2));
+    map2.addNode(dg::Node(4, 0, 3));
+    map2.addNode(dg::Node(5, 1, 2));
+    map2.addEdge(3, 4, dg::Edge(34));
+    map2.addEdge(3, 5, dg::Edge(35));
+    map2.addPOI(poi);
+    poi.id = 101;
+    map2.addPOI(poi);
+
+    // Check the union and its delta
+    dg::MapDelta delta = map1.set_union(map2);
+    VVS_CHECK_TRUE(map1.nodes.size() == 5);
+    VVS_CHECK_TRUE(map1.edges.size() == 4);
+    VVS_CHECK_TRUE(map1.pois.size() == 2);
+    VVS_CHECK_TRUE(delta.nodes.size() == 2 && delta.nodes[0] == 3 && delta.nodes[1] == 4);
+    VVS_CHECK_TRUE(delta.edges.size() == 2 && delta.edges[0] == 2 && delta.edges[1] == 3);
+    VVS_CHECK_TRUE(delta.pois.size() == 1 && delta.pois[0] == 1);
+    VVS_CHECK_TRUE(delta.views.empty());
+    VVS_CHECK_TRUE(map1.findNode(4) == &map1.nodes[3]);
+    VVS_CHECK_TRUE(map1.findEdge(3, 4) != nullptr);
+    VVS_CHECK_TRUE(map1.findEdge(3, 5) != nullptr);
+    VVS_CHECK_TRUE(map1.findEdge(2, 3) != nullptr);
+    VVS_CHECK_TRUE(map1.findNode(3)->edge_ids.size() == 3); // Merged connectivity of the duplicated node
+    VVS_CHECK_TRUE(map2.nodes.size() == 3); // Not changed
+
+    // Check the union of the same map again (nothing added)
+    VVS_CHECK_TRUE(map1.set_union(map2).empty());
+    VVS_CHECK_TRUE(map1.set_union(map1).empty());
+    VVS_CHECK_TRUE(map1.nodes.size() == 5);
+
+    // Check the union with moving
+    dg::Map map3;
+    map3.addNode(dg::Node(6, 1, 3));
+    map3.addNode(dg::Node(4, 0, 3));
+    map3.addEdge(4, 6, dg::Edge(46));
+    delta = map1.set_union(std::move(map3));
+    VVS_CHECK_TRUE(delta.nodes.size() == 1 && delta.edges.size() == 1);
+    VVS_CHECK_TRUE(map1.findEdge(4, 6) != nullptr);
+    VVS_CHECK_TRUE(map1.findEdge(6, 4) != nullptr);
+    VVS_CHECK_TRUE(map3.nodes.empty() && map3.findNode(6) == nullptr);
+
+    return 0;
+}
+
+int testCoreMapUnionBench(size_t rows = 500, size_t cols = 500, size_t n_tiles = 25)
+{
+    // Cut a big map into overlapped horizontal tiles
+    dg::Map whole = genBenchGridMap(rows, cols);
+    std::vector<dg::Map> tiles(n_tiles);
+    size_t tile_rows = rows / n_tiles;
+    for (size_t t = 0; t < n_tiles; t++)
+    {
+        size_t r_start = t * tile_rows, r_end = std::min(rows, (t + 1) * tile_rows + 1);
+        for (size_t i = r_start * cols; i < r_end * cols; i++) tiles[t].addNode(whole.nodes[i]);
+        for (auto edge = whole.edges.begin(); edge != whole.edges.end(); edge++)
+            if (tiles[t].findNode(edge->node_id1) != nullptr && tiles[t].findNode(edge->node_id2) != nullptr) tiles[t].edges.push_back(*edge);
+    }
+
+    // Benchmark the previous union (deep copy of the merged map for every tile)
+    double time_start = getBenchTime();
+    dg::Map merged_copy;
+    for (size_t t = 0; t < n_tiles; t++)
+    {
+        dg::Map merged = merged_copy;
+        for (auto node = tiles[t].nodes.begin(); node != tiles[t].nodes.end(); node++)
+            if (merged.findNode(node->id) == nullptr) merged.addNode(*node);
+        merged_copy = merged;
+    }
+    double time_copy = getBenchTime() - time_start;
+
+    // Benchmark the in-place union
+    time_start = getBenchTime();
+    dg::Map merged;
+    size_t n_added = 0;
+    for (size_t t = 0; t < n_tiles; t++) n_added += merged.set_union(tiles[t]).nodes.size();
+    double time_inplace = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(merged.nodes.size() == whole.nodes.size());
+    VVS_CHECK_TRUE(n_added == whole.nodes.size());
+    VVS_CHECK_TRUE(merged_copy.nodes.size() == whole.nodes.size());
+
+    printf("| Union (%zd nodes, %zd tiles) | Time [sec] |\n", whole.nodes.size(), n_tiles);
+    printf("| ------------------------------ | ---------- |\n");
+    printf("| Copy and assign (nodes only)   | %.6f |\n", time_copy);
+    printf("| In-place                       | %.6f |\n", time_inplace);
+
+    return 0;
+}
+
+int testCoreMapFile(const char* filename = "test_core_map.dgmap")
+{
+    // An example map with a directed edge, a POI, and a street-view
+    dg::Map map;
+    map.addNode(dg::Node(1, 36.1, 127.1));
+    map.addNode(dg::Node(2, 36.2, 127.2, dg::Node::NODE_JUNCTION, 1));
+    map.addNode(dg::Node(3, 36.3, 127.3));
+    map.addEdge(1, 2, dg::Edge(12, 10));
+    map.addEdge(2, 3, dg::Edge(23, 20, dg::Edge::EDGE_CROSSWALK, true));
+    dg::POI poi;
+    poi.id = 100;
+    poi.lat = 36.4;
+    poi.lon = 127.4;
+    poi.floor = 2;
+    poi.name = L"전자통신연구원 ETRI";
+    map.addPOI(poi);
+    dg::StreetView view;
+    view.id = 200;
+    view.lat = 36.5;
+    view.lon = 127.5;
+    view.floor = 0;
+    view.date = "2019-10-01";
+    view.heading = 90;
+    map.addView(view);
+    map.version = 7;
+
+    // Check saving and zero-copy access
+    VVS_CHECK_TRUE(dg::MapFile::save(filename, map));
+    dg::MapFile file;
+    VVS_CHECK_FALSE(file.isOpened());
+    VVS_CHECK_TRUE(file.open(filename));
+    VVS_CHECK_TRUE(file.isOpened());
+    VVS_CHECK_TRUE(file.getVersion() == dg::MapFile::VERSION);
+    VVS_CHECK_TRUE(file.getMapVersion() == 7);
+    VVS_CHECK_TRUE(file.countNodes() == 3 && file.countEdges() == 2 && file.countPOIs() == 1 && file.countViews() == 1);
+    VVS_CHECK_TRUE(file.getNodes()[1].id == 2 && file.getNodes()[1].edge_count == 2);
+    VVS_CHECK_TRUE(file.getNodeEdgeIDs(1)[0] == 12 && file.getNodeEdgeIDs(1)[1] == 23);
+    VVS_CHECK_TRUE(file.getEdges()[1].directed == 1);
+    VVS_CHECK_TRUE(file.getPOINameW(0) == poi.name);
+    VVS_CHECK_TRUE(std::string(file.getViewDate(0), file.getViews()[0].date_length) == view.date);
+
+    // Check conversion to a map
+    dg::Map loaded;
+    VVS_CHECK_TRUE(file.toMap(loaded));
+    VVS_CHECK_TRUE(loaded.nodes.size() == 3 && loaded.edges.size() == 2);
+    VVS_CHECK_TRUE(loaded.version == 7);
+    VVS_CHECK_TRUE(loaded.findNode(2) == &loaded.nodes[1]);
+    VVS_CHECK_TRUE(loaded.findNode(2)->type == dg::Node::NODE_JUNCTION && loaded.findNode(2)->floor == 1);
+    VVS_CHECK_TRUE(loaded.findNode(2)->edge_ids.size() == 2);
+    VVS_CHECK_TRUE(loaded.findEdge(1, 2) != nullptr);
+    VVS_CHECK_TRUE(loaded.findEdge(2, 1) != nullptr);
+    VVS_CHECK_TRUE(loaded.findEdge(2, 3) != nullptr);
+    VVS_CHECK_TRUE(loaded.findEdge(3, 2) == nullptr); // Directed
+    VVS_CHECK_TRUE(loaded.findEdge(23)->type == dg::Edge::EDGE_CROSSWALK);
+    VVS_CHECK_TRUE(loaded.pois.size() == 1 && loaded.pois[0].name == poi.name && loaded.pois[0].floor == 2);
+    VVS_CHECK_TRUE(loaded.views.size() == 1 && loaded.views[0].date == view.date && loaded.views[0].heading == 90);
+    file.close();
+    VVS_CHECK_FALSE(file.isOpened());
+    VVS_CHECK_TRUE(file.countNodes() == 0);
+
+    // Check failure with a missing or broken file
+    VVS_CHECK_FALSE(file.open("test_core_map_missing.dgmap"));
+    FILE* fd = fopen(filename, "r+b");
+    VVS_CHECK_TRUE(fd != nullptr);
+    fseek(fd, 0, SEEK_END);
+    long size = ftell(fd);
+    fclose(fd);
+    std::vector<char> buffer(size);
+    fd = fopen(filename, "rb");
+    VVS_CHECK_TRUE(fread(buffer.data(), 1, size, fd) == size_t(size));
+    fclose(fd);
+    fd = fopen(filename, "wb");
+    fwrite(buffer.data(), 1, size / 2, fd); // Truncated
+    fclose(fd);
+    VVS_CHECK_FALSE(file.open(filename));
+    buffer[0] = 'X';
+    fd = fopen(filename, "wb");
+    fwrite(buffer.data(), 1, size, fd); // Wrong magic number
+    fclose(fd);
+    VVS_CHECK_FALSE(file.open(filename));
+    buffer[0] = 'D';
+    const dg::MapFile::Header* header = reinterpret_cast<const dg::MapFile::Header*>(buffer.data());
+    uint64_t overflow = UINT64_MAX;
+    memcpy(buffer.data() + header->offsets[dg::MapFile::SECTION_NODES] + sizeof(dg::MapFile::NodeRecord) + offsetof(dg::MapFile::NodeRecord, edge_offset), &overflow, sizeof(overflow));
+    fd = fopen(filename, "wb");
+    fwrite(buffer.data(), 1, size, fd); // Wrong edge offset (overflow of 'edge_offset + edge_count')
+    fclose(fd);
+    VVS_CHECK_FALSE(file.open(filename));
+
+    // Check the memory-mapped file with an empty file
+    dg::MappedFile mapped;
+    VVS_CHECK_FALSE(mapped.open("test_core_map_missing.dgmap"));
+    VVS_CHECK_FALSE(mapped.isOpened());
+    fd = fopen(filename, "wb");
+    fclose(fd);
+    VVS_CHECK_TRUE(mapped.open(filename));
+    VVS_CHECK_TRUE(mapped.isOpened() && mapped.size() == 0 && mapped.data() == nullptr);
+    mapped.close();
+    VVS_CHECK_FALSE(mapped.isOpened());
+    VVS_CHECK_FALSE(file.open(filename));
+    remove(filename);
+
+    return 0;
+}
+
+int testCoreMapFileBench(size_t rows = 500, size_t cols = 500, const char* filename = "test_core_map_bench.dgmap")
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+
+    // Benchmark saving
+    double time_start = getBenchTime();
+    VVS_CHECK_TRUE(dg::MapFile::save(filename, map));
+    double time_save = getBenchTime() - time_start;
+
+    // Benchmark opening with zero-copy access
+    time_start = getBenchTime();
+    dg::MapFile file;
+    VVS_CHECK_TRUE(file.open(filename));
+    double length = 0;
+    const dg::MapFile::EdgeRecord* edges = file.getEdges();
+    for (size_t i = 0; i < file.countEdges(); i++) length += edges[i].length;
+    double time_open = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(file.countNodes() == map.nodes.size());
+    VVS_CHECK_TRUE(length > 0);
+
+    // Benchmark conversion to a map
+    time_start = getBenchTime();
+    dg::Map loaded;
+    VVS_CHECK_TRUE(file.toMap(loaded));
+    double time_convert = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(loaded.nodes.size() == map.nodes.size());
+    VVS_CHECK_TRUE(loaded.edges.size() == map.edges.size());
+    VVS_CHECK_TRUE(loaded.findEdge(map.edges.back().id) == &loaded.edges.back());
+    file.close();
+    remove(filename);
+
+    printf("| Map file (%zd nodes, %zd edges) | Time [sec] |\n", map.nodes.size(), map.edges.size());
+    printf("| -------------------------------- | ---------- |\n");
+    printf("| Save                             | %.6f |\n", time_save);
+    printf("| Open and scan (zero-copy)        | %.6f |\n", time_open);
+    printf("| Convert to dg::Map               | %.6f |\n", time_convert);
+
+    return 0;
+}
+
+int testCoreSpatialIndex(size_t n = 2000, unsigned int seed = 2019)
+{
+    // Generate random points and segments (with an invalid one)
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> pos(-500, 500), len(-30, 30);
+    std::vector<dg::Point2> pt1s, pt2s;
+    for (size_t i = 0; i < n; i++)
+    {
+        pt1s.push_back(dg::Point2(pos(rng), pos(rng)));
+        pt2s.push_back(pt1s.back() + dg::Point2(len(rng), len(rng)));
+    }
+    pt2s[n / 2].x = std::numeric_limits<double>::quiet_NaN();
+
+    // Check default values
+    dg::SpatialIndex points, segments;
+    std::vector<size_t> found, expected;
+    VVS_CHECK_TRUE(points.isEmpty());
+    VVS_CHECK_TRUE(points.queryNearest(dg::Point2(0, 0), 3, found) == 0);
+    VVS_CHECK_FALSE(points.build(std::vector<dg::Point2>()));
+    VVS_CHECK_TRUE(points.build(pt1s));
+    VVS_CHECK_TRUE(segments.build(pt1s, pt2s, 20));
+    VVS_CHECK_TRUE(points.size() == n && segments.size() == n);
+
+    // Compare queries with linear scans
+    const dg::Point2 queries[] = { dg::Point2(0, 0), dg::Point2(123, -321), dg::Point2(499, 499), dg::Point2(2000, -3000) };
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++)
+    {
+        const dg::SpatialIndex* indices[] = { &points, &segments };
+        for (int s = 0; s < 2; s++)
+        {
+            const dg::SpatialIndex& index = *indices[s];
+            const dg::Point2& pt = queries[q];
+
+            // Radius query
+            expected.clear();
+            for (size_t i = 0; i < n; i++)
+                if (index.getDistance(pt, i) <= 50) expected.push_back(i);
+            index.queryRadius(pt, 50, found);
+            VVS_CHECK_TRUE(found == expected);
+
+            // Box query
+            expected.clear();
+            for (size_t i = 0; i < n; i++)
+            {
+                if (s == 1 && i == n / 2) continue;
+                double x0 = std::min(pt1s[i].x, (s == 0) ? pt1s[i].x : pt2s[i].x), x1 = std::max(pt1s[i].x, (s == 0) ? pt1s[i].x : pt2s[i].x);
+                double y0 = std::min(pt1s[i].y, (s == 0) ? pt1s[i].y : pt2s[i].y), y1 = std::max(pt1s[i].y, (s == 0) ? pt1s[i].y : pt2s[i].y);
+                if (x1 >= pt.x - 40 && x0 <= pt.x + 60 && y1 >= pt.y - 70 && y0 <= pt.y + 30) expected.push_back(i);
+            }
+            index.queryBox(pt - dg::Point2(40, 70), pt + dg::Point2(60, 30), found);
+            VVS_CHECK_TRUE(found == expected);
+
+            // Nearest query (with and without a filter)
+            for (int odd = 0; odd < 2; odd++)
+            {
+                std::vector<std::pair<double, size_t> > sorted;
+                for (size_t i = 0; i < n; i++)
+                {
+                    if (s == 1 && i == n / 2) continue;
+                    if (odd && i % 2 == 0) continue;
+                    sorted.push_back(std::make_pair(index.getDistance(pt, i), i));
+                }
+                std::sort(sorted.begin(), sorted.end());
+                std::vector<double> dists;
+                if (odd) index.queryNearest(pt, 10, found, [](size_t i) { return i % 2 == 1; }, &dists);
+                else index.queryNearest(pt, 10, found, &dists);
+                VVS_CHECK_TRUE(found.size() == 10 && dists.size() == 10);
+                bool same = true;
+                for (size_t i = 0; i < found.size(); i++)
+                    if (found[i] != sorted[i].second || dists[i] != sorted[i].first) same = false;
+                VVS_CHECK_TRUE(same);
+            }
+
+            // Nearest query with a squared distance function (with a penalty and skipping even items)
+            auto dist2 = [&](size_t i) { double d = index.getDistance(pt, i); return (i % 2 == 0) ? -1 : d * d + (i % 7); };
+            size_t best = 0;
+            double best_d2 = DBL_MAX;
+            for (size_t i = 0; i < n; i++)
+            {
+                if ((s == 1 && i == n / 2) || dist2(i) < 0) continue;
+                if (dist2(i) < best_d2) { best_d2 = dist2(i); best = i; }
+            }
+            size_t nearest = 0;
+            double nearest_d2 = 0;
+            VVS_CHECK_TRUE(index.queryNearestWith(pt, dist2, nearest, &nearest_d2));
+            VVS_CHECK_TRUE(nearest == best && nearest_d2 == best_d2);
+            VVS_CHECK_TRUE(index.getEndPoint(nearest) == ((s == 0) ? pt1s[nearest] : pt2s[nearest]));
+            VVS_CHECK_TRUE(index.queryNearestWith(pt, dist2, nearest, nullptr, sqrt(best_d2)) && nearest == best);
+            if (q == 3) VVS_CHECK_FALSE(index.queryNearestWith(pt, dist2, nearest, nullptr, 100));
+        }
+    }
+    VVS_CHECK_TRUE(points.queryNearest(dg::Point2(0, 0), 2 * n, found) == n);
+    VVS_CHECK_TRUE(segments.queryNearest(dg::Point2(0, 0), 2 * n, found) == n - 1);
+
+    // Check spatial indices of a map
+    dg::Map map = genBenchGridMap(10, 10);
+    dg::UTMConverter converter;
+    converter.setReference(map.nodes[0]);
+    dg::MapSpatialIndex map_index;
+    VVS_CHECK_FALSE(map_index.isBuilt(map));
+    VVS_CHECK_TRUE(map_index.build(map, converter));
+    VVS_CHECK_TRUE(map_index.isBuilt(map));
+    VVS_CHECK_TRUE(map_index.nodes.queryNearest(converter.toMetric(dg::LatLon(36.38 + 0.0011, 127.36 + 0.0021)), 1, found) == 1);
+    VVS_CHECK_TRUE(map.nodes[found[0]].id == 559562564900000 + 2 * 10 + 4);
+    VVS_CHECK_TRUE(map_index.edges.queryRadius(converter.toMetric(map.nodes[0]), 1, found) == 2);
+    VVS_CHECK_TRUE(map.edges[found[0]].node_id1 == map.nodes[0].id && map.edges[found[1]].node_id1 == map.nodes[0].id);
+    VVS_CHECK_TRUE(map_index.pois.isEmpty() && map_index.views.isEmpty());
+    map.nodes[0].lat += 0.0001;
+    map.touch();
+    VVS_CHECK_FALSE(map_index.isBuilt(map));                                // Moved without adding nodes
+    VVS_CHECK_TRUE(map_index.build(map, converter));
+    VVS_CHECK_TRUE(map_index.isBuilt(map));
+    map.addNode(dg::Node(1, 36, 127));
+    VVS_CHECK_FALSE(map_index.isBuilt(map));
+
+    return 0;
+}
+
+int testCoreSpatialIndexBench(size_t rows = 500, size_t cols = 500, size_t n_queries = 100)
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+    for (size_t i = 0; i < map.nodes.size(); i += 7) map.nodes[i].type = dg::Node::NODE_JUNCTION;
+    dg::UTMConverter converter;
+    std::mt19937 rng(2019);
+    std::uniform_real_distribution<double> lat(36.38, 36.38 + rows * 0.0005), lon(127.36, 127.36 + cols * 0.0005);
+    std::vector<dg::LatLon> queries;
+    for (size_t q = 0; q < n_queries; q++) queries.push_back(dg::LatLon(lat(rng), lon(rng)));
+
+    // Benchmark the previous linear scan (sorting all junctions with 'std::map')
+    double time_start = getBenchTime();
+    std::vector<dg::ID> result_scan;
+    for (size_t q = 0; q < n_queries; q++)
+    {
+        dg::Point2 cur_metric = converter.toMetric(queries[q]);
+        std::map<double, dg::ID> lookup_junc_dist;
+        for (auto node = map.nodes.begin(); node != map.nodes.end(); node++)
+        {
+            if (node->type != dg::Node::NODE_JUNCTION) continue;
+            dg::Point2 node_metric = converter.toMetric(*node);
+            lookup_junc_dist.insert(std::make_pair(cv::norm(cur_metric - node_metric), node->id));
+        }
+        auto it = lookup_junc_dist.begin();
+        for (int i = 0; i < 3 && it != lookup_junc_dist.end(); i++, it++) result_scan.push_back(it->second);
+    }
+    double time_scan = getBenchTime() - time_start;
+
+    // Benchmark the spatial index
+    time_start = getBenchTime();
+    dg::MapSpatialIndex index;
+    VVS_CHECK_TRUE(index.build(map, converter));
+    double time_build = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    std::vector<dg::ID> result_index;
+    std::vector<size_t> found;
+    for (size_t q = 0; q < n_queries; q++)
+    {
+        index.nodes.queryNearest(converter.toMetric(queries[q]), 3, found, [&map](size_t i) { return map.nodes[i].type == dg::Node::NODE_JUNCTION; });
+        for (auto i = found.begin(); i != found.end(); i++) result_index.push_back(map.nodes[*i].id);
+    }
+    double time_query = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(result_index == result_scan);
+
+    // Benchmark radius queries
+    time_start = getBenchTime();
+    size_t n_found = 0;
+    for (size_t q = 0; q < n_queries; q++) n_found += index.edges.queryRadius(converter.toMetric(queries[q]), 100, found);
+    double time_radius = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(n_found > 0);
+
+    printf("| Junction 3-NN (%zd nodes, %zd queries) | Time [sec] |\n", map.nodes.size(), n_queries);
+    printf("| ---------------------------------------- | ---------- |\n");
+    printf("| Linear scan with 'std::map'              | %.6f |\n", time_scan);
+    printf("| Spatial index (build once)               | %.6f |\n", time_build);
+    printf("| Spatial index (queries)                  | %.6f |\n", time_query);
+    printf("| Spatial index (edges in 100 m)           | %.6f |\n", time_radius);
+
+    return 0;
+}
+
+int testCoreStringPool()
+{
+    // Check interning
+    dg::StringPool pool;
+    const wchar_t* a = pool.intern(L"ETRI");
+    const wchar_t* b = pool.intern(std::wstring(L"ETRI"));
+    const wchar_t* c = pool.intern(L"ETRI Cafe", 4);
+    const wchar_t* d = pool.intern(L"편의점");
+    VVS_CHECK_TRUE(a == b && a == c);
+    VVS_CHECK_TRUE(a != d);
+    VVS_CHECK_TRUE(std::wstring(a) == L"ETRI" && std::wstring(d) == L"편의점");
+    VVS_CHECK_TRUE(pool.size() == 2);
+    std::wstring long_name(100000, L'x');
+    VVS_CHECK_TRUE(pool.intern(long_name) == pool.intern(long_name));
+    VVS_CHECK_TRUE(a == pool.intern(L"ETRI")); // Not moved by a long string
+    for (int i = 0; i < 10000; i++) pool.intern(std::to_wstring(i));
+    VVS_CHECK_TRUE(pool.size() == 10003);
+    VVS_CHECK_TRUE(std::wstring(pool.intern(L"1234")) == L"1234");
+    VVS_CHECK_TRUE(pool.intern(L"") == dg::StringPool::emptyString() && pool.intern(L"ETRI", 0) == dg::StringPool::emptyString());
+    VVS_CHECK_TRUE(pool.size() == 10003); // The empty string is not stored
+
+    // Check interned strings
+    dg::InternedString empty, name1(L"ETRI"), name2 = std::wstring(L"ETRI"), name3;
+    name3 = L"KAIST";
+    VVS_CHECK_TRUE(empty.empty() && empty == L"" && empty.length() == 0);
+    VVS_CHECK_TRUE(empty == dg::InternedString(L"") && empty == dg::InternedString(std::wstring()));
+    VVS_CHECK_TRUE(name1 == name2 && name1.c_str() == name2.c_str() && name1.key() == name2.key());
+    VVS_CHECK_TRUE(name1 != name3 && name1.key() != name3.key());
+    VVS_CHECK_TRUE(name1 == std::wstring(L"ETRI") && std::wstring(L"ETRI") == name1);
+    VVS_CHECK_TRUE(name1 != std::wstring(L"KAIST") && name1 < name3);
+    std::wstring copy = name3;
+    VVS_CHECK_TRUE(copy == L"KAIST" && name3.length() == 5);
+
+    return 0;
+}
+
+int testCorePOINameIndex()
+{
+    // Add POIs with repeated names
+    dg::Map map;
+    const wchar_t* names[] = { L"카페", L"편의점", L"카페", L"약국", L"카페" };
+    for (int i = 0; i < 5; i++)
+    {
+        dg::POI poi;
+        poi.id = 100 + i;
+        poi.name = names[i];
+        map.addPOI(poi);
+    }
+    std::vector<size_t> found;
+    VVS_CHECK_TRUE(map.findPOIs(L"카페", found) == 3);
+    VVS_CHECK_TRUE(found[0] == 0 && found[1] == 2 && found[2] == 4);
+    VVS_CHECK_TRUE(map.findPOIs(L"편의점", found) == 1 && found[0] == 1);
+    VVS_CHECK_TRUE(map.findPOIs(L"병원", found) == 0 && found.empty());
+
+    // Check the name index after union and rebuilding
+    dg::Map map2;
+    dg::POI poi;
+    poi.id = 105;
+    poi.name = L"약국";
+    map2.addPOI(poi);
+    poi.id = 100; // Duplicated
+    poi.name = L"카페";
+    map2.addPOI(poi);
+    map.set_union(map2);
+    VVS_CHECK_TRUE(map.findPOIs(L"약국", found) == 2 && found[0] == 3 && found[1] == 5);
+    VVS_CHECK_TRUE(map.findPOIs(L"카페", found) == 3);
+    map.pois.erase(map.pois.begin());
+    map.rebuildLookup();
+    VVS_CHECK_TRUE(map.findPOIs(L"카페", found) == 2 && found[0] == 1 && found[1] == 3);
+
+    // Check removal
+    map.clearPOIs();
+    VVS_CHECK_TRUE(map.pois.empty() && map.findPOIs(L"카페", found) == 0);
+    map.addPOI(poi);
+    VVS_CHECK_TRUE(map.findPOIs(L"카페", found) == 1 && found[0] == 0);
+
+    return 0;
+}
+
+int testCorePOINameIndexBench(size_t n_pois = 100000, size_t n_names = 500, size_t n_queries = 1000)
+{
+    // Generate POIs of chain stores (names are repeated)
+    std::vector<std::wstring> names;
+    for (size_t i = 0; i < n_names; i++) names.push_back(L"체인점 " + std::to_wstring(i) + L" 대덕연구단지점");
+    std::vector<std::wstring> name_copies(n_pois); // As the previous 'dg::POI::name'
+    dg::Map map;
+    map.pois.reserve(n_pois);
+    for (size_t i = 0; i < n_pois; i++)
+    {
+        dg::POI poi;
+        poi.id = i;
+        poi.name = names[i % n_names];
+        name_copies[i] = names[i % n_names];
+        map.addPOI(poi);
+    }
+
+    // Compare memory for names
+    size_t bytes_copy = 0;
+    for (auto name = name_copies.begin(); name != name_copies.end(); name++) bytes_copy += sizeof(std::wstring) + (name->capacity() + 1) * sizeof(wchar_t);
+    size_t bytes_interned = n_pois * sizeof(dg::InternedString);
+    for (auto name = names.begin(); name != names.end(); name++) bytes_interned += (name->length() + 1) * sizeof(wchar_t); // Unique copies in the pool
+
+    // Benchmark the previous linear scan
+    double time_start = getBenchTime();
+    size_t n_scan = 0;
+    for (size_t q = 0; q < n_queries; q++)
+    {
+        const std::wstring& query = names[(q * 7) % n_names];
+        for (auto name = name_copies.begin(); name != name_copies.end(); name++)
+            if (*name == query) n_scan++;
+    }
+    double time_scan = getBenchTime() - time_start;
+
+    // Benchmark the name index
+    time_start = getBenchTime();
+    size_t n_index = 0;
+    std::vector<size_t> found;
+    for (size_t q = 0; q < n_queries; q++) n_index += map.findPOIs(names[(q * 7) % n_names], found);
+    double time_index = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(n_scan == n_index);
+    VVS_CHECK_TRUE(n_index == n_queries * n_pois / n_names);
+
+    printf("| POI names (%zd POIs, %zd names) | Memory [byte] | Query Time [sec] |\n", n_pois, n_names);
+    printf("| ------------------------------- | ------------- | ---------------- |\n");
+    printf("| std::wstring and linear scan    | %zd | %.6f |\n", bytes_copy, time_scan);
+    printf("| Interned and name index         | %zd | %.6f |\n", bytes_interned, time_index);
+
+    return 0;
+}
+
+int testCoreSharedMap(int n_readers = 4, int n_updates = 100)
+{
+    dg::SharedMap shared;
+    VVS_CHECK_TRUE(shared.get() == nullptr);
+    VVS_CHECK_TRUE(shared.getVersion() == 0);
+
+    // Publish a map without copying
+    dg::Map map;
+    map.addNode(dg::Node(1, 36.0, 127.0));
+    map.addNode(dg::Node(2, 36.1, 127.1));
+    VVS_CHECK_TRUE(map.addEdge(1, 2) != static_cast<size_t>(-1));
+    VVS_CHECK_TRUE(shared.set(std::move(map)) == 1);
+    uint64_t version = 0;
+    dg::MapSnapshot snap1 = shared.get(version);
+    VVS_CHECK_TRUE(snap1 != nullptr);
+    VVS_CHECK_TRUE(version == 1);
+    VVS_CHECK_TRUE(snap1->nodes.size() == 2);
+    VVS_CHECK_TRUE(snap1->findEdge(1, 2) != nullptr);
+
+    // Update as copy-on-write (the previous snapshot is not changed)
+    VVS_CHECK_TRUE(shared.update([](dg::Map& m) { m.addNode(dg::Node(3, 36.2, 127.2)); return m.addEdge(2, 3) != static_cast<size_t>(-1); }) == 2);
+    dg::MapSnapshot snap2 = shared.get();
+    VVS_CHECK_TRUE(snap2 != snap1);
+    VVS_CHECK_TRUE(snap1->nodes.size() == 2);
+    VVS_CHECK_TRUE(snap1->findNode(3) == nullptr);
+    VVS_CHECK_TRUE(snap2->nodes.size() == 3);
+    VVS_CHECK_TRUE(snap2->findEdge(2, 3) != nullptr);
+
+    // Check revisions of snapshots (a copy keeps its revision, but any modification changes it)
+    VVS_CHECK_TRUE(snap2->getRevision() != snap1->getRevision());
+    dg::Map copy = *snap2;
+    VVS_CHECK_TRUE(copy.getRevision() == snap2->getRevision());
+    copy.findNode(3)->lat = 36.3;
+    copy.touch();
+    VVS_CHECK_TRUE(copy.getRevision() != snap2->getRevision());
+    uint64_t revision = copy.getRevision();
+    dg::Map patched = copy;
+    dg::Map removed = copy;
+    removed.nodes.pop_back();
+    removed.edges.pop_back();
+    removed.rebuildLookup();
+    VVS_CHECK_TRUE(patched.applyPatch(dg::Map::diff(copy, removed)));
+    VVS_CHECK_TRUE(patched.getRevision() != revision && copy.getRevision() == revision);
+
+    // Cancel an update
+    VVS_CHECK_TRUE(shared.update([](dg::Map& m) { m.nodes.clear(); return false; }) == 0);
+    VVS_CHECK_TRUE(shared.get() == snap2);
+    VVS_CHECK_TRUE(shared.getVersion() == 2);
+
+    // Read snapshots while they are updated by another thread
+    std::vector<std::thread> readers;
+    std::vector<int> n_errors(n_readers, 0);
+    for (int r = 0; r < n_readers; r++)
+    {
+        readers.push_back(std::thread([&shared, &n_errors, r, n_updates]()
+        {
+            size_t n_prev = 0;
+            while (n_prev < 3 + static_cast<size_t>(n_updates))
+            {
+                dg::MapSnapshot snap = shared.get();
+                size_t n_nodes = snap->nodes.size();
+                if (n_nodes < n_prev) n_errors[r]++;                    // Never go back
+                for (size_t i = 0; i < n_nodes; i++)
+                    if (snap->findNode(snap->nodes[i].id) != &snap->nodes[i]) n_errors[r]++;
+                n_prev = n_nodes;
+            }
+        }));
+    }
+    for (int i = 0; i < n_updates; i++)
+    {
+        dg::ID id = 4 + i;
+        shared.update([id](dg::Map& m) { m.addNode(dg::Node(id, 36.0 + id * 0.01, 127.0)); return m.addEdge(id - 1, id) != static_cast<size_t>(-1); });
+    }
+    for (auto reader = readers.begin(); reader != readers.end(); reader++) reader->join();
+    for (int r = 0; r < n_readers; r++) VVS_CHECK_TRUE(n_errors[r] == 0);
+    VVS_CHECK_TRUE(shared.getVersion() == 2 + static_cast<uint64_t>(n_updates));
+    VVS_CHECK_TRUE(snap2->nodes.size() == 3);
+
+    shared.clear();
+    VVS_CHECK_TRUE(shared.get() == nullptr);
+
+    return 0;
+}
+
+int testCoreSharedMapBench(size_t rows = 500, size_t cols = 500, int n_consumers = 3)
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+
+    // Benchmark the previous deep copy for each consumer (e.g. localizer, guidance, and GUI)
+    double time_start = getBenchTime();
+    std::vector<dg::Map> copies;
+    for (int i = 0; i < n_consumers; i++) copies.push_back(map);
+    double time_copy = getBenchTime() - time_start;
+
+    // Benchmark sharing a snapshot
+    dg::SharedMap shared;
+    time_start = getBenchTime();
+    shared.set(std::move(map));
+    std::vector<dg::MapSnapshot> snapshots;
+    for (int i = 0; i < n_consumers; i++) snapshots.push_back(shared.get());
+    double time_share = getBenchTime() - time_start;
+    for (int i = 0; i < n_consumers; i++) VVS_CHECK_TRUE(snapshots[i]->nodes.size() == copies[i].nodes.size());
+
+    printf("| Map delivery (%zd nodes, %d consumers) | Time [sec] |\n", copies.front().nodes.size(), n_consumers);
+    printf("| -------------------------------------- | ---------- |\n");
+    printf("| Deep copy for each consumer            | %.6f |\n", time_copy);
+    printf("| Shared snapshot                        | %.6f |\n", time_share);
+
+    return 0;
+}
+
+int testCoreMapPatch()
+{
+    // The base version: 1 - 2 - 3 - 4 with two POIs and a street-view
+    dg::Map base;
+    for (dg::ID id = 1; id <= 4; id++) base.addNode(dg::Node(id, 36.0 + id * 0.001, 127.0));
+    base.addEdge(1, 2, dg::Edge(12, 10));
+    base.addEdge(2, 3, dg::Edge(23, 20));
+    base.addEdge(3, 4, dg::Edge(34, 30));
+    dg::POI poi;
+    poi.lat = 36.0;
+    poi.lon = 127.0;
+    poi.floor = 0;
+    poi.id = 100;
+    poi.name = L"카페";
+    base.addPOI(poi);
+    poi.id = 101;
+    poi.name = L"식당";
+    base.addPOI(poi);
+    dg::StreetView view;
+    view.id = 200;
+    view.lat = 36.0;
+    view.lon = 127.0;
+    view.floor = 0;
+    view.date = "2019-10-01";
+    view.heading = 0;
+    base.addView(view);
+    base.version = 1;
+
+    // The new version: node 4 is removed, node 5 is added, node 2 is moved, and edges are changed
+    dg::Map next;
+    next.addNode(dg::Node(1, 36.001, 127.0));
+    next.addNode(dg::Node(2, 36.0025, 127.0, dg::Node::NODE_JUNCTION));
+    next.addNode(dg::Node(3, 36.003, 127.0));
+    next.addNode(dg::Node(5, 36.002, 127.001));
+    next.addEdge(1, 3, dg::Edge(12, 15));                                   // Relinked
+    next.addEdge(2, 3, dg::Edge(23, 25, dg::Edge::EDGE_CROSSWALK));         // Modified
+    next.addEdge(2, 5, dg::Edge(25, 40, dg::Edge::EDGE_SIDEWALK, true));    // Added
+    poi.id = 100;
+    poi.name = L"빵집";                                                      // Renamed
+    next.addPOI(poi);
+    poi.id = 101;
+    poi.name = L"식당";
+    next.addPOI(poi);
+    view.id = 201;
+    next.addView(view);
+    next.version = 2;
+
+    // Check making and applying a patch
+    dg::MapPatch patch = dg::Map::diff(base, next);
+    VVS_CHECK_TRUE(patch.base_version == 1 && patch.version == 2);
+    VVS_CHECK_TRUE(patch.nodes.added.size() == 1 && patch.nodes.modified.size() == 1 && patch.nodes.removed.size() == 1);
+    VVS_CHECK_TRUE(patch.edges.added.size() == 1 && patch.edges.modified.size() == 2 && patch.edges.removed.size() == 1);
+    VVS_CHECK_TRUE(patch.pois.size() == 1 && patch.views.size() == 2);
+    dg::Map map = base;
+    VVS_CHECK_TRUE(map.applyPatch(patch));
+    VVS_CHECK_TRUE(map.version == 2);
+    VVS_CHECK_TRUE(isSameMap(map, next));
+    VVS_CHECK_TRUE(map.findEdge(1, 2) == nullptr);
+    VVS_CHECK_TRUE(map.findEdge(3, 1) != nullptr);
+    VVS_CHECK_TRUE(map.findEdge(5, 2) == nullptr); // Directed
+    VVS_CHECK_TRUE(map.findNode(3)->edge_ids.size() == 2);
+    std::vector<size_t> found;
+    VVS_CHECK_TRUE(map.findPOIs(L"카페", found) == 0);
+    VVS_CHECK_TRUE(map.findPOIs(L"빵집", found) == 1);
+
+    // Check a patch without removal (applied without rebuilding)
+    dg::Map closed = next;
+    closed.findEdge(23)->length = 1e6;
+    closed.addNode(dg::Node(6, 36.004, 127.0));
+    closed.addEdge(3, 6, dg::Edge(36, 10));
+    closed.version = 3;
+    patch = dg::Map::diff(next, closed);
+    VVS_CHECK_TRUE(patch.size() == 3);
+    VVS_CHECK_TRUE(map.applyPatch(patch));
+    VVS_CHECK_TRUE(isSameMap(map, closed));
+    VVS_CHECK_TRUE(map.findEdge(3, 6) != nullptr);
+
+    // Check rejection of a stale or invalid patch (the map is not changed)
+    VVS_CHECK_FALSE(map.applyPatch(patch));
+    dg::MapPatch invalid;
+    invalid.base_version = 3;
+    invalid.version = 4;
+    invalid.nodes.removed.push_back(1);
+    invalid.edges.added.push_back(dg::Edge(99, 10, 0, false, 1, 2)); // Node 1 is removed
+    VVS_CHECK_FALSE(map.applyPatch(invalid));
+    invalid.edges.added.clear();
+    invalid.nodes.added.push_back(dg::Node(2));                      // Node 2 exists
+    VVS_CHECK_FALSE(map.applyPatch(invalid));
+    invalid.nodes.added.clear();
+    invalid.edges.modified.push_back(dg::Edge(12, 99, 0, false, 1, 3)); // Edge 12 is removed with node 1
+    VVS_CHECK_FALSE(map.applyPatch(invalid));
+    VVS_CHECK_TRUE(map.version == 3);
+    VVS_CHECK_TRUE(isSameMap(map, closed));
+
+    // Check going back to the base version
+    patch = dg::Map::diff(closed, base);
+    VVS_CHECK_TRUE(map.applyPatch(patch));
+    VVS_CHECK_TRUE(map.version == 1);
+    VVS_CHECK_TRUE(isSameMap(map, base));
+    VVS_CHECK_TRUE(map.applyPatch(dg::Map::diff(base, base)));
+    VVS_CHECK_TRUE(isSameMap(map, base));
+
+    return 0;
+}
+
+int testCoreMapPatchBench(size_t rows = 500, size_t cols = 500, size_t n_changes = 1000)
+{
+    dg::Map base = genBenchGridMap(rows, cols);
+    base.version = 1;
+
+    // Make a new version with edge costs changed (e.g. closed roads) and a few new nodes
+    dg::Map next = base;
+    next.version = 2;
+    for (size_t i = 0; i < n_changes; i++) next.edges[(i * 7919) % next.edges.size()].length *= 10;
+    const dg::ID node_base = 559562564800000, edge_base = 559562564810000000;
+    for (size_t i = 0; i < n_changes / 10; i++)
+    {
+        next.addNode(dg::Node(node_base + i, 36.37, 127.36 + i * 0.0005));
+        next.addEdge(node_base + i, base.nodes[i].id, dg::Edge(edge_base + i, 100));
+    }
+    dg::Map removed = next;
+    removed.version = 3;
+    removed.nodes.erase(removed.nodes.end() - n_changes / 10, removed.nodes.end());
+    removed.edges.erase(removed.edges.end() - n_changes / 10, removed.edges.end());
+    for (auto node = removed.nodes.begin(); node != removed.nodes.begin() + n_changes / 10; node++) node->edge_ids.pop_back();
+    removed.rebuildLookup();
+
+    // Benchmark making patches
+    double time_start = getBenchTime();
+    dg::MapPatch patch = dg::Map::diff(base, next);
+    dg::MapPatch patch_removal = dg::Map::diff(next, removed);
+    double time_diff = (getBenchTime() - time_start) / 2;
+    VVS_CHECK_TRUE(patch.edges.modified.size() <= n_changes && patch.nodes.added.size() == n_changes / 10);
+    VVS_CHECK_TRUE(patch_removal.nodes.removed.size() == n_changes / 10);
+
+    // Benchmark replacing the whole map (the lower bound of downloading and parsing it again)
+    dg::Map map = base;
+    time_start = getBenchTime();
+    map = next;
+    map.rebuildLookup();
+    double time_replace = getBenchTime() - time_start;
+
+    // Benchmark applying the patches in place
+    map = base;
+    time_start = getBenchTime();
+    VVS_CHECK_TRUE(map.applyPatch(patch));
+    double time_patch = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(isSameMap(map, next));
+    time_start = getBenchTime();
+    VVS_CHECK_TRUE(map.applyPatch(patch_removal));
+    double time_patch_removal = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(isSameMap(map, removed));
+
+    printf("| Map update (%zd nodes, %zd changes) | Time [sec] |\n", base.nodes.size(), patch.size());
+    printf("| ----------------------------------- | ---------- |\n");
+    printf("| Replacing the whole map             | %.6f |\n", time_replace);
+    printf("| Making a patch (Map::diff)          | %.6f |\n", time_diff);
+    printf("| Applying a patch                    | %.6f |\n", time_patch);
+    printf("| Applying a patch with removal       | %.6f |\n", time_patch_removal);
+
+    return 0;
+}
+
+/**
+ * Check whether the given path is connected on the given map and calculate its length
+ * @param map The given map
+ * @param path The given path
+ * @param length The sum of edge lengths of the path (return value)
+ * @return True if the path is valid (false if not)
+ */
+inline bool isValidPath(const dg::Map& map, const dg::Path& path, double& length)
+{
+    length = 0;
+    if (path.pts.empty() || path.pts.back().edge_id != 0) return false;
+    for (size_t i = 0; i + 1 < path.pts.size(); i++)
+    {
+        const dg::Edge* edge = map.findEdge(path.pts[i].edge_id);
+        if (edge == nullptr) return false;
+        bool forward = (edge->node_id1 == path.pts[i].node_id && edge->node_id2 == path.pts[i + 1].node_id);
+        bool backward = (edge->node_id2 == path.pts[i].node_id && edge->node_id1 == path.pts[i + 1].node_id);
+        if (!forward && !(backward && !edge->directed)) return false;
+        length += edge->length;
+    }
+    return true;
+}
+
+int testCorePathFinder(size_t rows = 30, size_t cols = 30, size_t n_queries = 300, unsigned int seed = 2019)
+{
+    // An example map
+    // 2 --- 3 === 5 --> 6    (===: stairs)
+    // |     |     |     |
+    // |     |     |     |
+    // 1 --- 4     7 --- 8
+    dg::Map map;
+    map.addNode(dg::Node(1, 0, 0));
+    map.addNode(dg::Node(2, 0, 1));
+    map.addNode(dg::Node(3, 1, 1));
+    map.addNode(dg::Node(4, 1, 0));
+    map.addNode(dg::Node(5, 2, 1));
+    map.addNode(dg::Node(6, 3, 1));
+    map.addNode(dg::Node(7, 2, 0));
+    map.addNode(dg::Node(8, 3, 0));
+    map.addEdge(1, 2, dg::Edge(12, 1.2));
+    map.addEdge(1, 4, dg::Edge(14));
+    map.addEdge(2, 3, dg::Edge(23));
+    map.addEdge(3, 4, dg::Edge(34));
+    map.addEdge(3, 5, dg::Edge(35, 1, dg::Edge::EDGE_STAIR));
+    map.addEdge(5, 6, dg::Edge(56, 1, dg::Edge::EDGE_CROSSWALK, true));
+    map.addEdge(5, 7, dg::Edge(57));
+    map.addEdge(6, 8, dg::Edge(68));
+    map.addEdge(7, 8, dg::Edge(78));
+
+    // Check the shortest paths with all search algorithms
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(finder.build(map));
+    VVS_CHECK_TRUE(finder.isBuilt(map));
+    dg::Map modified = map;
+    VVS_CHECK_TRUE(finder.isBuilt(modified));
+    modified.findEdge(14)->length = 100;
+    modified.touch();
+    VVS_CHECK_FALSE(finder.isBuilt(modified));                              // Modified without adding edges
+    for (int method = dg::PathFinder::SEARCH_DIJKSTRA; method <= dg::PathFinder::SEARCH_BIDIRECTIONAL; method++)
+    {
+        dg::Path path;
+        double cost = -1, length = -1;
+        VVS_CHECK_TRUE(finder.findPath(1, 6, path, method, &cost));
+        VVS_CHECK_TRUE(path.pts.size() == 5);
+        VVS_CHECK_TRUE(path.pts[0].node_id == 1 && path.pts[1].node_id == 4 && path.pts[2].node_id == 3 && path.pts[3].node_id == 5 && path.pts[4].node_id == 6);
+        VVS_CHECK_TRUE(path.pts[0].edge_id == 14 && path.pts[3].edge_id == 56 && path.pts[4].edge_id == 0);
+        VVS_CHECK_TRUE(isValidPath(map, path, length) && length == 4 && cost == 4);
+        VVS_CHECK_TRUE(path.start_pos == dg::LatLon(0, 0) && path.dest_pos == dg::LatLon(3, 1));
+
+        // Check the reverse path which cannot use the directed edge
+        VVS_CHECK_TRUE(finder.findPath(6, 1, path, method, &cost));
+        VVS_CHECK_TRUE(isValidPath(map, path, length) && length == 6 && cost == 6);
+        VVS_CHECK_TRUE(path.pts[1].node_id == 8);
+
+        // Check trivial and invalid queries
+        VVS_CHECK_TRUE(finder.findPath(3, 3, path, method, &cost));
+        VVS_CHECK_TRUE(path.pts.size() == 1 && path.pts[0].node_id == 3 && cost == 0);
+        VVS_CHECK_FALSE(finder.findPath(1, 9, path, method));
+        VVS_CHECK_TRUE(path.pts.empty());
+    }
+
+    // Check the cost function with edge types
+    dg::RoadProfile crosswalk_cost;
+    crosswalk_cost.type_weights[dg::Edge::EDGE_CROSSWALK] = 10;
+    VVS_CHECK_TRUE(finder.build(map, crosswalk_cost));
+    dg::Path path;
+    double cost = -1;
+    VVS_CHECK_TRUE(finder.findPath(1, 6, path, dg::PathFinder::SEARCH_ASTAR, &cost));
+    VVS_CHECK_TRUE(path.pts.size() == 7 && cost == 6); // Detour through 7 and 8
+    VVS_CHECK_TRUE(finder.build(map, dg::RoadProfile::wheelchair()));
+    for (int method = dg::PathFinder::SEARCH_DIJKSTRA; method <= dg::PathFinder::SEARCH_BIDIRECTIONAL; method++)
+    {
+        VVS_CHECK_FALSE(finder.findPath(1, 6, path, method));
+        VVS_CHECK_TRUE(finder.findPath(6, 7, path, method));
+    }
+    dg::RoadProfile wheelchair = dg::RoadProfile::wheelchair();             // Same with the profile of RoadMap
+    VVS_CHECK_TRUE(wheelchair.calcWeight(10, dg::Edge::EDGE_SIDEWALK, 0.05) > 10);
+    VVS_CHECK_TRUE(wheelchair.calcWeight(10, dg::Edge::EDGE_SIDEWALK, 0.1) < 0); // Steeper than 1:12
+
+    // Check the same cost of all search algorithms on a grid map with some directed edges
+    dg::Map grid = genBenchGridMap(rows, cols);
+    for (size_t i = 0; i < grid.edges.size(); i += 5) grid.edges[i].directed = true;
+    VVS_CHECK_TRUE(finder.build(grid));
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, grid.nodes.size() - 1);
+    bool is_same = true, is_valid = true;
+    for (size_t q = 0; q < n_queries; q++)
+    {
+        dg::ID from = grid.nodes[pick(rng)].id, to = grid.nodes[pick(rng)].id;
+        dg::Path paths[3];
+        double costs[3] = { 0, 0, 0 };
+        bool found[3];
+        for (int method = 0; method < 3; method++)
+        {
+            found[method] = finder.findPath(from, to, paths[method], method, &costs[method]);
+            double length = 0;
+            if (found[method]) is_valid &= isValidPath(grid, paths[method], length) && fabs(length - costs[method]) < 1e-6;
+        }
+        is_same &= (found[0] == found[1] && found[0] == found[2]);
+        is_same &= (fabs(costs[0] - costs[1]) < 1e-6 && fabs(costs[0] - costs[2]) < 1e-6);
+    }
+    VVS_CHECK_TRUE(is_same);
+    VVS_CHECK_TRUE(is_valid);
+
+    return 0;
+}
+
+int testCorePathFinderBench(size_t rows = 200, size_t cols = 200, size_t n_queries = 2000, unsigned int seed = 2019)
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+    dg::RoadProfile cost;
+    cost.type_weights[dg::Edge::EDGE_CROSSWALK] = 1.5;
+
+    double time_start = getBenchTime();
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(finder.build(map, cost));
+    double time_build = getBenchTime() - time_start;
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, map.nodes.size() - 1);
+    std::vector<std::pair<dg::ID, dg::ID>> queries(n_queries);
+    for (size_t q = 0; q < n_queries; q++) queries[q] = std::make_pair(map.nodes[pick(rng)].id, map.nodes[pick(rng)].id);
+
+    // Benchmark all search algorithms with the same O/D pairs
+    const char* names[] = { "Dijkstra", "A*", "Bidirectional Dijkstra" };
+    double times[3], visits[3];
+    dg::Path path;
+    for (int method = 0; method < 3; method++)
+    {
+        size_t n_found = 0, n_visits = 0;
+        time_start = getBenchTime();
+        for (size_t q = 0; q < n_queries; q++)
+        {
+            if (finder.findPath(queries[q].first, queries[q].second, path, method)) n_found++;
+            n_visits += finder.countVisits();
+        }
+        times[method] = (getBenchTime() - time_start) / n_queries;
+        visits[method] = double(n_visits) / n_queries;
+        VVS_CHECK_TRUE(n_found == n_queries);
+    }
+
+    printf("| Path finding (%zd nodes, %zd queries) | Time [sec/query] | Visited nodes |\n", map.nodes.size(), n_queries);
+    printf("| ------------------------------------- | ---------------- | ------------- |\n");
+    printf("| Building (once)                       | %.6f | - |\n", time_build);
+    for (int method = 0; method < 3; method++)
+        printf("| %-37s | %.6f | %.0f |\n", names[method], times[method], visits[method]);
+
+    return 0;
+}
+
+/**
+ * Enumerate lengths of all simple paths between two nodes by depth-first search
+ * @param map The given map
+ * @param from ID of the current node
+ * @param to ID of the destination node
+ * @param length The length from the start node to the current node
+ * @param visited IDs of the visited nodes
+ * @param lengths Lengths of the enumerated paths (return value)
+ */
+inline void enumSimplePaths(const dg::Map& map, dg::ID from, dg::ID to, double length, std::set<dg::ID>& visited, std::vector<double>& lengths)
+{
+    if (from == to)
+    {
+        lengths.push_back(length);
+        return;
+    }
+    visited.insert(from);
+    const dg::Node* node = map.findNode(from);
+    for (size_t i = 0; i < node->edge_ids.size(); i++)
+    {
+        const dg::Edge* edge = map.findEdge(node->edge_ids[i]);
+        if (edge->directed && edge->node_id1 != from) continue;
+        dg::ID next = (edge->node_id1 == from) ? edge->node_id2 : edge->node_id1;
+        if (visited.count(next) == 0) enumSimplePaths(map, next, to, length + edge->length, visited, lengths);
+    }
+    visited.erase(from);
+}
+
+int testCorePathFinderKShortest(size_t rows = 4, size_t cols = 4, size_t n_queries = 100, unsigned int seed = 2019)
+{
+    // An example map
+    // 2 --- 3 --- 5 --> 6
+    // |     |     |     |
+    // |     |     |     |
+    // 1 --- 4     7 --- 8
+    dg::Map map;
+    map.addNode(dg::Node(1, 0, 0));
+    map.addNode(dg::Node(2, 0, 1));
+    map.addNode(dg::Node(3, 1, 1));
+    map.addNode(dg::Node(4, 1, 0));
+    map.addNode(dg::Node(5, 2, 1));
+    map.addNode(dg::Node(6, 3, 1));
+    map.addNode(dg::Node(7, 2, 0));
+    map.addNode(dg::Node(8, 3, 0));
+    map.addEdge(1, 2, dg::Edge(12, 1.2));
+    map.addEdge(1, 4, dg::Edge(14));
+    map.addEdge(2, 3, dg::Edge(23));
+    map.addEdge(3, 4, dg::Edge(34));
+    map.addEdge(3, 5, dg::Edge(35));
+    map.addEdge(5, 6, dg::Edge(56, 1, dg::Edge::EDGE_SIDEWALK, true));
+    map.addEdge(5, 7, dg::Edge(57));
+    map.addEdge(6, 8, dg::Edge(68));
+    map.addEdge(7, 8, dg::Edge(78));
+
+    // Check all simple paths in ascending order of their cost
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(finder.build(map));
+    std::vector<dg::Path> paths;
+    std::vector<double> costs;
+    double length = -1;
+    VVS_CHECK_TRUE(finder.findPaths(1, 6, 10, paths, 1, &costs));
+    VVS_CHECK_TRUE(paths.size() == 4 && costs.size() == 4);
+    VVS_CHECK_TRUE(fabs(costs[0] - 4) < 1e-6 && fabs(costs[1] - 4.2) < 1e-6 && fabs(costs[2] - 6) < 1e-6 && fabs(costs[3] - 6.2) < 1e-6);
+    VVS_CHECK_TRUE(paths[0].pts.size() == 5 && paths[0].pts[1].node_id == 4);
+    VVS_CHECK_TRUE(paths[3].pts.size() == 7 && paths[3].pts[1].node_id == 2 && paths[3].pts[4].node_id == 7);
+    VVS_CHECK_TRUE(isValidPath(map, paths[3], length) && fabs(length - 6.2) < 1e-6);
+    VVS_CHECK_TRUE(finder.findPaths(6, 1, 10, paths, 1, &costs));
+    VVS_CHECK_TRUE(paths.size() == 2 && fabs(costs[0] - 6) < 1e-6 && fabs(costs[1] - 6.2) < 1e-6);
+
+    // Check the limited overlap (the second path shares 3-5-6 with the first one)
+    VVS_CHECK_TRUE(finder.findPaths(1, 6, 2, paths, 0.5, &costs));
+    VVS_CHECK_TRUE(paths.size() == 2 && fabs(costs[1] - 4.2) < 1e-6);
+    VVS_CHECK_TRUE(finder.findPaths(1, 6, 2, paths, 0.4, &costs));
+    VVS_CHECK_TRUE(paths.size() == 2 && fabs(costs[1] - 6.2) < 1e-6); // Only 3-5 is shared
+
+    // Check trivial and invalid queries
+    VVS_CHECK_TRUE(finder.findPaths(3, 3, 3, paths));
+    VVS_CHECK_TRUE(paths.size() == 1 && paths[0].pts.size() == 1);
+    VVS_CHECK_FALSE(finder.findPaths(1, 9, 3, paths));
+    VVS_CHECK_FALSE(finder.findPaths(1, 6, 0, paths));
+    VVS_CHECK_TRUE(paths.empty());
+
+    // Check the same cost with exhaustive enumeration on a small grid map with some directed edges
+    dg::Map grid = genBenchGridMap(rows, cols);
+    for (size_t i = 0; i < grid.edges.size(); i += 5) grid.edges[i].directed = true;
+    VVS_CHECK_TRUE(finder.build(grid));
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, grid.nodes.size() - 1);
+    std::uniform_int_distribution<int> pick_k(1, 30);
+    bool is_same = true, is_valid = true;
+    for (size_t q = 0; q < n_queries; q++)
+    {
+        dg::ID from = grid.nodes[pick(rng)].id, to = grid.nodes[pick(rng)].id;
+        int k = pick_k(rng);
+        std::set<dg::ID> visited;
+        std::vector<double> lengths;
+        enumSimplePaths(grid, from, to, 0, visited, lengths);
+        std::sort(lengths.begin(), lengths.end());
+        if (lengths.size() > static_cast<size_t>(k)) lengths.resize(k);
+
+        finder.findPaths(from, to, k, paths, 1, &costs);
+        is_same &= (paths.size() == lengths.size());
+        std::set<std::vector<dg::ID>> distinct;
+        for (size_t i = 0; i < paths.size() && i < lengths.size(); i++)
+        {
+            is_same &= fabs(costs[i] - lengths[i]) < 1e-6;
+            is_valid &= isValidPath(grid, paths[i], length) && fabs(length - costs[i]) < 1e-6;
+            std::vector<dg::ID> ids;
+            for (size_t j = 0; j < paths[i].pts.size(); j++) ids.push_back(paths[i].pts[j].node_id);
+            is_valid &= std::set<dg::ID>(ids.begin(), ids.end()).size() == ids.size(); // Loopless
+            is_valid &= distinct.insert(ids).second;
+        }
+    }
+    VVS_CHECK_TRUE(is_same);
+    VVS_CHECK_TRUE(is_valid);
+
+    return 0;
+}
+
+int testCorePathFinderKShortestBench(size_t rows = 100, size_t cols = 100, size_t n_queries = 20, unsigned int seed = 2019)
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+    dg::RoadProfile cost;
+    cost.type_weights[dg::Edge::EDGE_CROSSWALK] = 1.5;
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(finder.build(map, cost));
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, map.nodes.size() - 1);
+    std::vector<std::pair<dg::ID, dg::ID>> queries(n_queries);
+    for (size_t q = 0; q < n_queries; q++) queries[q] = std::make_pair(map.nodes[pick(rng)].id, map.nodes[pick(rng)].id);
+
+    // Benchmark the k shortest paths with and without the overlap constraint
+    printf("| K shortest paths (%zd nodes, %zd queries) | Time [sec/query] | Time with 50%% overlap [sec/query] | Found paths with 50%% overlap |\n", map.nodes.size(), n_queries);
+    printf("| ----------------------------------------- | ---------------- | --------------------------------- | ---------------------------- |\n");
+    std::vector<dg::Path> paths;
+    for (int k = 2; k <= 10; k += 2)
+    {
+        double time_start = getBenchTime();
+        for (size_t q = 0; q < n_queries; q++) VVS_CHECK_TRUE(finder.findPaths(queries[q].first, queries[q].second, k, paths));
+        double time_all = (getBenchTime() - time_start) / n_queries;
+
+        size_t n_found = 0;
+        time_start = getBenchTime();
+        for (size_t q = 0; q < n_queries; q++)
+        {
+            VVS_CHECK_TRUE(finder.findPaths(queries[q].first, queries[q].second, k, paths, 0.5));
+            n_found += paths.size();
+        }
+        double time_diverse = (getBenchTime() - time_start) / n_queries;
+        printf("| k = %-37d | %.6f | %.6f | %.1f |\n", k, time_all, time_diverse, double(n_found) / n_queries);
+    }
+
+    return 0;
+}
+
+/**
+ * Check whether the contraction hierarchy finds the same shortest paths with Dijkstra's algorithm
+ * @param map The given map
+ * @param hierarchy The contraction hierarchy built with the map
+ * @param finder The path finder built with the map
+ * @param queries Pairs of node IDs to test
+ * @return True if all paths are valid and have the same cost (false if not)
+ */
+inline bool isSamePathHierarchy(const dg::Map& map, dg::ContractionHierarchy& hierarchy, dg::PathFinder& finder, const std::vector<std::pair<dg::ID, dg::ID>>& queries)
+{
+    for (size_t q = 0; q < queries.size(); q++)
+    {
+        dg::Path path_ch, path_dj;
+        double cost_ch = -1, cost_dj = -1, length = 0;
+        bool found_ch = hierarchy.findPath(queries[q].first, queries[q].second, path_ch, &cost_ch);
+        bool found_dj = finder.findPath(queries[q].first, queries[q].second, path_dj, dg::PathFinder::SEARCH_DIJKSTRA, &cost_dj);
+        if (found_ch != found_dj) return false;
+        if (!found_ch) continue;
+        if (fabs(cost_ch - cost_dj) > 1e-6) return false;
+        if (!isValidPath(map, path_ch, length)) return false;
+        if (path_ch.pts.front().node_id != queries[q].first || path_ch.pts.back().node_id != queries[q].second) return false;
+    }
+    return true;
+}
+
+int testCoreContractionHierarchy(dg::Map sample, size_t rows = 30, size_t cols = 30, size_t n_queries = 1000, unsigned int seed = 2019, const char* filename = "test_core_map.dgch")
+{
+    // Check all pairs of nodes on the sample map (e.g. the ETRI map; its edge lengths are calculated from their nodes)
+    dg::UTMConverter converter;
+    for (auto edge = sample.edges.begin(); edge != sample.edges.end(); edge++)
+    {
+        dg::Point2 p1 = converter.toMetric(*sample.findNode(edge->node_id1)), p2 = converter.toMetric(*sample.findNode(edge->node_id2));
+        edge->length = norm(p2 - p1);
+    }
+    dg::ContractionHierarchy hierarchy;
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(hierarchy.build(sample));
+    VVS_CHECK_TRUE(finder.build(sample));
+    std::vector<std::pair<dg::ID, dg::ID>> queries;
+    for (auto from = sample.nodes.begin(); from != sample.nodes.end(); from++)
+        for (auto to = sample.nodes.begin(); to != sample.nodes.end(); to++)
+            queries.push_back(std::make_pair(from->id, to->id));
+    VVS_CHECK_TRUE(isSamePathHierarchy(sample, hierarchy, finder, queries));
+
+    // Check random pairs on a grid map with random lengths, directed edges, and impassable stairs
+    dg::Map grid = genBenchGridMap(rows, cols);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> scale(0.5, 2);
+    for (size_t i = 0; i < grid.edges.size(); i++)
+    {
+        grid.edges[i].length *= scale(rng);
+        if (i % 7 == 0) grid.edges[i].directed = true;
+        if (i % 11 == 0) grid.edges[i].type = dg::Edge::EDGE_STAIR;
+    }
+    std::uniform_int_distribution<size_t> pick(0, grid.nodes.size() - 1);
+    queries.resize(n_queries);
+    for (size_t q = 0; q < n_queries; q++) queries[q] = std::make_pair(grid.nodes[pick(rng)].id, grid.nodes[pick(rng)].id);
+    VVS_CHECK_TRUE(hierarchy.build(grid));
+    VVS_CHECK_TRUE(finder.build(grid));
+    VVS_CHECK_TRUE(isSamePathHierarchy(grid, hierarchy, finder, queries));
+    VVS_CHECK_TRUE(hierarchy.build(grid, dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(finder.build(grid, dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(isSamePathHierarchy(grid, hierarchy, finder, queries));
+
+    // Check the overlay file (built with the wheelchair profile)
+    VVS_CHECK_TRUE(hierarchy.save(filename));
+    dg::ContractionHierarchy loaded;
+    VVS_CHECK_TRUE(loaded.load(filename, grid, dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(loaded.countArcs() == hierarchy.countArcs());
+    VVS_CHECK_TRUE(isSamePathHierarchy(grid, loaded, finder, queries));
+    VVS_CHECK_FALSE(loaded.load(filename, grid));           // A different cost function (the default profile)
+    VVS_CHECK_TRUE(loaded.getMap().isEmpty());
+    VVS_CHECK_FALSE(loaded.load(filename, sample, dg::RoadProfile::wheelchair())); // A different map
+    VVS_CHECK_FALSE(loaded.load("not_exist.dgch", grid, dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(loaded.getMap().isEmpty());
+    grid.version++;
+    VVS_CHECK_FALSE(loaded.load(filename, grid, dg::RoadProfile::wheelchair())); // A different version of the map
+    grid.version--;
+    grid.edges[0].length += 1;
+    VVS_CHECK_FALSE(loaded.load(filename, grid, dg::RoadProfile::wheelchair())); // Different lengths of the map
+    grid.edges[0].length -= 1;
+
+    // Check an overlay whose header claims more arcs than the file has
+    std::vector<char> bytes;
+    FILE* file = fopen(filename, "rb");
+    VVS_CHECK_TRUE(file != nullptr);
+    for (int c = fgetc(file); c != EOF; c = fgetc(file)) bytes.push_back(static_cast<char>(c));
+    fclose(file);
+    VVS_CHECK_TRUE(bytes.size() > sizeof(dg::ContractionHierarchy::Header));
+    dg::ContractionHierarchy::Header* header = reinterpret_cast<dg::ContractionHierarchy::Header*>(bytes.data());
+    header->n_arcs = 0x1000000000000000ULL;
+    file = fopen(filename, "wb");
+    VVS_CHECK_TRUE(file != nullptr);
+    fwrite(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+    VVS_CHECK_FALSE(loaded.load(filename, grid, dg::RoadProfile::wheelchair()));
+
+    // Check the overlay stored alongside the map file
+    std::string map_file = std::string(filename) + "_map.dgmap";
+    VVS_CHECK_TRUE(dg::MapFile::getOverlayFilename(map_file.c_str()) == std::string(filename) + "_map.dgch");
+    VVS_CHECK_TRUE(dg::MapFile::save(map_file.c_str(), grid, hierarchy));
+    dg::MapFile map_reader;
+    dg::Map map_loaded;
+    VVS_CHECK_TRUE(map_reader.open(map_file.c_str()) && map_reader.toMap(map_loaded));
+    VVS_CHECK_FALSE(dg::MapFile::loadOverlay(map_file.c_str(), map_loaded, loaded)); // Built with the wheelchair profile
+    VVS_CHECK_TRUE(dg::MapFile::loadOverlay(map_file.c_str(), map_loaded, loaded, dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(loaded.isBuilt(map_loaded));
+    VVS_CHECK_TRUE(isSamePathHierarchy(map_loaded, loaded, finder, queries));
+    map_reader.close();
+    remove(dg::MapFile::getOverlayFilename(map_file.c_str()).c_str());
+    remove(map_file.c_str());
+
+    return 0;
+}
+
+int testCoreContractionHierarchyBench(size_t rows = 200, size_t cols = 200, size_t n_queries = 2000, unsigned int seed = 2019)
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> scale(0.5, 2);
+    for (size_t i = 0; i < map.edges.size(); i++) map.edges[i].length *= scale(rng);
+
+    double time_start = getBenchTime();
+    dg::ContractionHierarchy hierarchy;
+    VVS_CHECK_TRUE(hierarchy.build(map));
+    double time_build = getBenchTime() - time_start;
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(finder.build(map));
+
+    std::uniform_int_distribution<size_t> pick(0, map.nodes.size() - 1);
+    std::vector<std::pair<dg::ID, dg::ID>> queries(n_queries);
+    for (size_t q = 0; q < n_queries; q++) queries[q] = std::make_pair(map.nodes[pick(rng)].id, map.nodes[pick(rng)].id);
+
+    // Benchmark queries of the path finder and the contraction hierarchy
+    double times[3], visits[3];
+    dg::Path path;
+    for (int method = 0; method < 3; method++)
+    {
+        size_t n_found = 0, n_visits = 0;
+        time_start = getBenchTime();
+        for (size_t q = 0; q < n_queries; q++)
+        {
+            bool found = (method < 2) ? finder.findPath(queries[q].first, queries[q].second, path, method) : hierarchy.findPath(queries[q].first, queries[q].second, path);
+            if (found) n_found++;
+            n_visits += (method < 2) ? finder.countVisits() : hierarchy.countVisits();
+        }
+        times[method] = (getBenchTime() - time_start) / n_queries;
+        visits[method] = double(n_visits) / n_queries;
+        VVS_CHECK_TRUE(n_found == n_queries);
+    }
+
+    printf("| Path query (%zd nodes, %zd queries) | Time [sec/query] | Visited nodes |\n", map.nodes.size(), n_queries);
+    printf("| ----------------------------------- | ---------------- | ------------- |\n");
+    printf("| Dijkstra                            | %.6f | %.0f |\n", times[0], visits[0]);
+    printf("| A*                                  | %.6f | %.0f |\n", times[1], visits[1]);
+    printf("| Contraction hierarchy               | %.6f | %.0f |\n", times[2], visits[2]);
+    printf("| (Preprocessing: %.3f sec, %zd arcs for %zd edges)\n", time_build, hierarchy.countArcs(), map.edges.size());
+
+    return 0;
+}
+
+/**
+ * @brief A cost function which blocks some edges (for comparing with a re-planner)
+ */
+struct BlockedPathCost
+{
+    double operator()(const dg::FrozenMap& map, size_t edge) const
+    {
+        if (blocked.count(map.edge_ids[edge]) > 0) return -1;
+        return base(map, edge);
+    }
+
+    dg::RoadProfile base;
+    std::set<dg::ID> blocked;
+};
+
+int testCorePathReplanner(size_t rows = 30, size_t cols = 30, size_t n_moves = 200, unsigned int seed = 2019)
+{
+    // An example map
+    // 2 --- 3 --- 5 --> 6
+    // |     |     |     |
+    // |     |     |     |
+    // 1 --- 4     7 --- 8
+    dg::Map map;
+    map.addNode(dg::Node(1, 0, 0));
+    map.addNode(dg::Node(2, 0, 1));
+    map.addNode(dg::Node(3, 1, 1));
+    map.addNode(dg::Node(4, 1, 0));
+    map.addNode(dg::Node(5, 2, 1));
+    map.addNode(dg::Node(6, 3, 1));
+    map.addNode(dg::Node(7, 2, 0));
+    map.addNode(dg::Node(8, 3, 0));
+    map.addEdge(1, 2, dg::Edge(12, 1.2));
+    map.addEdge(1, 4, dg::Edge(14));
+    map.addEdge(2, 3, dg::Edge(23));
+    map.addEdge(3, 4, dg::Edge(34));
+    map.addEdge(3, 5, dg::Edge(35));
+    map.addEdge(5, 6, dg::Edge(56, 1, dg::Edge::EDGE_CROSSWALK, true));
+    map.addEdge(5, 7, dg::Edge(57));
+    map.addEdge(6, 8, dg::Edge(68));
+    map.addEdge(7, 8, dg::Edge(78));
+
+    // Check re-planning with moving starts and blocked edges
+    dg::PathReplanner replanner;
+    dg::Path path;
+    double cost = -1, length = -1;
+    VVS_CHECK_TRUE(replanner.build(map));
+    VVS_CHECK_FALSE(replanner.findPath(1, path));   // No goal
+    VVS_CHECK_TRUE(replanner.setGoal(6));
+    VVS_CHECK_TRUE(replanner.getGoal() == 6);
+    VVS_CHECK_TRUE(replanner.findPath(1, path, &cost));
+    VVS_CHECK_TRUE(path.pts.size() == 5 && path.pts[1].node_id == 4 && path.pts[3].edge_id == 56 && path.pts.back().edge_id == 0);
+    VVS_CHECK_TRUE(isValidPath(map, path, length) && length == 4 && cost == 4);
+    VVS_CHECK_TRUE(replanner.findPath(2, path, &cost));
+    VVS_CHECK_TRUE(path.pts.size() == 4 && cost == 3);
+    VVS_CHECK_TRUE(replanner.blockEdge(56));
+    VVS_CHECK_TRUE(replanner.findPath(2, path, &cost));
+    VVS_CHECK_TRUE(isValidPath(map, path, length) && length == 5 && cost == 5); // Detour through 7 and 8
+    VVS_CHECK_TRUE(replanner.blockEdge(78));
+    VVS_CHECK_FALSE(replanner.findPath(2, path));
+    VVS_CHECK_TRUE(replanner.restoreEdge(56));
+    VVS_CHECK_TRUE(replanner.findPath(1, path, &cost));
+    VVS_CHECK_TRUE(cost == 4);
+    VVS_CHECK_TRUE(replanner.setEdgeCost(34, 0.5));     // Cheaper than the heuristic allows
+    VVS_CHECK_TRUE(replanner.findPath(1, path, &cost));
+    VVS_CHECK_TRUE(cost == 3.5);
+    VVS_CHECK_FALSE(replanner.blockEdge(99));
+    VVS_CHECK_FALSE(replanner.findPath(9, path));
+
+    // Check blocked edges which are kept after building again
+    VVS_CHECK_TRUE(replanner.blockEdge(56));
+    VVS_CHECK_TRUE(replanner.getBlockedEdges().size() == 2);
+    VVS_CHECK_TRUE(replanner.build(map));
+    VVS_CHECK_TRUE(replanner.setGoal(6));
+    VVS_CHECK_FALSE(replanner.findPath(2, path));   // 56 and 78 are still blocked
+    VVS_CHECK_TRUE(replanner.restoreEdge(56) && replanner.restoreEdge(78));
+    VVS_CHECK_TRUE(replanner.getBlockedEdges().empty());
+    VVS_CHECK_TRUE(replanner.findPath(2, path, &cost));
+    VVS_CHECK_TRUE(cost == 3);
+
+    // Check the map which is modified after building
+    dg::Map copy = map;
+    VVS_CHECK_TRUE(replanner.isBuilt(map) && replanner.isBuilt(copy));
+    copy.addNode(dg::Node(9, 4, 0));
+    VVS_CHECK_FALSE(replanner.isBuilt(copy));
+
+    // Check the same cost with Dijkstra's algorithm on a grid map while moving and blocking
+    dg::Map grid = genBenchGridMap(rows, cols);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> scale(0.5, 2);
+    for (size_t i = 0; i < grid.edges.size(); i++)
+    {
+        grid.edges[i].length *= scale(rng);
+        if (i % 7 == 0) grid.edges[i].directed = true;
+    }
+    std::uniform_int_distribution<size_t> pick(0, grid.nodes.size() - 1);
+    BlockedPathCost blocked_cost;
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(replanner.build(grid));
+    VVS_CHECK_TRUE(replanner.setGoal(grid.nodes[pick(rng)].id));
+    bool is_same = true, is_valid = true;
+    for (size_t m = 0; m < n_moves; m++)
+    {
+        dg::ID start = grid.nodes[pick(rng)].id;
+        dg::Path expected;
+        double cost_expected = 0;
+        bool found = replanner.findPath(start, path, &cost);
+        VVS_CHECK_TRUE(finder.build(grid, blocked_cost));
+        bool found_expected = finder.findPath(start, replanner.getGoal(), expected, dg::PathFinder::SEARCH_DIJKSTRA, &cost_expected);
+        is_same &= (found == found_expected) && (!found || fabs(cost - cost_expected) < 1e-6);
+        if (found) is_valid &= isValidPath(grid, path, length) && fabs(length - cost) < 1e-6 && path.pts.front().node_id == start;
+
+        // Block or restore an edge on the current path
+        if (found && path.pts.size() > 1 && m % 3 != 2)
+        {
+            dg::ID edge = path.pts[path.pts.size() / 2 - 1].edge_id;
+            VVS_CHECK_TRUE(replanner.blockEdge(edge));
+            blocked_cost.blocked.insert(edge);
+        }
+        else if (!blocked_cost.blocked.empty())
+        {
+            dg::ID edge = *blocked_cost.blocked.begin();
+            VVS_CHECK_TRUE(replanner.restoreEdge(edge));
+            blocked_cost.blocked.erase(edge);
+        }
+    }
+    VVS_CHECK_TRUE(is_same);
+    VVS_CHECK_TRUE(is_valid);
+
+    return 0;
+}
+
+int testCorePathReplannerBench(size_t rows = 200, size_t cols = 200, size_t n_replans = 200, unsigned int seed = 2019)
+{
+    dg::Map map = genBenchGridMap(rows, cols);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> scale(0.5, 2);
+    for (size_t i = 0; i < map.edges.size(); i++) map.edges[i].length *= scale(rng);
+
+    // Plan the initial path between two corners
+    dg::PathReplanner replanner;
+    dg::PathFinder finder;
+    VVS_CHECK_TRUE(replanner.build(map));
+    VVS_CHECK_TRUE(finder.build(map));
+    dg::ID start = map.nodes.front().id, goal = map.nodes.back().id;
+    dg::Path path;
+    double time_start = getBenchTime();
+    VVS_CHECK_TRUE(replanner.setGoal(goal));
+    VVS_CHECK_TRUE(replanner.findPath(start, path));
+    double time_initial = getBenchTime() - time_start;
+    size_t visits_initial = replanner.countVisits();
+
+    // Benchmark re-planning when the robot leaves the path (moving to a neighbor which is not on the path)
+    double time_oop = 0, time_astar = 0;
+    size_t visits_oop = 0, n_oop = 0;
+    for (size_t r = 0; r < n_replans && path.pts.size() > 2; r++)
+    {
+        const dg::Node* node = map.findNode(path.pts[1].node_id);
+        dg::ID next = path.pts[2].node_id, off = 0;
+        for (auto id = node->edge_ids.begin(); id != node->edge_ids.end() && off == 0; id++)
+        {
+            const dg::Edge* edge = map.findEdge(*id);
+            dg::ID other = (edge->node_id1 == node->id) ? edge->node_id2 : edge->node_id1;
+            if (other != next && other != path.pts[0].node_id) off = other;
+        }
+        if (off == 0) off = next;
+
+        time_start = getBenchTime();
+        bool ok = replanner.findPath(off, path);
+        time_oop += getBenchTime() - time_start;
+        visits_oop += replanner.countVisits();
+        n_oop++;
+
+        dg::Path scratch;
+        time_start = getBenchTime();
+        VVS_CHECK_TRUE(finder.findPath(off, goal, scratch, dg::PathFinder::SEARCH_ASTAR) == ok);
+        time_astar += getBenchTime() - time_start;
+        if (!ok) break;
+    }
+
+    // Benchmark re-planning when an edge on the path is blocked
+    VVS_CHECK_TRUE(replanner.findPath(start, path));
+    double time_blocked = 0;
+    size_t visits_blocked = 0, n_blocked = 0;
+    for (size_t r = 0; r < n_replans && path.pts.size() > 1; r++)
+    {
+        VVS_CHECK_TRUE(replanner.blockEdge(path.pts[path.pts.size() / 2].edge_id));
+        time_start = getBenchTime();
+        bool ok = replanner.findPath(start, path);
+        time_blocked += getBenchTime() - time_start;
+        visits_blocked += replanner.countVisits();
+        n_blocked++;
+        if (!ok) break;
+    }
+
+    printf("| Re-planning (%zd nodes) | Time [sec/query] | Visited nodes |\n", map.nodes.size());
+    printf("| ---------------------- | ---------------- | ------------- |\n");
+    printf("| Initial planning       | %.6f | %zd |\n", time_initial, visits_initial);
+    printf("| A* from scratch (OOP)  | %.6f | - |\n", time_astar / std::max(n_oop, size_t(1)));
+    printf("| D* Lite (OOP)          | %.6f | %.0f |\n", time_oop / std::max(n_oop, size_t(1)), double(visits_oop) / std::max(n_oop, size_t(1)));
+    printf("| D* Lite (blocked edge) | %.6f | %.0f |\n", time_blocked / std::max(n_blocked, size_t(1)), double(visits_blocked) / std::max(n_blocked, size_t(1)));
+
+    return 0;
+}
+
+#endif // End of '__TEST_CORE_MAP__'
@@ -3,6 +3,9 @@
 
 #include "vvs.h"
 #include "dg_localizer.hpp"
+#include "test_core_map.hpp"
+#include <atomic>
+#include <thread>
 
 int testLocEKFGPS(double gps_noise = 0.3, const dg::Polar2& gps_offset = dg::Polar2(1, 0), double interval = 0.1, double velocity = 1)
 {
@@ -98,4 +101,415 @@ int testLocEKFLocClue(const dg::Polar2 obs_noise = dg::Polar2(0.3, 0.1), const d
     return 0;
 }
 
+int testLocEKFLocClueBatch(const dg::Polar2 obs_noise = dg::Polar2(0.3, 0.1), int n_clues = 4)
+{
+    // Prepare a map with landmarks around the pose
+    dg::RoadMap map;
+    std::vector<dg::ID> ids;
+    for (int i = 0; i < n_clues; i++)
+    {
+        dg::ID id = 100 + i;
+        double angle = CV_PI * i / n_clues;
+        if (!map.addNode(dg::Point2ID(id, 10 + 8 * cos(angle), 1 + 8 * sin(angle)))) return -1;
+        ids.push_back(id);
+    }
+    const dg::Pose2 truth(10, 1, 0.1);
+    std::vector<dg::Polar2> obs;
+    for (int i = 0; i < n_clues; i++)
+    {
+        dg::Point2 p = map.getNode(ids[i])->data;
+        double dx = p.x - truth.x, dy = p.y - truth.y;
+        obs.push_back(dg::Polar2(sqrt(dx * dx + dy * dy) + 0.1 * (i - 1), cx::trimRad(atan2(dy, dx) - truth.theta) + 0.01 * (i - 1)));
+    }
+    dg::EKFLocalizer localizer[3];
+    for (int k = 0; k < 3; k++)
+    {
+        VVS_CHECK_TRUE(localizer[k].loadMap(map));
+        VVS_CHECK_TRUE(localizer[k].setParamLocClueNoise(obs_noise.lin, obs_noise.ang));
+        VVS_CHECK_TRUE(localizer[k].applyPosition(truth, 0.1));
+    }
+
+    // Check independence of the order of clues
+    std::vector<dg::ID> ids_rev(ids.rbegin(), ids.rend());
+    std::vector<dg::Polar2> obs_rev(obs.rbegin(), obs.rend());
+    VVS_CHECK_TRUE(localizer[0].applyLocClue(ids, obs, 0.2));
+    VVS_CHECK_TRUE(localizer[1].applyLocClue(ids_rev, obs_rev, 0.2));
+    cv::Mat state0 = localizer[0].getState(), state1 = localizer[1].getState();
+    for (int r = 0; r < 5; r++) VVS_CHECK_RANGE(state0.at<double>(r), state1.at<double>(r), 1e-9);
+
+    // Check skipping invalid, unknown, and outlier clues
+    std::vector<dg::ID> ids_bad = ids;
+    std::vector<dg::Polar2> obs_bad = obs;
+    ids_bad.insert(ids_bad.begin(), 3335);                          // Unknown
+    obs_bad.insert(obs_bad.begin(), obs.front());
+    ids_bad.insert(ids_bad.begin() + 2, ids.back());                // Outlier
+    obs_bad.insert(obs_bad.begin() + 2, dg::Polar2(obs.back().lin + 10, obs.back().ang));
+    ids_bad.push_back(ids.front());                                 // Invalid
+    obs_bad.push_back(dg::Polar2(-1, CV_PI));
+    VVS_CHECK_TRUE(localizer[2].applyLocClue(ids_bad, obs_bad, 0.2));
+    cv::Mat state2 = localizer[2].getState();
+    for (int r = 0; r < 5; r++) VVS_CHECK_RANGE(state0.at<double>(r), state2.at<double>(r), 1e-9);
+    VVS_CHECK_TRUE(!localizer[2].applyLocClue(std::vector<dg::ID>(1, 3335), std::vector<dg::Polar2>(1, obs.front()), 0.3));
+    VVS_CHECK_TRUE(!localizer[2].applyLocClue(ids, std::vector<dg::Polar2>(), 0.3));
+
+    // Check more clues than a stacked measurement
+    std::vector<dg::ID> ids_many;
+    std::vector<dg::Polar2> obs_many;
+    for (int i = 0; i < dg::EKFLocalizer::MAX_LOC_CLUES + 3; i++)
+    {
+        ids_many.push_back(ids[i % n_clues]);
+        obs_many.push_back(obs[i % n_clues]);
+    }
+    VVS_CHECK_TRUE(localizer[0].applyLocClue(ids_many, obs_many, 0.3));
+    dg::Pose2 pose = localizer[0].getPose();
+    double dx0 = state0.at<double>(0) - truth.x, dy0 = state0.at<double>(1) - truth.y;
+    VVS_CHECK_TRUE((pose.x - truth.x) * (pose.x - truth.x) + (pose.y - truth.y) * (pose.y - truth.y) < dx0 * dx0 + dy0 * dy0);
+
+    return 0;
+}
+
+/**
+ * @brief The EKF localizer with the previous loc-clue update (a full prediction and correction for each clue)
+ */
+class SequentialLocClueEKFLocalizer : public dg::EKFLocalizer
+{
+public:
+    bool applyLocClueSequential(dg::ID node_id, const dg::Polar2& obs, dg::Timestamp time)
+    {
+        cv::AutoLock lock(m_mutex);
+        dg::RoadMap::Node* node = m_map.getNode(dg::Point2ID(node_id));
+        if (node == nullptr) return false;
+
+        double interval = 0;
+        if (m_time_last_update > 0) interval = time - m_time_last_update;
+        bool predicted = (interval > m_threshold_time) && predict(ControlVec(interval), 1);
+        if (obs.lin > m_threshold_dist && obs.ang < CV_PI && correct(MeasureVec(obs.lin, obs.ang, node->data.x, node->data.y), 4))
+        {
+            m_state_vec(2) = cx::trimRad(m_state_vec(2));
+            m_time_last_update = time;
+            publishPose(time);
+            return true;
+        }
+        if (predicted) publishPose();
+        return false;
+    }
+};
+
+int testLocEKFLocClueBatchBench(int n_frames = 10000, int n_clues = 4, double interval = 0.1)
+{
+    dg::RoadMap map;
+    std::vector<dg::ID> ids;
+    for (int i = 0; i < n_clues; i++)
+    {
+        dg::ID id = 100 + i;
+        if (!map.addNode(dg::Point2ID(id, 10 * i, 10))) return -1;
+        ids.push_back(id);
+    }
+
+    const int n_methods = 2;
+    const char* names[] = { "A clue at a time (previous)", "Stacked clues" };
+    printf("| Loc-clue update (%d frames with %d clues) | Time [sec] | Frames/sec |\n", n_frames, n_clues);
+    printf("| ----------------------------------------- | ---------- | ---------- |\n");
+    for (int method = 0; method < n_methods; method++)
+    {
+        SequentialLocClueEKFLocalizer localizer;
+        VVS_CHECK_TRUE(localizer.loadMap(map));
+        VVS_CHECK_TRUE(localizer.applyPosition(dg::Point2(0, 0), interval));
+        double time_start = getBenchTime();
+        for (int f = 1; f <= n_frames; f++)
+        {
+            double t = (f + 1) * interval;
+            std::vector<dg::Polar2> obs;
+            for (int i = 0; i < n_clues; i++)
+            {
+                dg::Point2 p = map.getNode(ids[i])->data;
+                obs.push_back(dg::Polar2(sqrt(p.x * p.x + p.y * p.y), atan2(p.y, p.x)));
+            }
+            if (method == 0)
+            {
+                for (int i = 0; i < n_clues; i++) localizer.applyLocClueSequential(ids[i], obs[i], t);
+            }
+            else localizer.applyLocClue(ids, obs, t);
+        }
+        double time_total = getBenchTime() - time_start;
+        printf("| %-41s | %.6f | %.0f |\n", names[method], time_total, n_frames / time_total);
+    }
+    return 0;
+}
+
+/**
+ * @brief The previous EKF localizer based on cv::Mat (only for the velocity control input, GPS, and landmark observation)
+ */
+class LegacyEKFLocalizer : public cx::EKF
+{
+public:
+    LegacyEKFLocalizer()
+    {
+        m_noise_motion = cv::Mat::eye(2, 2, CV_64F);
+        m_noise_gps = cv::Mat::eye(2, 2, CV_64F);
+        m_noise_loc_clue = cv::Mat::eye(4, 4, CV_64F);
+        initialize(cv::Mat::zeros(5, 1, CV_64F), cv::Mat::eye(5, 5, CV_64F));
+    }
+
+protected:
+    virtual cv::Mat transitFunc(const cv::Mat& state, const cv::Mat& control, cv::Mat& jacobian, cv::Mat& noise)
+    {
+        // The control input: [ dt, v_c, w_c ]
+        const double dt = control.at<double>(0);
+        const double x = state.at<double>(0), y = state.at<double>(1), theta = state.at<double>(2);
+        const double v = control.at<double>(1), w = control.at<double>(2);
+        const double vt = v * dt, wt = w * dt;
+        const double c = cos(theta + wt / 2), s = sin(theta + wt / 2);
+        cv::Mat func = (cv::Mat_<double>(5, 1) <<
+            x + vt * c,
+            y + vt * s,
+            theta + wt,
+            v,
+            w);
+        jacobian = (cv::Mat_<double>(5, 5) <<
+            1, 0, -vt * s, 0, 0,
+            0, 1,  vt * c, 0, 0,
+            0, 0,       1, 0, 0,
+            0, 0,       0, 0, 0,
+            0, 0,       0, 0, 0);
+        cv::Mat W = (cv::Mat_<double>(5, 2) <<
+            dt * c, -vt * dt * s / 2,
+            dt * s,  vt * dt * c / 2,
+            0, dt,
+            1, 0,
+            0, 1);
+        noise = W * m_noise_motion * W.t();
+        return func;
+    }
+
+    virtual cv::Mat observeFunc(const cv::Mat& state, const cv::Mat& measure, cv::Mat& jacobian, cv::Mat& noise)
+    {
+        const double x = state.at<double>(0), y = state.at<double>(1), theta = state.at<double>(2);
+        cv::Mat func;
+        if (measure.rows == 2)
+        {
+            // Measurement: [ x_{GPS}, y_{GPS} ]
+            func = (cv::Mat_<double>(2, 1) << x, y);
+            jacobian = (cv::Mat_<double>(2, 5) <<
+                1, 0, 0, 0, 0,
+                0, 1, 0, 0, 0);
+            noise = m_noise_gps;
+        }
+        else
+        {
+            // Measurement: [ rho_{id}, phi_{id}, x_{id}, y_{id} ]
+            const double dx = measure.at<double>(2) - x;
+            const double dy = measure.at<double>(3) - y;
+            const double r = sqrt(dx * dx + dy * dy);
+            func = (cv::Mat_<double>(4, 1) <<
+                r,
+                cx::trimRad(atan2(dy, dx) - theta),
+                measure.at<double>(2),
+                measure.at<double>(3));
+            jacobian = (cv::Mat_<double>(4, 5) <<
+               -2 * dx / r, -2 * dy / r,  0, 0, 0,
+                dy / r / r, -dx / r / r, -1, 0, 0,
+                0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0);
+            noise = m_noise_loc_clue;
+        }
+        return func;
+    }
+
+    cv::Mat m_noise_motion;
+
+    cv::Mat m_noise_gps;
+
+    cv::Mat m_noise_loc_clue;
+};
+
+int testLocEKFFixed(int n_steps = 100, double interval = 0.1, unsigned int seed = 2019)
+{
+    // Check the linear solver using Cholesky decomposition
+    cv::Matx33d A(4, 2, 0, 2, 5, 0, 0, 0, 0);                         // The last row and column are zero
+    cv::Matx<double, 3, 1> b(2, 1, 7);
+    VVS_CHECK_TRUE(cx::solveCholesky(A, b));
+    VVS_CHECK_RANGE(b(0), 0.5, 1e-12);
+    VVS_CHECK_RANGE(b(1), 0, 1e-12);
+    VVS_CHECK_EQUL(b(2), 0);
+    cv::Matx22d B(1, 2, 2, 1);                                          // Not positive semi-definite
+    cv::Matx<double, 2, 1> c(1, 1);
+    VVS_CHECK_TRUE(!cx::solveCholesky(B, c));
+
+    // Compare the fixed-size EKF with the previous EKF
+    dg::EKFLocalizer fixed;
+    LegacyEKFLocalizer legacy;
+    cv::RNG rng(seed);
+    const dg::Point2 landmark(15, 1);
+    for (int i = 1; i <= n_steps; i++)
+    {
+        double t = i * interval;
+        double v = 1 + rng.gaussian(0.1), w = rng.gaussian(0.1);
+        VVS_CHECK_TRUE(fixed.predict(dg::EKFLocalizer::ControlVec(interval, v, w), 3));
+        VVS_CHECK_TRUE(legacy.predict(cv::Vec3d(interval, v, w)));
+        dg::Point2 gps(t + rng.gaussian(0.3), 1 + rng.gaussian(0.3));
+        VVS_CHECK_TRUE(fixed.correct(dg::EKFLocalizer::MeasureVec(gps.x, gps.y), 2));
+        VVS_CHECK_TRUE(legacy.correct(cv::Vec2d(gps.x, gps.y)));
+        if (i % 10 == 0)
+        {
+            double dx = landmark.x - t, dy = landmark.y - 1;
+            dg::Polar2 obs(sqrt(dx * dx + dy * dy) + rng.gaussian(0.3), atan2(dy, dx) + rng.gaussian(0.1));
+            VVS_CHECK_TRUE(fixed.correct(dg::EKFLocalizer::MeasureVec(obs.lin, obs.ang, landmark.x, landmark.y), 4));
+            VVS_CHECK_TRUE(legacy.correct(cv::Vec4d(obs.lin, obs.ang, landmark.x, landmark.y)));
+        }
+    }
+    cv::Mat state_f = fixed.getState(), state_l = legacy.getState();
+    cv::Mat cov_f = fixed.getStateCov(), cov_l = legacy.getStateCov();
+    double max_diff = 0;
+    for (int r = 0; r < 5; r++)
+    {
+        max_diff = std::max(max_diff, fabs(state_f.at<double>(r) - state_l.at<double>(r)));
+        for (int c = 0; c < 5; c++)
+            max_diff = std::max(max_diff, fabs(cov_f.at<double>(r, c) - cov_l.at<double>(r, c)));
+    }
+    VVS_CHECK_TRUE(max_diff < 1e-9);
+
+    return 0;
+}
+
+int testLocEKFFixedBench(int n_updates = 100000, double interval = 0.1)
+{
+    // Benchmark the previous EKF based on cv::Mat
+    LegacyEKFLocalizer legacy;
+    double time_start = getBenchTime();
+    for (int i = 1; i <= n_updates; i++)
+    {
+        legacy.predict(cv::Vec3d(interval, 1, 0));
+        legacy.correct(cv::Vec2d(i * interval, 1));
+    }
+    double time_legacy = getBenchTime() - time_start;
+
+    // Benchmark the fixed-size EKF
+    dg::EKFLocalizer fixed;
+    time_start = getBenchTime();
+    for (int i = 1; i <= n_updates; i++)
+    {
+        fixed.predict(dg::EKFLocalizer::ControlVec(interval, 1, 0), 3);
+        fixed.correct(dg::EKFLocalizer::MeasureVec(i * interval, 1), 2);
+    }
+    double time_fixed = getBenchTime() - time_start;
+    VVS_CHECK_RANGE(fixed.getState().at<double>(0), legacy.getState().at<double>(0), 1e-6);
+
+    printf("| EKF (%d predictions and GPS corrections) | Time [sec] | Updates/sec |\n", n_updates);
+    printf("| ----------------------------------------- | ---------- | ----------- |\n");
+    printf("| cv::Mat with SVD inversion (previous)     | %.6f | %.0f |\n", time_legacy, n_updates / time_legacy);
+    printf("| cv::Matx with Cholesky decomposition      | %.6f | %.0f |\n", time_fixed, n_updates / time_fixed);
+    return 0;
+}
+
+int testLocPoseSnapshot(int n_updates = 20000)
+{
+    dg::RoadMap map;
+    if (!map.addNode(dg::Point2ID(1, 0, 0))) return -1;
+    if (!map.addNode(dg::Point2ID(2, 100, 0))) return -1;
+    if (!map.addRoad(1, 2)) return -1;
+
+    // Check snapshots of the EKF localizer
+    dg::EKFLocalizer ekf;
+    VVS_CHECK_TRUE(ekf.loadMap(map));
+    dg::PoseSnapshot snap0 = ekf.getPoseSnapshot();
+    VVS_CHECK_TRUE(snap0.seq > 0);
+    VVS_CHECK_TRUE(ekf.applyPosition(dg::Point2(10, 1), 0.1));
+    VVS_CHECK_TRUE(ekf.applyPosition(dg::Point2(11, 1), 0.2));
+    dg::PoseSnapshot snap1 = ekf.getPoseSnapshot();
+    VVS_CHECK_TRUE(snap1.seq == snap0.seq + 2);
+    VVS_CHECK_EQUL(snap1.time, 0.2);
+    VVS_CHECK_TRUE(snap1.pose.x == ekf.getPose().x && snap1.pose.y == ekf.getPose().y);
+    VVS_CHECK_TRUE(snap1.confidence == ekf.getPoseConfidence());
+    VVS_CHECK_TRUE(snap1.topo.node_id == 1 && snap1.topo.edge_idx == 0);
+    VVS_CHECK_TRUE(snap1.pose_cov(0, 0) > 0 && snap1.pose_cov(1, 1) > 0);
+    VVS_CHECK_TRUE(snap0.seq < snap1.seq && snap0.time < 0);        // The old snapshot is not changed
+    VVS_CHECK_TRUE(ekf.initialize(cv::Mat::zeros(5, 1, CV_64F)));
+    VVS_CHECK_TRUE(ekf.getPoseSnapshot().pose.x == 0 && ekf.getPoseSnapshot().time == 0.2);
+
+    // Check snapshots after the state is assigned directly
+    VVS_CHECK_TRUE(ekf.setState(cv::Vec<double, 5>(20, 1, 0, 0, 0)));
+    VVS_CHECK_TRUE(ekf.getPose().x == 20 && ekf.getPose().y == 1);
+    VVS_CHECK_TRUE(ekf.getPoseTopometric().node_id == 1);
+    double conf_prev = ekf.getPoseConfidence();
+    VVS_CHECK_TRUE(ekf.setStateCov(0.01 * dg::EKFLocalizer::StateCov::eye()));
+    VVS_CHECK_TRUE(ekf.getPoseConfidence() > conf_prev);
+
+    // Check consistency of snapshots while they are updated by another thread
+    dg::SimpleLocalizer simple;
+    VVS_CHECK_TRUE(simple.loadMap(map));
+    std::atomic<bool> done(false);
+    int n_errors = 0, n_reads = 0;
+    std::thread reader([&simple, &done, &n_errors, &n_reads]()
+    {
+        uint64_t seq_prev = 0;
+        while (!done)
+        {
+            dg::PoseSnapshot snap = simple.getPoseSnapshot();
+            if (snap.seq < seq_prev) n_errors++;                            // Never go back
+            if (snap.time >= 0 && (snap.pose.x != snap.time || snap.pose.y != 2 * snap.time)) n_errors++;
+            seq_prev = snap.seq;
+            n_reads++;
+        }
+    });
+    for (int i = 1; i <= n_updates; i++)
+        simple.applyPosition(dg::Point2(i, 2 * i), i);
+    done = true;
+    reader.join();
+    VVS_CHECK_TRUE(n_errors == 0);
+    VVS_CHECK_TRUE(n_reads > 0);
+    VVS_CHECK_EQUL(simple.getPose().x, n_updates);
+    VVS_CHECK_TRUE(simple.getPoseTopometric().node_id != 0);
+
+    return 0;
+}
+
+/**
+ * @brief An EKF localizer which also provides the previous pose accessor (locking the localizer)
+ */
+class LockedEKFLocalizer : public dg::EKFLocalizer
+{
+public:
+    dg::Pose2 getPoseLocked()
+    {
+        cv::AutoLock lock(m_mutex);
+        return getStatePose();
+    }
+};
+
+int testLocPoseSnapshotBench(double duration = 1, double interval = 0.01)
+{
+    const int n_methods = 2;
+    const char* names[] = { "Locked state (previous)", "Pose snapshot" };
+    printf("| Pose reader (%.0f sec with GPS updates) | Reads | Updates | Read time [usec] |\n", duration);
+    printf("| ------------------------------------ | ----- | ------- | ---------------- |\n");
+    for (int method = 0; method < n_methods; method++)
+    {
+        // Update the pose by a writer while a reader gets the pose
+        LockedEKFLocalizer localizer;
+        std::atomic<bool> done(false);
+        size_t n_reads = 0;
+        double time_reads = 0;
+        std::thread reader([&localizer, &done, &n_reads, &time_reads, method]()
+        {
+            double time_start = getBenchTime();
+            while (!done)
+            {
+                dg::Pose2 pose = (method == 0) ? localizer.getPoseLocked() : localizer.getPose();
+                if (pose.x >= 0) n_reads++;
+            }
+            time_reads = getBenchTime() - time_start;
+        });
+        size_t n_updates = 0;
+        double time_start = getBenchTime();
+        for (double t = interval; getBenchTime() - time_start < duration; t += interval, n_updates++)
+            localizer.applyPosition(dg::Point2(t, 1), t);
+        done = true;
+        reader.join();
+        VVS_CHECK_TRUE(n_reads > 0 && n_updates > 0);
+        printf("| %-36s | %zd | %zd | %.3f |\n", names[method], n_reads, n_updates, time_reads / n_reads * 1e6);
+    }
+    return 0;
+}
+
 #endif // End of '__TEST_LOCALIZER_EKF__'
@@ -5,14 +5,15 @@
 #include "localizer/directed_graph.hpp"
 #include <string>
 
-typedef dg::DirectedGraph<std::string, int> FamilyTree;
-
+template<typename S = dg::ListStorage>
 int testDirectedGraphPtr(const char* file = "test_directed_graph.txt")
 {
+    typedef dg::DirectedGraph<std::string, int, S> FamilyTree;
+
     // Build a family tree
     FamilyTree family;
     VVS_CHECK_TRUE(family.addNode("Dangeun") != nullptr);
-    FamilyTree::Node* person[] =
+    typename FamilyTree::Node* person[] =
     {
         /* 0 */ family.addNode("CY"),
         /* 1 */ family.addNode("GY"),
@@ -44,6 +45,11 @@ int testDirectedGraphPtr(const char* file = "test_directed_graph.txt")
     VVS_CHECK_TRUE(family.getEdge("CS", "CY") == nullptr);
     VVS_CHECK_TRUE(family.getEdge(person[0], person[1]) != nullptr);
     VVS_CHECK_TRUE(family.getEdge(person[1], person[0]) != nullptr);
+    VVS_CHECK_EQUL(family.countInEdges(person[0]), 1);
+    VVS_CHECK_EQUL(family.countInEdges(person[3]), 2);
+    VVS_CHECK_TRUE(family.removeEdge(person[6], person[3]));
+    VVS_CHECK_EQUL(family.countInEdges(person[3]), 1);
+    VVS_CHECK_TRUE(family.addEdge(person[6], person[3], 0) != nullptr);
 
     // Check connectivities
     VVS_CHECK_EQUL(family.getEdgeCost(person[3], person[8]), 1);
@@ -52,25 +58,32 @@ int testDirectedGraphPtr(const char* file = "test_directed_graph.txt")
     VVS_CHECK_TRUE(family.isConnected(person[2], person[5]) == false);
 
     // Add and remove edges and nodes
-    FamilyTree::Node* gf = family.addNode("Grand Father");
-    FamilyTree::Node* gm = family.addNode("Grand Mother");
+    typename FamilyTree::Node* gf = family.addNode("Grand Father");
+    typename FamilyTree::Node* gm = family.addNode("Grand Mother");
     VVS_CHECK_TRUE(family.addEdge(gf, gm, 0) != nullptr);
     VVS_CHECK_TRUE(family.addEdge(gm, gf, 0) != nullptr);
     VVS_CHECK_TRUE(family.addEdge(gf, person[0], 1) != nullptr);
     VVS_CHECK_EQUL(family.countEdges(gf), 2);
     VVS_CHECK_EQUL(family.countEdges(gm), 1);
+    VVS_CHECK_EQUL(family.countInEdges(person[0]), 2);
     VVS_CHECK_TRUE(family.removeNode(gf));
     VVS_CHECK_EQUL(family.countEdges(gm), 0);
+    VVS_CHECK_EQUL(family.countInEdges(gm), 0);
+    VVS_CHECK_EQUL(family.countInEdges(person[0]), 1);
+    VVS_CHECK_TRUE(*family.getHeadInNodeConst(person[0]) == person[1]);
+    VVS_CHECK_TRUE(family.getNode("Grand Father") == nullptr);
     VVS_CHECK_TRUE(family.removeNode(gm));
     VVS_CHECK_TRUE(family.removeNode(family.getNode("Dangeun")));
+    VVS_CHECK_TRUE(family.getNode("CY") == person[0]);
+    VVS_CHECK_TRUE(family.getNode("CW") == person[9]);
 
     // Write the family to the file
     FILE* fid = fopen(file, "wt");
     VVS_CHECK_TRUE(fid != nullptr);
-    for (FamilyTree::NodeItrConst node = family.getHeadNodeConst(); node != family.getTailNodeConst(); node++)
+    for (typename FamilyTree::NodeItrConst node = family.getHeadNodeConst(); node != family.getTailNodeConst(); node++)
     {
         fprintf(fid, "* Node: %s\n", node->data.c_str());
-        for (FamilyTree::EdgeItrConst edge = family.getHeadEdgeConst(node); edge != family.getTailEdgeConst(node); edge++)
+        for (typename FamilyTree::EdgeItrConst edge = family.getHeadEdgeConst(node); edge != family.getTailEdgeConst(node); edge++)
             fprintf(fid, "  Is connected to %s (%s)\n", edge->to->data.c_str(), (edge->cost > 0) ? "Child" : "Marriage");
     }
     fclose(fid);
@@ -83,8 +96,11 @@ int testDirectedGraphPtr(const char* file = "test_directed_graph.txt")
     return 0;
 }
 
+template<typename S = dg::ListStorage>
 int testDirectedGraphItr()
 {
+    typedef dg::DirectedGraph<std::string, int, S> FamilyTree;
+
     // Build a family tree
     FamilyTree family;
     VVS_CHECK_TRUE(family.addNode("CS") != nullptr);
@@ -97,43 +113,43 @@ int testDirectedGraphItr()
     VVS_CHECK_TRUE(family.addEdge("CS", "CW", 1) != nullptr);
 
     // Test const_iterators
-    FamilyTree::NodeItrConst const_cs = family.getNodeConst("CS");
-    FamilyTree::NodeItrConst const_lk = family.getNodeConst("LK");
-    FamilyTree::NodeItrConst const_cj = family.getNodeConst("CJ");
-    FamilyTree::NodeItrConst const_cw = family.getNodeConst("CW");
+    typename FamilyTree::NodeItrConst const_cs = family.getNodeConst("CS");
+    typename FamilyTree::NodeItrConst const_lk = family.getNodeConst("LK");
+    typename FamilyTree::NodeItrConst const_cj = family.getNodeConst("CJ");
+    typename FamilyTree::NodeItrConst const_cw = family.getNodeConst("CW");
 
     VVS_CHECK_TRUE(const_cs != family.getTailNodeConst() && const_cs->data == "CS");
     VVS_CHECK_TRUE(const_lk != family.getTailNodeConst() && const_lk->data == "LK");
     VVS_CHECK_TRUE(const_cj != family.getTailNodeConst() && const_cj->data == "CJ");
     VVS_CHECK_TRUE(const_cw != family.getTailNodeConst() && const_cw->data == "CW");
 
-    FamilyTree::EdgeItrConst const_cs2lk = family.getEdgeConst(const_cs, const_lk);
+    typename FamilyTree::EdgeItrConst const_cs2lk = family.getEdgeConst(const_cs, const_lk);
     VVS_CHECK_TRUE(const_cs2lk != family.getTailEdgeConst(const_cs));
     VVS_CHECK_EQUL(family.getEdgeCost(const_cs, const_lk), 0);
     VVS_CHECK_TRUE(family.isConnected(const_cs, const_lk) == true);
 
-    FamilyTree::EdgeItrConst const_lk2cj = family.getEdgeConst(const_lk, const_cj);
+    typename FamilyTree::EdgeItrConst const_lk2cj = family.getEdgeConst(const_lk, const_cj);
     VVS_CHECK_TRUE(const_lk2cj == family.getTailEdgeConst(const_lk));
     VVS_CHECK_EQUL(family.getEdgeCost(const_lk, const_cj), -1);
     VVS_CHECK_TRUE(family.isConnected(const_lk, const_cj) == false);
 
     // Test (normal) iterators
-    FamilyTree::NodeItr cs = family.getHeadNode();
-    FamilyTree::NodeItr lk = family.getHeadNode(); lk++;
-    FamilyTree::NodeItr cj = family.getHeadNode(); cj++; cj++;
-    FamilyTree::NodeItr cw = family.getHeadNode(); cw++; cw++; cw++;
+    typename FamilyTree::NodeItr cs = family.getHeadNode();
+    typename FamilyTree::NodeItr lk = family.getHeadNode(); lk++;
+    typename FamilyTree::NodeItr cj = family.getHeadNode(); cj++; cj++;
+    typename FamilyTree::NodeItr cw = family.getHeadNode(); cw++; cw++; cw++;
 
     VVS_CHECK_TRUE(cs != family.getTailNode() && cs->data == "CS");
     VVS_CHECK_TRUE(lk != family.getTailNode() && lk->data == "LK");
     VVS_CHECK_TRUE(cj != family.getTailNode() && cj->data == "CJ");
     VVS_CHECK_TRUE(cw != family.getTailNode() && cw->data == "CW");
 
-    FamilyTree::Edge* cs2lk = family.getEdge(cs, lk);
+    typename FamilyTree::Edge* cs2lk = family.getEdge(cs, lk);
     VVS_CHECK_TRUE(cs2lk != nullptr);
     VVS_CHECK_EQUL(family.getEdgeCost(cs, lk), 0);
     VVS_CHECK_TRUE(family.isConnected(cs, lk) == true);
 
-    FamilyTree::Edge* lk2cj = family.getEdge(lk, cj);
+    typename FamilyTree::Edge* lk2cj = family.getEdge(lk, cj);
     VVS_CHECK_TRUE(lk2cj == nullptr);
     VVS_CHECK_EQUL(family.getEdgeCost(lk, cj), -1);
     VVS_CHECK_TRUE(family.isConnected(lk, cj) == false);
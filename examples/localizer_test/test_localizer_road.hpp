@@ -3,6 +3,36 @@
 
 #include "vvs.h"
 #include "dg_localizer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <future>
+
+/**
+ * Check whether two road maps have the same nodes and edges (in the same order of edges from each node)
+ * @param a The first map
+ * @param b The second map
+ * @return True if two maps are same (false if not)
+ */
+inline bool isSameRoadMap(dg::RoadMap& a, dg::RoadMap& b)
+{
+    if (a.countNodes() != b.countNodes()) return false;
+    for (auto node_a = a.getHeadNode(); node_a != a.getTailNode(); node_a++)
+    {
+        dg::RoadMap::Node* node_b = b.getNode(node_a->data.id);
+        if (node_b == nullptr || node_b->data.x != node_a->data.x || node_b->data.y != node_a->data.y) return false;
+        if (a.countEdges(node_a) != b.countEdges(node_b)) return false;
+        auto edge_b = b.getHeadEdge(node_b);
+        for (auto edge_a = a.getHeadEdge(node_a); edge_a != a.getTailEdge(node_a); edge_a++, edge_b++)
+        {
+            if (edge_a->to->data.id != edge_b->to->data.id || edge_a->cost.length != edge_b->cost.length) return false;
+            if (edge_a->cost.type != edge_b->cost.type || edge_a->cost.slope != edge_b->cost.slope || edge_a->cost.blocked != edge_b->cost.blocked) return false;
+        }
+    }
+    return true;
+}
 
 int testLocRoadMap(const char* filename = "test_simple_road_map.csv")
 {
@@ -46,6 +76,20 @@ int testLocRoadMap(const char* filename = "test_simple_road_map.csv")
     // Copy the map
     dg::RoadMap copy = map;
     VVS_CHECK_EQUL(copy.countNodes(), map.countNodes());
+    VVS_CHECK_TRUE(copy.getNode(3) != map.getNode(3));
+    VVS_CHECK_EQUL(copy.getEdgeCost(dg::Point2ID(3), dg::Point2ID(5)), 1);
+    VVS_CHECK_EQUL(copy.countInEdges(copy.getNode(5)), 3);
+
+    // Move the map
+    dg::RoadMap::Node* node3_ptr = copy.getNode(3);
+    dg::RoadMap moved = std::move(copy);
+    VVS_CHECK_TRUE(copy.isEmpty());
+    VVS_CHECK_EQUL(moved.countNodes(), map.countNodes());
+    VVS_CHECK_TRUE(moved.getNode(3) == node3_ptr);
+    VVS_CHECK_TRUE(moved.getEdge(3, 5) != nullptr && moved.getEdge(3, 5)->to == moved.getNode(5));
+    copy = std::move(moved);
+    VVS_CHECK_TRUE(moved.isEmpty());
+    VVS_CHECK_TRUE(copy.getNode(3) == node3_ptr);
 
     // Rest the map
     map.removeAll();
@@ -92,6 +136,126 @@ int testLocRoadMap(const char* filename = "test_simple_road_map.csv")
     VVS_CHECK_TRUE(map.getEdgeCost(dg::Point2ID(5), dg::Point2ID(6)) < 0);
     VVS_CHECK_TRUE(map.getEdgeCost(dg::Point2ID(5), dg::Point2ID(7)) < 0);
 
+    // Save and load the map as a binary file
+    std::string binary_file = std::string(filename) + ".bin";
+    VVS_CHECK_TRUE(map.save(binary_file.c_str(), true));
+    VVS_CHECK_TRUE(copy.load(binary_file.c_str()));
+    VVS_CHECK_TRUE(isSameRoadMap(map, copy));
+
+    // Load CSV files with comments, CRLF, automatic cost, and an invalid edge
+    FILE* file = fopen(filename, "wt");
+    VVS_CHECK_TRUE(file != nullptr);
+    fprintf(file, "# An edge before nodes\r\nEDGE, 1, 2, -1\r\nNODE, 1, 0.5, 1e1\r\nnode,2, -2.5 ,10\r\n\r\nedge, 2, 1, 3.25");
+    fclose(file);
+    VVS_CHECK_TRUE(copy.load(filename, 2));
+    VVS_CHECK_EQUL(copy.countNodes(), 2);
+    VVS_CHECK_TRUE(copy.getNode(1)->data.x == 0.5 && copy.getNode(1)->data.y == 10 && copy.getNode(2)->data.x == -2.5);
+    VVS_CHECK_TRUE(copy.getEdgeCost(dg::Point2ID(1), dg::Point2ID(2)) == 3 && copy.getEdgeCost(dg::Point2ID(2), dg::Point2ID(1)) == 3.25);
+    file = fopen(filename, "wt");
+    VVS_CHECK_TRUE(file != nullptr);
+    fprintf(file, "NODE, 1, 0, 0\nEDGE, 1, 2, 1\n");
+    fclose(file);
+    VVS_CHECK_FALSE(copy.load(filename));
+    VVS_CHECK_TRUE(copy.isEmpty());
+
+    // Reject CSV files with duplicated IDs or trailing characters in numbers
+    file = fopen(filename, "wt");
+    VVS_CHECK_TRUE(file != nullptr);
+    fprintf(file, "NODE, 1, 0, 0\nNODE, 2, 1, 0\nNODE, 1, 2, 0\n");
+    fclose(file);
+    VVS_CHECK_FALSE(copy.load(filename));
+    VVS_CHECK_TRUE(copy.isEmpty());
+    const char* invalid_lines[] = { "NODE, 1, 0.5x, 0\n", "NODE, 1, 0, 1e1e\n", "NODE, 1x, 0, 0\n", "NODE, 1, 0, abc\n", "NODE, 1, 0, \n" };
+    for (size_t i = 0; i < sizeof(invalid_lines) / sizeof(invalid_lines[0]); i++)
+    {
+        file = fopen(filename, "wt");
+        VVS_CHECK_TRUE(file != nullptr);
+        fprintf(file, "%s", invalid_lines[i]);
+        fclose(file);
+        VVS_CHECK_FALSE(copy.load(filename));
+    }
+
+    // Reject binary files with duplicated IDs
+    dg::RoadMap duplicated;
+    VVS_CHECK_TRUE(duplicated.addNode(dg::Point2ID(1, 0, 0)) != nullptr);
+    VVS_CHECK_TRUE(duplicated.addNode(dg::Point2ID(1, 1, 0)) != nullptr);
+    VVS_CHECK_TRUE(duplicated.save(binary_file.c_str(), true));
+    VVS_CHECK_FALSE(copy.load(binary_file.c_str()));
+    VVS_CHECK_TRUE(copy.isEmpty());
+
+    return 0;
+}
+
+int testLocRoadMapProfile(const char* filename = "test_simple_road_map_profile.bin")
+{
+    // An example road map with attributes of edges
+    // 4 --- 5    (===: stairs, ~~~: a road for cars, slope of 2-4: 0.1)
+    // |     ~
+    // 1 --- 2 === 3
+    dg::RoadMap map;
+    VVS_CHECK_TRUE(map.addNode(dg::Point2ID(1, 0, 0)) != nullptr);
+    VVS_CHECK_TRUE(map.addNode(dg::Point2ID(2, 1, 0)) != nullptr);
+    VVS_CHECK_TRUE(map.addNode(dg::Point2ID(3, 2, 0)) != nullptr);
+    VVS_CHECK_TRUE(map.addNode(dg::Point2ID(4, 0, 1)) != nullptr);
+    VVS_CHECK_TRUE(map.addNode(dg::Point2ID(5, 1, 1)) != nullptr);
+    VVS_CHECK_TRUE(map.addRoad(map.getNode(1), map.getNode(2), dg::RoadCost(-1)));
+    VVS_CHECK_TRUE(map.addRoad(map.getNode(2), map.getNode(3), dg::RoadCost(-1, dg::Edge::EDGE_STAIR)));
+    VVS_CHECK_TRUE(map.addRoad(map.getNode(1), map.getNode(4), dg::RoadCost(-1, dg::Edge::EDGE_SIDEWALK, 0.1)));
+    VVS_CHECK_TRUE(map.addRoad(map.getNode(4), map.getNode(5), dg::RoadCost(-1, dg::Edge::EDGE_SIDEWALK, 0.05)));
+    VVS_CHECK_TRUE(map.addEdge(map.getNode(5), map.getNode(2), dg::RoadCost(2, dg::Edge::EDGE_ROAD)) != nullptr);
+    VVS_CHECK_TRUE(map.getEdge(4, 1)->cost.slope == -0.1);
+
+    // Check weights with the default profile (same with length)
+    VVS_CHECK_TRUE(map.getProfile() == dg::RoadProfile::pedestrian());
+    VVS_CHECK_TRUE(map.getEdgeCost(dg::Point2ID(2), dg::Point2ID(3)) == 1);
+    VVS_CHECK_TRUE(map.getWeight(*map.getEdge(2, 3)) == 1);
+    VVS_CHECK_TRUE(map.getWeight(*map.getEdge(5, 2)) == 2);
+
+    // Check weights with other profiles
+    VVS_CHECK_TRUE(map.setProfile(dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(std::isnan(map.getEdge(1, 2)->cost.weights[1])); // Not calculated yet
+    VVS_CHECK_TRUE(map.getWeight(*map.getEdge(1, 2)) == 1);
+    VVS_CHECK_TRUE(map.getEdge(1, 2)->cost.weights[1] == 1);         // Cached
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(2, 3)));
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(1, 4)));
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(4, 1)));
+    VVS_CHECK_NEAR(map.getWeight(*map.getEdge(4, 5)), 1.5);
+    VVS_CHECK_TRUE(map.setProfile(dg::RoadProfile::robot()));
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(2, 3)));
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(5, 2)));
+    VVS_CHECK_NEAR(map.getWeight(*map.getEdge(1, 4)), 1.5);
+    VVS_CHECK_TRUE(map.setProfile(dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(map.getEdge(1, 2)->cost.weights[1] == 1);         // Still cached after switching profiles
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(1, 4)));
+
+    // Block and unblock an edge
+    VVS_CHECK_TRUE(map.setProfile(dg::RoadProfile::pedestrian()));
+    VVS_CHECK_TRUE(map.setBlocked(1, 2));
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(1, 2)));
+    VVS_CHECK_TRUE(map.isPassable(*map.getEdge(2, 1)));
+    VVS_CHECK_FALSE(map.setBlocked(1, 3));
+
+    // Copy and save the map with its attributes
+    VVS_CHECK_TRUE(map.setProfile(dg::RoadProfile::robot()));
+    dg::RoadMap copy = map;
+    VVS_CHECK_TRUE(copy.getProfile() == dg::RoadProfile::robot());
+    VVS_CHECK_FALSE(copy.isPassable(*copy.getEdge(1, 2)));
+    VVS_CHECK_TRUE(map.save(filename, true));
+    VVS_CHECK_TRUE(copy.load(filename));
+    VVS_CHECK_TRUE(isSameRoadMap(map, copy));
+    VVS_CHECK_TRUE(copy.getEdge(1, 2)->cost.blocked && copy.getEdge(4, 1)->cost.slope == -0.1 && copy.getEdge(5, 2)->cost.type == dg::Edge::EDGE_ROAD);
+
+    // Replace the oldest profile when all caches are used
+    for (int i = 0; i < dg::RoadCost::N_CACHES; i++)
+    {
+        dg::RoadProfile profile;
+        profile.slope_weight = i + 1;
+        VVS_CHECK_TRUE(map.setProfile(profile));
+        VVS_CHECK_NEAR(map.getWeight(*map.getEdge(1, 4)), 1 + 0.1 * (i + 1));
+    }
+    VVS_CHECK_TRUE(map.setProfile(dg::RoadProfile::pedestrian()));
+    VVS_CHECK_FALSE(map.isPassable(*map.getEdge(1, 2)));
+
     return 0;
 }
 
@@ -155,4 +319,607 @@ int testLocRoadPainter(int wait_msec = 1)
     return 0;
 }
 
+/**
+ * Build a grid road graph for benchmarks
+ * @param graph The graph to build
+ * @param rows The number of rows in the grid
+ * @param cols The number of columns in the grid
+ * @param seed The seed to shuffle the order of edges
+ */
+template<typename C, typename S>
+void genBenchRoadGraph(dg::DirectedGraph<dg::Point2ID, C, S>& graph, size_t rows, size_t cols, unsigned int seed = 2019)
+{
+    typedef dg::DirectedGraph<dg::Point2ID, C, S> Graph;
+    std::vector<typename Graph::Node*> nodes;
+    for (size_t r = 0; r < rows; r++)
+        for (size_t c = 0; c < cols; c++)
+            nodes.push_back(graph.addNode(dg::Point2ID(r * cols + c + 1, 10.0 * c, 10.0 * r)));
+
+    // Add bi-directional roads in a shuffled order (as like a map from the server)
+    std::vector<std::pair<size_t, size_t> > roads;
+    for (size_t r = 0; r < rows; r++)
+    {
+        for (size_t c = 0; c < cols; c++)
+        {
+            if (c + 1 < cols) roads.push_back(std::make_pair(r * cols + c, r * cols + c + 1));
+            if (r + 1 < rows) roads.push_back(std::make_pair(r * cols + c, (r + 1) * cols + c));
+        }
+    }
+    std::shuffle(roads.begin(), roads.end(), std::mt19937(seed));
+    for (auto road = roads.begin(); road != roads.end(); road++)
+    {
+        graph.addEdge(nodes[road->first], nodes[road->second], 10);
+        graph.addEdge(nodes[road->second], nodes[road->first], 10);
+    }
+}
+
+/**
+ * Find the nearest edge by traversing all nodes and edges (as like the linear search of 'BaseLocalizer::findNearestTopoPose')
+ * @return A pair of the ID of the start node and the index of the nearest edge
+ */
+template<typename C, typename S>
+std::pair<dg::ID, int> findBenchNearestEdge(const dg::DirectedGraph<dg::Point2ID, C, S>& graph, const dg::Pose2& pose, double turn_weight = 0)
+{
+    double min_dist2 = DBL_MAX;
+    std::pair<dg::ID, int> nearest(0, -1);
+    for (auto from = graph.getHeadNodeConst(); from != graph.getTailNodeConst(); from++)
+    {
+        int edge_idx = 0;
+        for (auto edge = graph.getHeadEdgeConst(from); edge != graph.getTailEdgeConst(from); edge++, edge_idx++)
+        {
+            double dist2 = dg::BaseLocalizer::calcDist2FromLineSeg(from->data, edge->to->data, pose, turn_weight).first;
+            if (dist2 < min_dist2)
+            {
+                min_dist2 = dist2;
+                nearest = std::make_pair(from->data.id, edge_idx);
+            }
+        }
+    }
+    return nearest;
+}
+
+/**
+ * Benchmark traversal of a graph
+ * @param times The elapsed times of node iteration, edge iteration, and nearest edge search (return value)
+ * @param nearest The found nearest edges (return value)
+ * @return Checksum of the traversal
+ */
+template<typename S>
+double runBenchRoadGraph(const dg::DirectedGraph<dg::Point2ID, double, S>& graph, const std::vector<dg::Pose2>& queries, int n_repeats, double times[3], std::vector<std::pair<dg::ID, int> >& nearest)
+{
+    double checksum = 0;
+    double time_start = getBenchTime();
+    for (int i = 0; i < n_repeats; i++)
+        for (auto node = graph.getHeadNodeConst(); node != graph.getTailNodeConst(); node++)
+            checksum += node->data.x;
+    times[0] = getBenchTime() - time_start;
+
+    time_start = getBenchTime();
+    for (int i = 0; i < n_repeats; i++)
+        for (auto from = graph.getHeadNodeConst(); from != graph.getTailNodeConst(); from++)
+            for (auto edge = graph.getHeadEdgeConst(from); edge != graph.getTailEdgeConst(from); edge++)
+                checksum += edge->cost + edge->to->data.y;
+    times[1] = getBenchTime() - time_start;
+
+    time_start = getBenchTime();
+    nearest.clear();
+    for (auto q = queries.begin(); q != queries.end(); q++)
+        nearest.push_back(findBenchNearestEdge(graph, *q));
+    times[2] = getBenchTime() - time_start;
+    return checksum;
+}
+
+int testLocRoadTileMap()
+{
+    // Split a grid map (30 x 30 nodes, 10 meters between nodes) into tiles (50 x 50 meters)
+    dg::RoadMap map;
+    genBenchRoadGraph(map, 30, 30);
+    auto tile_of = [](const dg::Point2& p) { return cv::Point2i(int(floor(p.x / 50)), int(floor(p.y / 50))); };
+    dg::RoadTileMap::Tiles tiles;
+    VVS_CHECK_TRUE(dg::RoadTileMap::split(map, tile_of, tiles));
+    VVS_CHECK_EQUL(tiles.size(), 36);
+    VVS_CHECK_EQUL(tiles[cv::Point2i(2, 2)].nodes.size(), 25);
+    dg::RoadMap stitched;
+    VVS_CHECK_TRUE(dg::RoadTileMap::stitch(tiles, stitched));
+    VVS_CHECK_TRUE(isSameRoadMap(map, stitched));
+
+    // Load tiles around the center tile
+    int n_loads = 0;
+    auto loader = [&](const cv::Point2i& idx, dg::RoadTile& tile)
+    {
+        auto found = tiles.find(idx);
+        if (found == tiles.end()) return false;
+        tile = found->second;
+        n_loads++;
+        return true;
+    };
+    dg::RoadTileMap tile_map;
+    VVS_CHECK_FALSE(tile_map.isEnabled());
+    VVS_CHECK_FALSE(tile_map.update(cv::Point2i(2, 2), stitched));
+    VVS_CHECK_TRUE(tile_map.setLoader(loader, 1));
+    VVS_CHECK_TRUE(tile_map.update(cv::Point2i(2, 2), stitched));
+    VVS_CHECK_EQUL(n_loads, 9);
+    VVS_CHECK_EQUL(stitched.countNodes(), 225);
+    VVS_CHECK_FALSE(tile_map.update(cv::Point2i(2, 2), stitched)); // Not changed
+    VVS_CHECK_EQUL(n_loads, 9);
+
+    // Check edges of a node in the center tile and a node at the border
+    auto isSameEdges = [&](dg::ID id)
+    {
+        dg::RoadMap::Node* node_a = map.getNode(id);
+        dg::RoadMap::Node* node_b = stitched.getNode(id);
+        if (node_a == nullptr || node_b == nullptr || map.countEdges(node_a) != stitched.countEdges(node_b)) return false;
+        auto edge_b = stitched.getHeadEdge(node_b);
+        for (auto edge_a = map.getHeadEdge(node_a); edge_a != map.getTailEdge(node_a); edge_a++, edge_b++)
+            if (edge_a->to->data.id != edge_b->to->data.id) return false;
+        return true;
+    };
+    const dg::ID center_id = 12 * 30 + 12 + 1, border_id = 12 * 30 + 5 + 1, far_id = 12 * 30 + 20 + 1;
+    VVS_CHECK_TRUE(isSameEdges(center_id));
+    VVS_CHECK_FALSE(isSameEdges(border_id));
+    VVS_CHECK_EQUL(stitched.countEdges(stitched.getNode(border_id)), 3);
+    VVS_CHECK_TRUE(stitched.getNode(far_id) == nullptr);
+
+    // Move the center tile (3 tiles are loaded and 3 tiles are evicted)
+    VVS_CHECK_TRUE(tile_map.update(cv::Point2i(3, 2), stitched));
+    VVS_CHECK_EQUL(n_loads, 12);
+    VVS_CHECK_EQUL(tile_map.getTiles().size(), 9);
+    VVS_CHECK_EQUL(stitched.countNodes(), 225);
+    VVS_CHECK_TRUE(isSameEdges(center_id));
+    VVS_CHECK_TRUE(stitched.getNode(border_id) == nullptr);
+    VVS_CHECK_TRUE(stitched.getNode(far_id) != nullptr);
+    cv::Point2i center;
+    VVS_CHECK_TRUE(tile_map.getCenter(center) && center == cv::Point2i(3, 2));
+
+    // Move the center tile with tiles loaded outside of the tile map (e.g. on another thread)
+    std::vector<cv::Point2i> missing;
+    VVS_CHECK_FALSE(tile_map.getMissingTiles(cv::Point2i(3, 2), missing)); // Not changed
+    VVS_CHECK_TRUE(tile_map.getMissingTiles(cv::Point2i(4, 2), missing));
+    VVS_CHECK_EQUL(missing.size(), 3);
+    VVS_CHECK_EQUL(n_loads, 12);
+    dg::RoadTileMap::Tiles loaded = dg::RoadTileMap::loadTiles(tile_map.getLoader(), missing);
+    VVS_CHECK_EQUL(n_loads, 15);
+    loaded[cv::Point2i(0, 0)] = tiles[cv::Point2i(0, 0)]; // Ignored because it is outside of the window
+    VVS_CHECK_TRUE(tile_map.update(cv::Point2i(4, 2), stitched, loaded));
+    VVS_CHECK_EQUL(n_loads, 15);
+    VVS_CHECK_EQUL(tile_map.getTiles().size(), 9);
+    VVS_CHECK_EQUL(stitched.countNodes(), 225);
+    VVS_CHECK_TRUE(stitched.getNode(center_id) == nullptr);
+    VVS_CHECK_FALSE(tile_map.update(cv::Point2i(4, 2), stitched, loaded)); // Not changed
+
+    // Move the center tile to the corner and outside of the map
+    VVS_CHECK_TRUE(tile_map.update(cv::Point2i(0, 0), stitched));
+    VVS_CHECK_EQUL(tile_map.getTiles().size(), 4);
+    VVS_CHECK_EQUL(stitched.countNodes(), 100);
+    VVS_CHECK_TRUE(tile_map.update(cv::Point2i(10, 10), stitched));
+    VVS_CHECK_TRUE(tile_map.getTiles().empty());
+    VVS_CHECK_TRUE(stitched.isEmpty());
+
+    // Check tile indices of the Web Mercator tile system
+    VVS_CHECK_TRUE(dg::RoadTileMap::cvtLatLon2Tile(dg::LatLon(0, 0), 1) == cv::Point2i(1, 1));
+    VVS_CHECK_TRUE(dg::RoadTileMap::cvtLatLon2Tile(dg::LatLon(37.5665, 126.978), 17) == cv::Point2i(111767, 50757));
+
+    return 0;
+}
+
+int testLocBaseMapTiles()
+{
+    // Prepare a grid map (30 x 30 nodes, 10 meters between nodes) as tiles (zoom level 19; about 60 meters in Korea)
+    dg::RoadMap map;
+    genBenchRoadGraph(map, 30, 30);
+    dg::RoadTileMap::Tiles tiles;
+    std::atomic<bool> loadable(true);
+    std::atomic<int> n_loads(0);
+    dg::SimpleLocalizer localizer;
+    localizer.setReference(dg::LatLon(36.38, 127.37));
+    VVS_CHECK_TRUE(localizer.setRoadTileLoader([&](const cv::Point2i& idx, dg::RoadTile& tile)
+    {
+        while (!loadable) std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Slow I/O
+        auto found = tiles.find(idx);
+        if (found == tiles.end()) return false;
+        tile = found->second;
+        n_loads++;
+        return true;
+    }, 19, 1));
+    VVS_CHECK_TRUE(dg::RoadTileMap::split(map, [&](const dg::Point2& p) { return localizer.getMapTile(p); }, tiles));
+
+    // Load tiles on the calling thread
+    const dg::ID center_id = 15 * 30 + 15 + 1;
+    VVS_CHECK_TRUE(localizer.applyPosition(dg::Point2(150, 150)));
+    VVS_CHECK_TRUE(localizer.updateMapTiles());
+    VVS_CHECK_FALSE(localizer.updateMapTiles()); // Not changed
+    VVS_CHECK_TRUE(n_loads == 9);
+    VVS_CHECK_TRUE(localizer.getMap().getNode(center_id) != nullptr);
+
+    // Load tiles on a worker thread, which does not block other threads
+    loadable = false;
+    VVS_CHECK_TRUE(localizer.applyPosition(dg::Point2(250, 150)));
+    VVS_CHECK_FALSE(localizer.requestMapTiles()); // Loading is started
+    VVS_CHECK_FALSE(localizer.requestMapTiles()); // Still loading
+    auto blocking = std::async(std::launch::async, [&]() { return localizer.setRoadBlocked(center_id + 10, center_id + 11); });
+    VVS_CHECK_TRUE(blocking.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    VVS_CHECK_TRUE(blocking.get());
+    VVS_CHECK_TRUE(localizer.getMap().getNode(center_id) != nullptr);
+    VVS_CHECK_TRUE(n_loads == 9);
+
+    // Replace the map after loading
+    loadable = true;
+    bool replaced = false;
+    for (int i = 0; i < 10000 && !replaced; i++)
+    {
+        replaced = localizer.requestMapTiles();
+        if (!replaced) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    VVS_CHECK_TRUE(replaced);
+    VVS_CHECK_TRUE(n_loads > 9);
+    VVS_CHECK_FALSE(localizer.requestMapTiles()); // Not changed
+    dg::RoadMap window = localizer.getMap();
+    VVS_CHECK_TRUE(window.getNode(center_id + 10) != nullptr);
+    VVS_CHECK_TRUE(window.getEdge(center_id + 10, center_id + 11) != nullptr && window.getEdge(center_id + 10, center_id + 11)->cost.blocked);
+
+    // Discard tiles of the previous loader
+    loadable = false;
+    VVS_CHECK_TRUE(localizer.applyPosition(dg::Point2(150, 150)));
+    VVS_CHECK_FALSE(localizer.requestMapTiles());
+    std::thread release([&]() { std::this_thread::sleep_for(std::chrono::milliseconds(10)); loadable = true; });
+    VVS_CHECK_TRUE(localizer.setRoadTileLoader([](const cv::Point2i&, dg::RoadTile&) { return false; }, 19, 1));
+    release.join();
+    VVS_CHECK_TRUE(localizer.getMap().getNode(center_id + 10) != nullptr);
+    VVS_CHECK_TRUE(localizer.updateMapTiles());
+    VVS_CHECK_TRUE(localizer.getMap().isEmpty());
+
+    return 0;
+}
+
+int testLocRoadMapBench(size_t rows = 300, size_t cols = 300, size_t n_queries = 20, int n_repeats = 10)
+{
+    // Build two graphs with the same contents
+    dg::DirectedGraph<dg::Point2ID, double, dg::ListStorage> list_graph;
+    dg::DirectedGraph<dg::Point2ID, double, dg::VectorStorage> vector_graph;
+    double time_start = getBenchTime();
+    genBenchRoadGraph(list_graph, rows, cols);
+    double time_build_list = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    genBenchRoadGraph(vector_graph, rows, cols);
+    double time_build_vector = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(list_graph.countNodes() == vector_graph.countNodes());
+
+    std::mt19937 rng(2019);
+    std::uniform_real_distribution<double> x(0, 10.0 * cols), y(0, 10.0 * rows);
+    std::vector<dg::Pose2> queries;
+    for (size_t q = 0; q < n_queries; q++) queries.push_back(dg::Pose2(x(rng), y(rng)));
+
+    // Benchmark both storages
+    double time_list[3], time_vector[3];
+    std::vector<std::pair<dg::ID, int> > nearest_list, nearest_vector;
+    double checksum_list = runBenchRoadGraph(list_graph, queries, n_repeats, time_list, nearest_list);
+    double checksum_vector = runBenchRoadGraph(vector_graph, queries, n_repeats, time_vector, nearest_vector);
+    VVS_CHECK_TRUE(checksum_list == checksum_vector);
+    VVS_CHECK_TRUE(nearest_list == nearest_vector);
+
+    // Benchmark copying and moving
+    time_start = getBenchTime();
+    dg::DirectedGraph<dg::Point2ID, double, dg::ListStorage> list_copy(list_graph);
+    double time_copy_list = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    dg::DirectedGraph<dg::Point2ID, double, dg::VectorStorage> vector_copy(vector_graph);
+    double time_copy_vector = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    dg::DirectedGraph<dg::Point2ID, double, dg::ListStorage> list_moved(std::move(list_copy));
+    double time_move_list = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    dg::DirectedGraph<dg::Point2ID, double, dg::VectorStorage> vector_moved(std::move(vector_copy));
+    double time_move_vector = getBenchTime() - time_start;
+    std::vector<std::pair<dg::ID, int> > nearest_copy;
+    double time_dummy[3];
+    VVS_CHECK_TRUE(runBenchRoadGraph(list_moved, queries, 1, time_dummy, nearest_copy) == runBenchRoadGraph(list_graph, queries, 1, time_dummy, nearest_list));
+    VVS_CHECK_TRUE(nearest_copy == nearest_list);
+    VVS_CHECK_TRUE(runBenchRoadGraph(vector_moved, queries, 1, time_dummy, nearest_copy) == runBenchRoadGraph(vector_graph, queries, 1, time_dummy, nearest_vector));
+    VVS_CHECK_TRUE(nearest_copy == nearest_vector);
+    VVS_CHECK_TRUE(list_copy.countNodes() == 0 && vector_copy.countNodes() == 0);
+
+    printf("| Graph (%zd nodes, %zd queries) | ListStorage [sec] | VectorStorage [sec] |\n", list_graph.countNodes(), n_queries);
+    printf("| ------------------------------- | ----------------- | ------------------- |\n");
+    printf("| Build                           | %.6f | %.6f |\n", time_build_list, time_build_vector);
+    printf("| Node iteration (x%d)            | %.6f | %.6f |\n", n_repeats, time_list[0], time_vector[0]);
+    printf("| Edge iteration (x%d)            | %.6f | %.6f |\n", n_repeats, time_list[1], time_vector[1]);
+    printf("| Nearest edge search             | %.6f | %.6f |\n", time_list[2], time_vector[2]);
+    printf("| Copy                            | %.6f | %.6f |\n", time_copy_list, time_copy_vector);
+    printf("| Move                            | %.6f | %.6f |\n", time_move_list, time_move_vector);
+
+    return 0;
+}
+
+/**
+ * Remove random nodes and check consistency of the remaining edges
+ * @return Elapsed time to remove the nodes (negative if inconsistent)
+ */
+template<typename S>
+double runBenchRoadGraphEdit(dg::DirectedGraph<dg::Point2ID, double, S>& graph, const std::vector<dg::ID>& removes)
+{
+    double time_start = getBenchTime();
+    for (auto id = removes.begin(); id != removes.end(); id++)
+        if (!graph.removeNode(graph.getNode(dg::Point2ID(*id)))) return -1;
+    double time_remove = getBenchTime() - time_start;
+
+    size_t n_edges = 0, n_in_edges = 0;
+    for (auto from = graph.getHeadNode(); from != graph.getTailNode(); from++)
+    {
+        for (auto edge = graph.getHeadEdge(from); edge != graph.getTailEdge(from); edge++)
+            if (graph.getNode(edge->to->data) != edge->to) return -1;
+        n_edges += graph.countEdges(from);
+        n_in_edges += graph.countInEdges(&(*from));
+    }
+    if (n_edges != n_in_edges) return -1;
+    return time_remove;
+}
+
+int testLocBaseNearestBench(size_t rows = 250, size_t cols = 250, size_t n_queries = 100)
+{
+    // Prepare a localizer with a grid map (about 2.5 * 10^5 edges as line segments)
+    dg::RoadMap map;
+    genBenchRoadGraph(map, rows, cols);
+    size_t n_edges = 0;
+    for (auto node = map.getHeadNodeConst(); node != map.getTailNodeConst(); node++) n_edges += map.countEdges(node);
+    dg::SimpleLocalizer localizer;
+    double time_start = getBenchTime();
+    VVS_CHECK_TRUE(localizer.loadMap(map));
+    double time_load = getBenchTime() - time_start;
+
+    std::mt19937 rng(2019);
+    std::uniform_real_distribution<double> x(-50, 10.0 * cols + 50), y(-50, 10.0 * rows + 50), heading(-CV_PI, CV_PI);
+    std::vector<dg::Pose2> queries;
+    for (size_t q = 0; q < n_queries; q++) queries.push_back(dg::Pose2(x(rng), y(rng), heading(rng)));
+
+    // Compare the spatial index with the linear search
+    const double turn_weights[] = { 0, 1 };
+    double time_linear[2], time_index[2];
+    for (int t = 0; t < 2; t++)
+    {
+        std::vector<std::pair<dg::ID, int> > nearest_linear, nearest_index;
+        time_start = getBenchTime();
+        for (auto q = queries.begin(); q != queries.end(); q++)
+            nearest_linear.push_back(findBenchNearestEdge(map, *q, turn_weights[t]));
+        time_linear[t] = getBenchTime() - time_start;
+        time_start = getBenchTime();
+        for (auto q = queries.begin(); q != queries.end(); q++)
+        {
+            dg::TopometricPose pose_t = localizer.findNearestTopoPose(*q, turn_weights[t]);
+            nearest_index.push_back(std::make_pair(pose_t.node_id, pose_t.edge_idx));
+        }
+        time_index[t] = getBenchTime() - time_start;
+        VVS_CHECK_TRUE(nearest_linear == nearest_index);
+    }
+
+    // Check the search range (start nodes of the found edges should be within the range)
+    time_start = getBenchTime();
+    for (auto q = queries.begin(); q != queries.end(); q++)
+    {
+        dg::Pose2 search_pt(q->x + 30, q->y);
+        dg::TopometricPose pose_t = localizer.findNearestTopoPose(*q, 1, 20, search_pt);
+        if (pose_t.node_id == 0) continue;
+        dg::RoadMap::Node* from = map.getNode(pose_t.node_id);
+        VVS_CHECK_TRUE(from != nullptr);
+        double dx = from->data.x - search_pt.x, dy = from->data.y - search_pt.y;
+        VVS_CHECK_TRUE(dx * dx + dy * dy <= 20 * 20);
+    }
+    double time_range = getBenchTime() - time_start;
+
+    printf("| Nearest edge search (%zd edges, %zd queries) | Linear search [msec] | Spatial index [msec] |\n", n_edges, n_queries);
+    printf("| ------------------------------------------- | -------------------- | -------------------- |\n");
+    printf("| Build (loadMap)                             | - | %.3f |\n", time_load * 1000);
+    printf("| Without heading (turn_weight = 0)           | %.3f | %.3f |\n", time_linear[0] * 1000, time_index[0] * 1000);
+    printf("| With heading (turn_weight = 1)              | %.3f | %.3f |\n", time_linear[1] * 1000, time_index[1] * 1000);
+    printf("| With search range (20 meters)               | - | %.3f |\n", time_range * 1000);
+
+    return 0;
+}
+
+int testLocRoadMapEditBench(size_t rows = 300, size_t cols = 300, size_t n_queries = 1000)
+{
+    dg::DirectedGraph<dg::Point2ID, double, dg::ListStorage> list_graph;
+    dg::DirectedGraph<dg::Point2ID, double, dg::VectorStorage> vector_graph;
+    genBenchRoadGraph(list_graph, rows, cols);
+    genBenchRoadGraph(vector_graph, rows, cols);
+
+    std::mt19937 rng(2019);
+    std::uniform_int_distribution<dg::ID> random_id(1, rows * cols);
+    std::vector<dg::ID> queries;
+    for (size_t q = 0; q < n_queries; q++) queries.push_back(random_id(rng));
+
+    // Benchmark the previous linear scan and the hash index
+    double time_start = getBenchTime();
+    size_t n_found_scan = 0;
+    for (auto id = queries.begin(); id != queries.end(); id++)
+    {
+        for (auto node = vector_graph.getHeadNodeConst(); node != vector_graph.getTailNodeConst(); node++)
+            if (node->data.id == *id) { n_found_scan++; break; }
+    }
+    double time_scan = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    size_t n_found_index = 0;
+    for (auto id = queries.begin(); id != queries.end(); id++)
+        if (vector_graph.getNode(dg::Point2ID(*id)) != nullptr) n_found_index++;
+    double time_index = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(n_found_scan == n_queries);
+    VVS_CHECK_TRUE(n_found_index == n_queries);
+
+    // Benchmark removal of nodes (e.g. closing blocked sidewalks)
+    std::sort(queries.begin(), queries.end());
+    queries.erase(std::unique(queries.begin(), queries.end()), queries.end());
+    std::shuffle(queries.begin(), queries.end(), rng);
+    double time_remove_list = runBenchRoadGraphEdit(list_graph, queries);
+    double time_remove_vector = runBenchRoadGraphEdit(vector_graph, queries);
+    VVS_CHECK_TRUE(time_remove_list >= 0);
+    VVS_CHECK_TRUE(time_remove_vector >= 0);
+    VVS_CHECK_TRUE(list_graph.countNodes() == rows * cols - queries.size());
+    VVS_CHECK_TRUE(vector_graph.countNodes() == rows * cols - queries.size());
+
+    printf("| Graph edit (%zd nodes)                | Time [sec] |\n", rows * cols);
+    printf("| ------------------------------------- | ---------- |\n");
+    printf("| Find %zd nodes (linear scan)         | %.6f |\n", n_queries, time_scan);
+    printf("| Find %zd nodes (hash index)          | %.6f |\n", n_queries, time_index);
+    printf("| Remove %zd nodes (ListStorage)        | %.6f |\n", queries.size(), time_remove_list);
+    printf("| Remove %zd nodes (VectorStorage)      | %.6f |\n", queries.size(), time_remove_vector);
+
+    return 0;
+}
+
+/**
+ * Read a road map line by line as the previous 'RoadMap::load' (a baseline for benchmarks)
+ * @return True if successful (false if failed)
+ */
+inline bool loadBenchRoadMapLegacy(dg::RoadMap& map, const char* filename)
+{
+    map.removeAll();
+    FILE* fid = fopen(filename, "rt");
+    if (fid == nullptr) return false;
+    char buffer[1024];
+    bool ok = true;
+    while (ok && fgets(buffer, sizeof(buffer), fid) != nullptr)
+    {
+        char* token = strtok(buffer, ",");
+        if (token == nullptr) ok = false;
+        else if (token[0] == 'N' || token[0] == 'n')
+        {
+            char* id = strtok(nullptr, ",");
+            char* x = strtok(nullptr, ",");
+            char* y = strtok(nullptr, ",");
+            if (id == nullptr || x == nullptr || y == nullptr) ok = false;
+            else map.addNode(dg::Point2ID(strtoll(id, nullptr, 10), strtod(x, nullptr), strtod(y, nullptr)));
+        }
+        else if (token[0] == 'E' || token[0] == 'e')
+        {
+            char* id1 = strtok(nullptr, ",");
+            char* id2 = strtok(nullptr, ",");
+            char* cost = strtok(nullptr, ",");
+            if (id1 == nullptr || id2 == nullptr || cost == nullptr) ok = false;
+            else ok = (map.addEdge(strtoll(id1, nullptr, 10), strtoll(id2, nullptr, 10), strtod(cost, nullptr)) != nullptr);
+        }
+    }
+    fclose(fid);
+    return ok;
+}
+
+int testLocRoadMapFileBench(size_t rows = 700, size_t cols = 700, const char* filename = "test_simple_road_map_bench.csv")
+{
+    // Build a grid road map in UTM-like coordinates
+    dg::RoadMap map;
+    genBenchRoadGraph(map, rows, cols);
+    std::mt19937 rng(2019);
+    std::uniform_real_distribution<double> noise(-1, 1);
+    for (auto node = map.getHeadNode(); node != map.getTailNode(); node++)
+    {
+        node->data.x += 354000 + noise(rng);
+        node->data.y += 4027000 + noise(rng);
+    }
+    for (auto node = map.getHeadNode(); node != map.getTailNode(); node++)
+        for (auto edge = map.getHeadEdge(node); edge != map.getTailEdge(node); edge++)
+        {
+            double dx = edge->to->data.x - node->data.x, dy = edge->to->data.y - node->data.y;
+            edge->cost = sqrt(dx * dx + dy * dy);
+        }
+    size_t n_lines = map.countNodes();
+    for (auto node = map.getHeadNode(); node != map.getTailNode(); node++) n_lines += map.countEdges(node);
+
+    // Benchmark saving
+    std::string binary_file = std::string(filename) + ".bin";
+    double time_start = getBenchTime();
+    VVS_CHECK_TRUE(map.save(filename));
+    double time_save_csv = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    VVS_CHECK_TRUE(map.save(binary_file.c_str(), true));
+    double time_save_binary = getBenchTime() - time_start;
+
+    // Benchmark loading and check the same results
+    dg::RoadMap legacy, single, multiple, binary;
+    time_start = getBenchTime();
+    VVS_CHECK_TRUE(loadBenchRoadMapLegacy(legacy, filename));
+    double time_load_legacy = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    VVS_CHECK_TRUE(single.load(filename, 1));
+    double time_load_single = getBenchTime() - time_start;
+    int n_threads = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+    time_start = getBenchTime();
+    VVS_CHECK_TRUE(multiple.load(filename, n_threads));
+    double time_load_multiple = getBenchTime() - time_start;
+    time_start = getBenchTime();
+    VVS_CHECK_TRUE(binary.load(binary_file.c_str()));
+    double time_load_binary = getBenchTime() - time_start;
+    VVS_CHECK_TRUE(isSameRoadMap(legacy, single));
+    VVS_CHECK_TRUE(isSameRoadMap(legacy, multiple));
+    VVS_CHECK_TRUE(isSameRoadMap(map, binary));
+
+    printf("| RoadMap file (%zd lines) | Save [sec] | Load [sec] |\n", n_lines);
+    printf("| ----------------------------- | ---------- | ---------- |\n");
+    printf("| CSV (fgets + strtok + strtod) | %.6f | %.6f |\n", time_save_csv, time_load_legacy);
+    printf("| CSV (mmap, 1 thread)          | - | %.6f |\n", time_load_single);
+    printf("| CSV (mmap, %2d threads)        | - | %.6f |\n", n_threads, time_load_multiple);
+    printf("| Binary                        | %.6f | %.6f |\n", time_save_binary, time_load_binary);
+
+    return 0;
+}
+
+int testLocRoadTileMapBench(size_t max_size = 200, size_t n_queries = 100)
+{
+    printf("| Grid | Nodes | Nodes (tiled) | Nearest (full) [msec] | Nearest (tiled) [msec] | Tile update [msec] |\n");
+    printf("| ---- | ----- | ------------- | --------------------- | ---------------------- | ------------------ |\n");
+    for (size_t size = 50; size <= max_size; size *= 2)
+    {
+        // Prepare two localizers with the whole map and its tiles (zoom level 19; about 60 meters in Korea)
+        dg::RoadMap map;
+        genBenchRoadGraph(map, size, size);
+        dg::SimpleLocalizer full, tiled;
+        full.setReference(dg::LatLon(36.38, 127.37));
+        tiled.setReference(dg::LatLon(36.38, 127.37));
+        VVS_CHECK_TRUE(full.loadMap(map));
+        dg::RoadTileMap::Tiles tiles;
+        VVS_CHECK_TRUE(tiled.setRoadTileLoader([&](const cv::Point2i& idx, dg::RoadTile& tile)
+        {
+            auto found = tiles.find(idx);
+            if (found == tiles.end()) return false;
+            tile = found->second;
+            return true;
+        }, 19, 1));
+        VVS_CHECK_TRUE(dg::RoadTileMap::split(map, [&](const dg::Point2& p) { return tiled.getMapTile(p); }, tiles));
+
+        // Move to the center of the map with a profile and a blocked edge
+        const double center = 5.0 * size;
+        const dg::ID center_id = (size / 2) * size + size / 2 + 1;
+        VVS_CHECK_TRUE(tiled.applyPosition(dg::Point2(center, center)));
+        VVS_CHECK_TRUE(tiled.setRoadProfile(dg::RoadProfile::robot()));
+        VVS_CHECK_TRUE(tiled.setRoadBlocked(center_id, center_id + 1));
+        double time_start = getBenchTime();
+        VVS_CHECK_TRUE(tiled.updateMapTiles());
+        double time_update = getBenchTime() - time_start;
+        VVS_CHECK_FALSE(tiled.updateMapTiles());
+        dg::RoadMap window = tiled.getMap();
+        VVS_CHECK_TRUE(window.countNodes() > 0 && window.countNodes() < map.countNodes());
+        VVS_CHECK_TRUE(window.getProfile() == dg::RoadProfile::robot());
+        VVS_CHECK_TRUE(window.getEdge(center_id, center_id + 1) != nullptr && window.getEdge(center_id, center_id + 1)->cost.blocked);
+
+        // Find the nearest topometric poses around the center
+        std::mt19937 rng(2019);
+        std::uniform_real_distribution<double> offset(-20, 20), heading(-CV_PI, CV_PI);
+        std::vector<dg::Pose2> queries;
+        for (size_t q = 0; q < n_queries; q++) queries.push_back(dg::Pose2(center + offset(rng), center + offset(rng), heading(rng)));
+        std::vector<dg::TopometricPose> results_full, results_tiled;
+        time_start = getBenchTime();
+        for (auto q = queries.begin(); q != queries.end(); q++) results_full.push_back(full.findNearestTopoPose(*q, 1));
+        double time_full = getBenchTime() - time_start;
+        time_start = getBenchTime();
+        for (auto q = queries.begin(); q != queries.end(); q++) results_tiled.push_back(tiled.findNearestTopoPose(*q, 1));
+        double time_tiled = getBenchTime() - time_start;
+        for (size_t q = 0; q < n_queries; q++)
+        {
+            VVS_CHECK_TRUE(results_full[q].node_id == results_tiled[q].node_id);
+            VVS_CHECK_TRUE(results_full[q].edge_idx == results_tiled[q].edge_idx);
+        }
+
+        printf("| %zd x %zd | %zd | %zd | %.3f | %.3f | %.3f |\n", size, size, map.countNodes(), window.countNodes(), time_full * 1000, time_tiled * 1000, time_update * 1000);
+    }
+
+    return 0;
+}
+
 #endif // End of '__TEST_LOCALIZER_ROAD__'
@@ -4,6 +4,8 @@
 #include "vvs.h"
 #include "dg_core.hpp"
 #include "dg_localizer.hpp"
+#include <algorithm>
+#include <random>
 
 int testLocBaseDist2()
 {
@@ -43,6 +45,104 @@ int testLocBaseDist2()
     return 0;
 }
 
+int testLocSegmentKernel(size_t n = 1001, unsigned int seed = 2019)
+{
+    // Generate random segments (including degenerate ones) and poses
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> pos(-100, 100), len(-20, 20), heading(-3 * CV_PI, 3 * CV_PI);
+    dg::SegmentArray segs;
+    std::vector<dg::Point2> pt1s, pt2s;
+    for (size_t i = 0; i < n; i++)
+    {
+        pt1s.push_back(dg::Point2(pos(rng), pos(rng)));
+        pt2s.push_back((i % 10 == 0) ? pt1s.back() : pt1s.back() + dg::Point2(len(rng), len(rng)));
+        segs.push_back(pt1s.back(), pt2s.back());
+    }
+    std::vector<uint32_t> items;
+    for (size_t i = 0; i < n; i += 3) items.push_back(static_cast<uint32_t>(n - 1 - i));
+    VVS_CHECK_TRUE(segs.size() == n);
+    VVS_CHECK_TRUE(dg::SegmentKernel::isSupported(dg::SegmentKernel::KERNEL_SCALAR));
+    VVS_CHECK_TRUE(dg::SegmentKernel::isSupported(dg::SegmentKernel::getBestKernel()));
+
+    // Compare all supported kernels with 'calcDist2FromLineSeg' (the same results are expected)
+    for (int kernel = dg::SegmentKernel::KERNEL_SCALAR; kernel <= dg::SegmentKernel::getBestKernel(); kernel++)
+    {
+        for (int q = 0; q < 10; q++)
+        {
+            dg::Pose2 pose(pos(rng), pos(rng), heading(rng));
+            double turn_weight = q % 3;
+            std::vector<double> dist2(n), dist2_items(items.size());
+            dg::SegmentKernel::calcDist2(segs, 0, n, pose, turn_weight, dist2.data(), kernel);
+            dg::SegmentKernel::calcDist2Indexed(segs, items.data(), items.size(), pose, turn_weight, dist2_items.data(), kernel);
+            bool same = true;
+            for (size_t i = 0; i < n; i++)
+                if (dist2[i] != dg::BaseLocalizer::calcDist2FromLineSeg(pt1s[i], pt2s[i], pose, turn_weight).first) same = false;
+            for (size_t i = 0; i < items.size(); i++)
+                if (dist2_items[i] != dist2[items[i]]) same = false;
+            VVS_CHECK_TRUE(same);
+        }
+    }
+
+    return 0;
+}
+
+int testLocSegmentKernelBench(size_t n = 1000000, int n_repeats = 5)
+{
+    // Generate random segments and an order of random access
+    std::mt19937 rng(2019);
+    std::uniform_real_distribution<double> pos(-1000, 1000), len(-20, 20);
+    dg::SegmentArray segs;
+    std::vector<dg::Point2> pt1s, pt2s;
+    segs.reserve(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        pt1s.push_back(dg::Point2(pos(rng), pos(rng)));
+        pt2s.push_back(pt1s.back() + dg::Point2(len(rng), len(rng)));
+        segs.push_back(pt1s.back(), pt2s.back());
+    }
+    std::vector<uint32_t> items(n);
+    for (size_t i = 0; i < n; i++) items[i] = static_cast<uint32_t>(i);
+    std::shuffle(items.begin(), items.end(), rng);
+    const dg::Pose2 pose(12, 34, 1);
+    std::vector<double> dist2(n);
+
+    // Measure the scalar function as the baseline
+    double checksum = 0;
+    double time_start = getBenchTime();
+    for (int r = 0; r < n_repeats; r++)
+        for (size_t i = 0; i < n; i++)
+            checksum += dg::BaseLocalizer::calcDist2FromLineSeg(pt1s[i], pt2s[i], pose, 1).first;
+    double time_base = getBenchTime() - time_start;
+
+    const char* names[] = { "Scalar", "SSE2", "AVX2" };
+    printf("| Segment kernel (%zd segments) | Contiguous [Mseg/sec] | Indexed [Mseg/sec] |\n", n);
+    printf("| ----------------------------- | --------------------- | ------------------ |\n");
+    printf("| calcDist2FromLineSeg          | %.1f | - |\n", n * n_repeats / time_base / 1e6);
+    for (int kernel = dg::SegmentKernel::KERNEL_SCALAR; kernel <= dg::SegmentKernel::getBestKernel(); kernel++)
+    {
+        double sum_contiguous = 0, sum_indexed = 0;
+        time_start = getBenchTime();
+        for (int r = 0; r < n_repeats; r++)
+        {
+            dg::SegmentKernel::calcDist2(segs, 0, n, pose, 1, dist2.data(), kernel);
+            sum_contiguous += dist2[r];
+        }
+        double time_contiguous = getBenchTime() - time_start;
+        time_start = getBenchTime();
+        for (int r = 0; r < n_repeats; r++)
+        {
+            dg::SegmentKernel::calcDist2Indexed(segs, items.data(), n, pose, 1, dist2.data(), kernel);
+            sum_indexed += dist2[r];
+        }
+        double time_indexed = getBenchTime() - time_start;
+        VVS_CHECK_TRUE(sum_contiguous > 0 && sum_indexed > 0);
+        printf("| %-29s | %.1f | %.1f |\n", names[kernel], n * n_repeats / time_contiguous / 1e6, n * n_repeats / time_indexed / 1e6);
+    }
+    VVS_CHECK_TRUE(checksum > 0);
+
+    return 0;
+}
+
 dg::RoadMap getSimpleRoadMap()
 {
     // An example road map ('+' represents direction of edges)
@@ -107,6 +207,15 @@ int testLocBaseNearest()
     VVS_CHECK_NEAR(pose_t4.dist, 0.5);
     VVS_CHECK_NEAR(pose_t4.head, -CV_PI / 4);
 
+    // Check the search range (only edges from the node 6 are within the range)
+    dg::TopometricPose pose_t5 = localizer.findNearestTopoPose(dg::Pose2(1.5, 1.5, CV_PI * 3 / 4), 1, 0.5, dg::Pose2(3, 1));
+    VVS_CHECK_EQUL(pose_t5.node_id, 6);
+    VVS_CHECK_EQUL(pose_t5.edge_idx, 0);
+    VVS_CHECK_NEAR(pose_t5.dist, 1);
+
+    dg::TopometricPose pose_t6 = localizer.findNearestTopoPose(dg::Pose2(1.5, 1.5, CV_PI * 3 / 4), 1, 0.5, dg::Pose2(10, 10));
+    VVS_CHECK_EQUL(pose_t6.node_id, 0);
+
     return 0;
 }
 
@@ -152,6 +261,38 @@ int testLocBaseTrack()
     VVS_CHECK_NEAR(pose_t6.dist, 0.5);
     VVS_CHECK_NEAR(pose_t6.head, -CV_PI);
 
+    // Check tracking which does not move onto impassable edges
+    VVS_CHECK_TRUE(localizer.setRoadBlocked(2, 3));
+    dg::TopometricPose pose_t7 = localizer.trackTopoPose(dg::TopometricPose(1, 0, 0, 0), dg::Pose2(0, 1.0, 0), 1);
+    VVS_CHECK_EQUL(pose_t7.node_id, 1);
+    VVS_CHECK_EQUL(pose_t7.edge_idx, 0);
+    VVS_CHECK_TRUE(localizer.setRoadBlocked(2, 3, false));
+    dg::TopometricPose pose_t8 = localizer.trackTopoPose(dg::TopometricPose(1, 0, 0, 0), dg::Pose2(0, 1.0, 0), 1);
+    VVS_CHECK_EQUL(pose_t8.node_id, 2);
+    VVS_CHECK_FALSE(localizer.setRoadBlocked(2, 1));
+
+    // Check the query profile and blocked edges which are kept after loading another map
+    VVS_CHECK_TRUE(localizer.setRoadProfile(dg::RoadProfile::wheelchair()));
+    VVS_CHECK_TRUE(localizer.setRoadBlocked(2, 3));
+    VVS_CHECK_TRUE(localizer.loadMap(map));
+    VVS_CHECK_TRUE(localizer.getMap().getProfile() == dg::RoadProfile::wheelchair());
+    dg::TopometricPose pose_t9 = localizer.trackTopoPose(dg::TopometricPose(1, 0, 0, 0), dg::Pose2(0, 1.0, 0), 1);
+    VVS_CHECK_EQUL(pose_t9.node_id, 1);
+    dg::RoadMap moved = getSimpleRoadMap();
+    VVS_CHECK_TRUE(localizer.loadMap(std::move(moved)));
+    VVS_CHECK_TRUE(localizer.getMap().getProfile() == dg::RoadProfile::wheelchair());
+    dg::TopometricPose pose_t10 = localizer.trackTopoPose(dg::TopometricPose(1, 0, 0, 0), dg::Pose2(0, 1.0, 0), 1);
+    VVS_CHECK_EQUL(pose_t10.node_id, 1);
+
+    // Check the query profiles which are moved together with the map
+    dg::RoadMap source = getSimpleRoadMap();
+    VVS_CHECK_TRUE(source.setProfile(dg::RoadProfile::robot()));
+    dg::RoadMap target(std::move(source));
+    VVS_CHECK_TRUE(target.getProfile() == dg::RoadProfile::robot());
+    VVS_CHECK_TRUE(source.getProfile() == dg::RoadProfile());
+    source = std::move(target);
+    VVS_CHECK_TRUE(source.getProfile() == dg::RoadProfile::robot());
+
     return 0;
 }
 
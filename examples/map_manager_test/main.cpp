@@ -6,6 +6,11 @@ int main()
 
     // Test simple cases
     VVS_RUN_TEST(testSimpleMapManager());
+    VVS_RUN_TEST(testMapManagerPatch());
+    VVS_RUN_TEST(testMapManagerFindPath());
+
+    // Test performance (only if the environment variable 'DG_RUN_BENCH' is set)
+    DG_RUN_BENCH(testMapManagerParseBench());
 
     return 0;
 }
\ No newline at end of file
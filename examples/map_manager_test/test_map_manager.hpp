@@ -5,6 +5,28 @@
 #include "dg_map_manager.hpp"
 #include <stdint.h>
 #include <cstdint>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+// Run the given benchmark only if the environment variable 'DG_RUN_BENCH' is set as non-zero (e.g. DG_RUN_BENCH=1)
+inline bool isBenchEnabled()
+{
+	const char* value = std::getenv("DG_RUN_BENCH");
+	return value != nullptr && value[0] != '\0' && value[0] != '0';
+}
+#define DG_RUN_BENCH(EXP) { if (isBenchEnabled()) VVS_RUN_TEST(EXP); }
+
+// Count memory allocations for benchmarks
+static size_t g_bench_n_allocs = 0;
+void* operator new(size_t size)
+{
+	g_bench_n_allocs++;
+	void* ptr = std::malloc(size);
+	if (ptr == nullptr) throw std::bad_alloc();
+	return ptr;
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
 
 int testSimpleMapManager()
 {
@@ -51,9 +73,9 @@ int testSimpleMapManager()
 		VVS_CHECK_EQUL(path.pts.size(), 37);
 	
 	// Find the node & edge
-	dg::Node* findNode = manager.getMap().findNode(559562564900154);
+	const dg::Node* findNode = manager.getMap().findNode(559562564900154);
 	VVS_CHECK_EQUL(findNode->id, 559562564900154);
-	dg::Edge* findEdge = manager.getMap().findEdge(559562564900154, 559562564900155);
+	const dg::Edge* findEdge = manager.getMap().findEdge(559562564900154, 559562564900155);
 	VVS_CHECK_EQUL(findEdge->length, 13.370689140764001);
 	VVS_CHECK_EQUL((manager.getMap().findEdge(findEdge->id))->length, 13.370689140764001);
 
@@ -91,4 +113,185 @@ int testSimpleMapManager()
     return 0;
 }
 
+// A map manager which exposes parsing of server responses (for tests without the server)
+class ParsingMapManager : public dg::MapManager
+{
+public:
+	using dg::MapManager::parseMap;
+	using dg::MapManager::parseMapPatch;
+
+	bool isHierarchyBuilt() { return m_hierarchy.isBuilt(*m_map); }
+};
+
+std::string genBenchMapJSON(int rows, int cols, double spacing = 0.0001)
+{
+	// Generate a grid map in the same GeoJSON format of the map server
+	std::string json = "{\"type\":\"FeatureCollection\",\"version\":1,\"features\":[";
+	char buffer[512];
+	bool first = true;
+	for (int r = 0; r < rows; r++)
+	{
+		for (int c = 0; c < cols; c++)
+		{
+			// Edges to the right and bottom nodes
+			dg::ID id = r * cols + c + 1;
+			for (int dir = 0; dir < 2; dir++)
+			{
+				if ((dir == 0 && c + 1 >= cols) || (dir == 1 && r + 1 >= rows)) continue;
+				sprintf(buffer, "%s{\"type\":\"Feature\",\"properties\":{\"name\":\"edge\",\"id\":%zu,\"type\":%d,\"length\":%.3f}}", first ? "" : ",", static_cast<size_t>(1000000 + 2 * id + dir), dir, 11.1);
+				json += buffer;
+				first = false;
+			}
+		}
+	}
+	for (int r = 0; r < rows; r++)
+	{
+		for (int c = 0; c < cols; c++)
+		{
+			dg::ID id = r * cols + c + 1;
+			std::string edge_ids;
+			if (c + 1 < cols) edge_ids += std::to_string(1000000 + 2 * id) + ",";
+			if (r + 1 < rows) edge_ids += std::to_string(1000000 + 2 * id + 1) + ",";
+			if (c > 0) edge_ids += std::to_string(1000000 + 2 * (id - 1)) + ",";
+			if (r > 0) edge_ids += std::to_string(1000000 + 2 * (id - cols) + 1) + ",";
+			if (!edge_ids.empty()) edge_ids.pop_back();
+			sprintf(buffer, ",{\"type\":\"Feature\",\"properties\":{\"name\":\"Node\",\"id\":%zu,\"type\":%d,\"floor\":0,\"latitude\":%.7f,\"longitude\":%.7f,\"edge_ids\":[%s]}}",
+				static_cast<size_t>(id), (r % 10 == 0 && c % 10 == 0) ? 1 : 0, 36.38 + r * spacing, 127.36 + c * spacing, edge_ids.c_str());
+			json += buffer;
+		}
+	}
+	json += "]}";
+	return json;
+}
+
+int testMapManagerParseBench(int rows = 200, int cols = 200)
+{
+	std::string json = genBenchMapJSON(rows, cols);
+
+	ParsingMapManager manager;
+	size_t n_allocs = g_bench_n_allocs;
+	auto time_start = std::chrono::high_resolution_clock::now();
+	VVS_CHECK_TRUE(manager.parseMap(json.c_str()));
+	double time_parse = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - time_start).count();
+	n_allocs = g_bench_n_allocs - n_allocs;
+
+	// Check the parsed map
+	const dg::Map& map = manager.getMap();
+	VVS_CHECK_TRUE(map.nodes.size() == static_cast<size_t>(rows * cols));
+	VVS_CHECK_TRUE(map.edges.size() == static_cast<size_t>((rows - 1) * cols + rows * (cols - 1)));
+	VVS_CHECK_TRUE(map.findEdge(1, 2) != nullptr);
+	VVS_CHECK_TRUE(map.findEdge(1, 1 + cols) != nullptr);
+	VVS_CHECK_TRUE(map.findEdge(1, 2 + cols) == nullptr);
+	VVS_CHECK_TRUE(map.findNode(1 + cols)->edge_ids.size() == 3);
+
+	printf("| Parsing a map (%zd nodes, %zd edges, %.1f MB) | Allocations | Time [sec] |\n", map.nodes.size(), map.edges.size(), json.length() / 1024. / 1024.);
+	printf("| --------------------------------------------- | ----------- | ---------- |\n");
+	printf("| MapManager::parseMap                          | %zd | %.6f |\n", n_allocs, time_parse);
+
+	return 0;
+}
+
+int testMapManagerPatch()
+{
+	// Parse a 3 x 3 grid map (version 1)
+	ParsingMapManager manager;
+	VVS_CHECK_TRUE(manager.parseMap(genBenchMapJSON(3, 3).c_str()));
+	uint64_t revision = manager.getMap().getRevision();
+	VVS_CHECK_TRUE(manager.getMap().getRevision() == revision); // Not changed by reading
+	dg::Map& map = manager.editMap();
+	VVS_CHECK_TRUE(map.getRevision() != revision);
+	VVS_CHECK_TRUE(map.version == 1);
+	VVS_CHECK_TRUE(map.nodes.size() == 9 && map.edges.size() == 12);
+
+	// Parse a patch response (version 1 to 2): node 9 is removed, node 10 is added and linked to node 8, and an edge is longer
+	const char* json = "{\"base_version\":1,\"version\":2,"
+		"\"nodes\":{\"added\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Node\",\"id\":10,\"type\":1,\"floor\":0,\"latitude\":36.3805,\"longitude\":127.3605,\"edge_ids\":[1000100]}}],"
+		"\"removed\":[9]},"
+		"\"edges\":{\"added\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"edge\",\"id\":1000100,\"type\":2,\"length\":25.0,\"node_ids\":[8,10]}}],"
+		"\"modified\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"edge\",\"id\":1000002,\"type\":0,\"length\":500.0,\"node_ids\":[1,2]}}]},"
+		"\"streetviews\":{\"removed\":[\"32364501511\"]}}";
+	dg::MapPatch patch;
+	VVS_CHECK_TRUE(manager.parseMapPatch(json, patch));
+	VVS_CHECK_TRUE(patch.base_version == 1 && patch.version == 2);
+	VVS_CHECK_TRUE(patch.nodes.added.size() == 1 && patch.nodes.added[0].type == dg::Node::NODE_JUNCTION);
+	VVS_CHECK_TRUE(patch.nodes.removed.size() == 1 && patch.nodes.removed[0] == 9);
+	VVS_CHECK_TRUE(patch.edges.added.size() == 1 && patch.edges.added[0].node_id1 == 8 && patch.edges.added[0].node_id2 == 10);
+	VVS_CHECK_TRUE(patch.edges.modified.size() == 1 && patch.edges.modified[0].length == 500);
+	VVS_CHECK_TRUE(patch.views.removed.size() == 1 && patch.views.removed[0] == 32364501511ULL);
+	VVS_CHECK_FALSE(manager.parseMapPatch("{\"version\":2}", patch));
+
+	// Apply the patch (the street-view does not exist, so it is rejected first)
+	VVS_CHECK_TRUE(manager.parseMapPatch(json, patch));
+	VVS_CHECK_FALSE(map.applyPatch(patch));
+	patch.views.removed.clear();
+	VVS_CHECK_TRUE(map.applyPatch(patch));
+	VVS_CHECK_TRUE(map.version == 2);
+	VVS_CHECK_TRUE(map.nodes.size() == 9 && map.edges.size() == 11);
+	VVS_CHECK_TRUE(map.findNode(9) == nullptr);
+	VVS_CHECK_TRUE(map.findEdge(8, 10) != nullptr);
+	VVS_CHECK_TRUE(map.findEdge(1, 2)->length == 500);
+	VVS_CHECK_FALSE(map.applyPatch(patch)); // Already applied
+
+	return 0;
+}
+
+int testMapManagerFindPath()
+{
+	// Parse a 3 x 3 grid map (node 1 at the bottom-left and node 9 at the top-right)
+	ParsingMapManager manager;
+	VVS_CHECK_TRUE(manager.parseMap(genBenchMapJSON(3, 3).c_str()));
+
+	// Parse a tile into another map without changing the current map (e.g. a tile loader of the localizer)
+	dg::Map tile;
+	dg::MonotonicArena arena;
+	VVS_CHECK_TRUE(ParsingMapManager::parseMap(genBenchMapJSON(2, 2).c_str(), tile, arena));
+	VVS_CHECK_TRUE(tile.nodes.size() == 4 && manager.getMapSnapshot()->nodes.size() == 9);
+
+	// Find a path between two locations near node 1 and 9 without the routing server
+	dg::Path path;
+	VVS_CHECK_TRUE(manager.findPath(36.38001, 127.36001, 36.38019, 127.36021, path));
+	VVS_CHECK_TRUE(path.pts.size() == 5);
+	VVS_CHECK_TRUE(path.pts.front().node_id == 1 && path.pts.back().node_id == 9);
+	VVS_CHECK_TRUE(path.pts.front().edge_id != 0 && path.pts.back().edge_id == 0);
+	VVS_CHECK_TRUE(manager.getPath().pts.size() == 5);
+
+	// Find alternative paths (there are six shortest paths from node 1 to 9)
+	std::vector<dg::Path> paths;
+	VVS_CHECK_TRUE(manager.findPaths(36.38001, 127.36001, 36.38019, 127.36021, paths, 3));
+	VVS_CHECK_TRUE(paths.size() == 3);
+	VVS_CHECK_TRUE(paths[0].pts.size() == 5 && paths[1].pts.size() == 5 && paths[2].pts.size() == 5);
+	VVS_CHECK_TRUE(paths[1].pts[1].node_id != paths[0].pts[1].node_id || paths[1].pts[2].node_id != paths[0].pts[2].node_id || paths[1].pts[3].node_id != paths[0].pts[3].node_id);
+
+	// Get a path through the same interface in the offline mode
+	VVS_CHECK_FALSE(manager.isOffline());
+	VVS_CHECK_TRUE(manager.setOffline(true));
+	VVS_CHECK_TRUE(manager.isOffline());
+	VVS_CHECK_TRUE(manager.getPath(36.38001, 127.36001, 36.38019, 127.36021, path, 3));
+	VVS_CHECK_TRUE(path.pts.size() == 5 && path.pts.back().node_id == 9);
+
+	// Find a path with the contraction hierarchy saved together with the map
+	VVS_CHECK_TRUE(manager.saveMap("test_map_manager.dgmap"));
+	ParsingMapManager loaded;
+	dg::Map loaded_map;
+	VVS_CHECK_TRUE(loaded.getMap("test_map_manager.dgmap", loaded_map));
+	VVS_CHECK_TRUE(loaded.isHierarchyBuilt());
+	VVS_CHECK_TRUE(loaded.findPath(36.38001, 127.36001, 36.38019, 127.36021, path));
+	VVS_CHECK_TRUE(path.pts.size() == 5 && path.pts.back().node_id == 9);
+	remove("test_map_manager.dgmap");
+	remove(dg::MapFile::getOverlayFilename("test_map_manager.dgmap").c_str());
+
+	// Find a path again after the map is changed (node 9 is removed)
+	dg::Map& map = manager.editMap();
+	dg::MapPatch patch;
+	patch.base_version = 1;
+	patch.version = 2;
+	patch.nodes.removed.push_back(9);
+	VVS_CHECK_TRUE(map.applyPatch(patch));
+	VVS_CHECK_TRUE(manager.findPath(36.38001, 127.36001, 36.38019, 127.36021, path));
+	VVS_CHECK_TRUE(path.pts.size() == 4);
+	VVS_CHECK_TRUE(path.pts.back().node_id == 6 || path.pts.back().node_id == 8);
+
+	return 0;
+}
+
 #endif // End of '__TEST_SIMPLE_MAP__'
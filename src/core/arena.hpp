@@ -0,0 +1,198 @@
+#ifndef __ARENA__
+#define __ARENA__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dg
+{
+
+/**
+ * @brief A monotonic memory arena
+ *
+ * A <b>monotonic arena</b> hands out memory from a few large blocks by moving a pointer forward.
+ * Each allocation is never freed individually, but all of them are released together by release().
+ * It is useful for many short-lived objects such as temporary data during parsing a map.
+ * It is not thread-safe.
+ */
+class MonotonicArena
+{
+public:
+    /**
+     * A constructor with the initial block size
+     * @param block_size The size of the first memory block (Unit: [byte])
+     */
+    MonotonicArena(size_t block_size = 65536) : m_block_size(block_size), m_block_used(0), m_memory(0), m_n_allocs(0) { }
+
+    /**
+     * Allocate memory (time complexity: O(1))
+     * @param bytes The size of memory (Unit: [byte])
+     * @param align The alignment of memory (a power of two)
+     * @return A pointer to the allocated memory
+     */
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        size_t offset = (m_block_used + align - 1) & ~(align - 1);
+        if (m_blocks.empty() || offset + bytes > m_blocks.back().size)
+        {
+            // Add a new block which is larger than the previous one (or the requested size)
+            size_t size = m_blocks.empty() ? m_block_size : 2 * m_blocks.back().size;
+            while (size < bytes) size *= 2;
+            addBlock(size);
+            offset = 0; // A new block is aligned for any fundamental type
+        }
+        m_block_used = offset + bytes;
+        m_n_allocs++;
+        return m_blocks.back().data.get() + offset;
+    }
+
+    /**
+     * Release all allocated memory<br>
+     * Only the largest block is kept and reused, so repeated use does not allocate memory from the system again.
+     */
+    void release()
+    {
+        if (m_blocks.size() > 1)
+        {
+            Block last = std::move(m_blocks.back());
+            m_blocks.clear();
+            m_blocks.push_back(std::move(last));
+            m_memory = m_blocks.back().size;
+        }
+        m_block_used = 0;
+        m_n_allocs = 0;
+    }
+
+    /**
+     * Get the size of memory blocks allocated from the system
+     * @return The size of memory blocks (Unit: [byte])
+     */
+    size_t memory() const { return m_memory; }
+
+    /**
+     * Count the number of memory blocks allocated from the system
+     * @return The number of memory blocks
+     */
+    size_t countBlocks() const { return m_blocks.size(); }
+
+    /**
+     * Count the number of allocations served since the last release()
+     * @return The number of allocations
+     */
+    size_t countAllocs() const { return m_n_allocs; }
+
+protected:
+    /**
+     * @brief A memory block
+     */
+    struct Block
+    {
+        /** The memory of this block */
+        std::unique_ptr<char[]> data;
+
+        /** The size of this block */
+        size_t size;
+    };
+
+    /**
+     * Add a memory block with the given size
+     */
+    void addBlock(size_t size)
+    {
+        Block block;
+        block.data.reset(new char[size]);
+        block.size = size;
+        m_blocks.push_back(std::move(block));
+        m_block_used = 0;
+        m_memory += size;
+    }
+
+    /** The size of the first memory block */
+    size_t m_block_size;
+
+    /** Memory blocks (the last one is being filled) */
+    std::vector<Block> m_blocks;
+
+    /** The number of used bytes in the last block */
+    size_t m_block_used;
+
+    /** The size of allocated memory blocks */
+    size_t m_memory;
+
+    /** The number of allocations */
+    size_t m_n_allocs;
+};
+
+/**
+ * @brief An allocator for standard containers using a monotonic arena
+ *
+ * An <b>arena allocator</b> makes standard containers (e.g. std::vector) get their memory from dg::MonotonicArena.
+ * Its deallocate() does nothing, and the memory is returned when the arena is released.
+ * Therefore, a container with this allocator should not be used after its arena is released.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    /** The type of elements */
+    typedef T value_type;
+
+    /**
+     * A constructor with the arena
+     * @param arena The arena which provides memory
+     */
+    ArenaAllocator(MonotonicArena& arena) : m_arena(&arena) { }
+
+    /**
+     * A copy constructor from an allocator of the other type
+     * @param other The other allocator
+     */
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.getArena()) { }
+
+    /**
+     * Allocate memory for the given number of elements
+     * @param n The number of elements
+     * @return A pointer to the allocated memory
+     */
+    T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+
+    /**
+     * Deallocate memory (do nothing)
+     */
+    void deallocate(T*, size_t) { }
+
+    /**
+     * Get the arena of this allocator
+     * @return A pointer to the arena
+     */
+    MonotonicArena* getArena() const { return m_arena; }
+
+    /** A rebinding of this allocator to the other type (for C++11 libraries without allocator_traits support) */
+    template <typename U>
+    struct rebind { typedef ArenaAllocator<U> other; };
+
+protected:
+    /** The arena which provides memory */
+    MonotonicArena* m_arena;
+};
+
+/**
+ * Check equality of two arena allocators
+ * @return True if they share the same arena
+ */
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.getArena() == rhs.getArena(); }
+
+/**
+ * Check inequality of two arena allocators
+ * @return True if they have different arenas
+ */
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.getArena() != rhs.getArena(); }
+
+} // End of 'dg'
+
+#endif // End of '__ARENA__'
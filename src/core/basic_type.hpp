@@ -152,6 +152,13 @@ public:
      */
     Pose2(const Pose2& pose) : Point2(pose.x, pose.y), theta(pose.theta) { }
 
+    /**
+     * The copy assignment operator (declared with the copy constructor)
+     * @param pose A value for 2D pose (Unit: [m] and [rad])
+     * @return The assigned instance
+     */
+    Pose2& operator=(const Pose2& pose) = default;
+
     /**
      * Overriding the equality operator
      * @param rhs A 2D pose in the right-hand side
@@ -0,0 +1,788 @@
+#ifndef __CONTRACTION_HIERARCHY__
+#define __CONTRACTION_HIERARCHY__
+
+#include "core/path_finder.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace dg
+{
+
+/**
+ * @brief A contraction hierarchy for fast shortest path queries
+ *
+ * A <b>contraction hierarchy</b> contracts nodes of the map one by one in the order of their importance.
+ * When a node is contracted, a <i>shortcut</i> is added between its two neighbors if the path through the node is the only shortest path between them.
+ * A query is a bidirectional Dijkstra's algorithm which only goes up to more important nodes, so it visits only a few hundreds of nodes even in a city-scale map.
+ * The found path is the same with the shortest path of dg::PathFinder with the same cost function, and its shortcuts are unpacked to the original edges.
+ *
+ * Preprocessing is done once by build(), and its result (the <i>overlay</i>) can be stored alongside the map by save() and restored by load().
+ * Memory for searching is reused for each query, so it is not thread-safe.
+ *
+ * MapFile stores the overlay next to its map file (*.dgch), and MapManager restores it with the map.
+ *
+ * <b>File Format (Version 3)</b>
+ *
+ * All numbers are little-endian.
+ * - Header: magic ("DGCH"), version, the number of nodes, edges, and arcs, the version of the map, a checksum of nodes and edges, and a checksum of edge costs
+ * - Ranks: an array of the contraction order of each node (32-bit)
+ * - Arcs: an array of Arc (original edges and shortcuts)
+ */
+class ContractionHierarchy
+{
+public:
+    /** The version of the file format */
+    static const uint32_t VERSION = 3;
+
+    /** An invalid index */
+    static const uint32_t NONE = 0xFFFFFFFF;
+
+    /**
+     * @brief A directed arc of the hierarchy (an original edge or a shortcut)
+     */
+    struct Arc
+    {
+        /** Index of the source node */
+        uint32_t from;
+
+        /** Index of the target node */
+        uint32_t to;
+
+        /** Cost of this arc */
+        double cost;
+
+        /** Index of its original edge (NONE if a shortcut) */
+        uint32_t edge;
+
+        /** The first arc of a shortcut (from 'from' to the contracted node; NONE if an original edge) */
+        uint32_t child1;
+
+        /** The second arc of a shortcut (from the contracted node to 'to'; NONE if an original edge) */
+        uint32_t child2;
+
+        /** Reserved for alignment */
+        uint32_t reserved;
+    };
+
+    /**
+     * @brief The header of an overlay file
+     */
+    struct Header
+    {
+        /** The magic string ("DGCH") */
+        char magic[8];
+
+        /** The version of the file format */
+        uint32_t version;
+
+        /** The size of this header (Unit: [byte]) */
+        uint32_t header_size;
+
+        /** The number of nodes */
+        uint64_t n_nodes;
+
+        /** The number of edges */
+        uint64_t n_edges;
+
+        /** The number of arcs */
+        uint64_t n_arcs;
+
+        /** The version of the map (Map::version) */
+        uint64_t map_version;
+
+        /** A checksum of node IDs and edges (IDs, nodes, lengths, and types) for checking the map */
+        uint64_t checksum;
+
+        /** A checksum of edge costs for checking the cost function (e.g. a different RoadProfile) */
+        uint64_t cost_checksum;
+    };
+
+    /**
+     * A constructor with the parameter of preprocessing
+     * @param witness_limit The maximum number of visited nodes to search a witness path during contraction
+     */
+    ContractionHierarchy(size_t witness_limit = 200) : m_witness_limit(witness_limit), m_map_version(0), m_cost_checksum(0), m_n_visits(0), m_generation(0) { }
+
+    /**
+     * Build this hierarchy with the given map (time complexity: about O(|N| log |N|) for road networks)
+     * @param map The given topological map
+     * @param cost The cost function of edges (e.g. dg::RoadProfile)
+     * @return True if successful (false if failed)
+     */
+    template <typename CostFunction>
+    bool build(const Map& map, CostFunction cost)
+    {
+        clear();
+        if (!m_map.build(map)) return false;
+        m_map_version = map.version;
+        m_cost_checksum = calcCostChecksum(m_map, cost);
+
+        // Add arcs of passable edges
+        const uint32_t n_nodes = static_cast<uint32_t>(m_map.countNodes());
+        m_arcs.reserve(2 * m_map.countEdges());
+        for (uint32_t e = 0; e < m_map.countEdges(); e++)
+        {
+            double c = cost(m_map, e);
+            if (c < 0) continue;
+            addArc(m_map.edge_node1s[e], m_map.edge_node2s[e], c, e);
+            if (!m_map.edge_directed[e]) addArc(m_map.edge_node2s[e], m_map.edge_node1s[e], c, e);
+        }
+        contract(n_nodes);
+        buildSearchGraph();
+        return true;
+    }
+
+    /**
+     * Build this hierarchy with the given map and the default cost function
+     * @param map The given topological map
+     * @return True if successful (false if failed)
+     */
+    bool build(const Map& map) { return build(map, RoadProfile()); }
+
+    /**
+     * Remove all data
+     */
+    void clear()
+    {
+        m_map.clear();
+        m_map_version = 0;
+        m_cost_checksum = 0;
+        m_arcs.clear();
+        m_ranks.clear();
+        for (int d = 0; d < 2; d++)
+        {
+            m_up_offsets[d].clear();
+            m_up_nodes[d].clear();
+            m_up_arcs[d].clear();
+            m_dist[d].clear();
+            m_parent[d].clear();
+            m_stamp[d].clear();
+            m_heap[d].clear();
+        }
+        m_n_visits = 0;
+    }
+
+    /**
+     * Check whether this is built (or loaded) with the given map or not (time complexity: O(1))
+     * @param map The given topological map
+     * @return True if built (false if not built or the map is modified after building)
+     * @see Map::getRevision
+     */
+    bool isBuilt(const Map& map) const { return !m_map.isEmpty() && m_map.getRevision() == map.getRevision(); }
+
+    /**
+     * Write the overlay of this hierarchy to the given file
+     * @param filename The filename to write the overlay (e.g. the map file with an extension, "*.dgch")
+     * @return True if successful (false if failed)
+     */
+    bool save(const char* filename) const
+    {
+        if (filename == nullptr || m_map.isEmpty()) return false;
+
+        Header header;
+        memset(&header, 0, sizeof(header));
+        strncpy(header.magic, "DGCH", sizeof(header.magic));
+        header.version = VERSION;
+        header.header_size = sizeof(Header);
+        header.n_nodes = m_map.countNodes();
+        header.n_edges = m_map.countEdges();
+        header.n_arcs = m_arcs.size();
+        header.map_version = m_map_version;
+        header.checksum = calcChecksum(m_map);
+        header.cost_checksum = m_cost_checksum;
+
+        FILE* file = fopen(filename, "wb");
+        if (file == nullptr) return false;
+        bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+        ok = ok && (fwrite(m_ranks.data(), sizeof(uint32_t), m_ranks.size(), file) == m_ranks.size());
+        ok = ok && (fwrite(m_arcs.data(), sizeof(Arc), m_arcs.size(), file) == m_arcs.size());
+        fclose(file);
+        return ok;
+    }
+
+    /**
+     * Read the overlay of the given map from the given file (time complexity: O(|N| + |E| + |A|))
+     * @param filename The filename to read the overlay
+     * @param map The topological map which the overlay was built with
+     * @param cost The cost function of edges which the overlay was built with (e.g. dg::RoadProfile)
+     * @return True if successful (false if failed or the overlay does not match with the map or the cost function)
+     */
+    template <typename CostFunction>
+    bool load(const char* filename, const Map& map, CostFunction cost)
+    {
+        clear();
+        if (filename == nullptr) return false;
+        FILE* file = fopen(filename, "rb");
+        if (file == nullptr) return false;
+
+        Header header;
+        bool ok = (fread(&header, sizeof(header), 1, file) == 1);
+        ok = ok && strncmp(header.magic, "DGCH", sizeof(header.magic)) == 0 && header.version == VERSION && header.header_size == sizeof(Header);
+        ok = ok && header.n_nodes == map.nodes.size() && header.n_edges == map.edges.size() && header.map_version == map.version;
+        ok = ok && m_map.build(map) && header.checksum == calcChecksum(m_map) && header.cost_checksum == calcCostChecksum(m_map, cost);
+        if (ok)
+        {
+            // Check the number of arcs with the file size before allocating memory
+            long begin = ftell(file);
+            ok = (begin >= 0 && fseek(file, 0, SEEK_END) == 0);
+            long end = ok ? ftell(file) : -1;
+            ok = ok && end >= begin && fseek(file, begin, SEEK_SET) == 0;
+            uint64_t remain = ok ? static_cast<uint64_t>(end - begin) : 0;
+            uint64_t rank_size = header.n_nodes * sizeof(uint32_t);
+            ok = ok && rank_size <= remain && (remain - rank_size) % sizeof(Arc) == 0 && header.n_arcs == (remain - rank_size) / sizeof(Arc);
+        }
+        if (ok)
+        {
+            m_ranks.resize(static_cast<size_t>(header.n_nodes));
+            m_arcs.resize(static_cast<size_t>(header.n_arcs));
+            ok = (fread(m_ranks.data(), sizeof(uint32_t), m_ranks.size(), file) == m_ranks.size());
+            ok = ok && (fread(m_arcs.data(), sizeof(Arc), m_arcs.size(), file) == m_arcs.size());
+        }
+        fclose(file);
+
+        // Check indices of arcs
+        for (size_t i = 0; ok && i < m_arcs.size(); i++)
+        {
+            const Arc& arc = m_arcs[i];
+            ok = (arc.from < header.n_nodes && arc.to < header.n_nodes);
+            if (arc.edge == NONE) ok = ok && (arc.child1 < i && arc.child2 < i);
+            else ok = ok && (arc.edge < header.n_edges);
+        }
+        if (!ok)
+        {
+            clear();
+            return false;
+        }
+        m_map_version = map.version;
+        m_cost_checksum = header.cost_checksum;
+        buildSearchGraph();
+        return true;
+    }
+
+    /**
+     * Read the overlay of the given map, which was built with the default cost function, from the given file
+     * @param filename The filename to read the overlay
+     * @param map The topological map which the overlay was built with
+     * @return True if successful (false if failed or the overlay does not match with the map or the default cost function)
+     */
+    bool load(const char* filename, const Map& map) { return load(filename, map, RoadProfile()); }
+
+    /**
+     * Find the shortest path between two nodes
+     * @param from ID of the start node
+     * @param to ID of the destination node
+     * @param path The found path (return value)
+     * @param cost Cost of the found path (return value; nullptr if not necessary)
+     * @return True if successful (false if not reachable)
+     */
+    bool findPath(ID from, ID to, Path& path, double* cost = nullptr)
+    {
+        path.pts.clear();
+        size_t from_idx = m_map.findNode(from), to_idx = m_map.findNode(to);
+        if (from_idx == FrozenMap::npos || to_idx == FrozenMap::npos) return false;
+
+        std::vector<uint32_t> nodes, edges;
+        double sum = 0;
+        if (!findPath(from_idx, to_idx, nodes, edges, &sum)) return false;
+
+        path.start_pos = LatLon(m_map.node_lats[from_idx], m_map.node_lons[from_idx]);
+        path.dest_pos = LatLon(m_map.node_lats[to_idx], m_map.node_lons[to_idx]);
+        path.pts.reserve(nodes.size());
+        for (size_t i = 0; i < edges.size(); i++) path.pts.push_back(PathElement(m_map.node_ids[nodes[i]], m_map.edge_ids[edges[i]]));
+        path.pts.push_back(PathElement(m_map.node_ids[nodes.back()], 0));
+        if (cost != nullptr) *cost = sum;
+        return true;
+    }
+
+    /**
+     * Find the shortest path between two nodes using their indices
+     * @param from Index of the start node
+     * @param to Index of the destination node
+     * @param nodes Indices of nodes on the found path (return value)
+     * @param edges Indices of edges on the found path (return value; one less than 'nodes')
+     * @param cost Cost of the found path (return value; nullptr if not necessary)
+     * @return True if successful (false if not reachable)
+     */
+    bool findPath(size_t from, size_t to, std::vector<uint32_t>& nodes, std::vector<uint32_t>& edges, double* cost = nullptr)
+    {
+        nodes.clear();
+        edges.clear();
+        m_n_visits = 0;
+        if (from >= m_ranks.size() || to >= m_ranks.size()) return false;
+
+        uint32_t meet = NONE;
+        double best = search(static_cast<uint32_t>(from), static_cast<uint32_t>(to), meet);
+        if (meet == NONE) return false;
+
+        // Collect arcs from the start to the meeting node and from the meeting node to the destination
+        std::vector<uint32_t> arcs;
+        for (uint32_t n = meet; n != from; n = m_arcs[m_parent[0][n]].from) arcs.push_back(m_parent[0][n]);
+        std::reverse(arcs.begin(), arcs.end());
+        for (uint32_t n = meet; n != to; n = m_arcs[m_parent[1][n]].to) arcs.push_back(m_parent[1][n]);
+
+        // Unpack shortcuts
+        nodes.push_back(static_cast<uint32_t>(from));
+        for (size_t i = 0; i < arcs.size(); i++) unpackArc(arcs[i], nodes, edges);
+        if (cost != nullptr) *cost = best;
+        return true;
+    }
+
+    /**
+     * Count the number of visited (expanded) nodes during the last search
+     * @return The number of visited nodes
+     */
+    size_t countVisits() const { return m_n_visits; }
+
+    /**
+     * Count the number of arcs (original edges and shortcuts)
+     * @return The number of arcs
+     */
+    size_t countArcs() const { return m_arcs.size(); }
+
+    /**
+     * Get the frozen map for searching
+     * @return A constant reference to the frozen map
+     */
+    const FrozenMap& getMap() const { return m_map; }
+
+protected:
+    /** An entry of the binary heap */
+    typedef std::pair<double, uint32_t> HeapEntry;
+
+    /**
+     * Add an arc of an original edge
+     */
+    void addArc(uint32_t from, uint32_t to, double cost, uint32_t edge)
+    {
+        Arc arc = { from, to, cost, edge, NONE, NONE, 0 };
+        m_arcs.push_back(arc);
+    }
+
+    /**
+     * Calculate a checksum of node IDs and edges (FNV-1a)
+     */
+    static uint64_t calcChecksum(const FrozenMap& map)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < map.node_ids.size(); i++) hashValue(hash, map.node_ids[i]);
+        for (size_t i = 0; i < map.edge_ids.size(); i++)
+        {
+            uint64_t length;
+            memcpy(&length, &map.edge_lengths[i], sizeof(length));
+            hashValue(hash, map.edge_ids[i]);
+            hashValue(hash, (static_cast<uint64_t>(map.edge_node1s[i]) << 32) | map.edge_node2s[i]);
+            hashValue(hash, length);
+            hashValue(hash, static_cast<uint64_t>(map.edge_types[i]) << 1 | map.edge_directed[i]);
+        }
+        return hash;
+    }
+
+    /**
+     * Calculate a checksum of edge costs given by the cost function (FNV-1a)
+     */
+    template <typename CostFunction>
+    static uint64_t calcCostChecksum(const FrozenMap& map, CostFunction cost)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t e = 0; e < map.edge_ids.size(); e++)
+        {
+            double c = cost(map, e);
+            uint64_t value;
+            memcpy(&value, &c, sizeof(value));
+            hashValue(hash, value);
+        }
+        return hash;
+    }
+
+    /**
+     * Accumulate the given value to a checksum (FNV-1a)
+     */
+    static void hashValue(uint64_t& hash, uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    }
+
+    /**
+     * Contract all nodes in the order of their priorities and assign their ranks
+     */
+    void contract(uint32_t n_nodes)
+    {
+        // Build dynamic adjacency of arcs
+        std::vector<std::vector<uint32_t>> outs(n_nodes), ins(n_nodes);
+        for (uint32_t a = 0; a < m_arcs.size(); a++)
+        {
+            if (m_arcs[a].from == m_arcs[a].to) continue;
+            outs[m_arcs[a].from].push_back(a);
+            ins[m_arcs[a].to].push_back(a);
+        }
+
+        // Prepare memory for witness search
+        m_ranks.assign(n_nodes, static_cast<uint32_t>(NONE));
+        m_dist[0].resize(n_nodes);
+        m_stamp[0].assign(n_nodes, 0);
+        m_generation = 0;
+        std::vector<uint32_t> levels(n_nodes, 0);
+
+        // Contract nodes with lazy update of their priorities
+        std::vector<HeapEntry> queue;
+        queue.reserve(n_nodes);
+        for (uint32_t v = 0; v < n_nodes; v++) pushHeap(queue, HeapEntry(calcPriority(v, outs, ins, levels), v));
+        uint32_t rank = 0;
+        std::vector<Arc> shortcuts;
+        while (!queue.empty())
+        {
+            HeapEntry top = popHeap(queue);
+            uint32_t v = top.second;
+            if (m_ranks[v] != NONE) continue; // Already contracted
+            double priority = calcPriority(v, outs, ins, levels);
+            if (!queue.empty() && priority > queue.front().first)
+            {
+                pushHeap(queue, HeapEntry(priority, v));
+                continue;
+            }
+
+            // Add shortcuts and remove the node
+            findShortcuts(v, outs, ins, &shortcuts);
+            m_ranks[v] = rank++;
+            for (size_t i = 0; i < shortcuts.size(); i++)
+            {
+                // Replace parallel arcs which are not shorter than the shortcut
+                const Arc& shortcut = shortcuts[i];
+                std::vector<uint32_t>& from_outs = outs[shortcut.from];
+                for (size_t j = 0; j < from_outs.size(); j++)
+                {
+                    const Arc& arc = m_arcs[from_outs[j]];
+                    if (arc.to != shortcut.to || arc.cost < shortcut.cost) continue;
+                    std::vector<uint32_t>& to_ins = ins[shortcut.to];
+                    to_ins.erase(std::find(to_ins.begin(), to_ins.end(), from_outs[j]));
+                    from_outs[j--] = from_outs.back();
+                    from_outs.pop_back();
+                }
+                uint32_t a = static_cast<uint32_t>(m_arcs.size());
+                m_arcs.push_back(shortcut);
+                from_outs.push_back(a);
+                ins[shortcut.to].push_back(a);
+            }
+            for (size_t i = 0; i < outs[v].size(); i++) levels[m_arcs[outs[v][i]].to] = std::max(levels[m_arcs[outs[v][i]].to], levels[v] + 1);
+            for (size_t i = 0; i < ins[v].size(); i++) levels[m_arcs[ins[v][i]].from] = std::max(levels[m_arcs[ins[v][i]].from], levels[v] + 1);
+            removeContracted(v, outs, ins);
+        }
+    }
+
+    /**
+     * Calculate priority of the given node (the edge difference with the level of contracted neighbors)
+     */
+    double calcPriority(uint32_t v, const std::vector<std::vector<uint32_t>>& outs, const std::vector<std::vector<uint32_t>>& ins, const std::vector<uint32_t>& levels)
+    {
+        size_t n_shortcuts = findShortcuts(v, outs, ins, nullptr);
+        return static_cast<double>(n_shortcuts) - static_cast<double>(outs[v].size() + ins[v].size()) + levels[v];
+    }
+
+    /**
+     * Find shortcuts which are necessary to contract the given node
+     * @return The number of necessary shortcuts
+     */
+    size_t findShortcuts(uint32_t v, const std::vector<std::vector<uint32_t>>& outs, const std::vector<std::vector<uint32_t>>& ins, std::vector<Arc>* shortcuts)
+    {
+        if (shortcuts != nullptr) shortcuts->clear();
+        if (outs[v].empty() || ins[v].empty()) return 0;
+        double max_out = 0;
+        for (size_t j = 0; j < outs[v].size(); j++) max_out = std::max(max_out, m_arcs[outs[v][j]].cost);
+
+        size_t n_shortcuts = 0;
+        for (size_t i = 0; i < ins[v].size(); i++)
+        {
+            const Arc& in = m_arcs[ins[v][i]];
+            searchWitness(in.from, v, in.cost + max_out, outs[v], outs);
+            for (size_t j = 0; j < outs[v].size(); j++)
+            {
+                const Arc& out = m_arcs[outs[v][j]];
+                if (out.to == in.from) continue;
+                double cost = in.cost + out.cost;
+                if (m_stamp[0][out.to] == m_generation && m_dist[0][out.to] <= cost) continue;
+                n_shortcuts++;
+                if (shortcuts != nullptr)
+                {
+                    Arc arc = { in.from, out.to, cost, NONE, ins[v][i], outs[v][j], 0 };
+                    shortcuts->push_back(arc);
+                }
+            }
+        }
+        return n_shortcuts;
+    }
+
+    /**
+     * Search paths from the given node without the contracted node within the given cost (limited by the number of visited nodes)<br>
+     * The search stops early when all targets (the next nodes of 'target_arcs') are visited.
+     */
+    void searchWitness(uint32_t source, uint32_t excluded, double max_cost, const std::vector<uint32_t>& target_arcs, const std::vector<std::vector<uint32_t>>& outs)
+    {
+        size_t n_targets = target_arcs.size();
+        startSearch();
+        std::vector<HeapEntry>& heap = m_heap[0];
+        heap.clear();
+        m_stamp[0][source] = m_generation;
+        m_dist[0][source] = 0;
+        pushHeap(heap, HeapEntry(0, source));
+        size_t n_visits = 0;
+        while (!heap.empty() && n_visits < m_witness_limit)
+        {
+            HeapEntry top = popHeap(heap);
+            uint32_t u = top.second;
+            if (top.first > m_dist[0][u]) continue;
+            if (top.first > max_cost) break;
+            n_visits++;
+            for (size_t i = 0; i < target_arcs.size(); i++)
+                if (m_arcs[target_arcs[i]].to == u) n_targets--;
+            if (n_targets == 0) break;
+            for (size_t i = 0; i < outs[u].size(); i++)
+            {
+                const Arc& arc = m_arcs[outs[u][i]];
+                if (arc.to == excluded) continue;
+                double dist = m_dist[0][u] + arc.cost;
+                if (m_stamp[0][arc.to] == m_generation && dist >= m_dist[0][arc.to]) continue;
+                m_stamp[0][arc.to] = m_generation;
+                m_dist[0][arc.to] = dist;
+                pushHeap(heap, HeapEntry(dist, arc.to));
+            }
+        }
+    }
+
+    /**
+     * Remove arcs of the contracted node from adjacency of its neighbors
+     */
+    static void removeArcs(std::vector<uint32_t>& arcs, uint32_t node, const std::vector<Arc>& all, bool is_from)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < arcs.size(); i++)
+        {
+            const Arc& arc = all[arcs[i]];
+            if ((is_from ? arc.from : arc.to) != node) arcs[n++] = arcs[i];
+        }
+        arcs.resize(n);
+    }
+
+    /**
+     * Remove the contracted node from the remaining graph
+     */
+    void removeContracted(uint32_t v, std::vector<std::vector<uint32_t>>& outs, std::vector<std::vector<uint32_t>>& ins) const
+    {
+        for (size_t i = 0; i < outs[v].size(); i++) removeArcs(ins[m_arcs[outs[v][i]].to], v, m_arcs, true);
+        for (size_t i = 0; i < ins[v].size(); i++) removeArcs(outs[m_arcs[ins[v][i]].from], v, m_arcs, false);
+        std::vector<uint32_t>().swap(outs[v]);
+        std::vector<uint32_t>().swap(ins[v]);
+    }
+
+    /**
+     * Build upward adjacency for forward (0) and backward (1) search from all arcs and ranks
+     */
+    void buildSearchGraph()
+    {
+        const size_t n_nodes = m_ranks.size();
+        for (int d = 0; d < 2; d++) m_up_offsets[d].assign(n_nodes + 1, 0);
+        for (size_t a = 0; a < m_arcs.size(); a++)
+        {
+            const Arc& arc = m_arcs[a];
+            if (m_ranks[arc.from] < m_ranks[arc.to]) m_up_offsets[0][arc.from + 1]++;
+            else if (m_ranks[arc.from] > m_ranks[arc.to]) m_up_offsets[1][arc.to + 1]++;
+        }
+        std::vector<uint32_t> fill[2];
+        for (int d = 0; d < 2; d++)
+        {
+            for (size_t i = 0; i < n_nodes; i++) m_up_offsets[d][i + 1] += m_up_offsets[d][i];
+            m_up_nodes[d].resize(m_up_offsets[d].back());
+            m_up_arcs[d].resize(m_up_offsets[d].back());
+            fill[d].assign(m_up_offsets[d].begin(), m_up_offsets[d].end() - 1);
+        }
+        for (uint32_t a = 0; a < m_arcs.size(); a++)
+        {
+            const Arc& arc = m_arcs[a];
+            int d = (m_ranks[arc.from] < m_ranks[arc.to]) ? 0 : 1;
+            if (m_ranks[arc.from] == m_ranks[arc.to]) continue;
+            uint32_t u = (d == 0) ? arc.from : arc.to, v = (d == 0) ? arc.to : arc.from;
+            m_up_nodes[d][fill[d][u]] = v;
+            m_up_arcs[d][fill[d][u]++] = a;
+        }
+
+        // Prepare memory for searching
+        for (int d = 0; d < 2; d++)
+        {
+            m_dist[d].resize(n_nodes);
+            m_parent[d].resize(n_nodes);
+            m_stamp[d].assign(n_nodes, 0);
+        }
+        m_generation = 0;
+    }
+
+    /**
+     * Search the shortest path with bidirectional upward search (with stall-on-demand)
+     * @return Cost of the shortest path (and 'meet' is NONE if not reachable)
+     */
+    double search(uint32_t from, uint32_t to, uint32_t& meet)
+    {
+        startSearch();
+        uint32_t sources[2] = { from, to };
+        for (int d = 0; d < 2; d++)
+        {
+            m_heap[d].clear();
+            m_stamp[d][sources[d]] = m_generation;
+            m_dist[d][sources[d]] = 0;
+            m_parent[d][sources[d]] = NONE;
+            pushHeap(m_heap[d], HeapEntry(0, sources[d]));
+        }
+
+        double best = DBL_MAX;
+        meet = NONE;
+        int d = 0;
+        while (!m_heap[0].empty() || !m_heap[1].empty())
+        {
+            // Alternate two directions (the search stops when both minimums exceed the best)
+            if (m_heap[d].empty() || m_heap[d].front().first >= best) d = 1 - d;
+            if (m_heap[d].empty() || m_heap[d].front().first >= best) break;
+            HeapEntry top = popHeap(m_heap[d]);
+            uint32_t u = top.second;
+            if (top.first > m_dist[d][u]) continue; // An outdated entry
+            m_n_visits++;
+            if (isLabeled(1 - d, u) && m_dist[d][u] + m_dist[1 - d][u] < best)
+            {
+                best = m_dist[d][u] + m_dist[1 - d][u];
+                meet = u;
+            }
+
+            // Stall the node if it is reached by a shorter path from a higher node
+            bool stalled = false;
+            for (uint32_t i = m_up_offsets[1 - d][u]; i < m_up_offsets[1 - d][u + 1] && !stalled; i++)
+            {
+                uint32_t w = m_up_nodes[1 - d][i];
+                stalled = isLabeled(d, w) && m_dist[d][w] + m_arcs[m_up_arcs[1 - d][i]].cost < m_dist[d][u];
+            }
+            if (!stalled)
+            {
+                for (uint32_t i = m_up_offsets[d][u]; i < m_up_offsets[d][u + 1]; i++)
+                {
+                    uint32_t v = m_up_nodes[d][i], a = m_up_arcs[d][i];
+                    double dist = m_dist[d][u] + m_arcs[a].cost;
+                    if (isLabeled(d, v) && dist >= m_dist[d][v]) continue;
+                    m_stamp[d][v] = m_generation;
+                    m_dist[d][v] = dist;
+                    m_parent[d][v] = a;
+                    pushHeap(m_heap[d], HeapEntry(dist, v));
+                }
+            }
+            d = 1 - d;
+        }
+        return best;
+    }
+
+    /**
+     * Unpack the given arc to its original edges and append them
+     */
+    void unpackArc(uint32_t arc, std::vector<uint32_t>& nodes, std::vector<uint32_t>& edges) const
+    {
+        std::vector<uint32_t> stack(1, arc);
+        while (!stack.empty())
+        {
+            const Arc& top = m_arcs[stack.back()];
+            stack.pop_back();
+            if (top.edge == NONE)
+            {
+                stack.push_back(top.child2);
+                stack.push_back(top.child1);
+            }
+            else
+            {
+                edges.push_back(top.edge);
+                nodes.push_back(top.to);
+            }
+        }
+    }
+
+    /**
+     * Start a new search (invalidate all labels in O(1))
+     */
+    void startSearch()
+    {
+        m_generation++;
+        if (m_generation == 0)
+        {
+            // Reset stamps when the generation is wrapped around
+            for (int d = 0; d < 2; d++) std::fill(m_stamp[d].begin(), m_stamp[d].end(), 0);
+            m_generation = 1;
+        }
+    }
+
+    /**
+     * Check whether the given node is labeled in the current search
+     */
+    bool isLabeled(int d, uint32_t node) const { return m_stamp[d][node] == m_generation; }
+
+    /**
+     * Push an entry to the binary min-heap
+     */
+    static void pushHeap(std::vector<HeapEntry>& heap, const HeapEntry& entry)
+    {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+    }
+
+    /**
+     * Pop the smallest entry from the binary min-heap
+     */
+    static HeapEntry popHeap(std::vector<HeapEntry>& heap)
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        HeapEntry entry = heap.back();
+        heap.pop_back();
+        return entry;
+    }
+
+    /** The maximum number of visited nodes to search a witness path */
+    size_t m_witness_limit;
+
+    /** The frozen map for searching */
+    FrozenMap m_map;
+
+    /** The version of the map */
+    uint64_t m_map_version;
+
+    /** The checksum of edge costs given by the cost function */
+    uint64_t m_cost_checksum;
+
+    /** All arcs (original edges and shortcuts; children of a shortcut are always before it) */
+    std::vector<Arc> m_arcs;
+
+    /** The contraction order of each node (a larger rank is more important) */
+    std::vector<uint32_t> m_ranks;
+
+    /** The start index of upward arcs of each node in 'm_up_nodes' and 'm_up_arcs' for forward (0) and backward (1) search */
+    std::vector<uint32_t> m_up_offsets[2];
+
+    /** The next nodes of upward arcs for forward (0) and backward (1) search */
+    std::vector<uint32_t> m_up_nodes[2];
+
+    /** Upward arcs for forward (0) and backward (1) search */
+    std::vector<uint32_t> m_up_arcs[2];
+
+    /** Distance of each node from the start (0) or destination (1) node */
+    std::vector<double> m_dist[2];
+
+    /** The arc to each node in the search tree from the start (0) or destination (1) node */
+    std::vector<uint32_t> m_parent[2];
+
+    /** The search generation when each node is labeled (labels of the other generations are invalid) */
+    std::vector<uint32_t> m_stamp[2];
+
+    /** The binary heaps for forward (0) and backward (1) search */
+    std::vector<HeapEntry> m_heap[2];
+
+    /** The number of visited nodes during the last search */
+    size_t m_n_visits;
+
+    /** The current search generation */
+    uint32_t m_generation;
+};
+
+} // End of 'dg'
+
+#endif // End of '__CONTRACTION_HIERARCHY__'
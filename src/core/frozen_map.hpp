@@ -0,0 +1,254 @@
+#ifndef __FROZEN_MAP__
+#define __FROZEN_MAP__
+
+#include "core/map.hpp"
+
+namespace dg
+{
+
+/**
+ * @brief An immutable and compact copy of the topological map
+ *
+ * A <b>frozen map</b> is a read-only snapshot of dg::Map for traversal-heavy modules such as routing, guidance, and localization.
+ * Its nodes and edges are stored as structure-of-arrays (SoA), and its connectivity is stored as compressed sparse row (CSR).
+ * Adjacency of the i-th node is given as the range [adj_offsets[i], adj_offsets[i + 1]) of 'adj_nodes' and 'adj_edges',
+ * so a graph search from node to edge to node only touches contiguous arrays without any ID lookup.
+ *
+ * The order of adjacency for each node follows Node::edge_ids, so the index in the range is same with TopometricPose::edge_idx.
+ * Nodes and edges also keep their indices in dg::Map::nodes and dg::Map::edges.
+ * Member arrays are public for fast access, but they should not be modified after build().
+ */
+class FrozenMap
+{
+public:
+    /** An index value to notify that the given ID does not exist */
+    static const size_t npos = LookupTable::npos;
+
+    /**
+     * The default constructor
+     */
+    FrozenMap() : m_revision(0) { }
+
+    /**
+     * A constructor with a topological map
+     * @param map The given topological map
+     */
+    FrozenMap(const Map& map) : m_revision(0) { build(map); }
+
+    /**
+     * Build this frozen map from the given topological map (time complexity: O(|N| + |E|))
+     * @param map The given topological map
+     * @return True if successful (false if any edge connects an unknown node)
+     */
+    bool build(const Map& map)
+    {
+        clear();
+        const size_t n_nodes = map.nodes.size(), n_edges = map.edges.size();
+
+        // Copy nodes
+        node_ids.reserve(n_nodes);
+        node_lats.reserve(n_nodes);
+        node_lons.reserve(n_nodes);
+        node_types.reserve(n_nodes);
+        node_floors.reserve(n_nodes);
+        m_lookup_nodes.reserve(n_nodes);
+        for (auto node = map.nodes.begin(); node != map.nodes.end(); node++)
+        {
+            m_lookup_nodes.insert(node->id, node_ids.size());
+            node_ids.push_back(node->id);
+            node_lats.push_back(node->lat);
+            node_lons.push_back(node->lon);
+            node_types.push_back(node->type);
+            node_floors.push_back(node->floor);
+        }
+
+        // Copy edges
+        edge_ids.reserve(n_edges);
+        edge_lengths.reserve(n_edges);
+        edge_types.reserve(n_edges);
+        edge_directed.reserve(n_edges);
+        edge_node1s.reserve(n_edges);
+        edge_node2s.reserve(n_edges);
+        m_lookup_edges.reserve(n_edges);
+        for (auto edge = map.edges.begin(); edge != map.edges.end(); edge++)
+        {
+            size_t node1 = m_lookup_nodes.find(edge->node_id1);
+            size_t node2 = m_lookup_nodes.find(edge->node_id2);
+            if (node1 == npos || node2 == npos)
+            {
+                clear();
+                return false;
+            }
+            m_lookup_edges.insert(edge->id, edge_ids.size());
+            edge_ids.push_back(edge->id);
+            edge_lengths.push_back(edge->length);
+            edge_types.push_back(edge->type);
+            edge_directed.push_back(edge->directed ? 1 : 0);
+            edge_node1s.push_back(static_cast<uint32_t>(node1));
+            edge_node2s.push_back(static_cast<uint32_t>(node2));
+        }
+
+        // Build adjacency as CSR (following the order of 'Node::edge_ids')
+        size_t n_adjs = 0;
+        for (auto node = map.nodes.begin(); node != map.nodes.end(); node++)
+            n_adjs += node->edge_ids.size();
+        adj_offsets.reserve(n_nodes + 1);
+        adj_nodes.reserve(n_adjs);
+        adj_edges.reserve(n_adjs);
+        adj_offsets.push_back(0);
+        for (size_t from = 0; from < n_nodes; from++)
+        {
+            const std::vector<ID>& ids = map.nodes[from].edge_ids;
+            for (auto edge_id = ids.begin(); edge_id != ids.end(); edge_id++)
+            {
+                size_t edge = m_lookup_edges.find(*edge_id);
+                if (edge == npos) continue;
+                uint32_t to = (edge_node1s[edge] == from) ? edge_node2s[edge] : edge_node1s[edge];
+                adj_nodes.push_back(to);
+                adj_edges.push_back(static_cast<uint32_t>(edge));
+            }
+            adj_offsets.push_back(static_cast<uint32_t>(adj_nodes.size()));
+        }
+        m_revision = map.getRevision();
+        return true;
+    }
+
+    /**
+     * Remove all data
+     */
+    void clear()
+    {
+        node_ids.clear();
+        node_lats.clear();
+        node_lons.clear();
+        node_types.clear();
+        node_floors.clear();
+        edge_ids.clear();
+        edge_lengths.clear();
+        edge_types.clear();
+        edge_directed.clear();
+        edge_node1s.clear();
+        edge_node2s.clear();
+        adj_offsets.clear();
+        adj_nodes.clear();
+        adj_edges.clear();
+        m_lookup_nodes.clear();
+        m_lookup_edges.clear();
+        m_revision = 0;
+    }
+
+    /**
+     * Check whether this map is empty or not
+     * @return True if empty (false if not empty)
+     */
+    bool isEmpty() const { return node_ids.empty(); }
+
+    /**
+     * Get the revision of the topological map which this map is built from (time complexity: O(1))
+     * @return The revision of the source map (0 if not built)
+     * @see Map::getRevision
+     */
+    uint64_t getRevision() const { return m_revision; }
+
+    /**
+     * Count the number of all nodes (time complexity: O(1))
+     * @return The number of nodes
+     */
+    size_t countNodes() const { return node_ids.size(); }
+
+    /**
+     * Count the number of all edges (time complexity: O(1))
+     * @return The number of edges
+     */
+    size_t countEdges() const { return edge_ids.size(); }
+
+    /**
+     * Count the number of adjacent edges of the given node (time complexity: O(1))
+     * @param node Index of the node
+     * @return The number of adjacent edges
+     */
+    size_t countAdjs(size_t node) const { return adj_offsets[node + 1] - adj_offsets[node]; }
+
+    /**
+     * Find a node using ID (time complexity: O(1))
+     * @param id ID to search
+     * @return Index of the found node (npos if not exist)
+     */
+    size_t findNode(ID id) const { return m_lookup_nodes.find(id); }
+
+    /**
+     * Find an edge using ID (time complexity: O(1))
+     * @param id ID to search
+     * @return Index of the found edge (npos if not exist)
+     */
+    size_t findEdge(ID id) const { return m_lookup_edges.find(id); }
+
+    /**
+     * Find an edge between two nodes (time complexity: O(degree))
+     * @param from Index of the start node
+     * @param to Index of the destination node
+     * @return Index of the found edge (npos if not exist)
+     */
+    size_t findEdge(size_t from, size_t to) const
+    {
+        for (uint32_t i = adj_offsets[from]; i < adj_offsets[from + 1]; i++)
+            if (adj_nodes[i] == to) return adj_edges[i];
+        return npos;
+    }
+
+    /** Node IDs */
+    std::vector<ID> node_ids;
+
+    /** Node latitudes (Unit: [deg]) */
+    std::vector<double> node_lats;
+
+    /** Node longitudes (Unit: [deg]) */
+    std::vector<double> node_lons;
+
+    /** Node types */
+    std::vector<int> node_types;
+
+    /** Node floors */
+    std::vector<int> node_floors;
+
+    /** Edge IDs */
+    std::vector<ID> edge_ids;
+
+    /** Edge lengths (Unit: [m]) */
+    std::vector<double> edge_lengths;
+
+    /** Edge types */
+    std::vector<int> edge_types;
+
+    /** Flags whether each edge is undirected (0) or directed (1) */
+    std::vector<uint8_t> edge_directed;
+
+    /** Indices of the first node of each edge */
+    std::vector<uint32_t> edge_node1s;
+
+    /** Indices of the second node of each edge */
+    std::vector<uint32_t> edge_node2s;
+
+    /** Offsets of adjacency for each node (size: the number of nodes + 1) */
+    std::vector<uint32_t> adj_offsets;
+
+    /** Indices of adjacent nodes */
+    std::vector<uint32_t> adj_nodes;
+
+    /** Indices of adjacent edges */
+    std::vector<uint32_t> adj_edges;
+
+protected:
+    /** A hash table for finding nodes */
+    LookupTable m_lookup_nodes;
+
+    /** A hash table for finding edges */
+    LookupTable m_lookup_edges;
+
+    /** The revision of the source map (0 if not built) */
+    uint64_t m_revision;
+};
+
+} // End of 'dg'
+
+#endif // End of '__FROZEN_MAP__'
@@ -0,0 +1,220 @@
+#ifndef __LOOKUP_TABLE__
+#define __LOOKUP_TABLE__
+
+#include "core/basic_type.hpp"
+
+namespace dg
+{
+
+/**
+ * @brief A hash table from ID to array index
+ *
+ * A <b>lookup table</b> is an open-addressing hash table (linear probing) which maps ID to the index of an element in a vector.
+ * All entries are stored in a single contiguous array without any per-entry heap node, so a lookup usually touches only one cache line.
+ * The array size is always a power of two, and the table grows twice when its load factor exceeds 3/4.
+ * Removal is done by backward-shift deletion, so no tombstone is left.
+ */
+class LookupTable
+{
+public:
+    /** An index value to notify that the given ID does not exist */
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * The default constructor
+     */
+    LookupTable() : m_size(0) { }
+
+    /**
+     * Insert an ID and its index (time complexity: O(1))<br>
+     * The index of the existing ID is not overwritten.
+     * @param id The given ID
+     * @param index The index of the given ID
+     * @return True if inserted (false if the ID already exists)
+     */
+    bool insert(ID id, size_t index)
+    {
+        if ((m_size + 1) * 4 > m_slots.size() * 3) rehash(std::max<size_t>(16, m_slots.size() * 2));
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(id) & mask;; i = (i + 1) & mask)
+        {
+            Slot& slot = m_slots[i];
+            if (slot.index == npos)
+            {
+                slot.id = id;
+                slot.index = index;
+                m_size++;
+                return true;
+            }
+            if (slot.id == id) return false;
+        }
+    }
+
+    /**
+     * Find the index of the given ID (time complexity: O(1))
+     * @param id ID to search
+     * @return The index of the given ID (npos if not exist)
+     */
+    size_t find(ID id) const
+    {
+        if (m_size == 0) return npos;
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(id) & mask;; i = (i + 1) & mask)
+        {
+            const Slot& slot = m_slots[i];
+            if (slot.index == npos) return npos;
+            if (slot.id == id) return slot.index;
+        }
+    }
+
+    /**
+     * Count the number of the given ID (time complexity: O(1))
+     * @param id ID to search
+     * @return The number of the given ID (0 or 1)
+     */
+    size_t count(ID id) const { return (find(id) != npos) ? 1 : 0; }
+
+    /**
+     * Change the index of the existing ID (time complexity: O(1))
+     * @param id The given ID
+     * @param index The new index of the given ID
+     * @return True if successful (false if the ID does not exist)
+     */
+    bool update(ID id, size_t index)
+    {
+        if (m_size == 0) return false;
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(id) & mask;; i = (i + 1) & mask)
+        {
+            Slot& slot = m_slots[i];
+            if (slot.index == npos) return false;
+            if (slot.id == id)
+            {
+                slot.index = index;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Remove the given ID (time complexity: O(1))
+     * @param id ID to remove
+     * @return True if successful (false if the ID does not exist)
+     */
+    bool erase(ID id)
+    {
+        if (m_size == 0) return false;
+        size_t mask = m_slots.size() - 1;
+        size_t hole = hash(id) & mask;
+        for (;; hole = (hole + 1) & mask)
+        {
+            if (m_slots[hole].index == npos) return false;
+            if (m_slots[hole].id == id) break;
+        }
+
+        // Shift the following entries backward to fill the hole
+        for (size_t i = (hole + 1) & mask; m_slots[i].index != npos; i = (i + 1) & mask)
+        {
+            size_t home = hash(m_slots[i].id) & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask))
+            {
+                m_slots[hole] = m_slots[i];
+                hole = i;
+            }
+        }
+        m_slots[hole].index = npos;
+        m_size--;
+        return true;
+    }
+
+    /**
+     * Prepare the table to contain the given number of IDs without rehashing
+     * @param n The expected number of IDs
+     */
+    void reserve(size_t n)
+    {
+        size_t capacity = 16;
+        while (capacity * 3 < n * 4) capacity *= 2;
+        if (capacity > m_slots.size()) rehash(capacity);
+    }
+
+    /**
+     * Remove all IDs
+     */
+    void clear()
+    {
+        m_slots.clear();
+        m_size = 0;
+    }
+
+    /**
+     * Count the number of all IDs (time complexity: O(1))
+     * @return The number of IDs
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     * Check whether this table is empty or not
+     * @return True if empty (false if not empty)
+     */
+    bool empty() const { return (m_size == 0); }
+
+protected:
+    /**
+     * @brief An entry of the lookup table
+     */
+    struct Slot
+    {
+        /** The default constructor to make an empty slot */
+        Slot() : id(0), index(npos) { }
+
+        /** The key ID */
+        ID id;
+
+        /** The value index (npos if this slot is empty) */
+        size_t index;
+    };
+
+    /**
+     * Scramble bits of the given ID (the finalizer of SplitMix64)<br>
+     * Sequential and structured IDs (e.g. 559562564900154) are spread over the whole table.
+     * @param id The given ID
+     * @return The hash value
+     */
+    static size_t hash(ID id)
+    {
+        uint64_t h = id;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h = h ^ (h >> 31);
+        return static_cast<size_t>(h);
+    }
+
+    /**
+     * Rebuild the table with the given number of slots
+     * @param capacity The number of slots (a power of two)
+     */
+    void rehash(size_t capacity)
+    {
+        std::vector<Slot> slots(capacity);
+        m_slots.swap(slots);
+        size_t mask = capacity - 1;
+        for (auto slot = slots.begin(); slot != slots.end(); slot++)
+        {
+            if (slot->index == npos) continue;
+            size_t i = hash(slot->id) & mask;
+            while (m_slots[i].index != npos) i = (i + 1) & mask;
+            m_slots[i] = *slot;
+        }
+    }
+
+    /** The array of slots */
+    std::vector<Slot> m_slots;
+
+    /** The number of stored IDs */
+    size_t m_size;
+};
+
+} // End of 'dg'
+
+#endif // End of '__LOOKUP_TABLE__'
@@ -2,6 +2,9 @@
 #define __MAP__
 
 #include "core/basic_type.hpp"
+#include "core/lookup_table.hpp"
+#include "core/string_pool.hpp"
+#include <atomic>
 
 namespace dg
 {
@@ -55,6 +58,21 @@ public:
      */
     Node(ID _id, const LatLon& ll, int _type = 0, int _floor = 0) : LatLon(ll), id(_id), type(_type), floor(_floor) { }
 
+    /**
+     * The copy constructor
+     */
+    Node(const Node&) = default;
+
+    /**
+     * The move constructor
+     */
+    Node(Node&&) = default;
+
+    /**
+     * The move assignment operator
+     */
+    Node& operator=(Node&&) = default;
+
     /**
      * Overriding the assignment operator
      * @param rhs The right-hand side
@@ -68,6 +86,8 @@ public:
         type   = rhs.type;
         floor  = rhs.floor;
         edge_ids = rhs.edge_ids;
+        edge_idxs = rhs.edge_idxs;
+        adj_node_idxs = rhs.adj_node_idxs;
         return *this;
     }
 
@@ -102,6 +122,18 @@ public:
 
     /** A vector of edge IDs */
     std::vector<ID> edge_ids;
+
+    /**
+     * A vector of edge indices in dg::Map::edges (same order with 'edge_ids')<br>
+     * It is maintained by dg::Map, and an unknown edge is given as LookupTable::npos.
+     */
+    std::vector<size_t> edge_idxs;
+
+    /**
+     * A vector of adjacent node indices in dg::Map::nodes (same order with 'edge_ids')<br>
+     * It is maintained by dg::Map, and an unknown node is given as LookupTable::npos.
+     */
+    std::vector<size_t> adj_node_idxs;
 };
 
 /**
@@ -211,8 +243,8 @@ public:
     /** The identifier */
     ID id;
 
-    /** The name of this POI */
-    std::wstring name;
+    /** The name of this POI (interned, so POIs with the same name share one string; empty by default without locking) */
+    InternedString name;
 
     /** The floor of this POI */
     int floor;
@@ -242,12 +274,137 @@ public:
     double heading;
 };
 
+/**
+ * @brief Indices of elements which are newly added to a map
+ *
+ * A <b>map delta</b> is returned when another map is merged into a map (e.g. loading a new tile).
+ * Downstream modules such as the localizer and map painters can update themselves only with the added elements.
+ */
+class MapDelta
+{
+public:
+    /**
+     * Check whether nothing is added or not
+     * @return True if nothing is added (false if any element is added)
+     */
+    bool empty() const { return nodes.empty() && edges.empty() && pois.empty() && views.empty(); }
+
+    /** Indices of the added nodes in Map::nodes */
+    std::vector<size_t> nodes;
+
+    /** Indices of the added edges in Map::edges */
+    std::vector<size_t> edges;
+
+    /** Indices of the added POIs in Map::pois */
+    std::vector<size_t> pois;
+
+    /** Indices of the added Street-views in Map::views */
+    std::vector<size_t> views;
+};
+
+/**
+ * @brief Changes between two versions of a map
+ *
+ * A <b>map patch</b> contains added, modified, and removed elements (keyed by their IDs) from a base version of a map to its new version.
+ * It is applied to a map in place by Map::applyPatch(), so a long-running session only receives and processes what is changed.
+ * Topology is described by edges, so Node::edge_ids of the given nodes are ignored.
+ */
+class MapPatch
+{
+public:
+    /**
+     * @brief Changes of a kind of elements
+     */
+    template <typename T>
+    class Changes
+    {
+    public:
+        /**
+         * Check whether nothing is changed or not
+         * @return True if nothing is changed (false if any element is changed)
+         */
+        bool empty() const { return added.empty() && modified.empty() && removed.empty(); }
+
+        /**
+         * Count the number of changed elements
+         * @return The number of changed elements
+         */
+        size_t size() const { return added.size() + modified.size() + removed.size(); }
+
+        /** The added elements (their IDs should not exist in the base version) */
+        std::vector<T> added;
+
+        /** The modified elements (their IDs should exist in the base version) */
+        std::vector<T> modified;
+
+        /** IDs of the removed elements */
+        std::vector<ID> removed;
+    };
+
+    /**
+     * The default constructor
+     */
+    MapPatch() : base_version(0), version(0) { }
+
+    /**
+     * Check whether nothing is changed or not
+     * @return True if nothing is changed (false if any element is changed)
+     */
+    bool empty() const { return nodes.empty() && edges.empty() && pois.empty() && views.empty(); }
+
+    /**
+     * Count the number of changed elements
+     * @return The number of changed elements
+     */
+    size_t size() const { return nodes.size() + edges.size() + pois.size() + views.size(); }
+
+    /** The version of a map which this patch is applied to */
+    uint64_t base_version;
+
+    /** The version of the map after applying this patch */
+    uint64_t version;
+
+    /** Changes of nodes */
+    Changes<Node> nodes;
+
+    /**
+     * Changes of edges<br>
+     * Edge::node_id1 and Edge::node_id2 are necessary for the added and modified edges.
+     */
+    Changes<Edge> edges;
+
+    /** Changes of POIs */
+    Changes<POI> pois;
+
+    /** Changes of Street-views */
+    Changes<StreetView> views;
+};
+
 /**
  * @brief A topological map
  */
 class Map
 {
 public:
+    /**
+     * The default constructor
+     */
+    Map() : version(0), revision(newRevision()) { }
+
+    /**
+     * Get the revision of this map (time complexity: O(1))<br>
+     * The revision is changed whenever this map is modified by its member functions or touch(), and it is unique among all maps (a copy has the same revision with its source).
+     * Data derived from this map (e.g. snapshots, spatial indices, and path finders) are out of date if their revisions are different.
+     * @return The revision of this map
+     */
+    uint64_t getRevision() const { return revision; }
+
+    /**
+     * Mark this map as modified (time complexity: O(1))<br>
+     * It is necessary after modifying elements or their attributes directly (member functions of this map call it by themselves).
+     */
+    void touch() { revision = newRevision(); }
+
     /**
      * Add a node (time complexity: O(1))
      * @param node Node to add
@@ -257,10 +414,29 @@ public:
     {
         nodes.push_back(node);
 		size_t node_idx = nodes.size() - 1;
-		lookup_nodes.insert(std::make_pair(node.id, node_idx));
+		lookup_nodes.insert(node.id, node_idx);
+		resolveAdjacency(node_idx, true);
+		touch();
 		return node_idx;
     }
 
+    /**
+     * Add a node without copying (time complexity: O(1))<br>
+     * Capacities of Node::edge_ids are kept, so a node reserved with its degree is filled without reallocation.
+     * @param node Node to add (moved out)
+     * @return A index of the added node
+     */
+    size_t addNode(Node&& node)
+    {
+        ID id = node.id;
+        nodes.push_back(std::move(node));
+        size_t node_idx = nodes.size() - 1;
+        lookup_nodes.insert(id, node_idx);
+        resolveAdjacency(node_idx, true);
+        touch();
+        return node_idx;
+    }
+
     /**
      * Add an edge between two nodes (time complexity: O(1))
      * @param node1 ID of the first node
@@ -271,9 +447,11 @@ public:
      */
     size_t addEdge(ID node1, ID node2, const Edge& info = Edge())
     {
-        Node* node1_ptr = findNode(node1);
-        Node* node2_ptr = findNode(node2);
-        if (node1_ptr == nullptr || node2_ptr == nullptr) return -1;
+        size_t node1_idx = lookup_nodes.find(node1);
+        size_t node2_idx = lookup_nodes.find(node2);
+        if (node1_idx == LookupTable::npos || node2_idx == LookupTable::npos) return -1;
+        Node* node1_ptr = &nodes[node1_idx];
+        Node* node2_ptr = &nodes[node2_idx];
 
         Edge edge = info;
         edge.node_id1 = node1_ptr->id;
@@ -281,8 +459,16 @@ public:
         edges.push_back(edge);
         size_t edge_idx = edges.size() - 1;
         node1_ptr->edge_ids.push_back(edges[edge_idx].id);
-        if (!edge.directed) node2_ptr->edge_ids.push_back(edges[edge_idx].id);
-        lookup_edges.insert(std::make_pair(edge.id, edge_idx));
+        node1_ptr->edge_idxs.push_back(edge_idx);
+        node1_ptr->adj_node_idxs.push_back(node2_idx);
+        if (!edge.directed)
+        {
+            node2_ptr->edge_ids.push_back(edges[edge_idx].id);
+            node2_ptr->edge_idxs.push_back(edge_idx);
+            node2_ptr->adj_node_idxs.push_back(node1_idx);
+        }
+        lookup_edges.insert(edge.id, edge_idx);
+        touch();
         return edge_idx;
     }
 
@@ -291,12 +477,19 @@ public:
      * @param id ID to search
      * @return A pointer to the found node (`nullptr` if not exist)
      */
-    Node* findNode(ID id)
+    Node* findNode(ID id) { return const_cast<Node*>(static_cast<const Map*>(this)->findNode(id)); }
+
+    /**
+     * Find a node using ID (time complexity: O(1))
+     * @param id ID to search
+     * @return A pointer to the found node (`nullptr` if not exist)
+     */
+    const Node* findNode(ID id) const
     {
         assert(nodes.size() == lookup_nodes.size() && lookup_nodes.count(id) <= 1); // Verify ID uniqueness (comment this line if you want speed-up in DEBUG mode)
-        auto found = lookup_nodes.find(id);
-        if (found == lookup_nodes.end()) return nullptr;
-        return &nodes[found->second];
+        size_t found = lookup_nodes.find(id);
+        if (found == LookupTable::npos) return nullptr;
+        return &nodes[found];
     }
 
     /**
@@ -304,33 +497,102 @@ public:
      * @param id ID to search
      * @return A pointer to the found edge (`nullptr` if not exist)
      */
-    Edge* findEdge(ID id)
+    Edge* findEdge(ID id) { return const_cast<Edge*>(static_cast<const Map*>(this)->findEdge(id)); }
+
+    /**
+     * Find an edge using ID (time complexity: O(1))
+     * @param id ID to search
+     * @return A pointer to the found edge (`nullptr` if not exist)
+     */
+    const Edge* findEdge(ID id) const
     {
         assert(edges.size() == lookup_edges.size() && lookup_edges.count(id) <= 1); // Verify ID uniqueness (comment this line if you want speed-up in DEBUG mode)
-        auto found = lookup_edges.find(id);
-        if (found == lookup_edges.end()) return nullptr;
-        return &edges[found->second];
+        size_t found = lookup_edges.find(id);
+        if (found == LookupTable::npos) return nullptr;
+        return &edges[found];
     }
 
     /**
-     * Find an edge using ID (time complexity: O(|E|))
+     * Find an edge using ID (time complexity: O(degree))
+     * @param from ID of the start node
+     * @param to ID of the destination node
+     * @return A pointer to the found edge (`nullptr` if not exist)
+     */
+    Edge* findEdge(ID from, ID to) { return const_cast<Edge*>(static_cast<const Map*>(this)->findEdge(from, to)); }
+
+    /**
+     * Find an edge using ID (time complexity: O(degree))
      * @param from ID of the start node
      * @param to ID of the destination node
      * @return A pointer to the found edge (`nullptr` if not exist)
      */
-    Edge* findEdge(ID from, ID to)
+    const Edge* findEdge(ID from, ID to) const
     {
-        Node* from_ptr = findNode(from);
+        const Node* from_ptr = findNode(from);
         if (from_ptr == nullptr) return nullptr;
-        for (auto edge = from_ptr->edge_ids.begin(); edge != from_ptr->edge_ids.end(); edge++)
+        assert(from_ptr->edge_idxs.size() == from_ptr->edge_ids.size()); // Verify adjacency (call 'rebuildLookup' after modifying 'edge_ids' directly)
+        for (size_t i = 0; i < from_ptr->adj_node_idxs.size(); i++)
         {
-			auto edge_ptr = findEdge(*edge);
-            assert(edge_ptr->node_id1 != 0 && edge_ptr->node_id2 != 0); // Verify connection (comment this line if you want speed-up in DEBUG mode)
-            if (edge_ptr->node_id1 == to || edge_ptr->node_id2 == to) return edge_ptr;
+            size_t to_idx = from_ptr->adj_node_idxs[i];
+            if (to_idx != LookupTable::npos && nodes[to_idx].id == to) return &edges[from_ptr->edge_idxs[i]];
         }
         return nullptr;
     }
 
+    /**
+     * Find the index of a node using ID (time complexity: O(1))
+     * @param id ID to search
+     * @return The index of the found node in 'nodes' (LookupTable::npos if not exist)
+     */
+    size_t findNodeIndex(ID id) const { return lookup_nodes.find(id); }
+
+    /**
+     * Find the index of an edge using ID (time complexity: O(1))
+     * @param id ID to search
+     * @return The index of the found edge in 'edges' (LookupTable::npos if not exist)
+     */
+    size_t findEdgeIndex(ID id) const { return lookup_edges.find(id); }
+
+    /**
+     * Get an adjacent edge of the given node (time complexity: O(1))
+     * @param node The given node in this map
+     * @param adj_idx The order of the edge in Node::edge_ids (e.g. TopometricPose::edge_idx)
+     * @return A pointer to the adjacent edge (`nullptr` if not exist)
+     */
+    Edge* getAdjEdge(const Node* node, size_t adj_idx) { return const_cast<Edge*>(static_cast<const Map*>(this)->getAdjEdge(node, adj_idx)); }
+
+    /**
+     * Get an adjacent edge of the given node (time complexity: O(1))
+     * @param node The given node in this map
+     * @param adj_idx The order of the edge in Node::edge_ids (e.g. TopometricPose::edge_idx)
+     * @return A pointer to the adjacent edge (`nullptr` if not exist)
+     */
+    const Edge* getAdjEdge(const Node* node, size_t adj_idx) const
+    {
+        if (node == nullptr || adj_idx >= node->edge_idxs.size() || node->edge_idxs[adj_idx] == LookupTable::npos) return nullptr;
+        return &edges[node->edge_idxs[adj_idx]];
+    }
+
+    /**
+     * Get an adjacent node of the given node (time complexity: O(1))
+     * @param node The given node in this map
+     * @param adj_idx The order of the connecting edge in Node::edge_ids (e.g. TopometricPose::edge_idx)
+     * @return A pointer to the adjacent node (`nullptr` if not exist)
+     */
+    Node* getAdjNode(const Node* node, size_t adj_idx) { return const_cast<Node*>(static_cast<const Map*>(this)->getAdjNode(node, adj_idx)); }
+
+    /**
+     * Get an adjacent node of the given node (time complexity: O(1))
+     * @param node The given node in this map
+     * @param adj_idx The order of the connecting edge in Node::edge_ids (e.g. TopometricPose::edge_idx)
+     * @return A pointer to the adjacent node (`nullptr` if not exist)
+     */
+    const Node* getAdjNode(const Node* node, size_t adj_idx) const
+    {
+        if (node == nullptr || adj_idx >= node->adj_node_idxs.size() || node->adj_node_idxs[adj_idx] == LookupTable::npos) return nullptr;
+        return &nodes[node->adj_node_idxs[adj_idx]];
+    }
+
 	/**
 	 * Add a POI (time complexity: O(1))
 	 * @param poi POI to add
@@ -340,10 +602,60 @@ public:
 	{
 		pois.push_back(poi);
 		size_t poi_idx = pois.size() - 1;
-		lookup_pois.insert(std::make_pair(poi.id, poi_idx));
+		lookup_pois.insert(poi.id, poi_idx);
+		linkPOIName(poi_idx);
+		touch();
 		return poi_idx;
 	}
 
+	/**
+	 * Find a POI using ID (time complexity: O(1))
+	 * @param id ID to search
+	 * @return A pointer to the found POI (`nullptr` if not exist)
+	 */
+	POI* findPOI(ID id) { return const_cast<POI*>(static_cast<const Map*>(this)->findPOI(id)); }
+
+	/**
+	 * Find a POI using ID (time complexity: O(1))
+	 * @param id ID to search
+	 * @return A pointer to the found POI (`nullptr` if not exist)
+	 */
+	const POI* findPOI(ID id) const
+	{
+		size_t idx = lookup_pois.find(id);
+		return (idx == LookupTable::npos) ? nullptr : &pois[idx];
+	}
+
+	/**
+	 * Find POIs using name (time complexity: O(k) for k POIs with the name)
+	 * @param name Name to search
+	 * @param found Indices of the found POIs (in ascending order)
+	 * @return The number of the found POIs
+	 */
+	size_t findPOIs(const InternedString& name, std::vector<size_t>& found) const
+	{
+		found.clear();
+		for (size_t i = lookup_poi_names.find(name.key()); i != LookupTable::npos && i < pois.size(); i = poi_name_prevs[i])
+		{
+			assert(pois[i].name == name); // Verify the name index (call 'rebuildLookup' after modifying 'pois' directly)
+			found.push_back(i);
+		}
+		std::reverse(found.begin(), found.end());
+		return found.size();
+	}
+
+	/**
+	 * Remove all POIs
+	 */
+	void clearPOIs()
+	{
+		pois.clear();
+		lookup_pois.clear();
+		lookup_poi_names.clear();
+		poi_name_prevs.clear();
+		touch();
+	}
+
 	/**
 	 * Add a Street-view (time complexity: O(1))
 	 * @param view Street-view to add
@@ -353,47 +665,255 @@ public:
 	{
 		views.push_back(view);
 		size_t view_idx = views.size() - 1;
-		lookup_views.insert(std::make_pair(view.id, view_idx));
+		lookup_views.insert(view.id, view_idx);
+		touch();
 		return view_idx;
 	}
 
 	/**
-	 * Get the union of two Map sets
+	 * Find a Street-view using ID (time complexity: O(1))
+	 * @param id ID to search
+	 * @return A pointer to the found Street-view (`nullptr` if not exist)
+	 */
+	StreetView* findView(ID id) { return const_cast<StreetView*>(static_cast<const Map*>(this)->findView(id)); }
+
+	/**
+	 * Find a Street-view using ID (time complexity: O(1))
+	 * @param id ID to search
+	 * @return A pointer to the found Street-view (`nullptr` if not exist)
+	 */
+	const StreetView* findView(ID id) const
+	{
+		size_t idx = lookup_views.find(id);
+		return (idx == LookupTable::npos) ? nullptr : &views[idx];
+	}
+
+	/**
+	 * Remove all Street-views
+	 */
+	void clearViews()
+	{
+		views.clear();
+		lookup_views.clear();
+		touch();
+	}
+
+	/**
+	 * Reserve space for the given number of elements (time complexity: O(|N| + |E| + |P| + |V|))<br>
+	 * It avoids repeated reallocation of vectors and hash tables when many elements are added (e.g. parsing a map).
+	 * @param n_nodes The number of nodes to be stored
+	 * @param n_edges The number of edges to be stored
+	 * @param n_pois The number of POIs to be stored
+	 * @param n_views The number of Street-views to be stored
+	 */
+	void reserve(size_t n_nodes, size_t n_edges, size_t n_pois = 0, size_t n_views = 0)
+	{
+		nodes.reserve(n_nodes);
+		lookup_nodes.reserve(n_nodes);
+		edges.reserve(n_edges);
+		lookup_edges.reserve(n_edges);
+		pois.reserve(n_pois);
+		lookup_pois.reserve(n_pois);
+		views.reserve(n_views);
+		lookup_views.reserve(n_views);
+	}
+
+	/**
+	 * Rebuild all hash tables and adjacency indices of nodes (time complexity: O(|N| + |E| + |P| + |V|))<br>
+	 * It is necessary after modifying 'nodes', 'edges', 'pois', 'views', or Node::edge_ids directly.
+	 */
+	void rebuildLookup()
+	{
+		lookup_nodes.clear();
+		lookup_nodes.reserve(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++) lookup_nodes.insert(nodes[i].id, i);
+		lookup_edges.clear();
+		lookup_edges.reserve(edges.size());
+		for (size_t i = 0; i < edges.size(); i++) lookup_edges.insert(edges[i].id, i);
+		lookup_pois.clear();
+		lookup_pois.reserve(pois.size());
+		for (size_t i = 0; i < pois.size(); i++) lookup_pois.insert(pois[i].id, i);
+		lookup_poi_names.clear();
+		poi_name_prevs.clear();
+		for (size_t i = 0; i < pois.size(); i++) linkPOIName(i);
+		lookup_views.clear();
+		lookup_views.reserve(views.size());
+		for (size_t i = 0; i < views.size(); i++) lookup_views.insert(views[i].id, i);
+		for (size_t i = 0; i < nodes.size(); i++) resolveAdjacency(i);
+		touch();
+	}
+
+	/**
+	 * Merge the given map into this map (time complexity: O(|set2|))<br>
+	 * Elements whose IDs already exist are skipped, but edge IDs of their duplicated nodes are merged.
 	 * @param set2 The given Map set of this union set
+	 * @return Indices of the newly added elements
 	 */
-	void set_union(const Map& set2) 
+	MapDelta set_union(const Map& set2)
 	{
-		Map set1 = *this;
-		
-		for (auto node = set2.lookup_nodes.begin(); node != set2.lookup_nodes.end(); ++node)
+		if (&set2 == this) return MapDelta();
+		return unite(set2.nodes, set2.edges, set2.pois, set2.views);
+	}
+
+	/**
+	 * Merge the given map into this map with moving its elements (time complexity: O(|set2|))<br>
+	 * Elements whose IDs already exist are skipped, but edge IDs of their duplicated nodes are merged.
+	 * @param set2 The given Map set of this union set (its elements are moved out)
+	 * @return Indices of the newly added elements
+	 */
+	MapDelta set_union(Map&& set2)
+	{
+		if (&set2 == this) return MapDelta();
+		MapDelta delta = unite(std::move(set2.nodes), std::move(set2.edges), std::move(set2.pois), std::move(set2.views));
+		set2.nodes.clear();
+		set2.edges.clear();
+		set2.clearPOIs();
+		set2.clearViews();
+		set2.lookup_nodes.clear();
+		set2.lookup_edges.clear();
+		set2.touch();
+		return delta;
+	}
+
+	/**
+	 * Apply the given patch in place (time complexity: O(|patch|) without removal, O(|N| + |E| + |P| + |V|) with removal)<br>
+	 * The patch is verified before modifying this map, so this map is not changed if it fails.
+	 * Edges of the removed nodes are also removed.
+	 * @param patch The given patch (its base version should be same with the version of this map)
+	 * @return True if successful (false if the version is not matched or the patch is not valid)
+	 */
+	bool applyPatch(const MapPatch& patch)
+	{
+		if (patch.base_version != version) return false;
+
+		// Verify IDs of the patch
+		LookupTable removed_nodes, added_nodes, removed_edges, relinked_edges;
+		std::vector<ID> relinked;
+		if (!checkChanges(patch.nodes, lookup_nodes, removed_nodes, added_nodes)) return false;
+		LookupTable added_edges, removed_pois, added_pois, removed_views, added_views;
+		if (!checkChanges(patch.edges, lookup_edges, removed_edges, added_edges)) return false;
+		if (!checkChanges(patch.pois, lookup_pois, removed_pois, added_pois)) return false;
+		if (!checkChanges(patch.views, lookup_views, removed_views, added_views)) return false;
+		for (auto edge = patch.edges.modified.begin(); edge != patch.edges.modified.end(); edge++)
+		{
+			// An edge whose nodes or direction are changed is removed and added again
+			const Edge& prev = edges[lookup_edges.find(edge->id)];
+			if (edge->node_id1 != prev.node_id1 || edge->node_id2 != prev.node_id2 || edge->directed != prev.directed)
+			{
+				relinked_edges.insert(edge->id, 0);
+				relinked.push_back(edge->id);
+			}
+		}
+		for (int k = 0; k < 2; k++)
 		{
-			auto result = set1.lookup_nodes.insert(std::make_pair(node->first, set1.nodes.size()));
-			if( result.second )
-				set1.nodes.push_back(set2.nodes[node->second]);
+			// Nodes of the added and modified edges should exist after applying the patch
+			const std::vector<Edge>& changed = (k == 0) ? patch.edges.added : patch.edges.modified;
+			for (auto edge = changed.begin(); edge != changed.end(); edge++)
+			{
+				const ID ends[] = { edge->node_id1, edge->node_id2 };
+				for (int e = 0; e < 2; e++)
+				{
+					if (k == 1 && relinked_edges.find(edge->id) == LookupTable::npos)
+					{
+						// An edge whose attributes are only changed should not be removed with its nodes
+						if (removed_nodes.find(ends[e]) != LookupTable::npos) return false;
+						continue;
+					}
+					bool exist = (lookup_nodes.find(ends[e]) != LookupTable::npos && removed_nodes.find(ends[e]) == LookupTable::npos);
+					if (!exist && added_nodes.find(ends[e]) == LookupTable::npos) return false;
+				}
+			}
 		}
 
-		for (auto edge = set2.lookup_edges.begin(); edge != set2.lookup_edges.end(); ++edge)
+		// Remove elements (and edges of the removed nodes)
+		bool removed = !patch.nodes.removed.empty() || !patch.edges.removed.empty() || !patch.pois.removed.empty() || !patch.views.removed.empty() || !relinked.empty();
+		if (removed)
 		{
-			auto result = set1.lookup_edges.insert(std::make_pair(edge->first, set1.edges.size()));
-			if (result.second)
-				set1.edges.push_back(set2.edges[edge->second]);
+			for (auto edge = edges.begin(); edge != edges.end(); edge++)
+			{
+				if (removed_nodes.find(edge->node_id1) != LookupTable::npos || removed_nodes.find(edge->node_id2) != LookupTable::npos) removed_edges.insert(edge->id, 0);
+			}
+			for (auto id = relinked.begin(); id != relinked.end(); id++) removed_edges.insert(*id, 0);
+			removeElements(nodes, removed_nodes);
+			removeElements(edges, removed_edges);
+			removeElements(pois, removed_pois);
+			removeElements(views, removed_views);
+			for (auto node = nodes.begin(); node != nodes.end(); node++)
+			{
+				size_t n = 0;
+				for (size_t i = 0; i < node->edge_ids.size(); i++)
+					if (removed_edges.find(node->edge_ids[i]) == LookupTable::npos) node->edge_ids[n++] = node->edge_ids[i];
+				node->edge_ids.resize(n);
+			}
+			rebuildLookup();
 		}
 
-		for (auto poi = set2.lookup_pois.begin(); poi != set2.lookup_pois.end(); ++poi)
+		// Modify attributes of elements
+		for (auto node = patch.nodes.modified.begin(); node != patch.nodes.modified.end(); node++)
+		{
+			Node& dst = nodes[lookup_nodes.find(node->id)];
+			dst.lat = node->lat;
+			dst.lon = node->lon;
+			dst.type = node->type;
+			dst.floor = node->floor;
+		}
+		for (auto edge = patch.edges.modified.begin(); edge != patch.edges.modified.end(); edge++)
+		{
+			if (relinked_edges.find(edge->id) != LookupTable::npos) continue;
+			Edge& dst = edges[lookup_edges.find(edge->id)];
+			dst.length = edge->length;
+			dst.type = edge->type;
+		}
+		bool renamed = false;
+		for (auto poi = patch.pois.modified.begin(); poi != patch.pois.modified.end(); poi++)
 		{
-			auto result = set1.lookup_pois.insert(std::make_pair(poi->first, set1.pois.size()));
-			if (result.second)
-				set1.pois.push_back(set2.pois[poi->second]);
+			POI& dst = pois[lookup_pois.find(poi->id)];
+			renamed = renamed || (dst.name != poi->name);
+			dst = *poi;
 		}
+		if (renamed)
+		{
+			lookup_poi_names.clear();
+			poi_name_prevs.clear();
+			for (size_t i = 0; i < pois.size(); i++) linkPOIName(i);
+		}
+		for (auto view = patch.views.modified.begin(); view != patch.views.modified.end(); view++) views[lookup_views.find(view->id)] = *view;
 
-		for (auto view = set2.lookup_views.begin(); view != set2.lookup_views.end(); ++view)
+		// Add elements
+		reserveMore(nodes, lookup_nodes, patch.nodes.added.size());
+		for (auto node = patch.nodes.added.begin(); node != patch.nodes.added.end(); node++)
 		{
-			auto result = set1.lookup_views.insert(std::make_pair(view->first, set1.views.size()));
-			if (result.second)
-				set1.views.push_back(set2.views[view->second]);
+			Node copy(node->id, *node, node->type, node->floor);
+			addNode(std::move(copy));
 		}
+		reserveMore(edges, lookup_edges, patch.edges.added.size() + relinked.size());
+		for (auto edge = patch.edges.added.begin(); edge != patch.edges.added.end(); edge++) addEdge(edge->node_id1, edge->node_id2, *edge);
+		for (auto edge = patch.edges.modified.begin(); edge != patch.edges.modified.end(); edge++)
+			if (relinked_edges.find(edge->id) != LookupTable::npos) addEdge(edge->node_id1, edge->node_id2, *edge);
+		for (auto poi = patch.pois.added.begin(); poi != patch.pois.added.end(); poi++) addPOI(*poi);
+		for (auto view = patch.views.added.begin(); view != patch.views.added.end(); view++) addView(*view);
+
+		version = patch.version;
+		touch();
+		return true;
+	}
 
-		*this = set1;
+	/**
+	 * Make a patch which changes the given map to the other map (time complexity: O(|N| + |E| + |P| + |V|))
+	 * @param from The given map of the base version
+	 * @param to The given map of the new version
+	 * @return The patch from 'from' to 'to'
+	 */
+	static MapPatch diff(const Map& from, const Map& to)
+	{
+		MapPatch patch;
+		patch.base_version = from.version;
+		patch.version = to.version;
+		diffElements(from.nodes, from.lookup_nodes, to.nodes, to.lookup_nodes, patch.nodes, [](const Node& a, const Node& b) { return a.lat == b.lat && a.lon == b.lon && a.type == b.type && a.floor == b.floor; });
+		diffElements(from.edges, from.lookup_edges, to.edges, to.lookup_edges, patch.edges, [](const Edge& a, const Edge& b) { return a.length == b.length && a.type == b.type && a.directed == b.directed && a.node_id1 == b.node_id1 && a.node_id2 == b.node_id2; });
+		diffElements(from.pois, from.lookup_pois, to.pois, to.lookup_pois, patch.pois, [](const POI& a, const POI& b) { return a.lat == b.lat && a.lon == b.lon && a.name == b.name && a.floor == b.floor; });
+		diffElements(from.views, from.lookup_views, to.views, to.lookup_views, patch.views, [](const StreetView& a, const StreetView& b) { return a.lat == b.lat && a.lon == b.lon && a.floor == b.floor && a.date == b.date && a.heading == b.heading; });
+		return patch;
 	}
 
     /** A vector of nodes */
@@ -408,18 +928,255 @@ public:
     /** A vector of Street-views */
     std::vector<StreetView> views;
 
+    /** The version of this map given by the map server (0 if unknown) */
+    uint64_t version;
+
 protected:
+	/**
+	 * Generate a new revision which is unique in this process (thread-safe)
+	 * @return The new revision
+	 */
+	static uint64_t newRevision()
+	{
+		static std::atomic<uint64_t> counter(0);
+		return ++counter;
+	}
+
+	/** The revision of this map (changed whenever this map is modified) */
+	uint64_t revision;
+
+	/**
+	 * Merge the given elements into this map
+	 * @param src_nodes The given nodes
+	 * @param src_edges The given edges
+	 * @param src_pois The given POIs
+	 * @param src_views The given Street-views
+	 * @return Indices of the newly added elements
+	 */
+	template <typename NodeVec, typename EdgeVec, typename POIVec, typename ViewVec>
+	MapDelta unite(NodeVec&& src_nodes, EdgeVec&& src_edges, POIVec&& src_pois, ViewVec&& src_views)
+	{
+		MapDelta delta;
+		std::vector<size_t> merged;
+		reserveMore(nodes, lookup_nodes, src_nodes.size());
+		for (auto node = src_nodes.begin(); node != src_nodes.end(); node++)
+		{
+			size_t found = lookup_nodes.find(node->id);
+			if (found == LookupTable::npos)
+			{
+				delta.nodes.push_back(nodes.size());
+				lookup_nodes.insert(node->id, nodes.size());
+				nodes.push_back(std::forward<typename std::conditional<std::is_lvalue_reference<NodeVec>::value, const Node&, Node&&>::type>(*node));
+			}
+			else
+			{
+				// Merge connectivity of the duplicated node
+				std::vector<ID>& edge_ids = nodes[found].edge_ids;
+				size_t n_edges = edge_ids.size();
+				for (auto edge_id = node->edge_ids.begin(); edge_id != node->edge_ids.end(); edge_id++)
+					if (std::find(edge_ids.begin(), edge_ids.end(), *edge_id) == edge_ids.end()) edge_ids.push_back(*edge_id);
+				if (edge_ids.size() > n_edges) merged.push_back(found);
+			}
+		}
+		uniteElements(edges, lookup_edges, std::forward<EdgeVec>(src_edges), delta.edges);
+		uniteElements(pois, lookup_pois, std::forward<POIVec>(src_pois), delta.pois);
+		uniteElements(views, lookup_views, std::forward<ViewVec>(src_views), delta.views);
+		for (auto poi_idx = delta.pois.begin(); poi_idx != delta.pois.end(); poi_idx++) linkPOIName(*poi_idx);
+
+		// Resolve adjacency of the added and merged nodes, and the end nodes of the added edges
+		for (auto node_idx = delta.nodes.begin(); node_idx != delta.nodes.end(); node_idx++) resolveAdjacency(*node_idx, true);
+		for (auto node_idx = merged.begin(); node_idx != merged.end(); node_idx++) resolveAdjacency(*node_idx);
+		for (auto edge_idx = delta.edges.begin(); edge_idx != delta.edges.end(); edge_idx++)
+		{
+			size_t node1 = lookup_nodes.find(edges[*edge_idx].node_id1);
+			size_t node2 = lookup_nodes.find(edges[*edge_idx].node_id2);
+			if (node1 != LookupTable::npos) attachEdge(node1, *edge_idx, node2);
+			if (node2 != LookupTable::npos) attachEdge(node2, *edge_idx, node1);
+		}
+		if (!delta.empty() || !merged.empty()) touch();
+		return delta;
+	}
+
+	/**
+	 * Register a POI to the name index (time complexity: O(1))
+	 * @param poi_idx The index of the POI (the last one of the name index)
+	 */
+	void linkPOIName(size_t poi_idx)
+	{
+		ID key = pois[poi_idx].name.key();
+		size_t head = lookup_poi_names.find(key);
+		poi_name_prevs.resize(pois.size(), static_cast<size_t>(LookupTable::npos));
+		poi_name_prevs[poi_idx] = head;
+		if (head == LookupTable::npos) lookup_poi_names.insert(key, poi_idx);
+		else lookup_poi_names.update(key, poi_idx);
+	}
+
+	/**
+	 * Fill the unknown edge index of a node with the given edge (time complexity: O(degree))
+	 * @param node_idx The index of the node
+	 * @param edge_idx The index of the edge
+	 * @param adj_idx The index of the other node of the edge
+	 */
+	void attachEdge(size_t node_idx, size_t edge_idx, size_t adj_idx)
+	{
+		Node& node = nodes[node_idx];
+		if (node.edge_idxs.size() != node.edge_ids.size() || node.adj_node_idxs.size() != node.edge_ids.size())
+		{
+			resolveAdjacency(node_idx);
+			return;
+		}
+		for (size_t i = 0; i < node.edge_ids.size(); i++)
+		{
+			if (node.edge_idxs[i] != LookupTable::npos || node.edge_ids[i] != edges[edge_idx].id) continue;
+			node.edge_idxs[i] = edge_idx;
+			node.adj_node_idxs[i] = adj_idx;
+		}
+	}
+
+	/**
+	 * Find edge and adjacent node indices of a node from its edge IDs (time complexity: O(degree))
+	 * @param node_idx The index of the node
+	 * @param is_new A flag whether the node is newly added (its adjacent nodes are also resolved to refer the node)
+	 */
+	void resolveAdjacency(size_t node_idx, bool is_new = false)
+	{
+		Node& node = nodes[node_idx];
+		node.edge_idxs.resize(node.edge_ids.size());
+		node.adj_node_idxs.resize(node.edge_ids.size());
+		for (size_t i = 0; i < node.edge_ids.size(); i++)
+		{
+			size_t edge_idx = lookup_edges.find(node.edge_ids[i]);
+			node.edge_idxs[i] = edge_idx;
+			node.adj_node_idxs[i] = LookupTable::npos;
+			if (edge_idx == LookupTable::npos) continue;
+			const Edge& edge = edges[edge_idx];
+			node.adj_node_idxs[i] = lookup_nodes.find((edge.node_id1 == node.id) ? edge.node_id2 : edge.node_id1);
+		}
+		if (is_new)
+		{
+			// Let the adjacent nodes refer this node through the same edges
+			for (size_t i = 0; i < node.adj_node_idxs.size(); i++)
+			{
+				if (node.adj_node_idxs[i] == LookupTable::npos) continue;
+				Node& adj = nodes[node.adj_node_idxs[i]];
+				for (size_t j = 0; j < adj.edge_idxs.size(); j++)
+					if (adj.edge_idxs[j] == node.edge_idxs[i] && adj.adj_node_idxs[j] == LookupTable::npos) adj.adj_node_idxs[j] = node_idx;
+			}
+		}
+	}
+
+	/**
+	 * Merge the given elements into the given vector if their IDs do not exist
+	 * @param dst The destination vector
+	 * @param lookup The hash table of the destination vector
+	 * @param src The given elements (moved if given as rvalue)
+	 * @param added Indices of the newly added elements (return value)
+	 */
+	template <typename T, typename SrcVec>
+	static void uniteElements(std::vector<T>& dst, LookupTable& lookup, SrcVec&& src, std::vector<size_t>& added)
+	{
+		reserveMore(dst, lookup, src.size());
+		for (auto item = src.begin(); item != src.end(); item++)
+		{
+			if (!lookup.insert(item->id, dst.size())) continue;
+			added.push_back(dst.size());
+			dst.push_back(std::forward<typename std::conditional<std::is_lvalue_reference<SrcVec>::value, const T&, T&&>::type>(*item));
+		}
+	}
+
+	/**
+	 * Verify IDs of the given changes
+	 * @param changes The given changes
+	 * @param lookup The hash table of the current elements
+	 * @param removed IDs of the removed elements (return value)
+	 * @param added IDs of the added elements (return value)
+	 * @return True if the removed and modified IDs exist and the added IDs do not exist after removal (false if not)
+	 */
+	template <typename T>
+	static bool checkChanges(const MapPatch::Changes<T>& changes, const LookupTable& lookup, LookupTable& removed, LookupTable& added)
+	{
+		for (auto id = changes.removed.begin(); id != changes.removed.end(); id++)
+			if (lookup.find(*id) == LookupTable::npos || !removed.insert(*id, 0)) return false;
+		for (auto item = changes.modified.begin(); item != changes.modified.end(); item++)
+			if (lookup.find(item->id) == LookupTable::npos || removed.find(item->id) != LookupTable::npos) return false;
+		for (auto item = changes.added.begin(); item != changes.added.end(); item++)
+		{
+			if (lookup.find(item->id) != LookupTable::npos && removed.find(item->id) == LookupTable::npos) return false;
+			if (!added.insert(item->id, 0)) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Remove elements with the given IDs with keeping the order of the others<br>
+	 * The elements are copied (or moved) into a new vector because Edge::operator= does not copy Edge::directed.
+	 * @param dst The destination vector
+	 * @param removed IDs of the removed elements
+	 */
+	template <typename T>
+	static void removeElements(std::vector<T>& dst, const LookupTable& removed)
+	{
+		if (removed.empty()) return;
+		std::vector<T> kept;
+		kept.reserve(dst.size());
+		for (auto item = dst.begin(); item != dst.end(); item++)
+			if (removed.find(item->id) == LookupTable::npos) kept.push_back(std::move(*item));
+		dst.swap(kept);
+	}
+
+	/**
+	 * Find changes between the given elements
+	 * @param from The elements of the base version
+	 * @param from_lookup The hash table of 'from'
+	 * @param to The elements of the new version
+	 * @param to_lookup The hash table of 'to'
+	 * @param changes The changes from 'from' to 'to' (return value)
+	 * @param equal A function which checks whether two elements with the same ID have the same attributes
+	 */
+	template <typename T, typename Equal>
+	static void diffElements(const std::vector<T>& from, const LookupTable& from_lookup, const std::vector<T>& to, const LookupTable& to_lookup, MapPatch::Changes<T>& changes, Equal equal)
+	{
+		for (auto item = to.begin(); item != to.end(); item++)
+		{
+			size_t idx = from_lookup.find(item->id);
+			if (idx == LookupTable::npos) changes.added.push_back(*item);
+			else if (!equal(from[idx], *item)) changes.modified.push_back(*item);
+		}
+		for (auto item = from.begin(); item != from.end(); item++)
+			if (to_lookup.find(item->id) == LookupTable::npos) changes.removed.push_back(item->id);
+	}
+
+	/**
+	 * Reserve space for more elements with keeping geometric growth
+	 * @param dst The destination vector
+	 * @param lookup The hash table of the destination vector
+	 * @param n The number of elements to be added at most
+	 */
+	template <typename T>
+	static void reserveMore(std::vector<T>& dst, LookupTable& lookup, size_t n)
+	{
+		size_t required = dst.size() + n;
+		if (required > dst.capacity()) dst.reserve(std::max(required, 2 * dst.capacity()));
+		lookup.reserve(required);
+	}
+
     /** A hash table for finding nodes */
-    std::map<ID, size_t> lookup_nodes;
+    LookupTable lookup_nodes;
 
     /** A hash table for finding edges */
-    std::map<ID, size_t> lookup_edges;
+    LookupTable lookup_edges;
 
 	/** A hash table for finding POIs */
-	std::map<ID, size_t> lookup_pois;
+	LookupTable lookup_pois;
+
+	/** A hash table for finding the last POI of each name */
+	LookupTable lookup_poi_names;
+
+	/** The previous POI with the same name for each POI (LookupTable::npos if not exist) */
+	std::vector<size_t> poi_name_prevs;
 
 	/** A hash table for finding Street-views */
-	std::map<ID, size_t> lookup_views;
+	LookupTable lookup_views;
 };
 
 } // End of 'dg'
@@ -0,0 +1,680 @@
+#ifndef __MAP_FILE__
+#define __MAP_FILE__
+
+#include "core/map.hpp"
+#include "core/contraction_hierarchy.hpp"
+#include "core/mapped_file.hpp"
+
+namespace dg
+{
+
+/**
+ * @brief A memory-mapped binary file of the topological map
+ *
+ * A <b>map file</b> (*.dgmap) stores nodes, edges, POIs, and Street-views of dg::Map in a versioned binary format.
+ * The file is opened with memory mapping, and its records are accessed directly without parsing and copying (zero-copy).
+ * Multiple processes opening the same file share the same physical pages.
+ * If a dg::Map instance is necessary, toMap() copies all records into it.
+ * The overlay of ContractionHierarchy can be stored alongside the map file (*.dgch), so route queries are ready without preprocessing.
+ *
+ * <b>File Format (Version 2)</b>
+ *
+ * All numbers are little-endian, and all sections are aligned with 8 bytes.
+ * - Header: magic ("DGMAP"), version, the number of elements and the byte offset of each section, and the version of the map
+ * - Nodes: an array of NodeRecord
+ * - Node edges: an array of edge IDs (64-bit) referred by NodeRecord::edge_offset and NodeRecord::edge_count
+ * - Edges: an array of EdgeRecord
+ * - POIs: an array of POIRecord
+ * - POI names: a string table of UTF-16 characters (16-bit) referred by POIRecord::name_offset and POIRecord::name_length
+ * - Street-views: an array of ViewRecord
+ * - Street-view dates: a string table of characters (8-bit) referred by ViewRecord::date_offset and ViewRecord::date_length
+ */
+class MapFile
+{
+public:
+    /** The version of the file format */
+    static const uint32_t VERSION = 2;
+
+    /** Indices of sections */
+    enum
+    {
+        SECTION_NODES = 0,
+        SECTION_NODE_EDGES,
+        SECTION_EDGES,
+        SECTION_POIS,
+        SECTION_POI_NAMES,
+        SECTION_VIEWS,
+        SECTION_VIEW_DATES,
+        SECTION_NUM
+    };
+
+    /**
+     * @brief The header of a map file
+     */
+    struct Header
+    {
+        /** The magic string ("DGMAP") */
+        char magic[8];
+
+        /** The version of the file format */
+        uint32_t version;
+
+        /** The size of this header (Unit: [byte]) */
+        uint32_t header_size;
+
+        /** The number of elements in each section */
+        uint64_t counts[SECTION_NUM];
+
+        /** The byte offset of each section from the beginning of the file */
+        uint64_t offsets[SECTION_NUM];
+
+        /** The version of the map (Map::version) */
+        uint64_t map_version;
+    };
+
+    /**
+     * @brief A node record of a map file
+     */
+    struct NodeRecord
+    {
+        /** The identifier */
+        ID id;
+
+        /** The latitude (Unit: [deg]) */
+        double lat;
+
+        /** The longitude (Unit: [deg]) */
+        double lon;
+
+        /** The type of node */
+        int32_t type;
+
+        /** The floor of node */
+        int32_t floor;
+
+        /** The index of the first edge ID in the node edge section */
+        uint64_t edge_offset;
+
+        /** The number of edge IDs */
+        uint32_t edge_count;
+
+        /** Reserved for alignment */
+        uint32_t reserved;
+    };
+
+    /**
+     * @brief An edge record of a map file
+     */
+    struct EdgeRecord
+    {
+        /** The identifier */
+        ID id;
+
+        /** The length of edge (Unit: [m]) */
+        double length;
+
+        /** The identifier of the first node */
+        ID node_id1;
+
+        /** The identifier of the second node */
+        ID node_id2;
+
+        /** The type of edge */
+        int32_t type;
+
+        /** A flag whether this edge is undirected (0) or directed (1) */
+        uint8_t directed;
+
+        /** Reserved for alignment */
+        uint8_t reserved[3];
+    };
+
+    /**
+     * @brief A POI record of a map file
+     */
+    struct POIRecord
+    {
+        /** The identifier */
+        ID id;
+
+        /** The latitude (Unit: [deg]) */
+        double lat;
+
+        /** The longitude (Unit: [deg]) */
+        double lon;
+
+        /** The floor of this POI */
+        int32_t floor;
+
+        /** The number of UTF-16 characters of the name */
+        uint32_t name_length;
+
+        /** The index of the first character of the name in the POI name section */
+        uint64_t name_offset;
+    };
+
+    /**
+     * @brief A Street-view record of a map file
+     */
+    struct ViewRecord
+    {
+        /** The identifier */
+        ID id;
+
+        /** The latitude (Unit: [deg]) */
+        double lat;
+
+        /** The longitude (Unit: [deg]) */
+        double lon;
+
+        /** The True north-based azimuth (Unit: [deg]) */
+        double heading;
+
+        /** The floor of this Street-view */
+        int32_t floor;
+
+        /** The number of characters of the date */
+        uint32_t date_length;
+
+        /** The index of the first character of the date in the Street-view date section */
+        uint64_t date_offset;
+    };
+
+    /**
+     * The default constructor
+     */
+    MapFile() : m_data(nullptr), m_size(0), m_header(nullptr) { }
+
+    /**
+     * The destructor
+     */
+    ~MapFile() { close(); }
+
+    /**
+     * Open a map file with memory mapping
+     * @param filename The filename to read a map
+     * @return True if successful (false if failed or the file is invalid)
+     */
+    bool open(const char* filename)
+    {
+        close();
+        if (!m_file.open(filename)) return false;
+        if (m_file.size() < sizeof(Header))
+        {
+            close();
+            return false;
+        }
+        m_data = m_file.data();
+        m_size = m_file.size();
+        m_header = reinterpret_cast<const Header*>(m_data);
+        if (!verify())
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Close the opened map file<br>
+     * All pointers given by this instance become invalid.
+     */
+    void close()
+    {
+        m_file.close();
+        m_data = nullptr;
+        m_size = 0;
+        m_header = nullptr;
+    }
+
+    /**
+     * Check whether a map file is opened or not
+     * @return True if opened (false if not opened)
+     */
+    bool isOpened() const { return (m_header != nullptr); }
+
+    /**
+     * Get the version of the opened map file
+     * @return The version (0 if not opened)
+     */
+    uint32_t getVersion() const { return isOpened() ? m_header->version : 0; }
+
+    /**
+     * Get the version of the map in the opened map file
+     * @return The version of the map (0 if not opened or unknown)
+     */
+    uint64_t getMapVersion() const { return isOpened() ? m_header->map_version : 0; }
+
+    /**
+     * Count the number of nodes
+     * @return The number of nodes
+     */
+    size_t countNodes() const { return count(SECTION_NODES); }
+
+    /**
+     * Count the number of edges
+     * @return The number of edges
+     */
+    size_t countEdges() const { return count(SECTION_EDGES); }
+
+    /**
+     * Count the number of POIs
+     * @return The number of POIs
+     */
+    size_t countPOIs() const { return count(SECTION_POIS); }
+
+    /**
+     * Count the number of Street-views
+     * @return The number of Street-views
+     */
+    size_t countViews() const { return count(SECTION_VIEWS); }
+
+    /**
+     * Get the array of nodes (zero-copy)
+     * @return A pointer to the first node record (`nullptr` if not opened)
+     */
+    const NodeRecord* getNodes() const { return section<NodeRecord>(SECTION_NODES); }
+
+    /**
+     * Get edge IDs of the given node (zero-copy)
+     * @param node_idx The index of the node
+     * @return A pointer to the first edge ID of the node (the number of IDs is given as NodeRecord::edge_count)
+     */
+    const ID* getNodeEdgeIDs(size_t node_idx) const { return section<ID>(SECTION_NODE_EDGES) + getNodes()[node_idx].edge_offset; }
+
+    /**
+     * Get the array of edges (zero-copy)
+     * @return A pointer to the first edge record (`nullptr` if not opened)
+     */
+    const EdgeRecord* getEdges() const { return section<EdgeRecord>(SECTION_EDGES); }
+
+    /**
+     * Get the array of POIs (zero-copy)
+     * @return A pointer to the first POI record (`nullptr` if not opened)
+     */
+    const POIRecord* getPOIs() const { return section<POIRecord>(SECTION_POIS); }
+
+    /**
+     * Get the name of the given POI in UTF-16 (zero-copy)
+     * @param poi_idx The index of the POI
+     * @return A pointer to the first character of the name (the length is given as POIRecord::name_length)
+     */
+    const uint16_t* getPOIName(size_t poi_idx) const { return section<uint16_t>(SECTION_POI_NAMES) + getPOIs()[poi_idx].name_offset; }
+
+    /**
+     * Get the name of the given POI as a wide string
+     * @param poi_idx The index of the POI
+     * @return The name of the POI
+     */
+    std::wstring getPOINameW(size_t poi_idx) const { return cvtUTF16ToWString(getPOIName(poi_idx), getPOIs()[poi_idx].name_length); }
+
+    /**
+     * Get the array of Street-views (zero-copy)
+     * @return A pointer to the first Street-view record (`nullptr` if not opened)
+     */
+    const ViewRecord* getViews() const { return section<ViewRecord>(SECTION_VIEWS); }
+
+    /**
+     * Get the date of the given Street-view (zero-copy)
+     * @param view_idx The index of the Street-view
+     * @return A pointer to the first character of the date (the length is given as ViewRecord::date_length)
+     */
+    const char* getViewDate(size_t view_idx) const { return section<char>(SECTION_VIEW_DATES) + getViews()[view_idx].date_offset; }
+
+    /**
+     * Copy all records of the opened map file to the given map (time complexity: O(|N| + |E| + |P| + |V|))
+     * @param map The map to be filled (its previous data are removed)
+     * @return True if successful (false if not opened)
+     */
+    bool toMap(Map& map) const
+    {
+        if (!isOpened()) return false;
+        map.nodes.clear();
+        map.edges.clear();
+        map.pois.clear();
+        map.views.clear();
+
+        const NodeRecord* nodes = getNodes();
+        map.nodes.resize(countNodes());
+        for (size_t i = 0; i < map.nodes.size(); i++)
+        {
+            Node& node = map.nodes[i];
+            node.id = nodes[i].id;
+            node.lat = nodes[i].lat;
+            node.lon = nodes[i].lon;
+            node.type = nodes[i].type;
+            node.floor = nodes[i].floor;
+            const ID* edge_ids = getNodeEdgeIDs(i);
+            node.edge_ids.assign(edge_ids, edge_ids + nodes[i].edge_count);
+        }
+
+        const EdgeRecord* edges = getEdges();
+        map.edges.reserve(countEdges());
+        for (size_t i = 0; i < countEdges(); i++)
+            map.edges.push_back(Edge(edges[i].id, edges[i].length, edges[i].type, edges[i].directed != 0, edges[i].node_id1, edges[i].node_id2));
+
+        const POIRecord* pois = getPOIs();
+        map.pois.resize(countPOIs());
+        for (size_t i = 0; i < map.pois.size(); i++)
+        {
+            POI& poi = map.pois[i];
+            poi.id = pois[i].id;
+            poi.lat = pois[i].lat;
+            poi.lon = pois[i].lon;
+            poi.floor = pois[i].floor;
+            poi.name = getPOINameW(i);
+        }
+
+        const ViewRecord* views = getViews();
+        map.views.resize(countViews());
+        for (size_t i = 0; i < map.views.size(); i++)
+        {
+            StreetView& view = map.views[i];
+            view.id = views[i].id;
+            view.lat = views[i].lat;
+            view.lon = views[i].lon;
+            view.heading = views[i].heading;
+            view.floor = views[i].floor;
+            view.date.assign(getViewDate(i), views[i].date_length);
+        }
+
+        map.version = m_header->map_version;
+        map.rebuildLookup();
+        return true;
+    }
+
+    /**
+     * Write the given map to a map file
+     * @param filename The filename to write the map
+     * @param map The map to write
+     * @return True if successful (false if failed)
+     */
+    static bool save(const char* filename, const Map& map)
+    {
+        if (filename == nullptr) return false;
+
+        // Prepare records and string tables
+        std::vector<NodeRecord> nodes(map.nodes.size());
+        std::vector<ID> node_edges;
+        for (size_t i = 0; i < map.nodes.size(); i++)
+        {
+            const Node& node = map.nodes[i];
+            NodeRecord& rec = nodes[i];
+            memset(&rec, 0, sizeof(rec));
+            rec.id = node.id;
+            rec.lat = node.lat;
+            rec.lon = node.lon;
+            rec.type = node.type;
+            rec.floor = node.floor;
+            rec.edge_offset = node_edges.size();
+            rec.edge_count = static_cast<uint32_t>(node.edge_ids.size());
+            node_edges.insert(node_edges.end(), node.edge_ids.begin(), node.edge_ids.end());
+        }
+
+        std::vector<EdgeRecord> edges(map.edges.size());
+        for (size_t i = 0; i < map.edges.size(); i++)
+        {
+            const Edge& edge = map.edges[i];
+            EdgeRecord& rec = edges[i];
+            memset(&rec, 0, sizeof(rec));
+            rec.id = edge.id;
+            rec.length = edge.length;
+            rec.node_id1 = edge.node_id1;
+            rec.node_id2 = edge.node_id2;
+            rec.type = edge.type;
+            rec.directed = edge.directed ? 1 : 0;
+        }
+
+        std::vector<POIRecord> pois(map.pois.size());
+        std::vector<uint16_t> poi_names;
+        for (size_t i = 0; i < map.pois.size(); i++)
+        {
+            const POI& poi = map.pois[i];
+            POIRecord& rec = pois[i];
+            memset(&rec, 0, sizeof(rec));
+            rec.id = poi.id;
+            rec.lat = poi.lat;
+            rec.lon = poi.lon;
+            rec.floor = poi.floor;
+            rec.name_offset = poi_names.size();
+            cvtWStringToUTF16(poi.name, poi_names);
+            rec.name_length = static_cast<uint32_t>(poi_names.size() - rec.name_offset);
+        }
+
+        std::vector<ViewRecord> views(map.views.size());
+        std::string view_dates;
+        for (size_t i = 0; i < map.views.size(); i++)
+        {
+            const StreetView& view = map.views[i];
+            ViewRecord& rec = views[i];
+            memset(&rec, 0, sizeof(rec));
+            rec.id = view.id;
+            rec.lat = view.lat;
+            rec.lon = view.lon;
+            rec.heading = view.heading;
+            rec.floor = view.floor;
+            rec.date_offset = view_dates.size();
+            rec.date_length = static_cast<uint32_t>(view.date.size());
+            view_dates += view.date;
+        }
+
+        // Fill the header
+        Header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "DGMAP", 5);
+        header.version = VERSION;
+        header.header_size = sizeof(Header);
+        header.map_version = map.version;
+        const void* data[SECTION_NUM] = { nodes.data(), node_edges.data(), edges.data(), pois.data(), poi_names.data(), views.data(), view_dates.data() };
+        const size_t sizes[SECTION_NUM] = { sizeof(NodeRecord), sizeof(ID), sizeof(EdgeRecord), sizeof(POIRecord), sizeof(uint16_t), sizeof(ViewRecord), sizeof(char) };
+        header.counts[SECTION_NODES] = nodes.size();
+        header.counts[SECTION_NODE_EDGES] = node_edges.size();
+        header.counts[SECTION_EDGES] = edges.size();
+        header.counts[SECTION_POIS] = pois.size();
+        header.counts[SECTION_POI_NAMES] = poi_names.size();
+        header.counts[SECTION_VIEWS] = views.size();
+        header.counts[SECTION_VIEW_DATES] = view_dates.size();
+        uint64_t offset = align(sizeof(Header));
+        for (int s = 0; s < SECTION_NUM; s++)
+        {
+            header.offsets[s] = offset;
+            offset = align(offset + header.counts[s] * sizes[s]);
+        }
+
+        // Write the header and sections
+        FILE* file = fopen(filename, "wb");
+        if (file == nullptr) return false;
+        const char padding[8] = { 0 };
+        bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+        uint64_t written = sizeof(header);
+        for (int s = 0; ok && s < SECTION_NUM; s++)
+        {
+            ok &= (fwrite(padding, 1, static_cast<size_t>(header.offsets[s] - written), file) == header.offsets[s] - written);
+            size_t bytes = static_cast<size_t>(header.counts[s] * sizes[s]);
+            if (bytes > 0) ok &= (fwrite(data[s], 1, bytes, file) == bytes);
+            written = header.offsets[s] + bytes;
+        }
+        ok &= (fwrite(padding, 1, static_cast<size_t>(offset - written), file) == offset - written);
+        fclose(file);
+        return ok;
+    }
+
+    /**
+     * Write the given map and the overlay of its contraction hierarchy<br>
+     * The overlay is written to the filename whose extension is replaced with "dgch" (e.g. "map.dgmap" and "map.dgch").
+     * @param filename The filename to write the map
+     * @param map The map to write
+     * @param hierarchy The contraction hierarchy built with the map
+     * @return True if successful (false if failed or the hierarchy is not built with the map)
+     */
+    static bool save(const char* filename, const Map& map, const ContractionHierarchy& hierarchy)
+    {
+        if (!hierarchy.isBuilt(map) || !save(filename, map)) return false;
+        return hierarchy.save(getOverlayFilename(filename).c_str());
+    }
+
+    /**
+     * Read the overlay of a contraction hierarchy stored alongside the given map file
+     * @param filename The filename of the map
+     * @param map The map read from the file (e.g. by toMap())
+     * @param hierarchy The contraction hierarchy to restore (return value)
+     * @param cost The cost function of edges which the overlay was built with (e.g. dg::RoadProfile)
+     * @return True if successful (false if there is no overlay or it does not match with the map or the cost function)
+     */
+    template <typename CostFunction>
+    static bool loadOverlay(const char* filename, const Map& map, ContractionHierarchy& hierarchy, CostFunction cost)
+    {
+        if (filename == nullptr) return false;
+        return hierarchy.load(getOverlayFilename(filename).c_str(), map, cost);
+    }
+
+    /**
+     * Read the overlay of a contraction hierarchy, which was built with the default cost function, stored alongside the given map file
+     * @param filename The filename of the map
+     * @param map The map read from the file (e.g. by toMap())
+     * @param hierarchy The contraction hierarchy to restore (return value)
+     * @return True if successful (false if there is no overlay or it does not match with the map or the default cost function)
+     */
+    static bool loadOverlay(const char* filename, const Map& map, ContractionHierarchy& hierarchy) { return loadOverlay(filename, map, hierarchy, RoadProfile()); }
+
+    /**
+     * Get the filename of the overlay of a contraction hierarchy for the given map file
+     * @param filename The filename of the map (e.g. "map.dgmap")
+     * @return The filename of the overlay (e.g. "map.dgch")
+     */
+    static std::string getOverlayFilename(const char* filename)
+    {
+        std::string name(filename);
+        size_t dot = name.find_last_of('.'), slash = name.find_last_of("/\\");
+        if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) name.erase(dot);
+        return name + ".dgch";
+    }
+
+    /**
+     * Convert a wide string to UTF-16 characters
+     * @param src The given wide string (UTF-16 if 'wchar_t' is 16-bit, otherwise UTF-32)
+     * @param dst The converted UTF-16 characters (appended)
+     */
+    static void cvtWStringToUTF16(const std::wstring& src, std::vector<uint16_t>& dst)
+    {
+        for (auto ch = src.begin(); ch != src.end(); ch++)
+        {
+            uint32_t code = static_cast<uint32_t>(*ch);
+            if (sizeof(wchar_t) > 2 && code >= 0x10000)
+            {
+                code -= 0x10000;
+                dst.push_back(static_cast<uint16_t>(0xD800 + (code >> 10)));
+                dst.push_back(static_cast<uint16_t>(0xDC00 + (code & 0x3FF)));
+            }
+            else dst.push_back(static_cast<uint16_t>(code));
+        }
+    }
+
+    /**
+     * Convert UTF-16 characters to a wide string
+     * @param src A pointer to the given UTF-16 characters
+     * @param length The number of the given UTF-16 characters
+     * @return The converted wide string (UTF-16 if 'wchar_t' is 16-bit, otherwise UTF-32)
+     */
+    static std::wstring cvtUTF16ToWString(const uint16_t* src, size_t length)
+    {
+        std::wstring dst;
+        dst.reserve(length);
+        for (size_t i = 0; i < length; i++)
+        {
+            uint32_t code = src[i];
+            if (sizeof(wchar_t) > 2 && code >= 0xD800 && code < 0xDC00 && i + 1 < length)
+            {
+                code = 0x10000 + ((code - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+                i++;
+            }
+            dst.push_back(static_cast<wchar_t>(code));
+        }
+        return dst;
+    }
+
+protected:
+    /**
+     * Verify the header and sections of the mapped file
+     * @return True if valid (false if invalid)
+     */
+    bool verify() const
+    {
+        if (memcmp(m_header->magic, "DGMAP", 5) != 0 || m_header->version != VERSION || m_header->header_size != sizeof(Header)) return false;
+        const uint64_t sizes[SECTION_NUM] = { sizeof(NodeRecord), sizeof(ID), sizeof(EdgeRecord), sizeof(POIRecord), sizeof(uint16_t), sizeof(ViewRecord), sizeof(char) };
+        for (int s = 0; s < SECTION_NUM; s++)
+        {
+            if (m_header->offsets[s] % 8 != 0 || m_header->offsets[s] > m_size) return false;
+            if (m_header->counts[s] > (m_size - m_header->offsets[s]) / sizes[s]) return false;
+        }
+
+        // Verify references to the edge IDs and string tables
+        const NodeRecord* nodes = getNodes();
+        for (size_t i = 0; i < countNodes(); i++)
+            if (!isInRange(nodes[i].edge_offset, nodes[i].edge_count, m_header->counts[SECTION_NODE_EDGES])) return false;
+        const POIRecord* pois = getPOIs();
+        for (size_t i = 0; i < countPOIs(); i++)
+            if (!isInRange(pois[i].name_offset, pois[i].name_length, m_header->counts[SECTION_POI_NAMES])) return false;
+        const ViewRecord* views = getViews();
+        for (size_t i = 0; i < countViews(); i++)
+            if (!isInRange(views[i].date_offset, views[i].date_length, m_header->counts[SECTION_VIEW_DATES])) return false;
+        return true;
+    }
+
+    /**
+     * Check whether the given range is inside of a section without overflow of (offset + length)
+     * @param offset The index of the first element of the range
+     * @param length The number of elements of the range
+     * @param total The number of elements of the section
+     * @return True if the range is inside (false if not)
+     */
+    static bool isInRange(uint64_t offset, uint64_t length, uint64_t total)
+    {
+        return offset <= total && length <= total - offset;
+    }
+
+    /**
+     * Count the number of elements in the given section
+     * @param s The index of the section
+     * @return The number of elements (0 if not opened)
+     */
+    size_t count(int s) const { return isOpened() ? static_cast<size_t>(m_header->counts[s]) : 0; }
+
+    /**
+     * Get the beginning of the given section
+     * @param s The index of the section
+     * @return A pointer to the beginning of the section (`nullptr` if not opened)
+     */
+    template <typename T>
+    const T* section(int s) const { return isOpened() ? reinterpret_cast<const T*>(m_data + m_header->offsets[s]) : nullptr; }
+
+    /**
+     * Align the given byte offset with 8 bytes
+     * @param offset The given byte offset
+     * @return The aligned byte offset
+     */
+    static uint64_t align(uint64_t offset) { return (offset + 7) & ~static_cast<uint64_t>(7); }
+
+    /** The mapped data */
+    const char* m_data;
+
+    /** The size of the mapped data (Unit: [byte]) */
+    size_t m_size;
+
+    /** The header of the mapped data */
+    const Header* m_header;
+
+    /** The memory-mapped file */
+    MappedFile m_file;
+
+private:
+    /** Disable the copy constructor */
+    MapFile(const MapFile&);
+
+    /** Disable the assignment operator */
+    MapFile& operator=(const MapFile&);
+};
+
+} // End of 'dg'
+
+#endif // End of '__MAP_FILE__'
@@ -0,0 +1,160 @@
+#ifndef __MAPPED_FILE__
+#define __MAPPED_FILE__
+
+#include <cstddef>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace dg
+{
+
+/**
+ * @brief A read-only memory-mapped file
+ *
+ * A <b>mapped file</b> maps the whole file into memory, so its data are read without copying into a buffer.
+ * Pages are loaded on demand by the operating system, and they are shared with other processes which read the same file.
+ * Binary formats (e.g. MapFile) and text formats (e.g. CSV files of RoadMap) are parsed on top of it.
+ */
+class MappedFile
+{
+public:
+    /**
+     * The default constructor
+     */
+    MappedFile() : m_data(nullptr), m_size(0)
+    {
+#ifdef _WIN32
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = nullptr;
+#else
+        m_fd = -1;
+#endif
+    }
+
+    /**
+     * The destructor
+     */
+    ~MappedFile() { close(); }
+
+    /**
+     * Open the given file with memory mapping (an empty file is opened without data)
+     * @param filename The filename to open
+     * @return True if successful (false if failed)
+     */
+    bool open(const char* filename)
+    {
+        close();
+        if (filename == nullptr) return false;
+#ifdef _WIN32
+        m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size)) goto MAPPEDFILE_OPEN_FAIL;
+        m_size = static_cast<size_t>(size.QuadPart);
+        if (m_size == 0) return true;
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) goto MAPPEDFILE_OPEN_FAIL;
+        m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr) goto MAPPEDFILE_OPEN_FAIL;
+#else
+        struct stat info;
+        m_fd = ::open(filename, O_RDONLY);
+        if (m_fd < 0) return false;
+        if (fstat(m_fd, &info) != 0) goto MAPPEDFILE_OPEN_FAIL;
+        m_size = static_cast<size_t>(info.st_size);
+        if (m_size == 0) return true;
+        {
+            void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+            if (data == MAP_FAILED) goto MAPPEDFILE_OPEN_FAIL;
+            m_data = static_cast<const char*>(data);
+        }
+#endif
+        return true;
+
+    MAPPEDFILE_OPEN_FAIL:
+        close();
+        return false;
+    }
+
+    /**
+     * Close the opened file<br>
+     * The mapped data become invalid.
+     */
+    void close()
+    {
+#ifdef _WIN32
+        if (m_data != nullptr) UnmapViewOfFile(m_data);
+        if (m_mapping != nullptr) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = nullptr;
+#else
+        if (m_data != nullptr) munmap(const_cast<char*>(m_data), m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    /**
+     * Check whether a file is opened or not
+     * @return True if opened (false if not opened)
+     */
+    bool isOpened() const
+    {
+#ifdef _WIN32
+        return (m_file != INVALID_HANDLE_VALUE);
+#else
+        return (m_fd >= 0);
+#endif
+    }
+
+    /**
+     * Get the mapped data
+     * @return A pointer to the mapped data (nullptr if not opened or empty)
+     */
+    const char* data() const { return m_data; }
+
+    /**
+     * Get the size of the mapped data
+     * @return The size of the mapped data (Unit: [byte])
+     */
+    size_t size() const { return m_size; }
+
+protected:
+    /** The mapped data */
+    const char* m_data;
+
+    /** The size of the mapped data (Unit: [byte]) */
+    size_t m_size;
+
+#ifdef _WIN32
+    /** The file handle */
+    HANDLE m_file;
+
+    /** The file mapping handle */
+    HANDLE m_mapping;
+#else
+    /** The file descriptor */
+    int m_fd;
+#endif
+
+private:
+    /** Disable the copy constructor */
+    MappedFile(const MappedFile&);
+
+    /** Disable the assignment operator */
+    MappedFile& operator=(const MappedFile&);
+};
+
+} // End of 'dg'
+
+#endif // End of '__MAPPED_FILE__'
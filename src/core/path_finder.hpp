@@ -0,0 +1,673 @@
+#ifndef __PATH_FINDER__
+#define __PATH_FINDER__
+
+#include "core/frozen_map.hpp"
+#include "core/path.hpp"
+#include "core/road_profile.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <set>
+
+namespace dg
+{
+
+/**
+ * @brief A shortest path finder on the topological map
+ *
+ * A <b>path finder</b> finds the shortest path on the loaded map without the routing server.
+ * It keeps a frozen copy of the map with cost of each edge, and it supports three algorithms with a binary heap.
+ * - Dijkstra's algorithm
+ * - A* algorithm with a haversine heuristic (default)
+ * - Bidirectional Dijkstra's algorithm
+ *
+ * It also finds the k shortest simple paths as alternative routes using Yen's algorithm.
+ *
+ * The heuristic of A* is the great-circle distance to the destination multiplied by the smallest ratio of
+ * cost to the great-circle distance of all edges, so it is admissible for any cost function and map.
+ * A directed edge is only traversed from its first node to its second node, and impassable edges are removed from adjacency in advance.
+ * Memory for searching is reused for each query, so it is not thread-safe.
+ */
+class PathFinder
+{
+public:
+    /** Search algorithms */
+    enum
+    {
+        /** Dijkstra's algorithm */
+        SEARCH_DIJKSTRA = 0,
+
+        /** A* algorithm */
+        SEARCH_ASTAR = 1,
+
+        /** Bidirectional Dijkstra's algorithm */
+        SEARCH_BIDIRECTIONAL = 2,
+    };
+
+    /**
+     * The default constructor
+     */
+    PathFinder() : m_heuristic_scale(0), m_n_visits(0), m_generation(0), m_ban_generation(0) { }
+
+    /**
+     * Build this path finder with the given map (time complexity: O(|N| + |E|))
+     * @param map The given topological map
+     * @param cost The cost function of edges
+     * @return True if successful (false if failed)
+     */
+    template <typename CostFunction>
+    bool build(const Map& map, CostFunction cost)
+    {
+        clear();
+        if (!m_map.build(map)) return false;
+
+        // Calculate cost of edges and the scale of the heuristic
+        const size_t n_edges = m_map.countEdges();
+        m_edge_costs.resize(n_edges);
+        m_heuristic_scale = DBL_MAX;
+        for (size_t i = 0; i < n_edges; i++)
+        {
+            m_edge_costs[i] = cost(m_map, i);
+            if (m_edge_costs[i] < 0) continue;
+            double dist = calcDistance(m_map.edge_node1s[i], m_map.edge_node2s[i]);
+            if (dist > 0) m_heuristic_scale = std::min(m_heuristic_scale, m_edge_costs[i] / dist);
+        }
+        if (m_heuristic_scale == DBL_MAX) m_heuristic_scale = 0;
+        m_heuristic_scale *= 1 - 1e-9; // Margin for numerical errors
+
+        // Build adjacency of passable edges for forward (0) and backward (1) search
+        const size_t n_nodes = m_map.countNodes();
+        for (int d = 0; d < 2; d++) m_adj_offsets[d].assign(n_nodes + 1, 0);
+        for (uint32_t u = 0; u < n_nodes; u++)
+        {
+            for (uint32_t i = m_map.adj_offsets[u]; i < m_map.adj_offsets[u + 1]; i++)
+            {
+                if (!isPassable(m_map.adj_edges[i], u)) continue;
+                m_adj_offsets[0][u + 1]++;
+                m_adj_offsets[1][m_map.adj_nodes[i] + 1]++;
+            }
+        }
+        for (int d = 0; d < 2; d++)
+        {
+            for (size_t i = 0; i < n_nodes; i++) m_adj_offsets[d][i + 1] += m_adj_offsets[d][i];
+            m_adj_nodes[d].resize(m_adj_offsets[d].back());
+            m_adj_edges[d].resize(m_adj_offsets[d].back());
+        }
+        std::vector<uint32_t> fill(m_adj_offsets[1].begin(), m_adj_offsets[1].end() - 1);
+        for (uint32_t u = 0, slot = 0; u < n_nodes; u++)
+        {
+            for (uint32_t i = m_map.adj_offsets[u]; i < m_map.adj_offsets[u + 1]; i++)
+            {
+                uint32_t e = m_map.adj_edges[i], v = m_map.adj_nodes[i];
+                if (!isPassable(e, u)) continue;
+                m_adj_nodes[0][slot] = v;
+                m_adj_edges[0][slot++] = e;
+                m_adj_nodes[1][fill[v]] = u;
+                m_adj_edges[1][fill[v]++] = e;
+            }
+        }
+
+        // Prepare memory for searching
+        for (int d = 0; d < 2; d++)
+        {
+            m_dist[d].resize(n_nodes);
+            m_parent_edge[d].resize(n_nodes);
+            m_parent_node[d].resize(n_nodes);
+            m_stamp[d].assign(n_nodes, 0);
+        }
+        m_heuristic.resize(n_nodes);
+        m_generation = 0;
+        m_ban_nodes.assign(n_nodes, 0);
+        m_ban_edges.assign(n_edges, 0);
+        m_ban_generation = 0;
+        return true;
+    }
+
+    /**
+     * Build this path finder with the given map and the default cost function (time complexity: O(|N| + |E|))
+     * @param map The given topological map
+     * @return True if successful (false if failed)
+     */
+    bool build(const Map& map) { return build(map, RoadProfile()); }
+
+    /**
+     * Remove all data
+     */
+    void clear()
+    {
+        m_map.clear();
+        m_edge_costs.clear();
+        for (int d = 0; d < 2; d++)
+        {
+            m_adj_offsets[d].clear();
+            m_adj_nodes[d].clear();
+            m_adj_edges[d].clear();
+            m_dist[d].clear();
+            m_parent_edge[d].clear();
+            m_parent_node[d].clear();
+            m_stamp[d].clear();
+        }
+        m_heuristic.clear();
+        m_heap.clear();
+        m_ban_nodes.clear();
+        m_ban_edges.clear();
+        m_heuristic_scale = 0;
+        m_n_visits = 0;
+    }
+
+    /**
+     * Check whether this is built with the given map or not (time complexity: O(1))
+     * @param map The given topological map
+     * @return True if built (false if not built or the map is modified after building)
+     * @see Map::getRevision
+     */
+    bool isBuilt(const Map& map) const { return !m_map.isEmpty() && m_map.getRevision() == map.getRevision(); }
+
+    /**
+     * Find the shortest path between two nodes
+     * @param from ID of the start node
+     * @param to ID of the destination node
+     * @param path The found path (return value)
+     * @param method The search algorithm (e.g. SEARCH_ASTAR)
+     * @param cost Cost of the found path (return value; nullptr if not necessary)
+     * @return True if successful (false if not reachable)
+     */
+    bool findPath(ID from, ID to, Path& path, int method = SEARCH_ASTAR, double* cost = nullptr)
+    {
+        path.pts.clear();
+        size_t from_idx = m_map.findNode(from), to_idx = m_map.findNode(to);
+        if (from_idx == FrozenMap::npos || to_idx == FrozenMap::npos) return false;
+
+        std::vector<uint32_t> nodes, edges;
+        if (!findPath(from_idx, to_idx, nodes, edges, method)) return false;
+
+        double sum = makePath(nodes, edges, path);
+        if (cost != nullptr) *cost = sum;
+        return true;
+    }
+
+    /**
+     * Find the shortest path between two nodes using their indices
+     * @param from Index of the start node
+     * @param to Index of the destination node
+     * @param nodes Indices of nodes on the found path (return value)
+     * @param edges Indices of edges on the found path (return value; one less than 'nodes')
+     * @param method The search algorithm (e.g. SEARCH_ASTAR)
+     * @return True if successful (false if not reachable)
+     */
+    bool findPath(size_t from, size_t to, std::vector<uint32_t>& nodes, std::vector<uint32_t>& edges, int method = SEARCH_ASTAR)
+    {
+        nodes.clear();
+        edges.clear();
+        m_n_visits = 0;
+        if (from >= m_map.countNodes() || to >= m_map.countNodes()) return false;
+        if (method == SEARCH_BIDIRECTIONAL) return searchBidirectional(static_cast<uint32_t>(from), static_cast<uint32_t>(to), nodes, edges);
+        return searchForward(static_cast<uint32_t>(from), static_cast<uint32_t>(to), method == SEARCH_ASTAR, nodes, edges);
+    }
+
+    /**
+     * Find the k shortest simple paths between two nodes as alternative routes<br>
+     * Alternative paths can be forced to be diverse by limiting their overlap with each shorter path,
+     * where the overlap is the ratio of cost of the shared edges to cost of the alternative path.
+     * @param from ID of the start node
+     * @param to ID of the destination node
+     * @param num_paths The maximum number of paths (k)
+     * @param paths The found paths in ascending order of their cost (return value)
+     * @param max_overlap The maximum overlap with each shorter path (default: 1, no constraint)
+     * @param costs Cost of the found paths (return value; nullptr if not necessary)
+     * @return True if at least one path is found (false if not reachable)
+     * @see findPaths(size_t, size_t, int, std::vector<std::vector<uint32_t>>&, std::vector<std::vector<uint32_t>>&, double)
+     */
+    bool findPaths(ID from, ID to, int num_paths, std::vector<Path>& paths, double max_overlap = 1, std::vector<double>* costs = nullptr)
+    {
+        paths.clear();
+        if (costs != nullptr) costs->clear();
+        size_t from_idx = m_map.findNode(from), to_idx = m_map.findNode(to);
+        if (from_idx == FrozenMap::npos || to_idx == FrozenMap::npos) return false;
+
+        std::vector<std::vector<uint32_t>> nodes, edges;
+        if (!findPaths(from_idx, to_idx, num_paths, nodes, edges, max_overlap)) return false;
+
+        paths.resize(nodes.size());
+        for (size_t k = 0; k < nodes.size(); k++)
+        {
+            double sum = makePath(nodes[k], edges[k], paths[k]);
+            if (costs != nullptr) costs->push_back(sum);
+        }
+        return true;
+    }
+
+    /**
+     * Find the k shortest simple paths between two nodes using their indices (time complexity: O(k |N| (|E| + |N|) log |N|))<br>
+     * It is Yen's algorithm with Lawler's modification, which searches spur paths only from the deviation node of each path.
+     * Each spur path is found by A* algorithm while its root path and the edges deviated from the same root are banned.
+     * When the overlap is limited, too similar paths are skipped but still expanded up to 'MAX_EXPANSIONS' times of 'num_paths'.
+     * @param from Index of the start node
+     * @param to Index of the destination node
+     * @param num_paths The maximum number of paths (k)
+     * @param nodes Indices of nodes on each found path (return value)
+     * @param edges Indices of edges on each found path (return value)
+     * @param max_overlap The maximum overlap with each shorter path (default: 1, no constraint)
+     * @return True if at least one path is found (false if not reachable)
+     */
+    bool findPaths(size_t from, size_t to, int num_paths, std::vector<std::vector<uint32_t>>& nodes, std::vector<std::vector<uint32_t>>& edges, double max_overlap = 1)
+    {
+        nodes.clear();
+        edges.clear();
+        m_n_visits = 0;
+        if (from >= m_map.countNodes() || to >= m_map.countNodes() || num_paths <= 0) return false;
+
+        // Find the shortest path as the first candidate
+        std::vector<Candidate> candidates(1);
+        if (!searchForward(static_cast<uint32_t>(from), static_cast<uint32_t>(to), true, candidates[0].nodes, candidates[0].edges)) return false;
+        candidates[0].cost = m_dist[0][to];
+        candidates[0].deviation = 0;
+        std::vector<HeapEntry> queue;
+        pushHeap(queue, HeapEntry(candidates[0].cost, 0));
+        std::set<std::vector<uint32_t>> known;
+        known.insert(candidates[0].edges);
+
+        // Expand candidates in ascending order of their cost
+        std::vector<uint32_t> expanded, accepted;
+        std::vector<std::vector<uint32_t>> accepted_edges;
+        const size_t max_expansions = (max_overlap < 1) ? MAX_EXPANSIONS * static_cast<size_t>(num_paths) : static_cast<size_t>(num_paths);
+        std::vector<uint32_t> spur_nodes, spur_edges;
+        while (!queue.empty() && accepted.size() < static_cast<size_t>(num_paths) && expanded.size() < max_expansions)
+        {
+            uint32_t c = popHeap(queue).second;
+            expanded.push_back(c);
+            if (isDiverse(candidates[c], accepted_edges, max_overlap))
+            {
+                accepted.push_back(c);
+                accepted_edges.push_back(candidates[c].edges);
+                std::sort(accepted_edges.back().begin(), accepted_edges.back().end());
+                if (accepted.size() >= static_cast<size_t>(num_paths)) break;
+            }
+
+            // Search spur paths which deviate from the candidate after its deviation node
+            double root_cost = 0;
+            for (size_t i = 0; i < candidates[c].deviation; i++) root_cost += m_edge_costs[candidates[c].edges[i]];
+            for (size_t i = candidates[c].deviation; i < candidates[c].edges.size(); i++)
+            {
+                startBan();
+                for (size_t j = 0; j < i; j++) m_ban_nodes[candidates[c].nodes[j]] = m_ban_generation;
+                for (size_t k = 0; k < expanded.size(); k++)
+                {
+                    const std::vector<uint32_t>& path = candidates[expanded[k]].edges;
+                    if (path.size() > i && std::equal(path.begin(), path.begin() + i, candidates[c].edges.begin())) m_ban_edges[path[i]] = m_ban_generation;
+                }
+
+                uint32_t spur = candidates[c].nodes[i];
+                if (searchForward(spur, static_cast<uint32_t>(to), true, spur_nodes, spur_edges, true))
+                {
+                    Candidate next;
+                    next.nodes.assign(candidates[c].nodes.begin(), candidates[c].nodes.begin() + i);
+                    next.nodes.insert(next.nodes.end(), spur_nodes.begin(), spur_nodes.end());
+                    next.edges.assign(candidates[c].edges.begin(), candidates[c].edges.begin() + i);
+                    next.edges.insert(next.edges.end(), spur_edges.begin(), spur_edges.end());
+                    next.cost = root_cost + m_dist[0][to];
+                    next.deviation = i;
+                    if (known.insert(next.edges).second)
+                    {
+                        candidates.push_back(next);
+                        pushHeap(queue, HeapEntry(next.cost, static_cast<uint32_t>(candidates.size() - 1)));
+                    }
+                }
+                root_cost += m_edge_costs[candidates[c].edges[i]];
+            }
+        }
+
+        nodes.resize(accepted.size());
+        edges.resize(accepted.size());
+        for (size_t k = 0; k < accepted.size(); k++)
+        {
+            nodes[k].swap(candidates[accepted[k]].nodes);
+            edges[k].swap(candidates[accepted[k]].edges);
+        }
+        return !nodes.empty();
+    }
+
+    /**
+     * Count the number of visited (expanded) nodes during the last search
+     * @return The number of visited nodes
+     */
+    size_t countVisits() const { return m_n_visits; }
+
+    /**
+     * Get the frozen map for searching
+     * @return A constant reference to the frozen map
+     */
+    const FrozenMap& getMap() const { return m_map; }
+
+protected:
+    /** The radius of the earth (Unit: [m]) */
+    static constexpr double EARTH_RADIUS = 6378137.0;
+
+    /** The maximum number of expanded candidates per requested path when the overlap is limited */
+    static const size_t MAX_EXPANSIONS = 10;
+
+    /** An entry of the binary heap */
+    typedef std::pair<double, uint32_t> HeapEntry;
+
+    /** A candidate of the k shortest paths */
+    struct Candidate
+    {
+        /** Indices of nodes on the path */
+        std::vector<uint32_t> nodes;
+
+        /** Indices of edges on the path */
+        std::vector<uint32_t> edges;
+
+        /** Cost of the path */
+        double cost;
+
+        /** The index of the node where the path deviates from its parent path */
+        size_t deviation;
+    };
+
+    /**
+     * Fill the given path with the given node and edge indices
+     * @return Cost of the path
+     */
+    double makePath(const std::vector<uint32_t>& nodes, const std::vector<uint32_t>& edges, Path& path) const
+    {
+        path.start_pos = LatLon(m_map.node_lats[nodes.front()], m_map.node_lons[nodes.front()]);
+        path.dest_pos = LatLon(m_map.node_lats[nodes.back()], m_map.node_lons[nodes.back()]);
+        path.pts.clear();
+        path.pts.reserve(nodes.size());
+        double sum = 0;
+        for (size_t i = 0; i < edges.size(); i++)
+        {
+            path.pts.push_back(PathElement(m_map.node_ids[nodes[i]], m_map.edge_ids[edges[i]]));
+            sum += m_edge_costs[edges[i]];
+        }
+        path.pts.push_back(PathElement(m_map.node_ids[nodes.back()], 0));
+        return sum;
+    }
+
+    /**
+     * Check whether the overlap of the given candidate with each accepted path (sorted edges) is within the given limit
+     */
+    bool isDiverse(const Candidate& candidate, const std::vector<std::vector<uint32_t>>& accepted_edges, double max_overlap) const
+    {
+        if (max_overlap >= 1 || candidate.cost <= 0) return true;
+        for (size_t k = 0; k < accepted_edges.size(); k++)
+        {
+            double shared = 0;
+            for (size_t i = 0; i < candidate.edges.size(); i++)
+            {
+                if (std::binary_search(accepted_edges[k].begin(), accepted_edges[k].end(), candidate.edges[i])) shared += m_edge_costs[candidate.edges[i]];
+            }
+            if (shared > max_overlap * candidate.cost) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Calculate the great-circle distance between two nodes using the haversine formula
+     */
+    double calcDistance(size_t a, size_t b) const
+    {
+        const double deg2rad = CV_PI / 180;
+        double lat_a = m_map.node_lats[a] * deg2rad, lat_b = m_map.node_lats[b] * deg2rad;
+        double s_lat = sin((lat_b - lat_a) / 2), s_lon = sin((m_map.node_lons[b] - m_map.node_lons[a]) * deg2rad / 2);
+        double h = s_lat * s_lat + cos(lat_a) * cos(lat_b) * s_lon * s_lon;
+        return 2 * EARTH_RADIUS * asin(std::min(1., sqrt(h)));
+    }
+
+    /**
+     * Check whether the given edge can be traversed from the given node
+     */
+    bool isPassable(uint32_t edge, uint32_t from) const
+    {
+        return m_edge_costs[edge] >= 0 && (!m_map.edge_directed[edge] || m_map.edge_node1s[edge] == from);
+    }
+
+    /**
+     * Start a new search (invalidate all labels in O(1))
+     */
+    void startSearch()
+    {
+        m_generation++;
+        if (m_generation == 0)
+        {
+            // Reset stamps when the generation is wrapped around
+            for (int d = 0; d < 2; d++) std::fill(m_stamp[d].begin(), m_stamp[d].end(), 0);
+            m_generation = 1;
+        }
+    }
+
+    /**
+     * Check whether the given node is labeled in the current search
+     */
+    bool isLabeled(int d, uint32_t node) const { return m_stamp[d][node] == m_generation; }
+
+    /**
+     * Start a new set of banned nodes and edges (unban all in O(1))
+     */
+    void startBan()
+    {
+        m_ban_generation++;
+        if (m_ban_generation == 0)
+        {
+            // Reset stamps when the generation is wrapped around
+            std::fill(m_ban_nodes.begin(), m_ban_nodes.end(), 0);
+            std::fill(m_ban_edges.begin(), m_ban_edges.end(), 0);
+            m_ban_generation = 1;
+        }
+    }
+
+    /**
+     * Check whether the given edge or its next node is banned
+     */
+    bool isBanned(uint32_t edge, uint32_t next) const { return m_ban_edges[edge] == m_ban_generation || m_ban_nodes[next] == m_ban_generation; }
+
+    /**
+     * Label the given node with its distance and parent
+     */
+    void label(int d, uint32_t node, double dist, uint32_t parent_node, uint32_t parent_edge)
+    {
+        m_stamp[d][node] = m_generation;
+        m_dist[d][node] = dist;
+        m_parent_node[d][node] = parent_node;
+        m_parent_edge[d][node] = parent_edge;
+    }
+
+    /**
+     * Search the shortest path from the start node using Dijkstra's or A* algorithm
+     */
+    bool searchForward(uint32_t from, uint32_t to, bool use_heuristic, std::vector<uint32_t>& nodes, std::vector<uint32_t>& edges, bool use_ban = false)
+    {
+        nodes.clear();
+        edges.clear();
+        startSearch();
+        m_heap.clear();
+        label(0, from, 0, from, 0);
+        m_heuristic[from] = use_heuristic ? m_heuristic_scale * calcDistance(from, to) : 0;
+        pushHeap(m_heap, HeapEntry(m_heuristic[from], from));
+        while (!m_heap.empty())
+        {
+            HeapEntry top = popHeap(m_heap);
+            uint32_t u = top.second;
+            if (top.first > m_dist[0][u] + m_heuristic[u]) continue; // An outdated entry
+            m_n_visits++;
+            if (u == to)
+            {
+                tracePath(from, to, nodes, edges);
+                return true;
+            }
+
+            for (uint32_t i = m_adj_offsets[0][u]; i < m_adj_offsets[0][u + 1]; i++)
+            {
+                uint32_t e = m_adj_edges[0][i], v = m_adj_nodes[0][i];
+                if (use_ban && isBanned(e, v)) continue;
+                double dist = m_dist[0][u] + m_edge_costs[e];
+                if (isLabeled(0, v))
+                {
+                    if (dist >= m_dist[0][v]) continue;
+                }
+                else m_heuristic[v] = use_heuristic ? m_heuristic_scale * calcDistance(v, to) : 0;
+                label(0, v, dist, u, e);
+                pushHeap(m_heap, HeapEntry(dist + m_heuristic[v], v));
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Search the shortest path from both of the start and destination nodes using Dijkstra's algorithm
+     */
+    bool searchBidirectional(uint32_t from, uint32_t to, std::vector<uint32_t>& nodes, std::vector<uint32_t>& edges)
+    {
+        startSearch();
+        std::vector<HeapEntry>* heaps[2] = { &m_heap, &m_heap_backward };
+        m_heap.clear();
+        m_heap_backward.clear();
+        label(0, from, 0, from, 0);
+        label(1, to, 0, to, 0);
+        pushHeap(m_heap, HeapEntry(0, from));
+        pushHeap(m_heap_backward, HeapEntry(0, to));
+
+        // Keep the best connection as (the end of forward search, the edge, the end of backward search)
+        double best = (from == to) ? 0 : DBL_MAX;
+        uint32_t meet_f = from, meet_b = to, meet_edge = 0;
+        bool meet_by_edge = false;
+        while (!m_heap.empty() && !m_heap_backward.empty())
+        {
+            if (m_heap.front().first + m_heap_backward.front().first >= best) break;
+
+            // Expand the direction which has the smaller heap
+            int d = (m_heap.size() <= m_heap_backward.size()) ? 0 : 1;
+            HeapEntry top = popHeap(*heaps[d]);
+            uint32_t u = top.second;
+            if (top.first > m_dist[d][u]) continue; // An outdated entry
+            m_n_visits++;
+
+            for (uint32_t i = m_adj_offsets[d][u]; i < m_adj_offsets[d][u + 1]; i++)
+            {
+                uint32_t e = m_adj_edges[d][i], v = m_adj_nodes[d][i];
+                double dist = m_dist[d][u] + m_edge_costs[e];
+                if (isLabeled(1 - d, v) && dist + m_dist[1 - d][v] < best)
+                {
+                    best = dist + m_dist[1 - d][v];
+                    meet_f = (d == 0) ? u : v;
+                    meet_b = (d == 0) ? v : u;
+                    meet_edge = e;
+                    meet_by_edge = true;
+                }
+                if (isLabeled(d, v) && dist >= m_dist[d][v]) continue;
+                label(d, v, dist, u, e);
+                pushHeap(*heaps[d], HeapEntry(dist, v));
+            }
+        }
+        if (best == DBL_MAX) return false;
+
+        // Connect the forward path to 'meet_f' and the backward path from 'meet_b'
+        tracePath(from, meet_f, nodes, edges);
+        if (meet_by_edge)
+        {
+            edges.push_back(meet_edge);
+            nodes.push_back(meet_b);
+        }
+        for (uint32_t n = meet_b; n != to; n = m_parent_node[1][n])
+        {
+            edges.push_back(m_parent_edge[1][n]);
+            nodes.push_back(m_parent_node[1][n]);
+        }
+        return true;
+    }
+
+    /**
+     * Trace the forward search tree from the start node to the given node
+     */
+    void tracePath(uint32_t from, uint32_t to, std::vector<uint32_t>& nodes, std::vector<uint32_t>& edges) const
+    {
+        for (uint32_t n = to; n != from; n = m_parent_node[0][n])
+        {
+            nodes.push_back(n);
+            edges.push_back(m_parent_edge[0][n]);
+        }
+        nodes.push_back(from);
+        std::reverse(nodes.begin(), nodes.end());
+        std::reverse(edges.begin(), edges.end());
+    }
+
+    /**
+     * Push an entry to the binary min-heap
+     */
+    static void pushHeap(std::vector<HeapEntry>& heap, const HeapEntry& entry)
+    {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+    }
+
+    /**
+     * Pop the smallest entry from the binary min-heap
+     */
+    static HeapEntry popHeap(std::vector<HeapEntry>& heap)
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        HeapEntry entry = heap.back();
+        heap.pop_back();
+        return entry;
+    }
+
+    /** The frozen map for searching */
+    FrozenMap m_map;
+
+    /** Cost of each edge (negative if impassable) */
+    std::vector<double> m_edge_costs;
+
+    /** The start index of passable edges of each node in 'm_adj_nodes' and 'm_adj_edges' for forward (0) and backward (1) search */
+    std::vector<uint32_t> m_adj_offsets[2];
+
+    /** The next nodes of passable edges for forward (0) and backward (1) search */
+    std::vector<uint32_t> m_adj_nodes[2];
+
+    /** Passable edges for forward (0) and backward (1) search */
+    std::vector<uint32_t> m_adj_edges[2];
+
+    /** The scale of the heuristic (the smallest ratio of cost to the great-circle distance of edges) */
+    double m_heuristic_scale;
+
+    /** Distance of each node from the start (0) or destination (1) node */
+    std::vector<double> m_dist[2];
+
+    /** The previous node of each node in the search tree from the start (0) or destination (1) node */
+    std::vector<uint32_t> m_parent_node[2];
+
+    /** The previous edge of each node in the search tree from the start (0) or destination (1) node */
+    std::vector<uint32_t> m_parent_edge[2];
+
+    /** The search generation when each node is labeled (labels of the other generations are invalid) */
+    std::vector<uint32_t> m_stamp[2];
+
+    /** The heuristic of each labeled node */
+    std::vector<double> m_heuristic;
+
+    /** The binary heap for forward search */
+    std::vector<HeapEntry> m_heap;
+
+    /** The binary heap for backward search */
+    std::vector<HeapEntry> m_heap_backward;
+
+    /** The number of visited nodes during the last search */
+    size_t m_n_visits;
+
+    /** The current search generation */
+    uint32_t m_generation;
+
+    /** The ban generation when each node is banned (bans of the other generations are invalid) */
+    std::vector<uint32_t> m_ban_nodes;
+
+    /** The ban generation when each edge is banned (bans of the other generations are invalid) */
+    std::vector<uint32_t> m_ban_edges;
+
+    /** The current ban generation */
+    uint32_t m_ban_generation;
+};
+
+} // End of 'dg'
+
+#endif // End of '__PATH_FINDER__'
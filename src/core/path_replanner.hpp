@@ -0,0 +1,568 @@
+#ifndef __PATH_REPLANNER__
+#define __PATH_REPLANNER__
+
+#include "core/path_finder.hpp"
+#include <limits>
+#include <set>
+
+namespace dg
+{
+
+/**
+ * @brief An incremental path re-planner using D* Lite
+ *
+ * A <b>path re-planner</b> keeps the shortest path tree toward a fixed destination (goal) and repairs only its changed part.
+ * It searches backward from the goal, so the tree is reused when the start moves (e.g. the robot leaves the path)
+ * or when cost of some edges is changed (e.g. a blocked edge).
+ * The first query costs the same as A* algorithm, and the following queries visit only a few nodes around the changes.
+ *
+ * The heuristic is same with dg::PathFinder (the great-circle distance multiplied by the smallest ratio of cost to distance).
+ * Memory for searching is reused for each query, so it is not thread-safe.
+ *
+ * @see Sven Koenig and Maxim Likhachev, D* Lite, AAAI, 2002
+ */
+class PathReplanner
+{
+public:
+    /**
+     * The default constructor
+     */
+    PathReplanner() : m_heuristic_scale(0), m_goal(NONE), m_start(NONE), m_km(0), m_n_visits(0) { }
+
+    /**
+     * Build this re-planner with the given map (time complexity: O(|N| + |E|))<br>
+     * Blocked edges are kept and blocked again in the given map.
+     * @param map The given topological map
+     * @param cost The cost function of edges (e.g. dg::RoadProfile)
+     * @return True if successful (false if failed)
+     */
+    template <typename CostFunction>
+    bool build(const Map& map, CostFunction cost)
+    {
+        clear();
+        if (!m_map.build(map)) return false;
+
+        // Calculate cost of edges and the scale of the heuristic
+        const size_t n_edges = m_map.countEdges();
+        m_edge_costs.resize(n_edges);
+        m_init_costs.resize(n_edges);
+        m_edge_dists.resize(n_edges);
+        m_heuristic_scale = DBL_MAX;
+        for (size_t i = 0; i < n_edges; i++)
+        {
+            double c = cost(m_map, i);
+            m_init_costs[i] = (c < 0) ? INF : c;
+            m_edge_costs[i] = m_init_costs[i];
+            m_edge_dists[i] = calcDistance(m_map.edge_node1s[i], m_map.edge_node2s[i]);
+            if (c >= 0 && m_edge_dists[i] > 0) m_heuristic_scale = std::min(m_heuristic_scale, c / m_edge_dists[i]);
+        }
+        for (auto id = m_blocked.begin(); id != m_blocked.end(); id++)
+        {
+            size_t e = m_map.findEdge(*id);
+            if (e != FrozenMap::npos) m_edge_costs[e] = INF;
+        }
+        if (m_heuristic_scale == DBL_MAX) m_heuristic_scale = 0;
+        m_heuristic_scale *= 1 - 1e-9; // Margin for numerical errors
+
+        // Build adjacency of successors (0) and predecessors (1) (including impassable edges whose cost can be changed)
+        const size_t n_nodes = m_map.countNodes();
+        for (int d = 0; d < 2; d++) m_adj_offsets[d].assign(n_nodes + 1, 0);
+        for (uint32_t u = 0; u < n_nodes; u++)
+        {
+            for (uint32_t i = m_map.adj_offsets[u]; i < m_map.adj_offsets[u + 1]; i++)
+            {
+                if (!isForward(m_map.adj_edges[i], u)) continue;
+                m_adj_offsets[0][u + 1]++;
+                m_adj_offsets[1][m_map.adj_nodes[i] + 1]++;
+            }
+        }
+        std::vector<uint32_t> fill[2];
+        for (int d = 0; d < 2; d++)
+        {
+            for (size_t i = 0; i < n_nodes; i++) m_adj_offsets[d][i + 1] += m_adj_offsets[d][i];
+            m_adj_nodes[d].resize(m_adj_offsets[d].back());
+            m_adj_edges[d].resize(m_adj_offsets[d].back());
+            fill[d].assign(m_adj_offsets[d].begin(), m_adj_offsets[d].end() - 1);
+        }
+        for (uint32_t u = 0; u < n_nodes; u++)
+        {
+            for (uint32_t i = m_map.adj_offsets[u]; i < m_map.adj_offsets[u + 1]; i++)
+            {
+                uint32_t e = m_map.adj_edges[i], v = m_map.adj_nodes[i];
+                if (!isForward(e, u)) continue;
+                m_adj_nodes[0][fill[0][u]] = v;
+                m_adj_edges[0][fill[0][u]++] = e;
+                m_adj_nodes[1][fill[1][v]] = u;
+                m_adj_edges[1][fill[1][v]++] = e;
+            }
+        }
+
+        // Prepare memory for searching
+        m_g.resize(n_nodes);
+        m_rhs.resize(n_nodes);
+        m_keys.resize(n_nodes);
+        m_in_queue.resize(n_nodes);
+        m_lat_rad.resize(n_nodes);
+        m_cos_lat.resize(n_nodes);
+        for (size_t i = 0; i < n_nodes; i++)
+        {
+            m_lat_rad[i] = m_map.node_lats[i] * CV_PI / 180;
+            m_cos_lat[i] = cos(m_lat_rad[i]);
+        }
+        return true;
+    }
+
+    /**
+     * Build this re-planner with the given map and the default cost function (time complexity: O(|N| + |E|))
+     * @param map The given topological map
+     * @return True if successful (false if failed)
+     */
+    bool build(const Map& map) { return build(map, RoadProfile()); }
+
+    /**
+     * Remove all data except blocked edges
+     */
+    void clear()
+    {
+        m_map.clear();
+        m_edge_costs.clear();
+        m_init_costs.clear();
+        m_edge_dists.clear();
+        for (int d = 0; d < 2; d++)
+        {
+            m_adj_offsets[d].clear();
+            m_adj_nodes[d].clear();
+            m_adj_edges[d].clear();
+        }
+        m_g.clear();
+        m_rhs.clear();
+        m_keys.clear();
+        m_in_queue.clear();
+        m_lat_rad.clear();
+        m_cos_lat.clear();
+        m_queue.clear();
+        m_heuristic_scale = 0;
+        m_goal = NONE;
+        m_start = NONE;
+        m_km = 0;
+        m_n_visits = 0;
+    }
+
+    /**
+     * Check whether this is built with the given map or not (comparing the revision of the map)
+     * @param map The given topological map
+     * @return True if built (false if not)
+     */
+    bool isBuilt(const Map& map) const { return !m_map.isEmpty() && m_map.getRevision() == map.getRevision(); }
+
+    /**
+     * Set the destination and discard the previous search tree (time complexity: O(|N|))
+     * @param goal ID of the destination node
+     * @return True if successful (false if the node does not exist)
+     */
+    bool setGoal(ID goal)
+    {
+        size_t idx = m_map.findNode(goal);
+        if (idx == FrozenMap::npos) return false;
+        m_goal = static_cast<uint32_t>(idx);
+        reset();
+        return true;
+    }
+
+    /**
+     * Get the current destination
+     * @return ID of the destination node (0 if not set)
+     */
+    ID getGoal() const { return (m_goal == NONE) ? 0 : m_map.node_ids[m_goal]; }
+
+    /**
+     * Change cost of the given edge (e.g. a closed or congested road)<br>
+     * Only nodes affected by the change are repaired at the next findPath().
+     * If the new cost is too small for the current heuristic, the search tree is discarded to keep the heuristic admissible.
+     * @param id ID of the edge
+     * @param cost New cost of the edge (negative to block the edge)
+     * @return True if successful (false if the edge does not exist)
+     */
+    bool setEdgeCost(ID id, double cost)
+    {
+        size_t e = m_map.findEdge(id);
+        if (e == FrozenMap::npos) return false;
+        double c_old = m_edge_costs[e], c_new = (cost < 0) ? INF : cost;
+        if (c_old == c_new) return true;
+        m_edge_costs[e] = c_new;
+        if (c_new < m_heuristic_scale * m_edge_dists[e])
+        {
+            // Decrease the heuristic and discard the search tree
+            m_heuristic_scale = c_new / m_edge_dists[e] * (1 - 1e-9);
+            reset();
+            return true;
+        }
+        if (m_goal == NONE) return true;
+
+        // Update the source nodes of the edge (for each direction)
+        uint32_t node1 = m_map.edge_node1s[e], node2 = m_map.edge_node2s[e];
+        updateArc(node1, node2, c_old, c_new);
+        if (!m_map.edge_directed[e]) updateArc(node2, node1, c_old, c_new);
+        return true;
+    }
+
+    /**
+     * Block the given edge, which is kept blocked after this re-planner is built again
+     * @param id ID of the edge
+     * @return True if successful (false if the edge does not exist)
+     */
+    bool blockEdge(ID id)
+    {
+        if (!setEdgeCost(id, -1)) return false;
+        m_blocked.insert(id);
+        return true;
+    }
+
+    /**
+     * Restore the initial cost of the given edge
+     * @param id ID of the edge
+     * @return True if successful (false if the edge does not exist)
+     */
+    bool restoreEdge(ID id)
+    {
+        m_blocked.erase(id);
+        size_t e = m_map.findEdge(id);
+        if (e == FrozenMap::npos) return false;
+        return setEdgeCost(id, (m_init_costs[e] == INF) ? -1 : m_init_costs[e]);
+    }
+
+    /**
+     * Find the shortest path from the given start to the destination, reusing the previous search tree
+     * @param start ID of the start node
+     * @param path The found path (return value)
+     * @param cost Cost of the found path (return value; nullptr if not necessary)
+     * @return True if successful (false if not reachable or the destination is not set)
+     */
+    bool findPath(ID start, Path& path, double* cost = nullptr)
+    {
+        path.pts.clear();
+        m_n_visits = 0;
+        size_t idx = m_map.findNode(start);
+        if (idx == FrozenMap::npos || m_goal == NONE) return false;
+
+        // Move the start (keys in the queue are kept as lower bounds by increasing 'm_km')
+        uint32_t s = static_cast<uint32_t>(idx);
+        if (m_start != NONE && m_start != s) m_km += calcHeuristic(m_start, s);
+        m_start = s;
+        computeShortestPath();
+        if (m_rhs[s] == INF) return false; // The start can be over-consistent, so its successors are used below
+
+        // Follow the successors which have the smallest cost to the goal
+        path.start_pos = LatLon(m_map.node_lats[s], m_map.node_lons[s]);
+        path.dest_pos = LatLon(m_map.node_lats[m_goal], m_map.node_lons[m_goal]);
+        double sum = 0;
+        for (size_t step = 0; s != m_goal && step < m_map.countNodes(); step++)
+        {
+            uint32_t best_node = NONE, best_edge = NONE;
+            double best = INF;
+            for (uint32_t i = m_adj_offsets[0][s]; i < m_adj_offsets[0][s + 1]; i++)
+            {
+                double c = m_edge_costs[m_adj_edges[0][i]] + m_g[m_adj_nodes[0][i]];
+                if (c < best)
+                {
+                    best = c;
+                    best_node = m_adj_nodes[0][i];
+                    best_edge = m_adj_edges[0][i];
+                }
+            }
+            if (best_node == NONE)
+            {
+                path.pts.clear();
+                return false;
+            }
+            path.pts.push_back(PathElement(m_map.node_ids[s], m_map.edge_ids[best_edge]));
+            sum += m_edge_costs[best_edge];
+            s = best_node;
+        }
+        if (s != m_goal)
+        {
+            path.pts.clear();
+            return false;
+        }
+        path.pts.push_back(PathElement(m_map.node_ids[s], 0));
+        if (cost != nullptr) *cost = sum;
+        return true;
+    }
+
+    /**
+     * Get the blocked edges
+     * @return A constant reference to IDs of the blocked edges
+     */
+    const std::set<ID>& getBlockedEdges() const { return m_blocked; }
+
+    /**
+     * Count the number of visited (expanded) nodes during the last search
+     * @return The number of visited nodes
+     */
+    size_t countVisits() const { return m_n_visits; }
+
+    /**
+     * Get the frozen map for searching
+     * @return A constant reference to the frozen map
+     */
+    const FrozenMap& getMap() const { return m_map; }
+
+protected:
+    /** An invalid index */
+    static const uint32_t NONE = 0xFFFFFFFF;
+
+    /** Infinite cost */
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    /** The radius of the earth (Unit: [m]) */
+    static constexpr double EARTH_RADIUS = 6378137.0;
+
+    /**
+     * @brief A priority key of D* Lite
+     */
+    struct Key
+    {
+        /** The primary key, min(g, rhs) + h + km */
+        double k1;
+
+        /** The secondary key, min(g, rhs) */
+        double k2;
+
+        /** Compare two keys lexicographically */
+        bool operator<(const Key& rhs) const { return (k1 < rhs.k1) || (k1 == rhs.k1 && k2 < rhs.k2); }
+
+        /** Check equality of two keys */
+        bool operator==(const Key& rhs) const { return k1 == rhs.k1 && k2 == rhs.k2; }
+    };
+
+    /** An entry of the binary heap */
+    typedef std::pair<Key, uint32_t> HeapEntry;
+
+    /**
+     * @brief A comparator for the binary min-heap
+     */
+    struct HeapGreater
+    {
+        bool operator()(const HeapEntry& a, const HeapEntry& b) const { return b.first < a.first; }
+    };
+
+    /**
+     * Check whether the given edge can be traversed from the given node in its direction
+     */
+    bool isForward(uint32_t edge, uint32_t from) const { return !m_map.edge_directed[edge] || m_map.edge_node1s[edge] == from; }
+
+    /**
+     * Calculate the great-circle distance between two nodes using the haversine formula
+     */
+    double calcDistance(size_t a, size_t b) const
+    {
+        const double deg2rad = CV_PI / 180;
+        double s_lat = sin((m_map.node_lats[b] - m_map.node_lats[a]) * deg2rad / 2), s_lon = sin((m_map.node_lons[b] - m_map.node_lons[a]) * deg2rad / 2);
+        double h = s_lat * s_lat + cos(m_map.node_lats[a] * deg2rad) * cos(m_map.node_lats[b] * deg2rad) * s_lon * s_lon;
+        return 2 * EARTH_RADIUS * asin(std::min(1., sqrt(h)));
+    }
+
+    /**
+     * Calculate the heuristic between two nodes (with cached latitudes)
+     */
+    double calcHeuristic(uint32_t a, uint32_t b) const
+    {
+        if (m_heuristic_scale <= 0) return 0;
+        double s_lat = sin((m_lat_rad[b] - m_lat_rad[a]) / 2), s_lon = sin((m_map.node_lons[b] - m_map.node_lons[a]) * CV_PI / 360);
+        double h = s_lat * s_lat + m_cos_lat[a] * m_cos_lat[b] * s_lon * s_lon;
+        return m_heuristic_scale * 2 * EARTH_RADIUS * asin(std::min(1., sqrt(h)));
+    }
+
+    /**
+     * Calculate the priority key of the given node
+     */
+    Key calcKey(uint32_t u) const
+    {
+        double m = std::min(m_g[u], m_rhs[u]);
+        Key key = { m + ((m_start == NONE) ? 0 : calcHeuristic(m_start, u)) + m_km, m };
+        return key;
+    }
+
+    /**
+     * Discard the search tree and start from the goal (time complexity: O(|N|))
+     */
+    void reset()
+    {
+        m_g.assign(m_g.size(), std::numeric_limits<double>::infinity());
+        m_rhs.assign(m_rhs.size(), std::numeric_limits<double>::infinity());
+        std::fill(m_in_queue.begin(), m_in_queue.end(), 0);
+        m_queue.clear();
+        m_km = 0;
+        if (m_goal == NONE) return;
+        m_rhs[m_goal] = 0;
+        push(m_goal);
+    }
+
+    /**
+     * Insert or update the given node in the queue
+     */
+    void push(uint32_t u)
+    {
+        m_keys[u] = calcKey(u);
+        m_in_queue[u] = 1;
+        m_queue.push_back(HeapEntry(m_keys[u], u));
+        std::push_heap(m_queue.begin(), m_queue.end(), HeapGreater());
+    }
+
+    /**
+     * Remove outdated entries from the top of the queue
+     */
+    void cleanQueue()
+    {
+        while (!m_queue.empty())
+        {
+            const HeapEntry& top = m_queue.front();
+            if (m_in_queue[top.second] && top.first == m_keys[top.second]) break;
+            std::pop_heap(m_queue.begin(), m_queue.end(), HeapGreater());
+            m_queue.pop_back();
+        }
+    }
+
+    /**
+     * Update the given node in the queue according to its consistency
+     */
+    void updateVertex(uint32_t u)
+    {
+        if (m_g[u] != m_rhs[u]) push(u);
+        else m_in_queue[u] = 0;
+    }
+
+    /**
+     * Recalculate 'rhs' of the given node from its successors
+     */
+    double calcRHS(uint32_t u) const
+    {
+        double rhs = INF;
+        for (uint32_t i = m_adj_offsets[0][u]; i < m_adj_offsets[0][u + 1]; i++)
+            rhs = std::min(rhs, m_edge_costs[m_adj_edges[0][i]] + m_g[m_adj_nodes[0][i]]);
+        return rhs;
+    }
+
+    /**
+     * Update the source node of a changed arc
+     */
+    void updateArc(uint32_t u, uint32_t v, double c_old, double c_new)
+    {
+        if (u == m_goal) return;
+        if (c_new < c_old) m_rhs[u] = std::min(m_rhs[u], c_new + m_g[v]);
+        else if (m_rhs[u] == c_old + m_g[v]) m_rhs[u] = calcRHS(u);
+        updateVertex(u);
+    }
+
+    /**
+     * Repair the search tree until the start is consistent
+     */
+    void computeShortestPath()
+    {
+        cleanQueue();
+        while (!m_queue.empty() && (m_queue.front().first < calcKey(m_start) || m_rhs[m_start] > m_g[m_start]))
+        {
+            uint32_t u = m_queue.front().second;
+            Key k_old = m_queue.front().first, k_new = calcKey(u);
+            std::pop_heap(m_queue.begin(), m_queue.end(), HeapGreater());
+            m_queue.pop_back();
+            m_in_queue[u] = 0;
+            m_n_visits++;
+            if (k_old < k_new)
+            {
+                push(u);
+            }
+            else if (m_g[u] > m_rhs[u])
+            {
+                // Make the node consistent and propagate to its predecessors
+                m_g[u] = m_rhs[u];
+                for (uint32_t i = m_adj_offsets[1][u]; i < m_adj_offsets[1][u + 1]; i++)
+                {
+                    uint32_t s = m_adj_nodes[1][i];
+                    if (s == m_goal) continue;
+                    m_rhs[s] = std::min(m_rhs[s], m_edge_costs[m_adj_edges[1][i]] + m_g[u]);
+                    updateVertex(s);
+                }
+            }
+            else
+            {
+                // Make the node under-consistent and recalculate its predecessors
+                double g_old = m_g[u];
+                m_g[u] = INF;
+                for (uint32_t i = m_adj_offsets[1][u]; i < m_adj_offsets[1][u + 1]; i++)
+                {
+                    uint32_t s = m_adj_nodes[1][i];
+                    if (s != m_goal && m_rhs[s] == m_edge_costs[m_adj_edges[1][i]] + g_old) m_rhs[s] = calcRHS(s);
+                    updateVertex(s);
+                }
+                if (u != m_goal) m_rhs[u] = calcRHS(u);
+                updateVertex(u);
+            }
+            cleanQueue();
+        }
+    }
+
+    /** The frozen map for searching */
+    FrozenMap m_map;
+
+    /** Current cost of each edge (infinite if blocked) */
+    std::vector<double> m_edge_costs;
+
+    /** Initial cost of each edge from the cost function (infinite if impassable) */
+    std::vector<double> m_init_costs;
+
+    /** IDs of the blocked edges (kept across building) */
+    std::set<ID> m_blocked;
+
+    /** The great-circle distance between two nodes of each edge (Unit: [m]) */
+    std::vector<double> m_edge_dists;
+
+    /** The start index of arcs of each node in 'm_adj_nodes' and 'm_adj_edges' for successors (0) and predecessors (1) */
+    std::vector<uint32_t> m_adj_offsets[2];
+
+    /** Successors (0) and predecessors (1) of all nodes */
+    std::vector<uint32_t> m_adj_nodes[2];
+
+    /** Edges to successors (0) and from predecessors (1) of all nodes */
+    std::vector<uint32_t> m_adj_edges[2];
+
+    /** The scale of the heuristic (the smallest ratio of cost to the great-circle distance of edges) */
+    double m_heuristic_scale;
+
+    /** Cost from each node to the goal */
+    std::vector<double> m_g;
+
+    /** One-step lookahead cost from each node to the goal */
+    std::vector<double> m_rhs;
+
+    /** The current key of each node in the queue */
+    std::vector<Key> m_keys;
+
+    /** A flag whether each node is in the queue or not */
+    std::vector<uint8_t> m_in_queue;
+
+    /** Latitude of each node (Unit: [rad]) */
+    std::vector<double> m_lat_rad;
+
+    /** Cosine of latitude of each node */
+    std::vector<double> m_cos_lat;
+
+    /** The priority queue (a binary heap with outdated entries) */
+    std::vector<HeapEntry> m_queue;
+
+    /** Index of the goal node */
+    uint32_t m_goal;
+
+    /** Index of the last start node */
+    uint32_t m_start;
+
+    /** The accumulated heuristic of start movements */
+    double m_km;
+
+    /** The number of visited nodes during the last search */
+    size_t m_n_visits;
+};
+
+} // End of 'dg'
+
+#endif // End of '__PATH_REPLANNER__'
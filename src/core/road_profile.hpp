@@ -0,0 +1,147 @@
+#ifndef __ROAD_PROFILE__
+#define __ROAD_PROFILE__
+
+#include "core/frozen_map.hpp"
+#include <cmath>
+
+namespace dg
+{
+
+/**
+ * @brief A query profile to calculate effective weights of RoadCost
+ *
+ * A <b>road profile</b> converts the attributes of an edge into its effective weight.
+ * The weight is its length multiplied by the weight of its type and the penalty of its slope as follows.
+ * - weight = length * (type_weight + slope_weight * |slope|)
+ *
+ * An edge is impassable (negative weight) if it is blocked, its type weight is negative, or its slope is steeper than the maximum slope.
+ * The same profile is used as a cost function of path finding on dg::Map (e.g. PathFinder) and as a query profile of RoadMap in the localizer.
+ * dg::Map does not have slopes of edges, so they are regarded as flat in path finding.
+ * A custom cost function can be used for path finding instead if it has 'double operator()(const FrozenMap& map, size_t edge) const'
+ * which returns cost of the given edge index (negative if impassable).
+ */
+struct RoadProfile
+{
+    /** The number of known edge types */
+    static const int N_TYPES = Edge::EDGE_STAIR + 1;
+
+    /**
+     * The default constructor (all weights are 1 without slope penalty, so the weight is same with length)
+     */
+    RoadProfile() : other_weight(1), slope_weight(0), max_slope(-1)
+    {
+        for (int i = 0; i < N_TYPES; i++) type_weights[i] = 1;
+    }
+
+    /**
+     * Get the weight of the given edge type
+     * @param type The edge type
+     * @return The weight of the type (negative if impassable)
+     */
+    double getWeight(int type) const { return (type >= 0 && type < N_TYPES) ? type_weights[type] : other_weight; }
+
+    /**
+     * Calculate the effective weight of an edge with the given attributes
+     * @param length Length of the edge (Unit: [m])
+     * @param type Type of the edge (e.g. Edge::EDGE_SIDEWALK)
+     * @param slope Slope of the edge (rise over run; negative for downhill)
+     * @param blocked A flag whether the edge is temporarily blocked or not
+     * @return The effective weight (negative if impassable)
+     */
+    double calcWeight(double length, int type, double slope = 0, bool blocked = false) const
+    {
+        if (blocked) return -1;
+        double weight = getWeight(type);
+        if (weight < 0) return -1;
+        slope = fabs(slope);
+        if (max_slope >= 0 && slope > max_slope) return -1;
+        return length * (weight + slope_weight * slope);
+    }
+
+    /**
+     * Calculate the effective weight of the given cost
+     * @param cost The given cost which has 'length', 'type', 'slope', and 'blocked' (e.g. RoadCost)
+     * @return The effective weight (negative if impassable)
+     */
+    template <typename Cost>
+    double operator()(const Cost& cost) const { return calcWeight(cost.length, cost.type, cost.slope, cost.blocked); }
+
+    /**
+     * Calculate the effective weight of the given edge for path finding
+     * @param map The map which has the edge
+     * @param edge Index of the edge
+     * @return The effective weight (negative if impassable)
+     */
+    double operator()(const FrozenMap& map, size_t edge) const { return calcWeight(map.edge_lengths[edge], map.edge_types[edge]); }
+
+    /**
+     * Check equality with the other profile
+     * @param rhs A profile in the right-hand side
+     * @return True if all parameters are same (false if not)
+     */
+    bool operator==(const RoadProfile& rhs) const
+    {
+        for (int i = 0; i < N_TYPES; i++)
+            if (type_weights[i] != rhs.type_weights[i]) return false;
+        return other_weight == rhs.other_weight && slope_weight == rhs.slope_weight && max_slope == rhs.max_slope;
+    }
+
+    /**
+     * Check inequality with the other profile
+     * @param rhs A profile in the right-hand side
+     * @return True if any parameter is different (false if not)
+     */
+    bool operator!=(const RoadProfile& rhs) const { return !(*this == rhs); }
+
+    /**
+     * Get a profile for pedestrians (same as the default)
+     * @return The profile for pedestrians
+     */
+    static RoadProfile pedestrian() { return RoadProfile(); }
+
+    /**
+     * Get a profile for wheelchairs, which cannot use stairs and escalators and avoids slopes steeper than 1:12
+     * @return The profile for wheelchairs
+     */
+    static RoadProfile wheelchair()
+    {
+        RoadProfile profile;
+        profile.type_weights[Edge::EDGE_STAIR] = -1;
+        profile.type_weights[Edge::EDGE_ESCALATOR] = -1;
+        profile.slope_weight = 10;
+        profile.max_slope = 1. / 12;
+        return profile;
+    }
+
+    /**
+     * Get a profile for mobile robots, which cannot use stairs, escalators, and roads for cars
+     * @return The profile for mobile robots
+     */
+    static RoadProfile robot()
+    {
+        RoadProfile profile;
+        profile.type_weights[Edge::EDGE_ROAD] = -1;
+        profile.type_weights[Edge::EDGE_STAIR] = -1;
+        profile.type_weights[Edge::EDGE_ESCALATOR] = -1;
+        profile.type_weights[Edge::EDGE_CROSSWALK] = 2;
+        profile.slope_weight = 5;
+        profile.max_slope = 0.15;
+        return profile;
+    }
+
+    /** Weight of each known edge type (negative if impassable) */
+    double type_weights[N_TYPES];
+
+    /** Weight of unknown edge types (negative if impassable) */
+    double other_weight;
+
+    /** Penalty per unit slope (rise over run) */
+    double slope_weight;
+
+    /** The maximum passable slope (negative if not limited) */
+    double max_slope;
+};
+
+} // End of 'dg'
+
+#endif // End of '__ROAD_PROFILE__'
@@ -0,0 +1,132 @@
+#ifndef __SHARED_MAP__
+#define __SHARED_MAP__
+
+#include "core/map.hpp"
+#include <memory>
+#include <mutex>
+
+namespace dg
+{
+
+/**
+ * @brief An immutable and reference-counted topological map
+ *
+ * A <b>map snapshot</b> is shared by modules (e.g. map manager, localizer, guidance, and GUI) without copying the whole map.
+ * It is never modified after publication, so it is safe to read from multiple threads without any lock.
+ */
+typedef std::shared_ptr<const Map> MapSnapshot;
+
+/**
+ * @brief A holder of the latest map snapshot with its version
+ *
+ * A <b>shared map</b> publishes a new map as a new snapshot and increases its version.
+ * Readers take the current snapshot in O(1), and they keep using it even if a newer snapshot is published later.
+ * Modification is done as copy-on-write through update(), so the previous snapshot is never changed.
+ * All member functions are thread-safe.
+ */
+class SharedMap
+{
+public:
+    /**
+     * The default constructor
+     */
+    SharedMap() : m_version(0) { }
+
+    /**
+     * Get the current snapshot (time complexity: O(1))
+     * @return The current snapshot (`nullptr` if nothing is published)
+     */
+    MapSnapshot get() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_snapshot;
+    }
+
+    /**
+     * Get the current snapshot and its version together (time complexity: O(1))
+     * @param version The version of the current snapshot (return value)
+     * @return The current snapshot (`nullptr` if nothing is published)
+     */
+    MapSnapshot get(uint64_t& version) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        version = m_version;
+        return m_snapshot;
+    }
+
+    /**
+     * Get the version of the current snapshot (time complexity: O(1))
+     * @return The version (0 if nothing is published)
+     */
+    uint64_t getVersion() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_version;
+    }
+
+    /**
+     * Publish the given snapshot (time complexity: O(1))
+     * @param snapshot The given snapshot
+     * @return The version of the published snapshot
+     */
+    uint64_t set(const MapSnapshot& snapshot)
+    {
+        std::lock_guard<std::mutex> writer(m_writer_mutex);
+        return publish(snapshot);
+    }
+
+    /**
+     * Publish the given map as a new snapshot without copying (time complexity: O(1))
+     * @param map The given map (moved out)
+     * @return The version of the published snapshot
+     */
+    uint64_t set(Map&& map) { return set(std::make_shared<const Map>(std::move(map))); }
+
+    /**
+     * Modify the current map and publish it as a new snapshot (time complexity: O(|N| + |E| + |P| + |V|) for copying)<br>
+     * Concurrent updates are serialized, so no modification is lost.
+     * @param modifier A function (or functor) which modifies the given 'Map&' and returns true to publish it
+     * @return The version of the published snapshot (0 if not published)
+     */
+    template <typename Modifier>
+    uint64_t update(Modifier modifier)
+    {
+        std::lock_guard<std::mutex> writer(m_writer_mutex);
+        MapSnapshot current = get();
+        std::shared_ptr<Map> next = current ? std::make_shared<Map>(*current) : std::make_shared<Map>();
+        if (!modifier(*next)) return 0;
+        return publish(next);
+    }
+
+    /**
+     * Remove the current snapshot
+     */
+    void clear() { set(MapSnapshot()); }
+
+protected:
+    /**
+     * Replace the current snapshot and increase the version
+     */
+    uint64_t publish(const MapSnapshot& snapshot)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_snapshot = snapshot;
+        return ++m_version;
+    }
+
+    /** The current snapshot */
+    MapSnapshot m_snapshot;
+
+    /** The version of the current snapshot */
+    uint64_t m_version;
+
+    /** A mutex for reading and replacing the current snapshot */
+    mutable std::mutex m_mutex;
+
+    /** A mutex for serializing writers */
+    std::mutex m_writer_mutex;
+};
+
+} // End of 'dg'
+
+#endif // End of '__SHARED_MAP__'
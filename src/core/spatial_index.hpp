@@ -0,0 +1,576 @@
+#ifndef __SPATIAL_INDEX__
+#define __SPATIAL_INDEX__
+
+#include "core/map.hpp"
+#include <cmath>
+#include <limits>
+
+namespace dg
+{
+
+/**
+ * @brief A uniform grid for spatial queries over points or line segments
+ *
+ * A <b>spatial index</b> divides a metric plane (e.g. UTM) into square cells and keeps indices of items overlapped with each cell.
+ * Cells are stored as compressed sparse row (CSR), so the whole index consists of a few contiguous arrays.
+ * An item is a point or a line segment, and it is identified by its index in the given array at build().
+ * A line segment is registered to all cells overlapped with its bounding box.
+ * Items with non-finite coordinates (e.g. an edge with an unknown node) are not registered.
+ */
+class SpatialIndex
+{
+public:
+    /**
+     * The default constructor
+     */
+    SpatialIndex() : m_cell_size(1), m_nx(0), m_ny(0) { }
+
+    /**
+     * Build this index with points (time complexity: O(N))
+     * @param pts The given points (Unit: [m])
+     * @param cell_size The side length of a cell (Unit: [m]; 0 for automatic selection)
+     * @return True if successful (false if no valid point is given)
+     */
+    bool build(const std::vector<Point2>& pts, double cell_size = 0)
+    {
+        return build(pts, std::vector<Point2>(), cell_size);
+    }
+
+    /**
+     * Build this index with line segments (time complexity: O(N))
+     * @param pt1s The given start points of line segments (Unit: [m])
+     * @param pt2s The given end points of line segments (Unit: [m]; empty if items are points)
+     * @param cell_size The side length of a cell (Unit: [m]; 0 for automatic selection)
+     * @return True if successful (false if no valid segment is given)
+     */
+    bool build(const std::vector<Point2>& pt1s, const std::vector<Point2>& pt2s, double cell_size = 0)
+    {
+        clear();
+        if (!pt2s.empty() && pt1s.size() != pt2s.size()) return false;
+        m_pt1s = pt1s;
+        m_pt2s = pt2s;
+
+        // Find the bounding box of valid items
+        Point2 box_min(HUGE_VAL, HUGE_VAL), box_max(-HUGE_VAL, -HUGE_VAL);
+        size_t n_valid = 0;
+        for (size_t i = 0; i < m_pt1s.size(); i++)
+        {
+            if (!isValid(i)) continue;
+            Point2 item_min, item_max;
+            getBox(i, item_min, item_max);
+            box_min.x = std::min(box_min.x, item_min.x);
+            box_min.y = std::min(box_min.y, item_min.y);
+            box_max.x = std::max(box_max.x, item_max.x);
+            box_max.y = std::max(box_max.y, item_max.y);
+            n_valid++;
+        }
+        if (n_valid == 0)
+        {
+            clear();
+            return false;
+        }
+
+        // Decide the grid size (about one item per cell, and at most 4 cells per item)
+        double width = std::max(box_max.x - box_min.x, 1.), height = std::max(box_max.y - box_min.y, 1.);
+        if (cell_size <= 0) cell_size = std::sqrt(width * height / n_valid);
+        cell_size = std::max(cell_size, std::sqrt(width * height / (4 * n_valid + 16)));
+        m_origin = box_min;
+        m_cell_size = cell_size;
+        m_nx = static_cast<int>(width / cell_size) + 1;
+        m_ny = static_cast<int>(height / cell_size) + 1;
+
+        // Count items for each cell and arrange them as CSR
+        m_cell_offsets.assign(static_cast<size_t>(m_nx) * m_ny + 1, 0);
+        for (size_t i = 0; i < m_pt1s.size(); i++)
+        {
+            if (!isValid(i)) continue;
+            int x0, y0, x1, y1;
+            getCellRange(i, x0, y0, x1, y1);
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                    m_cell_offsets[y * m_nx + x + 1]++;
+        }
+        for (size_t c = 1; c < m_cell_offsets.size(); c++) m_cell_offsets[c] += m_cell_offsets[c - 1];
+        m_cell_items.resize(m_cell_offsets.back());
+        std::vector<uint32_t> fill(m_cell_offsets.begin(), m_cell_offsets.end() - 1);
+        for (size_t i = 0; i < m_pt1s.size(); i++)
+        {
+            if (!isValid(i)) continue;
+            int x0, y0, x1, y1;
+            getCellRange(i, x0, y0, x1, y1);
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                    m_cell_items[fill[y * m_nx + x]++] = static_cast<uint32_t>(i);
+        }
+        return true;
+    }
+
+    /**
+     * Remove all data
+     */
+    void clear()
+    {
+        m_pt1s.clear();
+        m_pt2s.clear();
+        m_cell_offsets.clear();
+        m_cell_items.clear();
+        m_cell_size = 1;
+        m_nx = m_ny = 0;
+    }
+
+    /**
+     * Check whether this index is empty or not
+     * @return True if empty (false if not empty)
+     */
+    bool isEmpty() const { return m_cell_items.empty(); }
+
+    /**
+     * Count the number of all items including invalid ones (time complexity: O(1))
+     * @return The number of items
+     */
+    size_t size() const { return m_pt1s.size(); }
+
+    /**
+     * Get the (start) point of an item
+     * @param item Index of the item
+     * @return The (start) point of the item (Unit: [m])
+     */
+    const Point2& getPoint(size_t item) const { return m_pt1s[item]; }
+
+    /**
+     * Get the end point of an item
+     * @param item Index of the item
+     * @return The end point of the item (the point itself if items are points; Unit: [m])
+     */
+    const Point2& getEndPoint(size_t item) const { return m_pt2s.empty() ? m_pt1s[item] : m_pt2s[item]; }
+
+    /**
+     * Calculate distance from the given point to an item
+     * @param pt The given point (Unit: [m])
+     * @param item Index of the item
+     * @return The distance (Unit: [m])
+     */
+    double getDistance(const Point2& pt, size_t item) const
+    {
+        if (m_pt2s.empty())
+        {
+            double dx = pt.x - m_pt1s[item].x, dy = pt.y - m_pt1s[item].y;
+            return std::sqrt(dx * dx + dy * dy);
+        }
+        const Point2& p1 = m_pt1s[item];
+        const Point2& p2 = m_pt2s[item];
+        double vx = p2.x - p1.x, vy = p2.y - p1.y, wx = pt.x - p1.x, wy = pt.y - p1.y;
+        double len2 = vx * vx + vy * vy;
+        double t = (len2 > 0) ? std::max(0., std::min(1., (vx * wx + vy * wy) / len2)) : 0;
+        double dx = wx - t * vx, dy = wy - t * vy;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    /**
+     * Find items overlapped with the given box
+     * @param box_min The minimum corner of the box (Unit: [m])
+     * @param box_max The maximum corner of the box (Unit: [m])
+     * @param found Indices of the found items (in ascending order)
+     * @return The number of the found items
+     */
+    size_t queryBox(const Point2& box_min, const Point2& box_max, std::vector<size_t>& found) const
+    {
+        found.clear();
+        if (isEmpty()) return 0;
+        int x0 = std::max(toCellX(box_min.x), 0), y0 = std::max(toCellY(box_min.y), 0);
+        int x1 = std::min(toCellX(box_max.x), m_nx - 1), y1 = std::min(toCellY(box_max.y), m_ny - 1);
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                int c = y * m_nx + x;
+                for (uint32_t j = m_cell_offsets[c]; j < m_cell_offsets[c + 1]; j++)
+                {
+                    Point2 item_min, item_max;
+                    getBox(m_cell_items[j], item_min, item_max);
+                    if (item_max.x >= box_min.x && item_min.x <= box_max.x && item_max.y >= box_min.y && item_min.y <= box_max.y)
+                        found.push_back(m_cell_items[j]);
+                }
+            }
+        }
+        removeDuplicates(found);
+        return found.size();
+    }
+
+    /**
+     * Find items within the given radius
+     * @param pt The given center point (Unit: [m])
+     * @param radius The given radius (Unit: [m])
+     * @param found Indices of the found items (in ascending order)
+     * @return The number of the found items
+     */
+    size_t queryRadius(const Point2& pt, double radius, std::vector<size_t>& found) const
+    {
+        found.clear();
+        if (isEmpty()) return 0;
+        int x0 = std::max(toCellX(pt.x - radius), 0), y0 = std::max(toCellY(pt.y - radius), 0);
+        int x1 = std::min(toCellX(pt.x + radius), m_nx - 1), y1 = std::min(toCellY(pt.y + radius), m_ny - 1);
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                int c = y * m_nx + x;
+                for (uint32_t j = m_cell_offsets[c]; j < m_cell_offsets[c + 1]; j++)
+                    if (getDistance(pt, m_cell_items[j]) <= radius) found.push_back(m_cell_items[j]);
+            }
+        }
+        removeDuplicates(found);
+        return found.size();
+    }
+
+    /**
+     * Find the k-nearest items
+     * @param pt The given query point (Unit: [m])
+     * @param k The number of items to find
+     * @param found Indices of the found items (in ascending order of distance)
+     * @param dists Distance to the found items (Unit: [m]; nullptr if not necessary)
+     * @return The number of the found items
+     */
+    size_t queryNearest(const Point2& pt, size_t k, std::vector<size_t>& found, std::vector<double>* dists = nullptr) const
+    {
+        return queryNearest(pt, k, found, [](size_t) { return true; }, dists);
+    }
+
+    /**
+     * Find the k-nearest items which satisfy the given condition<br>
+     * Cells are visited ring by ring from the query point, and the search stops when the next ring cannot contain any closer item.
+     * @param pt The given query point (Unit: [m])
+     * @param k The number of items to find
+     * @param found Indices of the found items (in ascending order of distance)
+     * @param filter A function (or functor) which returns true for an acceptable item index
+     * @param dists Distance to the found items (Unit: [m]; nullptr if not necessary)
+     * @return The number of the found items
+     */
+    template <typename Filter>
+    size_t queryNearest(const Point2& pt, size_t k, std::vector<size_t>& found, Filter filter, std::vector<double>* dists = nullptr) const
+    {
+        found.clear();
+        if (dists != nullptr) dists->clear();
+        if (isEmpty() || k == 0) return 0;
+
+        std::vector<std::pair<double, size_t> > best; // Sorted by distance
+        int cx = toCellX(pt.x), cy = toCellY(pt.y);
+        int r_start = std::max(std::max(-cx, cx - m_nx + 1), std::max(-cy, cy - m_ny + 1));
+        int r_end = std::max(std::max(cx, m_nx - 1 - cx), std::max(cy, m_ny - 1 - cy));
+        for (int r = std::max(r_start, 0); r <= r_end; r++)
+        {
+            int y0 = std::max(cy - r, 0), y1 = std::min(cy + r, m_ny - 1);
+            for (int y = y0; y <= y1; y++)
+            {
+                bool full_row = (y == cy - r || y == cy + r);
+                int x0 = std::max(cx - r, 0), x1 = std::min(cx + r, m_nx - 1);
+                int step = full_row ? 1 : (2 * r); // Only two cells at both ends if not a full row
+                for (int x = full_row ? x0 : cx - r; x <= x1; x += step)
+                {
+                    if (x < x0) continue;
+                    int c = y * m_nx + x;
+                    for (uint32_t j = m_cell_offsets[c]; j < m_cell_offsets[c + 1]; j++)
+                    {
+                        size_t item = m_cell_items[j];
+                        double d = getDistance(pt, item);
+                        if (best.size() >= k && d >= best.back().first) continue;
+                        if (!m_pt2s.empty() && isFound(best, item)) continue;
+                        if (!filter(item)) continue;
+                        std::pair<double, size_t> candidate(d, item);
+                        best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+                        if (best.size() > k) best.pop_back();
+                    }
+                }
+            }
+            if (best.size() >= k && best.back().first <= r * m_cell_size) break; // Items in the next ring are farther than 'r * m_cell_size'
+        }
+
+        found.reserve(best.size());
+        for (auto b = best.begin(); b != best.end(); b++)
+        {
+            found.push_back(b->second);
+            if (dists != nullptr) dists->push_back(b->first);
+        }
+        return found.size();
+    }
+
+    /**
+     * Find the nearest item with the given squared distance function<br>
+     * The function can add penalties (e.g. heading difference) to the squared Euclidean distance, but it should not be less than it.
+     * Cells are visited ring by ring from the query point, and ties are broken by the smaller item index
+     * (the same result with a linear search over items in their order).
+     * @param pt The given query point (Unit: [m])
+     * @param dist2 A function (or functor) which returns the squared distance to an item (negative to skip the item)
+     * @param found Index of the found item (output)
+     * @param found_dist2 The squared distance to the found item (output; nullptr if not necessary)
+     * @param max_dist The maximum Euclidean distance to search (Unit: [m]; negative if not limited; farther items can be skipped)
+     * @return True if an item is found (false if not)
+     */
+    template <typename Dist2>
+    bool queryNearestWith(const Point2& pt, Dist2 dist2, size_t& found, double* found_dist2 = nullptr, double max_dist = -1) const
+    {
+        auto dist2_batch = [&dist2](const uint32_t* items, size_t n, double* d2)
+        {
+            for (size_t i = 0; i < n; i++) d2[i] = dist2(items[i]);
+        };
+        return queryNearestBatch(pt, dist2_batch, found, found_dist2, max_dist);
+    }
+
+    /**
+     * Find the nearest item with the given squared distance function which evaluates all items in a cell at once (e.g. using SIMD)
+     * @param pt The given query point (Unit: [m])
+     * @param dist2_batch A function (or functor) as 'void (const uint32_t* items, size_t n, double* dist2)' which fills the squared distance to each item (negative to skip the item)
+     * @param found Index of the found item (output)
+     * @param found_dist2 The squared distance to the found item (output; nullptr if not necessary)
+     * @param max_dist The maximum Euclidean distance to search (Unit: [m]; negative if not limited; farther items can be skipped)
+     * @return True if an item is found (false if not)
+     * @see queryNearestWith
+     */
+    template <typename Dist2Batch>
+    bool queryNearestBatch(const Point2& pt, Dist2Batch dist2_batch, size_t& found, double* found_dist2 = nullptr, double max_dist = -1) const
+    {
+        if (isEmpty()) return false;
+
+        double best_d2 = HUGE_VAL;
+        size_t best = 0;
+        std::vector<double> d2;
+        int cx = toCellX(pt.x), cy = toCellY(pt.y);
+        int r_start = std::max(std::max(-cx, cx - m_nx + 1), std::max(-cy, cy - m_ny + 1));
+        int r_end = std::max(std::max(cx, m_nx - 1 - cx), std::max(cy, m_ny - 1 - cy));
+        if (max_dist >= 0) r_end = std::min(r_end, static_cast<int>(max_dist / m_cell_size) + 1);
+        for (int r = std::max(r_start, 0); r <= r_end; r++)
+        {
+            int y0 = std::max(cy - r, 0), y1 = std::min(cy + r, m_ny - 1);
+            for (int y = y0; y <= y1; y++)
+            {
+                bool full_row = (y == cy - r || y == cy + r);
+                int x0 = std::max(cx - r, 0), x1 = std::min(cx + r, m_nx - 1);
+                int step = full_row ? 1 : (2 * r); // Only two cells at both ends if not a full row
+                for (int x = full_row ? x0 : cx - r; x <= x1; x += step)
+                {
+                    if (x < x0) continue;
+                    int c = y * m_nx + x;
+                    size_t n = m_cell_offsets[c + 1] - m_cell_offsets[c];
+                    if (n == 0) continue;
+                    const uint32_t* items = &m_cell_items[m_cell_offsets[c]];
+                    if (d2.size() < n) d2.resize(n);
+                    dist2_batch(items, n, d2.data());
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        if (d2[j] < 0) continue;
+                        if (d2[j] < best_d2 || (d2[j] == best_d2 && items[j] < best))
+                        {
+                            best_d2 = d2[j];
+                            best = items[j];
+                        }
+                    }
+                }
+            }
+            double ring = r * m_cell_size;
+            if (best_d2 < ring * ring) break; // Items in the next ring are farther than 'r * m_cell_size'
+        }
+
+        if (best_d2 == HUGE_VAL) return false;
+        found = best;
+        if (found_dist2 != nullptr) *found_dist2 = best_d2;
+        return true;
+    }
+
+protected:
+    /**
+     * Check whether an item has finite coordinates or not
+     */
+    bool isValid(size_t item) const
+    {
+        if (!std::isfinite(m_pt1s[item].x) || !std::isfinite(m_pt1s[item].y)) return false;
+        if (!m_pt2s.empty() && (!std::isfinite(m_pt2s[item].x) || !std::isfinite(m_pt2s[item].y))) return false;
+        return true;
+    }
+
+    /**
+     * Get the bounding box of an item
+     */
+    void getBox(size_t item, Point2& item_min, Point2& item_max) const
+    {
+        item_min = item_max = m_pt1s[item];
+        if (m_pt2s.empty()) return;
+        item_min.x = std::min(item_min.x, m_pt2s[item].x);
+        item_min.y = std::min(item_min.y, m_pt2s[item].y);
+        item_max.x = std::max(item_max.x, m_pt2s[item].x);
+        item_max.y = std::max(item_max.y, m_pt2s[item].y);
+    }
+
+    /**
+     * Get the range of cells overlapped with an item
+     */
+    void getCellRange(size_t item, int& x0, int& y0, int& x1, int& y1) const
+    {
+        Point2 item_min, item_max;
+        getBox(item, item_min, item_max);
+        x0 = std::max(toCellX(item_min.x), 0);
+        y0 = std::max(toCellY(item_min.y), 0);
+        x1 = std::min(toCellX(item_max.x), m_nx - 1);
+        y1 = std::min(toCellY(item_max.y), m_ny - 1);
+    }
+
+    /**
+     * Convert X position to the column of cells (not clipped)
+     */
+    int toCellX(double x) const { return static_cast<int>(std::floor(std::max(std::min((x - m_origin.x) / m_cell_size, 1e9), -1e9))); }
+
+    /**
+     * Convert Y position to the row of cells (not clipped)
+     */
+    int toCellY(double y) const { return static_cast<int>(std::floor(std::max(std::min((y - m_origin.y) / m_cell_size, 1e9), -1e9))); }
+
+    /**
+     * Check whether the given item is already in the list
+     */
+    static bool isFound(const std::vector<std::pair<double, size_t> >& best, size_t item)
+    {
+        for (auto b = best.begin(); b != best.end(); b++)
+            if (b->second == item) return true;
+        return false;
+    }
+
+    /**
+     * Sort indices and remove duplicated ones (registered in multiple cells)
+     */
+    void removeDuplicates(std::vector<size_t>& found) const
+    {
+        std::sort(found.begin(), found.end());
+        if (!m_pt2s.empty()) found.erase(std::unique(found.begin(), found.end()), found.end());
+    }
+
+    /** The (start) points of items */
+    std::vector<Point2> m_pt1s;
+
+    /** The end points of items (empty if items are points) */
+    std::vector<Point2> m_pt2s;
+
+    /** The minimum corner of the grid */
+    Point2 m_origin;
+
+    /** The side length of a cell */
+    double m_cell_size;
+
+    /** The number of columns of cells */
+    int m_nx;
+
+    /** The number of rows of cells */
+    int m_ny;
+
+    /** Offsets of items for each cell (size: the number of cells + 1) */
+    std::vector<uint32_t> m_cell_offsets;
+
+    /** Indices of items sorted by their cells */
+    std::vector<uint32_t> m_cell_items;
+};
+
+/**
+ * @brief Spatial indices over all elements of the topological map
+ *
+ * A <b>map spatial index</b> keeps a spatial index for each of nodes, edges (as line segments), POIs, and street-views of dg::Map.
+ * Each item index is same with the index of the element in dg::Map, and all positions are in the metric coordinate given at build().
+ * It should be built again when the map is changed, which is checked by isBuilt() with the revision of the map.
+ */
+class MapSpatialIndex
+{
+public:
+    /**
+     * The default constructor
+     */
+    MapSpatialIndex() : m_revision(0) { }
+
+    /**
+     * Build spatial indices of the given map (time complexity: O(|N| + |E| + |P| + |V|))
+     * @param map The given topological map
+     * @param converter A converter from geodesic to metric positions which has 'Point2 toMetric(const LatLon&)' (e.g. dg::UTMConverter)
+     * @param cell_size The side length of a cell (Unit: [m]; 0 for automatic selection)
+     * @return True if successful (false if the map is empty)
+     */
+    template <typename Converter>
+    bool build(const Map& map, const Converter& converter, double cell_size = 0)
+    {
+        clear();
+        std::vector<Point2> pts;
+        LookupTable lookup_nodes;
+        pts.reserve(map.nodes.size());
+        lookup_nodes.reserve(map.nodes.size());
+        for (auto node = map.nodes.begin(); node != map.nodes.end(); node++)
+        {
+            lookup_nodes.insert(node->id, pts.size());
+            pts.push_back(converter.toMetric(*node));
+        }
+        nodes.build(pts, cell_size);
+
+        // Make edges as line segments with the converted nodes
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<Point2> pt1s(map.edges.size(), Point2(nan, nan)), pt2s(map.edges.size(), Point2(nan, nan));
+        for (size_t i = 0; i < map.edges.size(); i++)
+        {
+            size_t node1 = lookup_nodes.find(map.edges[i].node_id1);
+            size_t node2 = lookup_nodes.find(map.edges[i].node_id2);
+            if (node1 != LookupTable::npos) pt1s[i] = pts[node1];
+            if (node2 != LookupTable::npos) pt2s[i] = pts[node2];
+        }
+        edges.build(pt1s, pt2s, cell_size);
+
+        pts.clear();
+        for (auto poi = map.pois.begin(); poi != map.pois.end(); poi++)
+            pts.push_back(converter.toMetric(*poi));
+        pois.build(pts, cell_size);
+
+        pts.clear();
+        for (auto view = map.views.begin(); view != map.views.end(); view++)
+            pts.push_back(converter.toMetric(*view));
+        views.build(pts, cell_size);
+
+        bool built = !map.nodes.empty() || !map.pois.empty() || !map.views.empty();
+        m_revision = built ? map.getRevision() : 0;
+        return built;
+    }
+
+    /**
+     * Remove all data
+     */
+    void clear()
+    {
+        nodes.clear();
+        edges.clear();
+        pois.clear();
+        views.clear();
+        m_revision = 0;
+    }
+
+    /**
+     * Check whether this index is built for the given map or not (time complexity: O(1))
+     * @param map The given topological map
+     * @return True if built (false if not built or the map is modified after building)
+     * @see Map::getRevision
+     */
+    bool isBuilt(const Map& map) const
+    {
+        return m_revision != 0 && m_revision == map.getRevision();
+    }
+
+    /** A spatial index of nodes */
+    SpatialIndex nodes;
+
+    /** A spatial index of edges (line segments) */
+    SpatialIndex edges;
+
+    /** A spatial index of POIs */
+    SpatialIndex pois;
+
+    /** A spatial index of street-views */
+    SpatialIndex views;
+
+protected:
+    /** The revision of the map which this index is built for (0 if not built) */
+    uint64_t m_revision;
+};
+
+} // End of 'dg'
+
+#endif // End of '__SPATIAL_INDEX__'
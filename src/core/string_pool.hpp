@@ -0,0 +1,321 @@
+#ifndef __STRING_POOL__
+#define __STRING_POOL__
+
+#include "core/lookup_table.hpp"
+#include <cwchar>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace dg
+{
+
+/**
+ * @brief A pool of unique strings
+ *
+ * A <b>string pool</b> keeps only one copy of each distinct string in large memory blocks (arena).
+ * A stored string is never moved or removed, so its pointer is valid until the pool is destroyed.
+ * Two strings from the same pool are equal if and only if their pointers are same.
+ * The empty string is not stored but shared by all pools as StringPool::emptyString() without locking.
+ * All member functions are thread-safe.
+ */
+class StringPool
+{
+public:
+    /**
+     * The default constructor
+     */
+    StringPool() : m_block_used(BLOCK_SIZE), m_memory(0) { }
+
+    /**
+     * Store the given string if it does not exist (time complexity: O(L))
+     * @param str The given string
+     * @param length The length of the given string
+     * @return A pointer to the unique copy of the given string (null-terminated)
+     */
+    const wchar_t* intern(const wchar_t* str, size_t length)
+    {
+        if (length == 0) return emptyString();
+        uint64_t key = hash(str, length);
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Find the string in the chain of the same hash value
+        size_t head = m_lookup.find(key);
+        for (size_t i = head; i != LookupTable::npos; i = m_entries[i].next)
+        {
+            const Entry& entry = m_entries[i];
+            if (entry.length == length && std::wmemcmp(entry.str, str, length) == 0) return entry.str;
+        }
+
+        // Copy the string into the arena
+        wchar_t* copy = allocate(length + 1);
+        std::wmemcpy(copy, str, length);
+        copy[length] = L'\0';
+        Entry entry = { copy, length, head };
+        if (head == LookupTable::npos) m_lookup.insert(key, m_entries.size());
+        else m_lookup.update(key, m_entries.size());
+        m_entries.push_back(entry);
+        return copy;
+    }
+
+    /**
+     * Store the given string if it does not exist (time complexity: O(L))
+     * @param str The given string
+     * @return A pointer to the unique copy of the given string (null-terminated)
+     */
+    const wchar_t* intern(const std::wstring& str) { return intern(str.c_str(), str.length()); }
+
+    /**
+     * Count the number of distinct strings
+     * @return The number of strings
+     */
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    /**
+     * Get the size of memory blocks allocated for strings
+     * @return The size of memory blocks (Unit: [byte])
+     */
+    size_t memory() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_memory;
+    }
+
+    /**
+     * Get the empty string which is shared by all pools (lock-free)
+     * @return A pointer to the empty string (null-terminated)
+     */
+    static const wchar_t* emptyString()
+    {
+        static const wchar_t empty[1] = { L'\0' };
+        return empty;
+    }
+
+    /**
+     * Get the process-wide string pool<br>
+     * It lives until the process exits (never destroyed), so its strings are still valid in destructors of static objects.
+     * Its strings are never released, so it is suitable for a bounded set of strings such as names of POIs.
+     * @return A reference to the process-wide string pool
+     */
+    static StringPool& global()
+    {
+        static StringPool* pool = new StringPool();
+        return *pool;
+    }
+
+protected:
+    /** The number of characters in a memory block */
+    static const size_t BLOCK_SIZE = 16384;
+
+    /**
+     * @brief An entry of the stored string
+     */
+    struct Entry
+    {
+        /** A pointer to the stored string */
+        const wchar_t* str;
+
+        /** The length of the stored string */
+        size_t length;
+
+        /** The next entry with the same hash value (LookupTable::npos if not exist) */
+        size_t next;
+    };
+
+    /**
+     * Calculate a hash value of the given string (FNV-1a)
+     */
+    static uint64_t hash(const wchar_t* str, size_t length)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++)
+        {
+            h ^= static_cast<uint64_t>(str[i]);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    /**
+     * Allocate the given number of characters in the arena
+     */
+    wchar_t* allocate(size_t n)
+    {
+        if (n > BLOCK_SIZE / 4)
+        {
+            // Keep a long string in its own block (and do not waste the current block)
+            std::unique_ptr<wchar_t[]> block(new wchar_t[n]);
+            wchar_t* ptr = block.get();
+            m_blocks.insert(m_blocks.begin(), std::move(block));
+            m_memory += n * sizeof(wchar_t);
+            return ptr;
+        }
+        if (m_block_used + n > BLOCK_SIZE)
+        {
+            m_blocks.push_back(std::unique_ptr<wchar_t[]>(new wchar_t[BLOCK_SIZE]));
+            m_block_used = 0;
+            m_memory += BLOCK_SIZE * sizeof(wchar_t);
+        }
+        wchar_t* ptr = m_blocks.back().get() + m_block_used;
+        m_block_used += n;
+        return ptr;
+    }
+
+    /** Memory blocks of strings (the last one is being filled) */
+    std::vector<std::unique_ptr<wchar_t[]> > m_blocks;
+
+    /** The number of used characters in the last block */
+    size_t m_block_used;
+
+    /** The size of allocated memory blocks */
+    size_t m_memory;
+
+    /** Entries of the stored strings */
+    std::vector<Entry> m_entries;
+
+    /** A hash table from hash values to the first entry of each chain */
+    LookupTable m_lookup;
+
+    /** A mutex for thread-safety */
+    mutable std::mutex m_mutex;
+};
+
+/**
+ * @brief A string interned in the process-wide string pool
+ *
+ * An <b>interned string</b> only keeps a pointer to the unique copy in StringPool::global(),
+ * so copying and comparing equality take O(1) regardless of its length.
+ * It can be used as like std::wstring for assignment, comparison, and conversion.
+ */
+class InternedString
+{
+public:
+    /**
+     * The default constructor (an empty string without locking the pool)
+     */
+    InternedString() : m_str(StringPool::emptyString()) { }
+
+    /**
+     * A constructor with a string
+     * @param str The given string
+     */
+    InternedString(const std::wstring& str) : m_str(StringPool::global().intern(str)) { }
+
+    /**
+     * A constructor with a null-terminated string
+     * @param str The given string
+     */
+    InternedString(const wchar_t* str) : m_str(StringPool::global().intern(str, std::wcslen(str))) { }
+
+    /**
+     * Get the null-terminated string
+     * @return A pointer to the string
+     */
+    const wchar_t* c_str() const { return m_str; }
+
+    /**
+     * Get the length of the string (time complexity: O(L))
+     * @return The length of the string
+     */
+    size_t length() const { return std::wcslen(m_str); }
+
+    /**
+     * Check whether the string is empty or not
+     * @return True if empty (false if not empty)
+     */
+    bool empty() const { return m_str[0] == L'\0'; }
+
+    /**
+     * Get a copy as std::wstring
+     * @return A copy of the string
+     */
+    std::wstring str() const { return std::wstring(m_str); }
+
+    /**
+     * Convert to std::wstring
+     */
+    operator std::wstring() const { return str(); }
+
+    /**
+     * Get a key which is unique for each distinct string
+     * @return The key of this string
+     */
+    ID key() const { return static_cast<ID>(reinterpret_cast<uintptr_t>(m_str)); }
+
+    /**
+     * Check equality (time complexity: O(1))
+     * @param rhs The right-hand side
+     * @return Equality of two operands
+     */
+    bool operator==(const InternedString& rhs) const { return (m_str == rhs.m_str); }
+
+    /**
+     * Check inequality (time complexity: O(1))
+     * @param rhs The right-hand side
+     * @return Inequality of two operands
+     */
+    bool operator!=(const InternedString& rhs) const { return (m_str != rhs.m_str); }
+
+    /**
+     * Check equality with a string
+     * @param rhs The right-hand side
+     * @return Equality of two operands
+     */
+    bool operator==(const std::wstring& rhs) const { return (rhs.compare(m_str) == 0); }
+
+    /**
+     * Check inequality with a string
+     * @param rhs The right-hand side
+     * @return Inequality of two operands
+     */
+    bool operator!=(const std::wstring& rhs) const { return (rhs.compare(m_str) != 0); }
+
+    /**
+     * Check equality with a null-terminated string
+     * @param rhs The right-hand side
+     * @return Equality of two operands
+     */
+    bool operator==(const wchar_t* rhs) const { return (std::wcscmp(m_str, rhs) == 0); }
+
+    /**
+     * Check inequality with a null-terminated string
+     * @param rhs The right-hand side
+     * @return Inequality of two operands
+     */
+    bool operator!=(const wchar_t* rhs) const { return (std::wcscmp(m_str, rhs) != 0); }
+
+    /**
+     * Compare in lexicographical order
+     * @param rhs The right-hand side
+     * @return True if this string comes first
+     */
+    bool operator<(const InternedString& rhs) const { return (m_str != rhs.m_str) && (std::wcscmp(m_str, rhs.m_str) < 0); }
+
+protected:
+    /** A pointer to the unique copy in the process-wide string pool */
+    const wchar_t* m_str;
+};
+
+/**
+ * Check equality between a string and an interned string
+ * @param lhs The left-hand side
+ * @param rhs The right-hand side
+ * @return Equality of two operands
+ */
+inline bool operator==(const std::wstring& lhs, const InternedString& rhs) { return (rhs == lhs); }
+
+/**
+ * Check inequality between a string and an interned string
+ * @param lhs The left-hand side
+ * @param rhs The right-hand side
+ * @return Inequality of two operands
+ */
+inline bool operator!=(const std::wstring& lhs, const InternedString& rhs) { return (rhs != lhs); }
+
+} // End of 'dg'
+
+#endif // End of '__STRING_POOL__'
@@ -3,6 +3,13 @@
 
 #include "core/basic_type.hpp"
 #include "core/map.hpp"
+#include "core/frozen_map.hpp"
+#include "core/spatial_index.hpp"
+#include "core/shared_map.hpp"
 #include "core/path.hpp"
+#include "core/road_profile.hpp"
+#include "core/path_finder.hpp"
+#include "core/contraction_hierarchy.hpp"
+#include "core/path_replanner.hpp"
 
 #endif // End of '__DG_CORE__'
@@ -5,14 +5,14 @@
 
 using namespace dg;
 
-bool GuidanceManager::initiateNewGuidance(Path& path, Map& map)
+bool GuidanceManager::initiateNewGuidance(Path& path, MapSnapshot map)
 {
 	if (path.pts.size() < 1)
 	{
 		printf("[Error] GuidanceManager::initiateNewGuidance - No path input!\n");
 		return false;
 	}
-	if (!validatePath(path, map))
+	if (!map || !validatePath(path, *map))
 	{
 		printf("[Error] GuidanceManager::initiateNewGuidance - Path id is not in map!\n");
 		return false;
@@ -26,7 +26,7 @@ bool GuidanceManager::initiateNewGuidance(Path& path, Map& map)
 
 bool GuidanceManager::buildGuides()
 {
-	if (m_map.nodes.empty())
+	if (!m_map || m_map->nodes.empty())
 	{
 		printf("[Error] GuidanceManager::buildGuides - Empty Map\n");
 		return false;
@@ -46,7 +46,7 @@ bool GuidanceManager::buildGuides()
 		ID nextnid = m_path.pts[i + 1].node_id;
 		ID nexteid = m_path.pts[i + 1].edge_id;
 
-		Node* curNode = m_map.findNode(curnid);
+		const Node* curNode = m_map->findNode(curnid);
 		if (curNode == nullptr)
 		{
 			printf("[Error] GuidanceManager::buildGuides()\n");
@@ -57,8 +57,8 @@ bool GuidanceManager::buildGuides()
 		if (i > 0)
 		{
 			ID prevnid = m_path.pts[i - 1].node_id;
-			Node* prevNode = m_map.findNode(prevnid);
-			Node* nextNode = m_map.findNode(nextnid);
+			const Node* prevNode = m_map->findNode(prevnid);
+			const Node* nextNode = m_map->findNode(nextnid);
 
 			angle = getDegree(prevNode, curNode, nextNode);
 		}
@@ -71,7 +71,7 @@ bool GuidanceManager::buildGuides()
 	}
 
 	//add last node
-	Node* lastNode = m_map.findNode(m_path.pts.back().node_id);
+	const Node* lastNode = m_map->findNode(m_path.pts.back().node_id);
 	ID lastEdge = lastNode->edge_ids[0];
 	m_finalTurn = 0;
 	m_extendedPath.push_back(ExtendedPathElement(m_path.pts.back().node_id, lastEdge, 0, 0, m_finalTurn));
@@ -81,7 +81,7 @@ bool GuidanceManager::buildGuides()
 	for (int i = (int)m_extendedPath.size() - 2; i >= 0; i--)
 	{
 		ID eid = m_extendedPath[i].cur_edge_id;
-		Edge* edge = m_map.findEdge(eid);
+		const Edge* edge = m_map->findEdge(eid);
 		d_accumulated += edge->length;
 
 		m_extendedPath[i].remain_distance_to_next_junction = d_accumulated;
@@ -97,7 +97,7 @@ bool GuidanceManager::buildGuides()
 	for (int i = 1; i < (int)m_extendedPath.size(); i++)
 	{
 		ID eid = m_extendedPath[i - 1].cur_edge_id;
-		Edge* edge = m_map.findEdge(eid);
+		const Edge* edge = m_map->findEdge(eid);
 		d_accumulated += edge->length;
 
 		m_extendedPath[i].past_distance_from_prev_junction = d_accumulated;
@@ -182,10 +182,9 @@ bool GuidanceManager::setInitialGuide()
 	{
 		//current robot's pose
 		ID curnid = m_curpose.node_id;
-		Node* curNode = m_map.findNode(curnid);
+		const Node* curNode = m_map->findNode(curnid);
 		ID cureid = curNode->edge_ids[m_curpose.edge_idx];
-		Edge* curEdge = m_map.findEdge(cureid);
-		ID nextnid = (curEdge->node_id1 == curnid) ? curEdge->node_id2 : curEdge->node_id1;
+		ID nextnid = m_map->getAdjNode(curNode, m_curpose.edge_idx)->id;
 
 		//if wrong direction
 		// printf("[applyPose] nextnid: %zu, curEP.next_node_id: %zu!\n", nextnid, curEP.next_node_id);
@@ -244,8 +243,8 @@ bool GuidanceManager::setInitialGuide()
 */
 GuidanceManager::Action GuidanceManager::setActionTurn(ID nid_cur, ID eid_cur, int degree_cur)
 {
-	Node* node = m_map.findNode(nid_cur);
-	Edge* edge = m_map.findEdge(eid_cur);
+	const Node* node = m_map->findNode(nid_cur);
+	const Edge* edge = m_map->findEdge(eid_cur);
 	if (node == nullptr || edge == nullptr)
 	{
 		printf("[Error] GuidanceManager::setActionTurn\n");
@@ -261,8 +260,8 @@ GuidanceManager::Action GuidanceManager::setActionTurn(ID nid_cur, ID eid_cur, i
 
 GuidanceManager::Action GuidanceManager::setActionGo(ID nid_next, ID eid_cur, int degree)
 {
-	Node* node = m_map.findNode(nid_next);
-	Edge* edge = m_map.findEdge(eid_cur);
+	const Node* node = m_map->findNode(nid_next);
+	const Edge* edge = m_map->findEdge(eid_cur);
 	if (node == nullptr || edge == nullptr)
 	{
 		printf("[Error] GuidanceManager::setActionGo - No node or edge\n");
@@ -376,7 +375,7 @@ bool GuidanceManager::applyPose(TopometricPose  pose)
 
 	//validate Current robot location 
 	ID curnid = pose.node_id;
-	Node* curnode = m_map.findNode(curnid);
+	const Node* curnode = m_map->findNode(curnid);
 	if (curnode == nullptr)
 	{
 		printf("[Error] GuidanceManager::applyPose - curnode == nullptr!\n");
@@ -402,8 +401,8 @@ bool GuidanceManager::applyPose(TopometricPose  pose)
 	}
 
 	ExtendedPathElement curEP = getCurExtendedPath(gidx);
-	ID cureid = curnode->edge_ids[pose.edge_idx];
-	Edge* curedge = m_map.findEdge(cureid);
+	const Edge* curedge = m_map->getAdjEdge(curnode, pose.edge_idx);
+	ID cureid = curedge->id;
 
 	//check remain distance
 	double edgedist = curedge->length;
@@ -482,6 +481,14 @@ bool GuidanceManager::setGuideStatus(TopometricPose pose, double conf)
 		return false;
 	}
 
+	//check blocked edges on the remaining path
+	if (isPathBlocked())
+	{
+		printf("The path is blocked!\n");
+		m_gstatus = GuideStatus::GUIDE_PATH_BLOCKED;
+		return false;
+	}
+
 	//check initial status
 	if (m_guide_idx == 0)
 	{
@@ -490,7 +497,7 @@ bool GuidanceManager::setGuideStatus(TopometricPose pose, double conf)
 		return true;
 	}
 
-	Node* curnode = m_map.findNode(curNId);
+	const Node* curnode = m_map->findNode(curNId);
 	ID edgeid = curnode->edge_ids[pose.edge_idx];
 	if (isNodeInPath(curNId) > 0)
 	{//as long as curNId exists on path, everything is ok
@@ -707,7 +714,7 @@ bool GuidanceManager::setArrivalGuide()
 	if (!isForward(m_finalTurn))
 	{
 		ExtendedPathElement lastguide = m_extendedPath.back();
-		Node* dest = m_map.findNode(lastguide.cur_node_id);
+		const Node* dest = m_map->findNode(lastguide.cur_node_id);
 		if (dest == nullptr)
 		{
 			printf("[Error] GuidanceManager::setArrivalGuide - undefined last node: %zu!\n", lastguide.cur_node_id);
@@ -974,6 +981,17 @@ bool GuidanceManager::isEdgeInPath(ID edgeid)
  	return false;
 }
 
+bool GuidanceManager::isPathBlocked()
+{
+	size_t start = (m_guide_idx > 0) ? (size_t)m_guide_idx : 0;
+	for (size_t i = start; i < m_extendedPath.size(); i++)
+	{
+		if (m_blocked_edges.count(m_extendedPath[i].cur_edge_id) > 0)
+			return true;
+	}
+	return false;
+}
+
 int GuidanceManager::getGuideIdxFromPose(TopometricPose pose)
 {
 	ID curnodei = pose.node_id;
@@ -1000,6 +1018,21 @@ bool GuidanceManager::applyPoseGPS(LatLon gps)
 	return true;
 };
 
+/**applyPathBlocked keeps the edge reported as blocked (e.g. by the robot).
+	GUIDE_PATH_BLOCKED is set at the next update if the edge is on the remaining path.
+*/
+bool GuidanceManager::applyPathBlocked(ID edge_id)
+{
+	if (edge_id == 0)
+	{
+		printf("[Error] GuidanceManager::applyPathBlocked - Empty edge id!\n");
+		return false;
+	}
+
+	m_blocked_edges.insert(edge_id);
+	return isEdgeInPath(edge_id);
+}
+
 void GuidanceManager::makeLostValue(double prevconf, double curconf)
 {
 	double lowerlimit = 0.4;
@@ -1089,7 +1122,7 @@ void GuidanceManager::makeLostValue(double prevconf, double curconf)
 //	return result;
 //
 //}
-int GuidanceManager::getDegree(Node* node1, Node* node2, Node* node3)
+int GuidanceManager::getDegree(const Node* node1, const Node* node2, const Node* node3)
 {
 	double x1 = node1->lon;
 	double y1 = node1->lat;
@@ -1121,17 +1154,17 @@ int GuidanceManager::getDegree(Node* node1, Node* node2, Node* node3)
 
 }
 
-bool GuidanceManager::validatePath(Path& path, Map& map)
+bool GuidanceManager::validatePath(Path& path, const Map& map)
 {
 	for (size_t i = 0; i < path.pts.size() - 2; i++)
 	{
-		Node* curnode = map.findNode(path.pts[i].node_id);
+		const Node* curnode = map.findNode(path.pts[i].node_id);
 		if (curnode == nullptr)
 		{
 			printf("No Node-%zu found on map!\n", path.pts[i].node_id);
 			return false;
 		}
-		Edge* curedge = map.findEdge(path.pts[i].edge_id);
+		const Edge* curedge = map.findEdge(path.pts[i].edge_id);
 		if (curedge == nullptr)
 		{
 			printf("No Edge-%zu found on map!\n", path.pts[i].edge_id);
@@ -1,6 +1,7 @@
 #ifndef __GUIDANCE__
 #define __GUIDANCE__
 #include "dg_core.hpp"
+#include <set>
 
 namespace dg
 {
@@ -169,20 +170,22 @@ namespace dg
 	public:
 		GuidanceManager() { }
 
-		bool initiateNewGuidance(Path& path, Map& map);
+		bool initiateNewGuidance(Path& path, MapSnapshot map);
 
 		bool update(TopometricPose pose, double confidence);
 		bool applyPoseGPS(LatLon gps);
+		bool applyPathBlocked(ID edge_id);
+		const std::set<ID>& getBlockedEdges() const { return m_blocked_edges; };
 
 		GuideStatus getGuidanceStatus() const { return m_gstatus; };
 		Guidance getGuidance() const { return m_curguidance; };
 
 	protected:
-		bool validatePath(Path& path, Map& map);
-		int getDegree(Node* node1, Node* node2, Node* node3);
+		bool validatePath(Path& path, const Map& map);
+		int getDegree(const Node* node1, const Node* node2, const Node* node3);
 
 		Path m_path;
-		Map m_map;
+		MapSnapshot m_map;
 		std::vector <ExtendedPathElement> m_extendedPath;
 		int m_guide_idx = -1;	//starts with -1 because its pointing current guide.
 
@@ -210,6 +213,7 @@ namespace dg
 		double m_approachingThreshold = 10.0;
 		bool m_arrival = false;
 		bool m_juctionguide = true;
+		std::set<ID> m_blocked_edges;
 
 		std::string m_movestates[4] = { "ON_NODE","ON_EDGE", "APPROACHING_NODE", "STOP_WAIT" };
 		std::string m_nodes[6] = { "POI", "JUNCTION", "DOOR", "ELEVATOR"
@@ -257,6 +261,7 @@ namespace dg
 
 		bool isNodeInPath(ID nodeid);
 		bool isEdgeInPath(ID edgeid);
+		bool isPathBlocked();
 		Motion getMotion(int ntype, int etype, int degree);
 		Guidance getLastGuidance() { return m_past_guides.back(); };
 		std::string getStringAction(Action action);
@@ -267,7 +272,7 @@ namespace dg
 		std::string getStringTurnDist(Action act, int ntype, double dist);
 		std::string getStringGuidance(Guidance guidance, MoveStatus status);
 		int getGuideIdxFromPose(TopometricPose pose);
-		Map getMap() { return m_map; };
+		MapSnapshot getMap() const { return m_map; };
 		MoveStatus getMoveStatus() { return m_mvstatus; };
 		LatLon getPoseGPS() { return m_latlon; };
 
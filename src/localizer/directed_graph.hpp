@@ -2,13 +2,343 @@
 #define __DIRECTED_GRAPH__
 
 #include <list>
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+#include <functional>
+#include <unordered_map>
 
 namespace dg
 {
 
-template<typename D, typename C> class NodeType;
-template<typename D, typename C> class EdgeType;
-template<typename D, typename C> class DirectedGraph;
+/**
+ * @brief A vector whose elements are never moved
+ *
+ * A <b>stable vector</b> stores its elements in fixed-size chunks of contiguous memory.
+ * Adding an element never moves the others, so pointers to its elements are valid until clear().
+ * Removing an element only marks its slot as removed (and its iterators skip the slot),
+ * so pointers to the other elements are also kept. The removed slot is not reused until clear().
+ * Moving a stable vector keeps pointers and iterators to its elements valid as like std::list.
+ * It provides a subset of std::list interfaces which are used by DirectedGraph.
+ */
+template<typename T>
+class StableVector
+{
+protected:
+    /** The number of bits for the index in a chunk */
+    static const size_t CHUNK_BITS = 8;
+
+    /** The number of elements in a chunk */
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+
+    /** A mask for the index in a chunk */
+    static const size_t CHUNK_MASK = CHUNK_SIZE - 1;
+
+    /**
+     * @brief Elements and their slots (separated from the container to be moved without invalidating iterators)
+     */
+    struct Body
+    {
+        /** The default constructor */
+        Body() : n_slots(0), n_alive(0) { }
+
+        /** Access the element in the given slot */
+        T& at(size_t index) { return chunks[index >> CHUNK_BITS][index & CHUNK_MASK]; }
+
+        /** Access the element in the given slot */
+        const T& at(size_t index) const { return chunks[index >> CHUNK_BITS][index & CHUNK_MASK]; }
+
+        /** Find the next slot which is not removed (the number of slots if not exist) */
+        size_t next(size_t index) const
+        {
+            do { index++; } while (index < n_slots && !alive[index]);
+            return index;
+        }
+
+        /** Find the previous slot which is not removed */
+        size_t prev(size_t index) const
+        {
+            do { index--; } while (index > 0 && !alive[index]);
+            return index;
+        }
+
+        /** Find the first slot which is not removed */
+        size_t first() const { return (n_slots > 0 && !alive[0]) ? next(0) : 0; }
+
+        /** Chunks of elements */
+        std::vector<std::unique_ptr<T[]> > chunks;
+
+        /** Flags whether each slot has an element (1) or is removed (0) */
+        std::vector<char> alive;
+
+        /** The number of used slots */
+        size_t n_slots;
+
+        /** The number of elements */
+        size_t n_alive;
+    };
+
+public:
+    /**
+     * @brief An iterator of StableVector
+     */
+    template<bool IS_CONST>
+    class Iterator
+    {
+    public:
+        /** The type of the elements and their slots */
+        typedef typename std::conditional<IS_CONST, const Body, Body>::type Slots;
+
+        /** The type of element pointers */
+        typedef typename std::conditional<IS_CONST, const T*, T*>::type Pointer;
+
+        /** The type of element references */
+        typedef typename std::conditional<IS_CONST, const T&, T&>::type Reference;
+
+        /** Types for std::iterator_traits */
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Pointer pointer;
+        typedef Reference reference;
+
+        /**
+         * The default constructor
+         */
+        Iterator() : m_body(nullptr), m_index(0) { }
+
+        /**
+         * A constructor with the elements and the index of a slot
+         * @param body A pointer to the elements
+         * @param index The index of the slot
+         */
+        Iterator(Slots* body, size_t index) : m_body(body), m_index(index) { }
+
+        /**
+         * A conversion constructor from a non-constant iterator (only for a constant iterator, so the implicit copy operations are kept)
+         * @param itr The non-constant iterator
+         */
+        template <bool C = IS_CONST, typename std::enable_if<C, int>::type = 0>
+        Iterator(const Iterator<false>& itr) : m_body(itr.getBody()), m_index(itr.getIndex()) { }
+
+        /** Access the element */
+        Reference operator*() const { return m_body->at(m_index); }
+
+        /** Access a member of the element */
+        Pointer operator->() const { return &(m_body->at(m_index)); }
+
+        /** Move to the next element (prefix) */
+        Iterator& operator++() { m_index = m_body->next(m_index); return *this; }
+
+        /** Move to the next element (postfix) */
+        Iterator operator++(int) { Iterator prev = *this; m_index = m_body->next(m_index); return prev; }
+
+        /** Move to the previous element (prefix) */
+        Iterator& operator--() { m_index = m_body->prev(m_index); return *this; }
+
+        /** Move to the previous element (postfix) */
+        Iterator operator--(int) { Iterator next = *this; m_index = m_body->prev(m_index); return next; }
+
+        /** Check equality */
+        bool operator==(const Iterator& rhs) const { return (m_index == rhs.m_index) && (m_body == rhs.m_body); }
+
+        /** Check inequality */
+        bool operator!=(const Iterator& rhs) const { return (m_index != rhs.m_index) || (m_body != rhs.m_body); }
+
+        /** Get the elements of this iterator */
+        Slots* getBody() const { return m_body; }
+
+        /** Get the index of the slot */
+        size_t getIndex() const { return m_index; }
+
+    protected:
+        /** The elements and their slots */
+        Slots* m_body;
+
+        /** The index of the current slot */
+        size_t m_index;
+    };
+
+    /** An iterator */
+    typedef Iterator<false> iterator;
+
+    /** A constant iterator */
+    typedef Iterator<true> const_iterator;
+
+    /**
+     * The default constructor
+     */
+    StableVector() : m_body(new Body()) { }
+
+    /**
+     * The move constructor
+     * @param vector The other vector (empty after moving)
+     */
+    StableVector(StableVector&& vector) : m_body(std::move(vector.m_body)) { vector.m_body.reset(new Body()); }
+
+    /**
+     * The move assignment operator
+     * @param rhs The other vector (empty after moving)
+     * @return This object
+     */
+    StableVector& operator=(StableVector&& rhs)
+    {
+        m_body.swap(rhs.m_body);
+        rhs.clear();
+        return *this;
+    }
+
+    /**
+     * Add an element at the end (time complexity: amortized O(1))
+     * @param value The element to add
+     */
+    void push_back(const T& value)
+    {
+        Body& body = *m_body;
+        if ((body.n_slots >> CHUNK_BITS) >= body.chunks.size())
+            body.chunks.push_back(std::unique_ptr<T[]>(new T[CHUNK_SIZE]));
+        body.at(body.n_slots) = value;
+        body.alive.push_back(1);
+        body.n_slots++;
+        body.n_alive++;
+    }
+
+    /**
+     * Get the last added element
+     * @return A reference to the last added element
+     */
+    T& back() { return m_body->at(m_body->n_slots - 1); }
+
+    /**
+     * Remove an element (time complexity: O(1))<br>
+     * The slot of the element is cleared and skipped by iterators.
+     * @param itr An iterator of the element to remove
+     * @return An iterator of the next element
+     */
+    iterator erase(const_iterator itr)
+    {
+        Body& body = *m_body;
+        size_t index = itr.getIndex();
+        if (index < body.n_slots && body.alive[index])
+        {
+            body.at(index) = T();
+            body.alive[index] = 0;
+            body.n_alive--;
+        }
+        return iterator(&body, body.next(index));
+    }
+
+    /**
+     * Remove all elements
+     */
+    void clear()
+    {
+        m_body->chunks.clear();
+        m_body->alive.clear();
+        m_body->n_slots = 0;
+        m_body->n_alive = 0;
+    }
+
+    /**
+     * Reserve memory for the given number of elements
+     * @param n The number of elements
+     */
+    void reserve(size_t n)
+    {
+        m_body->alive.reserve(n);
+        m_body->chunks.reserve((n + CHUNK_MASK) >> CHUNK_BITS);
+    }
+
+    /**
+     * Count the number of elements (time complexity: O(1))
+     * @return The number of elements
+     */
+    size_t size() const { return m_body->n_alive; }
+
+    /**
+     * Check whether this is empty or not
+     * @return True if empty (false if not empty)
+     */
+    bool empty() const { return (m_body->n_alive == 0); }
+
+    /** Get an iterator of the first element */
+    iterator begin() { return iterator(m_body.get(), m_body->first()); }
+
+    /** Get an iterator of the ending element */
+    iterator end() { return iterator(m_body.get(), m_body->n_slots); }
+
+    /** Get a constant iterator of the first element */
+    const_iterator begin() const { return const_iterator(m_body.get(), m_body->first()); }
+
+    /** Get a constant iterator of the ending element */
+    const_iterator end() const { return const_iterator(m_body.get(), m_body->n_slots); }
+
+    /** Get a constant iterator of the first element */
+    const_iterator cbegin() const { return begin(); }
+
+    /** Get a constant iterator of the ending element */
+    const_iterator cend() const { return end(); }
+
+protected:
+    /** The elements and their slots */
+    std::unique_ptr<Body> m_body;
+};
+
+/**
+ * @brief A storage policy of DirectedGraph using linked lists
+ *
+ * Nodes and edges are stored in std::list, so every node and edge is allocated separately.
+ * All pointers and iterators to nodes and edges are valid until they are removed.
+ */
+struct ListStorage
+{
+    /** A container for nodes */
+    template<typename T> struct NodeContainer { typedef std::list<T> type; };
+
+    /** A container for edges of each node */
+    template<typename T> struct EdgeContainer { typedef std::list<T> type; };
+
+    /** Reserve memory of a container (do nothing for std::list) */
+    template<typename Container> static void reserve(Container&, size_t) { }
+};
+
+/**
+ * @brief A storage policy of DirectedGraph using contiguous memory
+ *
+ * Nodes are stored in StableVector and edges of each node are stored in std::vector.
+ * Traversing nodes and edges reads contiguous memory, so it is much more cache-friendly than ListStorage.
+ * Pointers to nodes are valid until they are removed as like ListStorage.
+ * However, pointers and iterators to edges from a node are invalidated when an edge is added to or removed from the node.
+ */
+struct VectorStorage
+{
+    /** A container for nodes */
+    template<typename T> struct NodeContainer { typedef StableVector<T> type; };
+
+    /** A container for edges of each node */
+    template<typename T> struct EdgeContainer { typedef std::vector<T> type; };
+
+    /** Reserve memory of a container */
+    template<typename Container> static void reserve(Container& container, size_t n) { container.reserve(n); }
+};
+
+/**
+ * @brief A hash function of node data in DirectedGraph
+ *
+ * It uses std::hash as default. It should be specialized for node data which does not have std::hash,
+ * and its hash values should be consistent with 'operator==' of the node data.
+ */
+template<typename D>
+struct GraphHash
+{
+    /** Calculate a hash value of the given data */
+    size_t operator()(const D& data) const { return std::hash<D>()(data); }
+};
+
+template<typename D, typename C, typename S = ListStorage> class NodeType;
+template<typename D, typename C, typename S = ListStorage> class EdgeType;
+template<typename D, typename C, typename S = ListStorage> class DirectedGraph;
 
 /**
  * @brief Node for directed graphs
@@ -20,7 +350,7 @@ template<typename D, typename C> class DirectedGraph;
  * @see DirectedGraph A directed graph
  * @see EdgeType An edge in a graph
  */
-template<typename D, typename C>
+template<typename D, typename C, typename S>
 class NodeType
 {
 public:
@@ -40,23 +370,26 @@ public:
      * @param rhs A node in the right-hand side
      * @return True if both data are equal (false if not equal)
      */
-    bool operator==(const NodeType<D, C>& rhs) const { return (data == rhs.data); }
+    bool operator==(const NodeType<D, C, S>& rhs) const { return (data == rhs.data); }
 
     /**
      * Check inequality with the other node
      * @param rhs A node in the right-hand side
      * @return True if both data are not equal (false if equal)
      */
-    bool operator!=(const NodeType<D, C>& rhs) const { return (data != rhs.data); }
+    bool operator!=(const NodeType<D, C, S>& rhs) const { return (data != rhs.data); }
 
     /** Data in this node */
     D data;
 
-    friend class DirectedGraph<D, C>;
+    friend class DirectedGraph<D, C, S>;
 
 protected:
     /** A list for edges that start from this node */
-    std::list<EdgeType<D, C> > m_edge_list;
+    typename S::template EdgeContainer<EdgeType<D, C, S> >::type m_edge_list;
+
+    /** A list for start nodes of edges that come to this node (one for each edge) */
+    std::vector<NodeType<D, C, S>*> m_in_list;
 };
 
 /**
@@ -69,7 +402,7 @@ protected:
  * @see DirectedGraph A directed graph
  * @see NodeType A node in a graph
  */
-template<typename D, typename C>
+template<typename D, typename C, typename S>
 class EdgeType
 {
 public:
@@ -83,10 +416,10 @@ public:
      * @param to A pointer to the destination node
      * @param cost Cost to the destination node
      */
-    EdgeType(NodeType<D, C>* to, const C& cost) { this->to = to; this->cost = cost; }
+    EdgeType(NodeType<D, C, S>* to, const C& cost) { this->to = to; this->cost = cost; }
 
     /** A pointer to the destination node */
-    NodeType<D, C>* to;
+    NodeType<D, C, S>* to;
 
     /** Cost to the destination node */
     C cost;
@@ -100,42 +433,58 @@ public:
  * It would be better to use a matrix to implement a dense graph.
  * Its edge is directed so that its connection is represented by the start node and destination node.
  * However, it can describe an undirected graph if every edge has its dual edge which connects from the destination node to the start node.
+ * Its memory layout is selected by the storage policy, S, as ListStorage (default) or VectorStorage.
  *
  * @see Directed Graph (Wikipedia), http://en.wikipedia.org/wiki/Directed_graph
  */
-template<typename D, typename C>
+template<typename D, typename C, typename S>
 class DirectedGraph
 {
 public:
     /**
      * A node definition
      */
-    typedef NodeType<D, C> Node;
+    typedef NodeType<D, C, S> Node;
 
     /**
      * An edge definition
      */
-    typedef EdgeType<D, C> Edge;
+    typedef EdgeType<D, C, S> Edge;
+
+    /**
+     * A container definition for nodes
+     */
+    typedef typename S::template NodeContainer<Node>::type NodeList;
+
+    /**
+     * A container definition for edges
+     */
+    typedef typename S::template EdgeContainer<Edge>::type EdgeList;
 
     /**
      * A node iterator
      */
-    typedef typename std::list< NodeType<D, C> >::iterator NodeItr;
+    typedef typename NodeList::iterator NodeItr;
 
     /**
      * An edge iterator
      */
-    typedef typename std::list< EdgeType<D, C> >::iterator EdgeItr;
+    typedef typename EdgeList::iterator EdgeItr;
 
     /**
      * A constant node iterator
      */
-    typedef typename std::list< NodeType<D, C> >::const_iterator NodeItrConst;
+    typedef typename NodeList::const_iterator NodeItrConst;
 
     /**
      * A constant edge iterator
      */
-    typedef typename std::list< EdgeType<D, C> >::const_iterator EdgeItrConst;
+    typedef typename EdgeList::const_iterator EdgeItrConst;
+
+    /**
+     * A constant iterator of start nodes of incoming edges
+     */
+    typedef typename std::vector<Node*>::const_iterator InNodeItrConst;
 
     /**
      * The default constructor
@@ -145,7 +494,17 @@ public:
     /**
      * The copy constructor
      */
-    DirectedGraph(const DirectedGraph<D, C>& graph) { graph.copyTo(this); }
+    DirectedGraph(const DirectedGraph<D, C, S>& graph) { graph.copyTo(this); }
+
+    /**
+     * The move constructor (time complexity: O(1))<br>
+     * Pointers and iterators to nodes and edges of the other graph are still valid in this graph.
+     * @param graph The other graph (empty after moving)
+     */
+    DirectedGraph(DirectedGraph<D, C, S>&& graph) : m_node_list(std::move(graph.m_node_list)), m_node_index(std::move(graph.m_node_index))
+    {
+        graph.removeAll();
+    }
 
     /**
      * The destructor
@@ -157,7 +516,23 @@ public:
      * @param data Data to add
      * @return A pointer to the added node
      */
-    Node* addNode(const D& data) { m_node_list.push_back(data); return &(m_node_list.back()); }
+    Node* addNode(const D& data)
+    {
+        m_node_list.push_back(data);
+        NodeItr node_itr = std::prev(m_node_list.end());
+        m_node_index.insert(std::make_pair(data, node_itr));
+        return &(*node_itr);
+    }
+
+    /**
+     * Reserve memory for the given number of nodes (time complexity: O(N))
+     * @param n The number of nodes to reserve
+     */
+    void reserveNodes(size_t n)
+    {
+        S::reserve(m_node_list, n);
+        m_node_index.reserve(n);
+    }
 
     /**
      * Add an edge (time complexity: O(1))
@@ -184,30 +559,25 @@ public:
     {
         if ((from == nullptr) || (to == nullptr)) return nullptr;
         from->m_edge_list.push_back(Edge(to, cost));
+        to->m_in_list.push_back(from);
         return &(from->m_edge_list.back());
     }
 
     /**
-     * Find a node using its data (time complexity: O(|N|))
+     * Find a node using its data (time complexity: O(1))<br>
+     * If multiple nodes have the same data, one of them is returned.
      * @param data Data to search
      * @return A pointer to the found node (nullptr if not exist)
      */
     Node* getNode(const D& data)
     {
-        Node* node = nullptr;
-        for (NodeItr node_itr = getHeadNode(); node_itr != getTailNode(); node_itr++)
-        {
-            if (node_itr->data == data)
-            {
-                node = &(*node_itr);
-                break;
-            }
-        }
-        return node;
+        auto found = m_node_index.find(data);
+        if (found == m_node_index.end()) return nullptr;
+        return &(*found->second);
     }
 
     /**
-     * Find an edge using its connecting node data (time complexity: O(|N| + |E|))
+     * Find an edge using its connecting node data (time complexity: O(|E|))
      * @param from Data of the start node
      * @param to Data of the destination node
      * @return A pointer to the found edge (nullptr if not exist)
@@ -250,7 +620,7 @@ public:
     }
 
     /**
-     * Retrieve edge cost from its start node to its destination node (time complexity: O(|N| + |E|))
+     * Retrieve edge cost from its start node to its destination node (time complexity: O(|E|))
      * @param from Data of the start node
      * @param to Data of the destination node
      * @return Cost of the found edge
@@ -313,20 +683,36 @@ public:
     bool isConnected(NodeItrConst from, NodeItrConst to) const { return (getEdgeCost(from, to) >= 0); }
 
     /**
-     * Copy this to the other graph (time complexity: O(|N|^2|E|))
+     * Copy this to the other graph (time complexity: O(|N| + |E|))
      * @param dest A pointer to the other graph
      * @return True if successful (false if failed)
      */
-    bool copyTo(DirectedGraph<D, C>* dest) const
+    bool copyTo(DirectedGraph<D, C, S>* dest) const
     {
         if (dest == nullptr) return false;
+        if (dest == this) return true;
 
+        // Copy nodes with a table from their pointers to the copied nodes
         dest->removeAll();
+        S::reserve(dest->m_node_list, countNodes());
+        dest->m_node_index.reserve(countNodes());
+        std::unordered_map<const Node*, Node*> node_table;
+        node_table.reserve(countNodes());
         for (NodeItrConst node = getHeadNodeConst(); node != getTailNodeConst(); node++)
-            dest->addNode(node->data);
+        {
+            Node* copy = dest->addNode(node->data);
+            S::reserve(copy->m_edge_list, node->m_edge_list.size());
+            copy->m_in_list.reserve(node->m_in_list.size());
+            node_table.insert(std::make_pair(&(*node), copy));
+        }
+
+        // Copy edges with the table
         for (NodeItrConst from = getHeadNodeConst(); from != getTailNodeConst(); from++)
+        {
+            Node* from_copy = node_table[&(*from)];
             for (EdgeItrConst edge = getHeadEdgeConst(from); edge != getTailEdgeConst(from); edge++)
-                dest->addEdge(dest->getNode(from->data), dest->getNode(edge->to->data), edge->cost);
+                dest->addEdge(from_copy, node_table[edge->to], edge->cost);
+        }
         return true;
     }
 
@@ -335,50 +721,72 @@ public:
      * @param rhs A directed graph in the right-hand side
      * @return This object
      */
-    DirectedGraph<D, C>& operator=(const DirectedGraph<D, C>& rhs)
+    DirectedGraph<D, C, S>& operator=(const DirectedGraph<D, C, S>& rhs)
     {
         rhs.copyTo(this);
         return *this;
     }
 
     /**
-     * Remove a node (time complexity: O(|V| |E|))<br>
-     * This removes all edges connected from the node
+     * Overriding the move assignment operator (time complexity: O(|N|) to release nodes of this graph)
+     * @param rhs A directed graph in the right-hand side (empty after moving)
+     * @return This object
+     */
+    DirectedGraph<D, C, S>& operator=(DirectedGraph<D, C, S>&& rhs)
+    {
+        if (&rhs == this) return *this;
+        m_node_list = std::move(rhs.m_node_list);
+        m_node_index = std::move(rhs.m_node_index);
+        rhs.removeAll();
+        return *this;
+    }
+
+    /**
+     * Remove a node (time complexity: O(|E|) for edges of the node and its neighbors)<br>
+     * This removes all edges connected from and to the node
      * @param node A node pointer to remove
      * @return True if successful (false if failed)
      */
     bool removeNode(Node* node)
     {
         if (node == nullptr) return false;
-        NodeItr is_found = getTailNode();
-        for (NodeItr node_itr = getHeadNode(); node_itr != getTailNode(); node_itr++)
+
+        // Find the node in the index
+        auto range = m_node_index.equal_range(node->data);
+        auto found = range.first;
+        for (; found != range.second; found++)
+            if (&(*found->second) == node) break;
+        if (found == range.second) return false;
+
+        // Remove edges which come to the node
+        for (auto from = node->m_in_list.begin(); from != node->m_in_list.end(); from++)
         {
-            removeEdge(&(*node_itr), node);
-            if (node_itr->data == node->data) is_found = node_itr;
+            if (*from == node) continue;
+            EdgeItr edge_itr = getHeadEdge(*from);
+            while (edge_itr != getTailEdge(*from))
+            {
+                if (edge_itr->to == node) edge_itr = (*from)->m_edge_list.erase(edge_itr);
+                else edge_itr++;
+            }
         }
-        if (is_found == m_node_list.end()) return false;
-        m_node_list.erase(is_found);
+
+        // Remove edges which start from the node
+        for (EdgeItr edge_itr = getHeadEdge(node); edge_itr != getTailEdge(node); edge_itr++)
+            if (edge_itr->to != node) removeInNode(edge_itr->to, node);
+
+        NodeItr node_itr = found->second;
+        m_node_index.erase(found);
+        m_node_list.erase(node_itr);
         return true;
     }
 
     /**
-     * Remove a node (time complexity: O(|V| |E|))<br>
-     * This removes all edges connected from the node
+     * Remove a node (time complexity: O(|E|) for edges of the node and its neighbors)<br>
+     * This removes all edges connected from and to the node
      * @param node A node iterator of remove
      * @return True if successful (false if failed)
      */
-    bool removeNode(NodeItr node)
-    {
-        NodeItr is_found = getTailNode();
-        for (NodeItr node_itr = getHeadNode(); node_itr != getTailNode(); node_itr++)
-        {
-            removeEdge(node_itr, node);
-            if (node_itr->data == node->data) is_found = node_itr;
-        }
-        if (is_found == m_node_list.end()) return false;
-        m_node_list.erase(is_found);
-        return true;
-    }
+    bool removeNode(NodeItr node) { return removeNode(&(*node)); }
 
     /**
      * Remove an edge (time complexity: O(|E|))
@@ -395,6 +803,7 @@ public:
         {
             if (edge_itr->to->data == to->data)
             {
+                removeInNode(edge_itr->to, &(*from));
                 edge_itr = from->m_edge_list.erase(edge_itr);
                 is_found = true;
                 continue;
@@ -418,6 +827,7 @@ public:
         {
             if (edge_itr->to->data == to->data)
             {
+                removeInNode(edge_itr->to, &(*from));
                 edge_itr = from->m_edge_list.erase(edge_itr);
                 is_found = true;
                 continue;
@@ -431,7 +841,12 @@ public:
      * Remove all nodes and edges
      * @return True if successful (false if failed)
      */
-    bool removeAll() { m_node_list.clear(); return true; }
+    bool removeAll()
+    {
+        m_node_index.clear();
+        m_node_list.clear();
+        return true;
+    }
 
     /**
      * Count the number of all nodes (time complexity: O(1))
@@ -469,6 +884,17 @@ public:
      */
     size_t countEdges(NodeItrConst node) const { return node->m_edge_list.size(); }
 
+    /**
+     * Count the number of edges coming to the given node (time complexity: O(1))
+     * @param node A pointer to the node
+     * @return The number of incoming edges
+     */
+    size_t countInEdges(const Node* node) const
+    {
+        if (node == nullptr) return 0;
+        return node->m_in_list.size();
+    }
+
     /**
      * Get an iterator of the first node in this graph (time complexity: O(1))
      * @return An iterator of the first node
@@ -516,16 +942,16 @@ public:
     EdgeItr getTailEdge(NodeItr node) { return node->m_edge_list.end(); }
 
     /**
-     * Find a node using its data (time complexity: O(|N|))
+     * Find a node using its data (time complexity: O(1))<br>
+     * If multiple nodes have the same data, one of them is returned.
      * @param data Data to search
      * @return A const_iterator of the found node (getTailNodeConst() if not exist)
      */
     NodeItrConst getNodeConst(const D& data) const
     {
-        NodeItrConst node_itr = getHeadNodeConst();
-        for (; node_itr != getTailNodeConst(); node_itr++)
-            if (node_itr->data == data) break;
-        return node_itr;
+        auto found = m_node_index.find(data);
+        if (found == m_node_index.end()) return getTailNodeConst();
+        return found->second;
     }
 
     /**
@@ -588,9 +1014,47 @@ public:
      */
     EdgeItrConst getTailEdgeConst(NodeItrConst node) const { return node->m_edge_list.cend(); }
 
+    /**
+     * Get a const_iterator of the first start node of edges coming to the given node (time complexity: O(1))<br>
+     * A start node appears as many times as the number of its edges to the given node.
+     * @param node A constant pointer to a node
+     * @return A const_iterator of the first start node
+     * @see getTailInNodeConst
+     */
+    InNodeItrConst getHeadInNodeConst(const Node* node) const { return node->m_in_list.cbegin(); }
+
+    /**
+     * Get a const_iterator of the ending start node of edges coming to the given node (time complexity: O(1))
+     * @param node A constant pointer to a node
+     * @return A const_iterator of the ending start node
+     * @see getHeadInNodeConst
+     */
+    InNodeItrConst getTailInNodeConst(const Node* node) const { return node->m_in_list.cend(); }
+
 protected:
+    /**
+     * Remove an incoming edge from the reverse adjacency of the given node (time complexity: O(|E|) of the node)
+     * @param node A pointer to the destination node
+     * @param from A pointer to the start node of the removed edge
+     */
+    static void removeInNode(Node* node, Node* from)
+    {
+        for (auto in = node->m_in_list.begin(); in != node->m_in_list.end(); in++)
+        {
+            if (*in == from)
+            {
+                *in = node->m_in_list.back();
+                node->m_in_list.pop_back();
+                break;
+            }
+        }
+    }
+
     /** A list for all edges in this graph */
-    std::list<Node> m_node_list;
+    NodeList m_node_list;
+
+    /** A hash index from node data to the corresponding node */
+    std::unordered_multimap<D, NodeItr, GraphHash<D> > m_node_index;
 
 }; // End of 'DirectedGraph'
 
@@ -23,13 +23,13 @@ public:
     Point2 offset;
 };
 
-template<typename D, typename C>
+template<typename D, typename C, typename S = ListStorage>
 class GraphPainter : public cx::Algorithm
 {
 public:
-    typedef DirectedGraph<D, C> Point2IDGraph;
+    typedef DirectedGraph<D, C, S> Point2IDGraph;
 
-    typedef NodeType<D, C> Point2IDNode;
+    typedef NodeType<D, C, S> Point2IDNode;
 
     GraphPainter()
     {
@@ -2,27 +2,188 @@
 #define __BASE_LOCALIZER__
 
 #include "core/map.hpp"
+#include "core/frozen_map.hpp"
+#include "core/spatial_index.hpp"
 #include "localizer/localizer.hpp"
+#include "localizer/road_tile_map.hpp"
+#include "localizer/segment_kernel.hpp"
 #include "utils/opencx.hpp"
 #include <set>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <chrono>
 
 namespace dg
 {
 
+/**
+ * @brief A spatial index over line segments of edges in RoadMap
+ *
+ * A <b>road edge index</b> keeps line segments of all edges as SegmentArray and their spatial index.
+ * Segments are stored in the order of nodes and their edges, so edges from a node are contiguous and a segment is referred by its node ID and edge index.
+ * It should be built again when the map is changed.
+ */
+struct RoadEdgeIndex
+{
+    /**
+     * Build the index of the given map (time complexity: O(|V| + |E|))
+     * @param map The given map
+     * @return True if successful (false if no edge exists)
+     */
+    bool build(const RoadMap& map)
+    {
+        clear();
+        std::vector<Point2> pt1s, pt2s;
+        firsts.reserve(map.countNodes());
+        for (auto from = map.getHeadNodeConst(); from != map.getTailNodeConst(); from++)
+        {
+            if (map.countEdges(from) == 0) continue;
+            firsts.insert(from->data.id, refs.size());
+            int edge_idx = 0;
+            for (auto edge = map.getHeadEdgeConst(from); edge != map.getTailEdgeConst(from); edge++, edge_idx++)
+            {
+                pt1s.push_back(from->data);
+                pt2s.push_back(edge->to->data);
+                segments.push_back(from->data, edge->to->data);
+                refs.push_back(std::make_pair(from->data.id, edge_idx));
+            }
+        }
+        if (pt1s.empty()) return false;
+        return grid.build(pt1s, pt2s);
+    }
+
+    /**
+     * Remove all data
+     */
+    void clear()
+    {
+        grid.clear();
+        segments.clear();
+        refs.clear();
+        firsts.clear();
+    }
+
+    /**
+     * Find the first segment of edges from the given node (time complexity: O(1))
+     * @param node_id ID of the given node
+     * @return Index of the first segment (LookupTable::npos if the node has no edge)
+     */
+    size_t findFirst(ID node_id) const { return firsts.find(node_id); }
+
+    /** A spatial index of the segments */
+    SpatialIndex grid;
+
+    /** The segments as a structure of arrays */
+    SegmentArray segments;
+
+    /** The start node ID and edge index of each segment */
+    std::vector<std::pair<ID, int> > refs;
+
+    /** Index of the first segment of each node */
+    LookupTable firsts;
+};
+
+/**
+ * @brief A snapshot of the localization result
+ *
+ * A <b>pose snapshot</b> is published by a localizer after each update, so readers (e.g. GUI and guidance threads)
+ * can copy a consistent result without waiting for sensor updates.
+ */
+struct PoseSnapshot
+{
+    /**
+     * The default constructor
+     */
+    PoseSnapshot() : pose_cov(cv::Matx33d::zeros()), confidence(0), time(-1), seq(0) { }
+
+    /** The metric pose (Unit: [m] and [rad]) */
+    Pose2 pose;
+
+    /** The linear and angular velocity (Unit: [m/s] and [rad/s]) */
+    Polar2 velocity;
+
+    /** The covariance of the metric pose (zero if not estimated) */
+    cv::Matx33d pose_cov;
+
+    /** The confidence of the pose */
+    double confidence;
+
+    /** The topometric pose */
+    TopometricPose topo;
+
+    /** The time of the last update (Unit: [sec]; negative if unknown) */
+    Timestamp time;
+
+    /** The sequence number which increases whenever a snapshot is published */
+    uint64_t seq;
+};
+
 class BaseLocalizer : public Localizer, public TopometricLocalizer, public UTMConverter
 {
 public:
-    virtual bool loadMap(Map& map, bool auto_cost = false)
+    BaseLocalizer() : m_tile_zoom(17), m_tile_loader_seq(0), m_snapshot_seq(0) { }
+
+    /**
+     * Get the latest pose snapshot without blocking sensor updates (time complexity: O(1))<br>
+     * The snapshot is copied under a sequence lock, so a reader never locks the localizer and only retries while a new snapshot is being written.
+     * @return A copy of the latest pose snapshot
+     */
+    PoseSnapshot getPoseSnapshot() const
     {
+        PoseSnapshot snapshot;
+        while (true)
+        {
+            uint64_t begin = m_snapshot_seq.load(std::memory_order_acquire);
+            if (begin & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            snapshot = m_snapshot;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_snapshot_seq.load(std::memory_order_relaxed) == begin) return snapshot;
+        }
+    }
+
+    virtual bool loadMap(const Map& map, bool auto_cost = false)
+    {
+        // Convert the map without blocking other threads which use the current map
+        RoadMap road_map = cvtMap2RoadMap(map, *this, auto_cost);
+        RoadEdgeIndex edge_index;
+        edge_index.build(road_map);
         cv::AutoLock lock(m_mutex);
-        m_map = cvtMap2RoadMap(map, *this, auto_cost);
+        applyRoadState(road_map);
+        m_map = std::move(road_map);
+        m_edge_index = std::move(edge_index);
+        publishPose();
         return true;
     }
 
     virtual bool loadMap(const RoadMap& map)
     {
+        RoadEdgeIndex edge_index;
+        edge_index.build(map);
+        cv::AutoLock lock(m_mutex);
+        RoadMap road_map;
+        if (!map.copyTo(&road_map)) return false;
+        applyRoadState(road_map);
+        m_map = std::move(road_map);
+        m_edge_index = std::move(edge_index);
+        publishPose();
+        return true;
+    }
+
+    virtual bool loadMap(RoadMap&& map)
+    {
+        RoadEdgeIndex edge_index;
+        edge_index.build(map);
         cv::AutoLock lock(m_mutex);
-        return map.copyTo(&m_map);
+        applyRoadState(map);
+        m_map = std::move(map);
+        m_edge_index = std::move(edge_index);
+        publishPose();
+        return true;
     }
 
     virtual RoadMap getMap() const
@@ -31,6 +192,164 @@ public:
         return m_map;
     }
 
+    /**
+     * Select the query profile of the road map (e.g. RoadProfile::wheelchair())<br>
+     * Tracking does not move onto edges which are impassable with the profile. The profile is kept when another map is loaded.
+     * @param profile The query profile
+     * @return True if successful (false if failed)
+     * @see RoadMap::setProfile
+     */
+    bool setRoadProfile(const RoadProfile& profile)
+    {
+        cv::AutoLock lock(m_mutex);
+        return m_map.setProfile(profile);
+    }
+
+    /**
+     * Block or unblock an edge of the road map (e.g. construction)
+     * @param from ID of the start node
+     * @param to ID of the destination node
+     * @param blocked True to block the edge (false to unblock)
+     * @return True if successful (false if the edge does not exist)<br>
+     *  The flag is always kept and applied to maps and tiles loaded later, so it is successful if tiles are enabled.
+     * @see RoadMap::setBlocked
+     */
+    bool setRoadBlocked(ID from, ID to, bool blocked = true)
+    {
+        cv::AutoLock tile_lock(m_tile_mutex);
+        cv::AutoLock lock(m_mutex);
+        m_road_blocked[std::make_pair(from, to)] = blocked;
+        bool ok = m_map.setBlocked(from, to, blocked);
+        return ok || m_tiles.isEnabled();
+    }
+
+    /**
+     * Hold the road map as tiles around the current pose, which are loaded on demand using the given loader of dg::Map tiles<br>
+     * The current map is replaced with the stitched tiles whenever updateMapTiles() or requestMapTiles() moves to another tile, so call one of them after pose updates.
+     * The loader is called without locking this localizer (on a worker thread for requestMapTiles()), so it should not change data shared with other threads.
+     * @param loader The loader of dg::Map tiles (e.g. dg::MapManager::loadMapTile; an empty function to disable tiles)
+     * @param zoom The zoom level of tiles (the same level with the map server)
+     * @param radius The radius of the tile window (e.g. 1 for 3 x 3 tiles)
+     * @param auto_cost A flag to calculate edge lengths from node positions
+     * @return True if successful (false if failed)
+     */
+    bool setMapTileLoader(const std::function<bool(const cv::Point2i&, Map&)>& loader, int zoom = 17, int radius = 1, bool auto_cost = false)
+    {
+        if (!loader) return setRoadTileLoader(RoadTileMap::Loader(), zoom, radius);
+        return setRoadTileLoader([this, loader, auto_cost](const cv::Point2i& tile, RoadTile& data)
+        {
+            Map map;
+            if (!loader(tile, map)) return false;
+            return cvtMap2RoadTile(map, *this, data, auto_cost);
+        }, zoom, radius);
+    }
+
+    /**
+     * Hold the road map as tiles around the current pose, which are loaded on demand using the given loader of RoadTile
+     * @param loader The loader of RoadTile (an empty function to disable tiles)
+     * @param zoom The zoom level of tiles
+     * @param radius The radius of the tile window (e.g. 1 for 3 x 3 tiles)
+     * @return True if successful (false if failed)
+     * @see setMapTileLoader
+     */
+    bool setRoadTileLoader(const RoadTileMap::Loader& loader, int zoom = 17, int radius = 1)
+    {
+        if (zoom < 0 || zoom > 30) return false;
+        std::future<RoadTileMap::Tiles> request;
+        bool ok;
+        {
+            cv::AutoLock tile_lock(m_tile_mutex);
+            request = std::move(m_tile_request); // Tiles from the previous loader are discarded
+            m_tile_loader_seq++;
+            m_tile_zoom = zoom;
+            ok = m_tiles.setLoader(loader, radius);
+        }
+        if (request.valid()) request.wait(); // Wait for the previous loader without holding the lock
+        return ok;
+    }
+
+    /**
+     * Move the tile window to the given point, which loads new tiles, evicts far tiles, and replaces the current map<br>
+     * New tiles are loaded on the calling thread without any lock, so other threads (e.g. setRoadBlocked()) are not blocked by the loader.
+     * Only stitching the tiles and swapping the current map are done under the lock.
+     * @param center The given point in the metric coordinate
+     * @return True if the map is replaced (false if not changed or failed)
+     * @see requestMapTiles
+     */
+    bool updateMapTiles(const Point2& center)
+    {
+        cv::Point2i tile;
+        std::vector<cv::Point2i> missing;
+        RoadTileMap::Loader loader;
+        uint64_t loader_seq;
+        {
+            cv::AutoLock tile_lock(m_tile_mutex);
+            tile = getMapTile(center);
+            if (!m_tiles.getMissingTiles(tile, missing)) return false;
+            loader = m_tiles.getLoader();
+            loader_seq = m_tile_loader_seq;
+        }
+        RoadTileMap::Tiles loaded = RoadTileMap::loadTiles(loader, missing);
+
+        cv::AutoLock tile_lock(m_tile_mutex);
+        if (loader_seq != m_tile_loader_seq) return false; // The loader is replaced during loading
+        return applyMapTiles(tile, loaded);
+    }
+
+    /**
+     * Move the tile window to the current pose
+     * @return True if the map is replaced (false if not changed or failed)
+     * @see updateMapTiles(const Point2&)
+     */
+    bool updateMapTiles() { return updateMapTiles(getPose()); }
+
+    /**
+     * Move the tile window to the given point without waiting for the loader (e.g. in a sensor callback)<br>
+     * New tiles are loaded on a worker thread, and the current map is replaced by a following call after they are loaded.
+     * While the worker is loading, other requests are ignored and the tile window is moved by the next request after it.
+     * @param center The given point in the metric coordinate
+     * @return True if the map is replaced (false if not changed, still loading, or failed)
+     * @see updateMapTiles
+     */
+    bool requestMapTiles(const Point2& center)
+    {
+        cv::AutoLock tile_lock(m_tile_mutex);
+        bool replaced = false;
+        if (m_tile_request.valid())
+        {
+            if (m_tile_request.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+            RoadTileMap::Tiles loaded = m_tile_request.get();
+            replaced = applyMapTiles(m_tile_request_center, loaded);
+        }
+
+        cv::Point2i tile = getMapTile(center);
+        std::vector<cv::Point2i> missing;
+        if (!m_tiles.getMissingTiles(tile, missing)) return replaced;
+        if (missing.empty())
+        {
+            RoadTileMap::Tiles loaded;
+            return applyMapTiles(tile, loaded) || replaced;
+        }
+        RoadTileMap::Loader loader = m_tiles.getLoader();
+        m_tile_request = std::async(std::launch::async, [loader, missing]() { return RoadTileMap::loadTiles(loader, missing); });
+        m_tile_request_center = tile;
+        return replaced;
+    }
+
+    /**
+     * Move the tile window to the current pose without waiting for the loader
+     * @return True if the map is replaced (false if not changed, still loading, or failed)
+     * @see requestMapTiles(const Point2&)
+     */
+    bool requestMapTiles() { return requestMapTiles(getPose()); }
+
+    /**
+     * Get the tile index of the given point
+     * @param p The given point in the metric coordinate
+     * @return The tile index
+     */
+    cv::Point2i getMapTile(const Point2& p) const { return RoadTileMap::cvtLatLon2Tile(toLatLon(p), m_tile_zoom); }
+
     Pose2 cvtTopmetric2Metric(const TopometricPose& pose_t)
     {
         cv::AutoLock lock(m_mutex);
@@ -61,37 +380,53 @@ public:
 
     }
 
+    /**
+     * Find the nearest topometric pose on edges of the road map<br>
+     * Edges are searched using a spatial index of their line segments, which is built when the map is loaded.
+     * Segments in each cell of the index are scored at once by SegmentKernel.
+     * (time complexity: O(1) on average for uniformly distributed edges)
+     * @param pose_m The given metric pose
+     * @param turn_weight The weight of heading difference against an edge (0 to ignore heading)
+     * @param search_range The radius to search start nodes of edges around 'search_pt' (Unit: [m]; non-positive if not limited)
+     * @param search_pt The center of the search range
+     * @return The nearest topometric pose (its node ID is 0 if not found)
+     */
     TopometricPose findNearestTopoPose(const Pose2& pose_m, double turn_weight = 0, double search_range = -1, const Pose2& search_pt = Pose2())
     {
         cv::AutoLock lock(m_mutex);
 
         // Find the nearest edge
-        std::pair<double, Point2> min_dist2 = std::make_pair(DBL_MAX, Point2());
-        ID min_node_id = 0;
-        int min_edge_idx = 0;
         const double range2 = search_range * search_range;
-        for (auto from = m_map.getHeadNodeConst(); from != m_map.getTailNodeConst(); from++)
+        double max_dist = -1;
+        if (search_range > 0)
+        {
+            // The nearest point on an edge is not farther than its start node
+            double dx = pose_m.x - search_pt.x, dy = pose_m.y - search_pt.y;
+            max_dist = sqrt(dx * dx + dy * dy) + search_range;
+        }
+        const SegmentArray& segs = m_edge_index.segments;
+        auto dist2_batch = [&](const uint32_t* items, size_t n, double* dist2)
         {
-            if (m_map.countEdges(from) == 0) continue;
+            // Score all segments in a cell at once
+            SegmentKernel::calcDist2Indexed(segs, items, n, pose_m, turn_weight, dist2);
             if (search_range > 0)
             {
-                double dx = pose_m.x - search_pt.x, dy = pose_m.y - search_pt.y;
-                if ((dx * dx + dy * dy) > range2) continue;
-            }
-
-            int edge_idx = 0;
-            for (auto edge = m_map.getHeadEdgeConst(from); edge != m_map.getTailEdgeConst(from); edge++, edge_idx++)
-            {
-                const RoadMap::Node* to = edge->to;
-                if (to == nullptr) continue;
-                auto dist2 = calcDist2FromLineSeg(from->data, to->data, pose_m, turn_weight);
-                if (dist2.first < min_dist2.first)
+                for (size_t i = 0; i < n; i++)
                 {
-                    min_dist2 = dist2;
-                    min_node_id = from->data.id;
-                    min_edge_idx = edge_idx;
+                    double dx = segs.x[items[i]] - search_pt.x, dy = segs.y[items[i]] - search_pt.y;
+                    if ((dx * dx + dy * dy) > range2) dist2[i] = -1;
                 }
             }
+        };
+        size_t found = 0;
+        std::pair<double, Point2> min_dist2 = std::make_pair(DBL_MAX, Point2());
+        ID min_node_id = 0;
+        int min_edge_idx = 0;
+        if (m_edge_index.grid.queryNearestBatch(pose_m, dist2_batch, found, nullptr, max_dist))
+        {
+            min_dist2 = calcDist2FromLineSeg(m_edge_index.grid.getPoint(found), m_edge_index.grid.getEndPoint(found), pose_m, turn_weight);
+            min_node_id = m_edge_index.refs[found].first;
+            min_edge_idx = m_edge_index.refs[found].second;
         }
 
         // Return the nearest topometric pose
@@ -131,6 +466,7 @@ public:
         // Check 'pose_m' on the connected edges
         std::set<ID> node_visit;
         std::queue<RoadMap::Node*> node_queue;
+        std::vector<double> dist2s;
         node_queue.push(node_goal);
         for (int depth = 0; depth < extend_depth; depth++)
         {
@@ -138,15 +474,26 @@ public:
             RoadMap::Node* node_pick = node_queue.front();
             node_queue.pop();
             node_visit.insert(node_pick->data.id);
+
+            // Score all edges from the node at once
+            size_t n_edges = m_map.countEdges(node_pick);
+            size_t first = m_edge_index.findFirst(node_pick->data.id);
+            bool indexed = (first != LookupTable::npos && first + n_edges <= m_edge_index.refs.size());
+            if (indexed)
+            {
+                dist2s.resize(n_edges);
+                SegmentKernel::calcDist2(m_edge_index.segments, first, first + n_edges, pose_m, turn_weight, dist2s.data());
+            }
+
             int edge_idx = 0;
             for (auto edge = m_map.getHeadEdgeConst(node_pick); edge != m_map.getTailEdgeConst(node_pick); edge++, edge_idx++)
             {
                 RoadMap::Node* to = edge->to;
-                if (to == nullptr) continue;
-                auto dist2 = calcDist2FromLineSeg(node_pick->data, to->data, pose_m, turn_weight);
-                if (dist2.first < min_dist2.first)
+                if (to == nullptr || !m_map.isPassable(*edge)) continue;
+                double dist2 = indexed ? dist2s[edge_idx] : calcDist2FromLineSeg(node_pick->data, to->data, pose_m, turn_weight).first;
+                if (dist2 < min_dist2.first)
                 {
-                    min_dist2 = dist2;
+                    min_dist2 = calcDist2FromLineSeg(node_pick->data, to->data, pose_m, turn_weight);
                     min_node_id = node_goal->data.id;
                     min_edge_idx = edge_idx;
                 }
@@ -169,15 +516,19 @@ public:
         return pose_t;
     }
 
-    static RoadMap cvtMap2RoadMap(Map& map, const UTMConverter& converter, bool auto_cost = true)
+    static RoadMap cvtMap2RoadMap(const Map& map, const UTMConverter& converter, bool auto_cost = true)
     {
         RoadMap road_map;
+        FrozenMap frozen;
+        if (!frozen.build(map)) return road_map;
 
         // Copy nodes
-        for (auto node = map.nodes.begin(); node != map.nodes.end(); node++)
+        std::vector<RoadMap::Node*> road_nodes(frozen.countNodes());
+        for (size_t i = 0; i < frozen.countNodes(); i++)
         {
-            Point2ID road_node(node->id, converter.toMetric(*node));
-            if (road_map.addNode(road_node) == nullptr)
+            Point2ID road_node(frozen.node_ids[i], converter.toMetric(LatLon(frozen.node_lats[i], frozen.node_lons[i])));
+            road_nodes[i] = road_map.addNode(road_node);
+            if (road_nodes[i] == nullptr)
             {
                 // Return an empty map if failed
                 road_map.removeAll();
@@ -186,41 +537,17 @@ public:
         }
 
         // Copy edges
-        if (auto_cost)
+        for (size_t from = 0; from < frozen.countNodes(); from++)
         {
-            for (auto from = map.nodes.begin(); from != map.nodes.end(); from++)
+            for (uint32_t i = frozen.adj_offsets[from]; i < frozen.adj_offsets[from + 1]; i++)
             {
-                for (auto edge_id = from->edge_ids.begin(); edge_id != from->edge_ids.end(); edge_id++)
+                uint32_t e = frozen.adj_edges[i];
+                RoadCost cost(auto_cost ? -1 : frozen.edge_lengths[e], frozen.edge_types[e]);
+                if (road_map.addEdge(road_nodes[from], road_nodes[frozen.adj_nodes[i]], cost) == nullptr)
                 {
-                    const Edge* edge = map.findEdge(*edge_id);
-                    if (edge == nullptr) continue;
-                    ID to_id = edge->node_id2;
-                    if (from->id == to_id) to_id = edge->node_id1;
-                    if (road_map.addEdge(from->id, to_id, -1) == nullptr)
-                    {
-                        // Return an empty map if failed
-                        road_map.removeAll();
-                        return road_map;
-                    }
-                }
-            }
-        }
-        else
-        {
-            for (auto from = map.nodes.begin(); from != map.nodes.end(); from++)
-            {
-                for (auto edge_id = from->edge_ids.begin(); edge_id != from->edge_ids.end(); edge_id++)
-                {
-                    const Edge* edge = map.findEdge(*edge_id);
-                    if (edge == nullptr) continue;
-                    ID to_id = edge->node_id2;
-                    if (from->id == to_id) to_id = edge->node_id1;
-                    if (road_map.addEdge(from->id, to_id, edge->length) == nullptr)
-                    {
-                        // Return an empty map if failed
-                        road_map.removeAll();
-                        return road_map;
-                    }
+                    // Return an empty map if failed
+                    road_map.removeAll();
+                    return road_map;
                 }
             }
         }
@@ -252,6 +579,32 @@ public:
         return road_map;
     }
 
+    static bool cvtMap2RoadTile(const Map& map, const UTMConverter& converter, RoadTile& tile, bool auto_cost = true)
+    {
+        tile.clear();
+        tile.nodes.reserve(map.nodes.size() + map.pois.size() + map.views.size());
+
+        // Copy nodes and their edges (destinations can be in other tiles)
+        for (auto node = map.nodes.begin(); node != map.nodes.end(); node++)
+        {
+            tile.nodes.push_back(Point2ID(node->id, converter.toMetric(LatLon(node->lat, node->lon))));
+            for (auto edge_id = node->edge_ids.begin(); edge_id != node->edge_ids.end(); edge_id++)
+            {
+                const Edge* edge = map.findEdge(*edge_id);
+                if (edge == nullptr) continue;
+                ID to = (edge->node_id1 == node->id) ? edge->node_id2 : edge->node_id1;
+                tile.edges.push_back(RoadTile::EdgeInfo(node->id, to, RoadCost(auto_cost ? -1 : edge->length, edge->type)));
+            }
+        }
+
+        // Copy POIs and StreetViews
+        for (auto poi = map.pois.begin(); poi != map.pois.end(); poi++)
+            tile.nodes.push_back(Point2ID(poi->id, converter.toMetric(*poi)));
+        for (auto view = map.views.begin(); view != map.views.end(); view++)
+            tile.nodes.push_back(Point2ID(view->id, converter.toMetric(*view)));
+        return true;
+    }
+
     static std::pair<double, Point2> calcDist2FromLineSeg(const Point2& from, const Point2& to, const Pose2& p, double turn_weight = 0)
     {
         // Ref. https://stackoverflow.com/questions/849211/shortest-distance-between-a-point-and-a-line-segment
@@ -275,9 +628,89 @@ public:
     }
 
 protected:
+    /**
+     * Move the tile window with the loaded tiles and replace the current map with the stitched tiles (called with m_tile_mutex locked)
+     * @param tile The center tile of the window
+     * @param loaded The loaded tiles, which are moved into the tile window
+     * @return True if the map is replaced (false if not changed or failed)
+     */
+    bool applyMapTiles(const cv::Point2i& tile, RoadTileMap::Tiles& loaded)
+    {
+        RoadMap road_map;
+        if (!m_tiles.update(tile, road_map, loaded)) return false;
+        RoadEdgeIndex edge_index;
+        edge_index.build(road_map);
+
+        cv::AutoLock lock(m_mutex);
+        applyRoadState(road_map);
+        m_map = std::move(road_map);
+        m_edge_index = std::move(edge_index);
+        publishPose();
+        return true;
+    }
+
+    /**
+     * Apply the query profile and blocked edges of the current map to the given map, which will replace the current map (called with m_mutex locked)
+     * @param road_map The given map to replace the current map
+     */
+    void applyRoadState(RoadMap& road_map) const
+    {
+        road_map.setProfile(m_map.getProfile());
+        for (auto blocked = m_road_blocked.begin(); blocked != m_road_blocked.end(); blocked++)
+            road_map.setBlocked(blocked->first.first, blocked->first.second, blocked->second);
+    }
+
+    /**
+     * Fill the given snapshot with the current state except its timestamp and sequence number (called with m_mutex locked)
+     * @param snapshot The snapshot to fill (output)
+     * @return True if successful (false if there is no state to publish)
+     */
+    virtual bool fillPoseSnapshot(PoseSnapshot&) { return false; }
+
+    /**
+     * Publish the current state as a new snapshot, which should be called with m_mutex locked whenever the state is changed
+     * @param time The time of the update (a negative value to keep the previous time)
+     * @return True if successful (false if failed)
+     */
+    bool publishPose(Timestamp time = -1)
+    {
+        PoseSnapshot snapshot;
+        if (!fillPoseSnapshot(snapshot)) return false;
+        snapshot.time = (time < 0) ? m_snapshot.time : time;
+        snapshot.seq = m_snapshot.seq + 1;
+
+        // Write the snapshot while the sequence number is odd (writers are serialized by m_mutex)
+        uint64_t seq = m_snapshot_seq.load(std::memory_order_relaxed);
+        m_snapshot_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_snapshot = snapshot;
+        m_snapshot_seq.store(seq + 2, std::memory_order_release);
+        return true;
+    }
+
     RoadMap m_map;
 
+    RoadEdgeIndex m_edge_index;
+
     mutable cv::Mutex m_mutex;
+
+    RoadTileMap m_tiles;
+
+    int m_tile_zoom;
+
+    std::map<std::pair<ID, ID>, bool> m_road_blocked;
+
+    cv::Mutex m_tile_mutex;
+
+    uint64_t m_tile_loader_seq;
+
+    std::future<RoadTileMap::Tiles> m_tile_request;
+
+    cv::Point2i m_tile_request_center;
+
+    PoseSnapshot m_snapshot;
+
+    std::atomic<uint64_t> m_snapshot_seq;
 }; // End of 'BaseLocalizer'
 
 } // End of 'dg'
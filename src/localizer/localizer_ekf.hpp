@@ -6,9 +6,12 @@
 namespace dg
 {
 
-class EKFLocalizer : public BaseLocalizer, public cx::EKF, public cx::Algorithm
+class EKFLocalizer : public BaseLocalizer, public cx::FixedEKF<5, 3, 4>, public cx::Algorithm
 {
 public:
+    /** The maximum number of localization clues in a stacked measurement and its dimension */
+    enum { MAX_LOC_CLUES = 8, LOC_CLUE_DIM = 2 * MAX_LOC_CLUES };
+
     EKFLocalizer()
     {
         // Parameters
@@ -19,6 +22,7 @@ public:
         m_noise_gps_deadzone = 10 * cv::Mat::eye(2, 2, CV_64F);
         m_noise_gps = m_noise_gps_normal;
         m_noise_loc_clue = cv::Mat::eye(4, 4, CV_64F);
+        m_gate_loc_clue = 13.82; // The 99.9% quantile of the chi-squared distribution with 2 DOF
         m_offset_gps = cv::Vec2d(0, 0);
         m_norm_conf_a = 1;
         m_norm_conf_b = 2;
@@ -27,7 +31,31 @@ public:
         m_time_last_update = -1;
         m_time_last_delta = -1;
 
-        initialize(cv::Mat::zeros(5, 1, CV_64F), cv::Mat::eye(5, 5, CV_64F));
+        initialize(StateVec::zeros(), StateCov::eye());
+    }
+
+    virtual bool initialize(cv::InputArray state_vec, cv::InputArray state_cov = cv::noArray())
+    {
+        cv::AutoLock lock(m_mutex);
+        if (!cx::FixedEKF<5, 3, 4>::initialize(state_vec, state_cov)) return false;
+        publishPose();
+        return true;
+    }
+
+    bool setState(const StateVec& state)
+    {
+        cv::AutoLock lock(m_mutex);
+        if (!cx::FixedEKF<5, 3, 4>::setState(state)) return false;
+        publishPose();
+        return true;
+    }
+
+    bool setStateCov(const StateCov& covariance)
+    {
+        cv::AutoLock lock(m_mutex);
+        if (!cx::FixedEKF<5, 3, 4>::setStateCov(covariance)) return false;
+        publishPose();
+        return true;
     }
 
     virtual int readParam(const cv::FileNode& fn)
@@ -39,6 +67,7 @@ public:
         CX_LOAD_PARAM_COUNT(fn, "noise_gps_normal", m_noise_gps_normal, n_read);
         CX_LOAD_PARAM_COUNT(fn, "noise_gps_deadzone", m_noise_gps_deadzone, n_read);
         CX_LOAD_PARAM_COUNT(fn, "noise_loc_clue", m_noise_loc_clue, n_read);
+        CX_LOAD_PARAM_COUNT(fn, "gate_loc_clue", m_gate_loc_clue, n_read);
         CX_LOAD_PARAM_COUNT(fn, "offset_gps", m_offset_gps, n_read);
         CX_LOAD_PARAM_COUNT(fn, "gps_dead_zones", m_gps_dead_zones, n_read);
         return n_read;
@@ -68,6 +97,13 @@ public:
         return true;
     }
 
+    bool setParamLocClueGate(double mah_dist2)
+    {
+        cv::AutoLock lock(m_mutex);
+        m_gate_loc_clue = mah_dist2;
+        return true;
+    }
+
     bool addParamGPSDeadZone(const dg::Point2& p1, dg::Point2& p2)
     {
         cv::AutoLock lock(m_mutex);
@@ -77,14 +113,12 @@ public:
 
     virtual Pose2 getPose()
     {
-        cv::AutoLock lock(m_mutex);
-        return Pose2(m_state_vec.at<double>(0), m_state_vec.at<double>(1), m_state_vec.at<double>(2));
+        return getPoseSnapshot().pose;
     }
 
     virtual Polar2 getVelocity()
     {
-        cv::AutoLock lock(m_mutex);
-        return Polar2(m_state_vec.at<double>(3), m_state_vec.at<double>(4));
+        return getPoseSnapshot().velocity;
     }
 
     virtual LatLon getPoseGPS()
@@ -94,15 +128,12 @@ public:
 
     virtual TopometricPose getPoseTopometric()
     {
-        return findNearestTopoPose(getPose());
+        return getPoseSnapshot().topo;
     }
 
     virtual double getPoseConfidence()
     {
-        cv::AutoLock lock(m_mutex);
-        double conf = log10(cv::determinant(m_state_cov.rowRange(0, 3).colRange(0, 3)));
-        if (m_norm_conf_a > 0) conf = 1 / (1 + exp(m_norm_conf_a * conf + m_norm_conf_b));
-        return conf;
+        return getPoseSnapshot().confidence;
     }
 
     virtual bool applyOdometry(const Pose2& pose_curr, const Pose2& pose_prev, Timestamp time_curr = -1, Timestamp time_prev = -1, double confidence = -1)
@@ -114,10 +145,11 @@ public:
             double v = sqrt(dx * dx + dy * dy) / dt, w = cx::trimRad(pose_curr.theta - pose_prev.theta) / dt;
             cv::AutoLock lock(m_mutex);
             double interval = time_curr - m_time_last_update;
-            if (interval > DBL_EPSILON && predict(cv::Vec3d(interval, v, w)))
+            if (interval > DBL_EPSILON && predict(ControlVec(interval, v, w), 3))
             {
-                m_state_vec.at<double>(2) = cx::trimRad(m_state_vec.at<double>(2));
+                m_state_vec(2) = cx::trimRad(m_state_vec(2));
                 m_time_last_update = time_curr;
+                publishPose(time_curr);
                 return true;
             }
         }
@@ -133,10 +165,11 @@ public:
         if (dt > DBL_EPSILON)
         {
             double interval = time - m_time_last_update;
-            if (interval > DBL_EPSILON && predict(cv::Vec3d(interval, delta.lin / dt, delta.ang / dt)))
+            if (interval > DBL_EPSILON && predict(ControlVec(interval, delta.lin / dt, delta.ang / dt), 3))
             {
-                m_state_vec.at<double>(2) = cx::trimRad(m_state_vec.at<double>(2));
+                m_state_vec(2) = cx::trimRad(m_state_vec(2));
                 m_time_last_update = time;
+                publishPose(time);
                 return true;
             }
         }
@@ -151,10 +184,11 @@ public:
             double w = cx::trimRad(theta_curr - theta_prev) / dt;
             cv::AutoLock lock(m_mutex);
             double interval = time_curr - m_time_last_update;
-            if (interval > DBL_EPSILON && predict(cv::Vec2d(interval, w)))
+            if (interval > DBL_EPSILON && predict(ControlVec(interval, w), 2))
             {
-                m_state_vec.at<double>(2) = cx::trimRad(m_state_vec.at<double>(2));
+                m_state_vec(2) = cx::trimRad(m_state_vec(2));
                 m_time_last_update = time_curr;
+                publishPose(time_curr);
                 return true;
             }
         }
@@ -173,7 +207,7 @@ public:
         cv::AutoLock lock(m_mutex);
         double interval = 0;
         if (m_time_last_update > 0) interval = time - m_time_last_update;
-        if (interval > m_threshold_time) predict(interval);
+        bool predicted = (interval > m_threshold_time) && predict(ControlVec(interval), 1);
 
         bool is_normal = true;
         for (auto zone = m_gps_dead_zones.begin(); zone != m_gps_dead_zones.end(); zone++)
@@ -186,12 +220,14 @@ public:
             }
         }
         if (is_normal) m_noise_gps = m_noise_gps_normal;
-        if (correct(cv::Vec2d(xy.x, xy.y)))
+        if (correct(MeasureVec(xy.x, xy.y), 2))
         {
-            m_state_vec.at<double>(2) = cx::trimRad(m_state_vec.at<double>(2));
+            m_state_vec(2) = cx::trimRad(m_state_vec(2));
             m_time_last_update = time;
+            publishPose(time);
             return true;
         }
+        if (predicted) publishPose();
         return false;
     }
 
@@ -210,161 +246,189 @@ public:
 
     virtual bool applyLocClue(ID node_id, const Polar2& obs = Polar2(-1, CV_PI), Timestamp time = -1, double confidence = -1)
     {
-        cv::AutoLock lock(m_mutex);
-        RoadMap::Node* node = m_map.getNode(Point2ID(node_id));
-        if (node == nullptr) return false;
+        return applyLocClue(std::vector<ID>(1, node_id), std::vector<Polar2>(1, obs), time, std::vector<double>(1, confidence));
+    }
 
+    /**
+     * Apply multiple localization clues from a frame as a single stacked measurement<br>
+     * Clues are gated by their squared Mahalanobis distance, and clues which are invalid, unknown, or gated out are skipped,
+     * so the result does not depend on the order of clues (up to MAX_LOC_CLUES clues in a stacked measurement).
+     * @param node_ids The IDs of observed clues
+     * @param obs The relative observation from each clue (Unit: [m] and [rad])
+     * @param time The observed time (Unit: [sec])
+     * @param confidence The observation confidence (not used yet)
+     * @return True if at least one clue is applied (false if not)
+     */
+    virtual bool applyLocClue(const std::vector<ID>& node_ids, const std::vector<Polar2>& obs, Timestamp time = -1, const std::vector<double>& confidence = std::vector<double>())
+    {
+        if (node_ids.empty() || node_ids.size() != obs.size()) return false;
+        cv::AutoLock lock(m_mutex);
         double interval = 0;
         if (m_time_last_update > 0) interval = time - m_time_last_update;
-        if (interval > m_threshold_time) predict(interval);
-        // TODO: Deal with missing observation
-        if (obs.lin > m_threshold_dist && obs.ang < CV_PI && correct(cv::Vec4d(obs.lin, obs.ang, node->data.x, node->data.y)))
+        bool predicted = (interval > m_threshold_time) && predict(ControlVec(interval), 1);
+
+        size_t n_applied = 0;
+        for (size_t i = 0; i < node_ids.size();)
+        {
+            // Stack clues which pass the gate
+            cv::Matx<double, LOC_CLUE_DIM, 1> innovation;
+            cv::Matx<double, LOC_CLUE_DIM, 5> H;
+            cv::Matx<double, LOC_CLUE_DIM, LOC_CLUE_DIM> R;
+            int n_rows = 0;
+            for (; i < node_ids.size() && n_rows < LOC_CLUE_DIM; i++)
+            {
+                // TODO: Deal with missing observation
+                if (obs[i].lin <= m_threshold_dist || obs[i].ang >= CV_PI) continue;
+                RoadMap::Node* node = m_map.getNode(Point2ID(node_ids[i]));
+                if (node == nullptr) continue;
+                MeasureVec z(obs[i].lin, obs[i].ang, node->data.x, node->data.y);
+                double mah_dist2 = checkMeasurement(z, 4);
+                if (mah_dist2 < 0 || (m_gate_loc_clue > 0 && mah_dist2 > m_gate_loc_clue)) continue;
+
+                MeasureJac H_i;
+                MeasureCov R_i;
+                MeasureVec expectation = observeFunc(m_state_vec, z, 4, H_i, R_i);
+                for (int r = 0; r < 2; r++)
+                {
+                    innovation(n_rows + r) = z(r) - expectation(r);
+                    for (int c = 0; c < 5; c++) H(n_rows + r, c) = H_i(r, c);
+                    for (int c = 0; c < 2; c++) R(n_rows + r, n_rows + c) = R_i(r, c);
+                }
+                n_rows += 2;
+            }
+
+            // Correct the state with the stacked measurement
+            if (n_rows > 0 && correctInnovation(innovation, H, R))
+            {
+                m_state_vec(2) = cx::trimRad(m_state_vec(2));
+                n_applied += n_rows / 2;
+            }
+        }
+        if (n_applied > 0)
         {
-            m_state_vec.at<double>(2) = cx::trimRad(m_state_vec.at<double>(2));
             m_time_last_update = time;
+            publishPose(time);
             return true;
         }
+        if (predicted) publishPose();
         return false;
     }
 
-    virtual bool applyLocClue(const std::vector<ID>& node_ids, const std::vector<Polar2>& obs, Timestamp time = -1, const std::vector<double>& confidence = std::vector<double>())
+protected:
+    Pose2 getStatePose() const
     {
-        if (node_ids.empty() || node_ids.size() != obs.size()) return false;
-        if (confidence.size() == node_ids.size())
-        {
-            for (size_t i = 0; i < node_ids.size(); i++)
-                if (!applyLocClue(node_ids[i], obs[i], time, confidence[i])) return false;
-        }
-        else
-        {
-            for (size_t i = 0; i < node_ids.size(); i++)
-                if (!applyLocClue(node_ids[i], obs[i], time)) return false;
-        }
+        return Pose2(m_state_vec(0), m_state_vec(1), m_state_vec(2));
+    }
+
+    virtual bool fillPoseSnapshot(PoseSnapshot& snapshot)
+    {
+        snapshot.pose = getStatePose();
+        snapshot.velocity = Polar2(m_state_vec(3), m_state_vec(4));
+        snapshot.pose_cov = m_state_cov.get_minor<3, 3>(0, 0);
+        snapshot.confidence = log10(cv::determinant(snapshot.pose_cov));
+        if (m_norm_conf_a > 0) snapshot.confidence = 1 / (1 + exp(m_norm_conf_a * snapshot.confidence + m_norm_conf_b));
+        snapshot.topo = findNearestTopoPose(snapshot.pose);
         return true;
     }
 
-protected:
-    virtual cv::Mat transitFunc(const cv::Mat& state, const cv::Mat& control, cv::Mat& jacobian, cv::Mat& noise)
+    virtual StateVec transitFunc(const StateVec& state, const ControlVec& control, int control_dim, StateCov& jacobian, StateCov& noise)
     {
-        const double dt = control.at<double>(0);
-        const double x = state.at<double>(0), y = state.at<double>(1), theta = state.at<double>(2);
-        cv::Mat func, W;
-        if (control.rows == 1)
+        const double dt = control(0);
+        const double x = state(0), y = state(1), theta = state(2);
+        double v = state(3), w = state(4);
+        if (control_dim == 2)
+        {
+            // The control input: [ dt, w_c ]
+            w = control(1);
+        }
+        else if (control_dim >= 3)
+        {
+            // The control input: [ dt, v_c, w_c ]
+            v = control(1);
+            w = control(2);
+        }
+        const double vt = v * dt, wt = w * dt;
+        const double c = cos(theta + wt / 2), s = sin(theta + wt / 2);
+        StateVec func(
+            x + vt * c,
+            y + vt * s,
+            theta + wt,
+            v,
+            w);
+        jacobian = StateCov::eye();
+        jacobian(0, 2) = -vt * s;
+        jacobian(1, 2) =  vt * c;
+        if (control_dim == 1)
         {
             // The control input: [ dt ]
-            const double v = state.at<double>(3), w = state.at<double>(4);
-            const double vt = v * dt, wt = w * dt;
-            const double c = cos(theta + wt / 2), s = sin(theta + wt / 2);
-            func = (cv::Mat_<double>(5, 1) <<
-                x + vt * c,
-                y + vt * s,
-                theta + wt,
-                v,
-                w);
-            jacobian = (cv::Mat_<double>(5, 5) <<
-                1, 0, -vt * s, dt * c, -vt * dt * s / 2,
-                0, 1,  vt * c, dt * s,  vt * dt * c / 2,
-                0, 0,       1,      0,               dt,
-                0, 0,       0,      1,                0,
-                0, 0,       0,      0,                1);
-            W = (cv::Mat_<double>(5, 2) <<
-                dt * c, -vt * dt * s / 2,
-                dt * s,  vt * dt * c / 2,
-                0, dt,
-                1, 0,
-                0, 1);
+            jacobian(0, 3) = dt * c; jacobian(0, 4) = -vt * dt * s / 2;
+            jacobian(1, 3) = dt * s; jacobian(1, 4) =  vt * dt * c / 2;
+            jacobian(2, 4) = dt;
         }
-        else if (control.rows == 2)
+        else if (control_dim == 2)
         {
-            // The control input: [ dt, w_c ]
-            const double v = state.at<double>(3), w = control.at<double>(1);
-            const double vt = v * dt, wt = w * dt;
-            const double c = cos(theta + wt / 2), s = sin(theta + wt / 2);
-            func = (cv::Mat_<double>(5, 1) <<
-                x + vt * c,
-                y + vt * s,
-                theta + wt,
-                v,
-                w);
-            jacobian = (cv::Mat_<double>(5, 5) <<
-                1, 0, -vt * s, dt * c, 0,
-                0, 1,  vt * c, dt * s, 0,
-                0, 0,       1,      0, 0,
-                0, 0,       0,      1, 0,
-                0, 0,       0,      0, 0);
-            W = (cv::Mat_<double>(5, 2) <<
-                dt * c, -vt * dt * s / 2,
-                dt * s,  vt * dt * c / 2,
-                0, dt,
-                1, 0,
-                0, 1);
+            jacobian(0, 3) = dt * c;
+            jacobian(1, 3) = dt * s;
+            jacobian(4, 4) = 0;
         }
-        else if (control.rows >= 3)
+        else
         {
-            // The control input: [ dt, v_c, w_c ]
-            const double v = control.at<double>(1), w = control.at<double>(2);
-            const double vt = v * dt, wt = w * dt;
-            const double c = cos(theta + wt / 2), s = sin(theta + wt / 2);
-            func = (cv::Mat_<double>(5, 1) <<
-                x + vt * c,
-                y + vt * s,
-                theta + wt,
-                v,
-                w);
-            jacobian = (cv::Mat_<double>(5, 5) <<
-                1, 0, -vt * s, 0, 0,
-                0, 1,  vt * c, 0, 0,
-                0, 0,       1, 0, 0,
-                0, 0,       0, 0, 0,
-                0, 0,       0, 0, 0);
-            W = (cv::Mat_<double>(5, 2) <<
-                dt * c, -vt * dt * s / 2,
-                dt * s,  vt * dt * c / 2,
-                0, dt,
-                1, 0,
-                0, 1);
+            jacobian(3, 3) = 0;
+            jacobian(4, 4) = 0;
         }
-        if (!W.empty()) noise = W * m_noise_motion * W.t();
+        const double W[] = {
+            dt * c, -vt * dt * s / 2,
+            dt * s,  vt * dt * c / 2,
+            0, dt,
+            1, 0,
+            0, 1 };
+        noise = calcMotionNoise(cv::Matx<double, 5, 2>(W));
         return func;
     }
 
-    virtual cv::Mat observeFunc(const cv::Mat& state, const cv::Mat& measure, cv::Mat& jacobian, cv::Mat& noise)
+    virtual MeasureVec observeFunc(const StateVec& state, const MeasureVec& measure, int measure_dim, MeasureJac& jacobian, MeasureCov& noise)
     {
-        const double x = state.at<double>(0), y = state.at<double>(1), theta = state.at<double>(2);
-        cv::Mat func;
-        if (measure.rows == 2)
+        const double x = state(0), y = state(1), theta = state(2);
+        MeasureVec func;
+        if (measure_dim == 2)
         {
             // Measurement: [ x_{GPS}, y_{GPS} ]
             const double c = cos(theta + m_offset_gps(1)), s = sin(theta + m_offset_gps(1));
-            func = (cv::Mat_<double>(2, 1) <<
+            func = MeasureVec(
                 x + m_offset_gps(0) * c,
-                y + m_offset_gps(0) * s);
-            jacobian = (cv::Mat_<double>(2, 5) <<
-                1, 0, -m_offset_gps(0) * s, 0, 0,
-                0, 1,  m_offset_gps(0) * c, 0, 0);
-            noise = m_noise_gps;
+                y + m_offset_gps(0) * s,
+                0,
+                0);
+            jacobian(0, 0) = 1; jacobian(0, 2) = -m_offset_gps(0) * s;
+            jacobian(1, 1) = 1; jacobian(1, 2) =  m_offset_gps(0) * c;
+            const cv::Matx22d R = m_noise_gps;
+            noise(0, 0) = R(0, 0); noise(0, 1) = R(0, 1);
+            noise(1, 0) = R(1, 0); noise(1, 1) = R(1, 1);
         }
-        else if (measure.rows >= 4)
+        else if (measure_dim >= 4)
         {
             // Measurement: [ rho_{id}, phi_{id}, x_{id}, y_{id} ]
-            const double dx = measure.at<double>(2) - x;
-            const double dy = measure.at<double>(3) - y;
+            const double dx = measure(2) - x;
+            const double dy = measure(3) - y;
             const double r = sqrt(dx * dx + dy * dy);
-            func = (cv::Mat_<double>(4, 1) <<
+            func = MeasureVec(
                 r,
-                cx::trimRad(atan2(dy, dx) - theta),
-                measure.at<double>(2),
-                measure.at<double>(3));
-            jacobian = (cv::Mat_<double>(4, 5) <<
-               -2 * dx / r, -2 * dy / r,  0, 0, 0,
-                dy / r / r, -dx / r / r, -1, 0, 0,
-                0, 0, 0, 0, 0,
-                0, 0, 0, 0, 0);
+                measure(1) - cx::trimRad(measure(1) - atan2(dy, dx) + theta), // Unwrapped near the measured angle
+                measure(2),
+                measure(3));
+            jacobian(0, 0) = -2 * dx / r; jacobian(0, 1) = -2 * dy / r;
+            jacobian(1, 0) =  dy / r / r; jacobian(1, 1) = -dx / r / r; jacobian(1, 2) = -1;
             noise = m_noise_loc_clue;
         }
         return func;
     }
 
+    StateCov calcMotionNoise(const cv::Matx<double, 5, 2>& W) const
+    {
+        const cv::Matx22d Q = m_noise_motion;
+        return W * Q * W.t();
+    }
+
     double m_threshold_time;
 
     double m_threshold_dist;
@@ -379,6 +443,8 @@ protected:
 
     cv::Mat m_noise_loc_clue;
 
+    double m_gate_loc_clue;
+
     cv::Vec2d m_offset_gps;
 
     double m_norm_conf_a;
@@ -9,53 +9,54 @@ namespace dg
 class EKFLocalizerZeroGyro : public EKFLocalizer
 {
 protected:
-    virtual cv::Mat transitFunc(const cv::Mat& state, const cv::Mat& control, cv::Mat& jacobian, cv::Mat& noise)
+    virtual StateVec transitFunc(const StateVec& state, const ControlVec& control, int control_dim, StateCov& jacobian, StateCov& noise)
     {
-        if (control.rows == 1)
+        if (control_dim == 1)
         {
-            cv::Vec2d control_fake(control.at<double>(0), 0); // Add fake observation
-            return EKFLocalizer::transitFunc(state, cv::Mat(control_fake), jacobian, noise);
+            ControlVec control_fake(control(0), 0); // Add fake observation
+            return EKFLocalizer::transitFunc(state, control_fake, 2, jacobian, noise);
         }
-        return EKFLocalizer::transitFunc(state, control, jacobian, noise);
+        return EKFLocalizer::transitFunc(state, control, control_dim, jacobian, noise);
     }
 };
 
 class EKFLocalizerHyperTan : public EKFLocalizer
 {
 protected:
-    virtual cv::Mat transitFunc(const cv::Mat& state, const cv::Mat& control, cv::Mat& jacobian, cv::Mat& noise)
+    virtual StateVec transitFunc(const StateVec& state, const ControlVec& control, int control_dim, StateCov& jacobian, StateCov& noise)
     {
         const double w_op = 1;
-        if (control.rows == 1)
+        if (control_dim == 1)
         {
             // The control input: [ dt ]
-            const double dt = control.at<double>(0);
-            const double x = state.at<double>(0), y = state.at<double>(1), theta = state.at<double>(2);
-            const double v = state.at<double>(3), w = state.at<double>(4);
+            const double dt = control(0);
+            const double x = state(0), y = state(1), theta = state(2);
+            const double v = state(3), w = state(4);
             const double vt = v * dt, wt = w * dt;
             const double c = cos(theta + wt / 2), s = sin(theta + wt / 2), th = w_op * tanh(w / w_op);
-            cv::Mat func = (cv::Mat_<double>(5, 1) <<
+            StateVec func(
                 x + vt * c,
                 y + vt * s,
                 theta + wt,
                 v,
                 th);
-            jacobian = (cv::Mat_<double>(5, 5) <<
+            const double F[] = {
                 1, 0, -vt * s, dt * c, -vt * dt * s / 2,
                 0, 1,  vt * c, dt * s,  vt * dt * c / 2,
                 0, 0, 1, 0, dt,
                 0, 0, 0, 1, 0,
-                0, 0, 0, 0, 1 - th * th);
-            cv::Mat W = (cv::Mat_<double>(5, 2) <<
+                0, 0, 0, 0, 1 - th * th };
+            jacobian = StateCov(F);
+            const double W[] = {
                 dt * c, -vt * dt * s / 2,
                 dt * s,  vt * dt * c / 2,
                 0, dt,
                 1, 0,
-                0, 1 - th * th);
-            if (!W.empty()) noise = W * m_noise_motion * W.t();
+                0, 1 - th * th };
+            noise = calcMotionNoise(cv::Matx<double, 5, 2>(W));
             return func;
         }
-        return EKFLocalizer::transitFunc(state, control, jacobian, noise);
+        return EKFLocalizer::transitFunc(state, control, control_dim, jacobian, noise);
     }
 };
 
@@ -65,18 +66,7 @@ public:
     EKFLocalizerSinTrack()
     {
         m_track_converge = 0;
-    }
-
-    virtual Pose2 getPose()
-    {
-        cv::AutoLock lock(m_mutex);
-        return cvtTopmetric2Metric(getPoseTopometric());
-    }
-
-    virtual TopometricPose getPoseTopometric()
-    {
-        cv::AutoLock lock(m_mutex);
-        return m_track_topo;
+        publishPose();
     }
 
     virtual bool applyPosition(const Point2& xy, Timestamp time = -1, double confidence = -1)
@@ -87,7 +77,7 @@ public:
             const double turn_weight = 1;
             const int converge_repeat = 5;
             const double drift_radius = 50;
-            Pose2 pose_m = EKFLocalizerHyperTan::getPose();
+            Pose2 pose_m = getStatePose();
             if (m_track_topo.node_id == 0 || m_track_converge < converge_repeat)
             {
                 m_track_topo = findNearestTopoPose(pose_m, turn_weight);
@@ -112,12 +102,21 @@ public:
                 }
             }
             m_track_prev = m_track_topo;
+            publishPose();
             return true;
         }
         return false;
     }
 
 protected:
+    virtual bool fillPoseSnapshot(PoseSnapshot& snapshot)
+    {
+        if (!EKFLocalizerHyperTan::fillPoseSnapshot(snapshot)) return false;
+        snapshot.topo = m_track_topo;
+        snapshot.pose = cvtTopmetric2Metric(m_track_topo);
+        return true;
+    }
+
     TopometricPose m_track_topo;
 
     TopometricPose m_track_prev;
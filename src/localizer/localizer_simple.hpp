@@ -11,8 +11,7 @@ class SimpleLocalizer : public BaseLocalizer
 public:
     virtual Pose2 getPose()
     {
-        cv::AutoLock lock(m_mutex);
-        return m_pose;
+        return getPoseSnapshot().pose;
     }
 
     virtual LatLon getPoseGPS()
@@ -22,7 +21,7 @@ public:
 
     virtual TopometricPose getPoseTopometric()
     {
-        return findNearestTopoPose(getPose());
+        return getPoseSnapshot().topo;
     }
 
     virtual double getPoseConfidence()
@@ -39,6 +38,7 @@ public:
         m_pose.x += c * dx - s * dy;
         m_pose.x += s * dx + c * dy;
         m_pose.theta = cx::trimRad(m_pose.theta + pose_curr.theta - pose_prev.theta);
+        publishPose(time_curr);
         return true;
     }
 
@@ -48,6 +48,7 @@ public:
         m_pose.x += delta.lin * cos(m_pose.theta + delta.ang / 2);
         m_pose.y += delta.lin * sin(m_pose.theta + delta.ang / 2);
         m_pose.theta = cx::trimRad(m_pose.theta + delta.ang);
+        publishPose(time);
         return true;
     }
 
@@ -55,6 +56,7 @@ public:
     {
         cv::AutoLock lock(m_mutex);
         m_pose.theta = cx::trimRad(m_pose.theta + theta_curr - theta_prev);
+        publishPose(time_curr);
         return true;
     }
 
@@ -62,6 +64,7 @@ public:
     {
         cv::AutoLock lock(m_mutex);
         m_pose = pose;
+        publishPose(time);
         return true;
     }
 
@@ -70,6 +73,7 @@ public:
         cv::AutoLock lock(m_mutex);
         m_pose.x = xy.x;
         m_pose.y = xy.y;
+        publishPose(time);
         return true;
     }
 
@@ -83,6 +87,7 @@ public:
     {
         cv::AutoLock lock(m_mutex);
         m_pose.theta = theta;
+        publishPose(time);
         return true;
     }
 
@@ -93,6 +98,7 @@ public:
         if (node == nullptr) return false;
         m_pose.x = node->data.x;
         m_pose.y = node->data.y;
+        publishPose(time);
         return true;
     }
 
@@ -103,6 +109,13 @@ public:
     }
 
 protected:
+    virtual bool fillPoseSnapshot(PoseSnapshot& snapshot)
+    {
+        snapshot.pose = m_pose;
+        snapshot.topo = findNearestTopoPose(m_pose);
+        return true;
+    }
+
     Pose2 m_pose;
 }; // End of 'SimpleLocalizer'
 
@@ -0,0 +1,64 @@
+#ifndef __ROAD_COST__
+#define __ROAD_COST__
+
+#include "core/road_profile.hpp"
+#include <cmath>
+#include <limits>
+
+namespace dg
+{
+
+/**
+ * @brief Multi-criteria cost of an edge in RoadMap
+ *
+ * A <b>road cost</b> keeps attributes of an edge (its length, type, slope, and blocking flag) instead of a single scalar.
+ * It is implicitly converted from and to its length, so it can be used as a scalar cost of DirectedGraph.
+ * Its effective weight depends on a query profile (RoadProfile), and RoadMap calculates the weight lazily
+ * and caches it for each of the recently used profiles in this cost.
+ */
+struct RoadCost
+{
+    /** The number of profiles whose weights are cached */
+    static const int N_CACHES = 4;
+
+    /**
+     * A constructor with member initialization
+     * @param _length Length of the edge (Unit: [m])
+     * @param _type Type of the edge (e.g. Edge::EDGE_SIDEWALK)
+     * @param _slope Slope of the edge (rise over run; negative for downhill)
+     * @param _blocked A flag whether the edge is temporarily blocked or not
+     */
+    RoadCost(double _length = 0, int _type = Edge::EDGE_SIDEWALK, double _slope = 0, bool _blocked = false) : length(_length), type(_type), slope(_slope), blocked(_blocked) { invalidate(); }
+
+    /**
+     * Convert to its length
+     */
+    operator double() const { return length; }
+
+    /**
+     * Invalidate all cached weights
+     */
+    void invalidate() const
+    {
+        for (int i = 0; i < N_CACHES; i++) weights[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /** Length of the edge (Unit: [m]) */
+    double length;
+
+    /** Type of the edge (e.g. Edge::EDGE_SIDEWALK) */
+    int type;
+
+    /** Slope of the edge (rise over run; negative for downhill) */
+    double slope;
+
+    /** A flag whether the edge is temporarily blocked or not (e.g. construction) */
+    bool blocked;
+
+    /** Cached weights for each profile slot of RoadMap (NaN if not calculated yet) */
+    mutable double weights[N_CACHES];
+};
+
+} // End of 'dg'
+
+#endif // End of '__ROAD_COST__'
@@ -1,70 +1,441 @@
 #include "road_map.hpp"
+#include "core/mapped_file.hpp"
+#include <cstring>
+#include <thread>
+#include <unordered_map>
 
-#define ROAD_MAP_BUF_SIZE               (1024)
+#define ROAD_MAP_MIN_CHUNK              (1 << 20)
+#define ROAD_MAP_NUM_BUF_SIZE           (64)
 
 namespace dg
 {
 
+/**
+ * @brief Nodes and edges parsed from a chunk of a CSV file
+ */
+struct RoadMapChunk
+{
+    /** An edge line of a CSV file */
+    struct EdgeLine
+    {
+        /** ID of the start node */
+        ID from;
+
+        /** ID of the destination node */
+        ID to;
+
+        /** Cost of the edge (negative for Euclidean distance) */
+        double cost;
+
+        /** A pointer to the start node (resolved after adding nodes) */
+        RoadMap::Node* from_ptr;
+
+        /** A pointer to the destination node (resolved after adding nodes) */
+        RoadMap::Node* to_ptr;
+    };
+
+    /** Parsed nodes in order of lines */
+    std::vector<Point2ID> nodes;
+
+    /** Parsed edges in order of lines */
+    std::vector<EdgeLine> edges;
+
+    /** Result of parsing or resolving the chunk */
+    bool ok;
+};
+
+/**
+ * Skip spaces and tabs
+ */
+static inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+/**
+ * Parse an unsigned integer field (which is equivalent with 'strtoll' for valid IDs)<br>
+ * A field with trailing characters except spaces is rejected.
+ */
+static bool parseID(const char* p, const char* end, ID& value)
+{
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+') p++;
+    if (p >= end || *p < '0' || *p > '9') return false;
+    value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) value = value * 10 + (*p - '0');
+    return skipSpaces(p, end) == end;
+}
+
+/**
+ * Parse a floating-point field<br>
+ * A decimal number with less than 20 digits and a small exponent is exactly converted with one multiplication or division (Clinger's fast path),
+ * and other numbers are converted by 'strtod'. A field with trailing characters except spaces is rejected.
+ */
+static bool parseDouble(const char* p, const char* end, double& value)
+{
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    p = skipSpaces(p, end);
+    const char* begin = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+    uint64_t mantissa = 0;
+    int n_digits = 0, exponent = 0;
+    bool exact = true, has_digits = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        has_digits = true;
+        if (n_digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa > 0) n_digits++;
+        }
+        else
+        {
+            exponent++;
+            exact &= (*p == '0');
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+        {
+            has_digits = true;
+            if (n_digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa > 0) n_digits++;
+                exponent--;
+            }
+            else exact &= (*p == '0');
+        }
+    }
+    if (has_digits && p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        bool exp_negative = false;
+        if (q < end && (*q == '-' || *q == '+')) exp_negative = (*q++ == '-');
+        if (q < end && *q >= '0' && *q <= '9')
+        {
+            int exp_value = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; q++)
+                if (exp_value < 10000) exp_value = exp_value * 10 + (*q - '0');
+            exponent += exp_negative ? -exp_value : exp_value;
+            p = q;
+        }
+    }
+
+    if (has_digits && skipSpaces(p, end) != end) return false;
+    if (has_digits && exact && mantissa <= (static_cast<uint64_t>(1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        double number = static_cast<double>(mantissa);
+        number = (exponent < 0) ? number / pow10[-exponent] : number * pow10[exponent];
+        value = negative ? -number : number;
+        return true;
+    }
+
+    // Use 'strtod' for the other cases (e.g. too many digits, 'inf', and 'nan')
+    char buffer[ROAD_MAP_NUM_BUF_SIZE];
+    size_t length = std::min(static_cast<size_t>(end - begin), sizeof(buffer) - 1);
+    memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    char* parsed = nullptr;
+    value = strtod(buffer, &parsed);
+    if (parsed == buffer) return false;
+    return skipSpaces(parsed, buffer + length) == buffer + length;
+}
+
+/**
+ * Find the end of the current field (a comma or the end of the line)
+ */
+static inline const char* findFieldEnd(const char* p, const char* end)
+{
+    const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+    return (comma == nullptr) ? end : comma;
+}
+
+/**
+ * Parse lines of a CSV file in the given range (the range starts at the beginning of a line)
+ */
+static void parseRoadMapChunk(const char* p, const char* end, RoadMapChunk* chunk)
+{
+    chunk->ok = false;
+    while (p < end)
+    {
+        const char* line_end = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (line_end == nullptr) line_end = end;
+        const char* next = line_end + 1;
+        if (line_end > p && line_end[-1] == '\r') line_end--;
+
+        char prefix = *p;
+        if (prefix == 'N' || prefix == 'n' || prefix == 'E' || prefix == 'e')
+        {
+            // Read three fields after the prefix
+            const char* field[3];
+            const char* field_end[3];
+            const char* q = findFieldEnd(p, line_end);
+            for (int i = 0; i < 3; i++)
+            {
+                if (q >= line_end) return;
+                field[i] = q + 1;
+                q = findFieldEnd(field[i], line_end);
+                field_end[i] = q;
+            }
+
+            if (prefix == 'N' || prefix == 'n')
+            {
+                // Read nodes
+                Point2ID node;
+                if (!parseID(field[0], field_end[0], node.id)) return;
+                if (!parseDouble(field[1], field_end[1], node.x)) return;
+                if (!parseDouble(field[2], field_end[2], node.y)) return;
+                chunk->nodes.push_back(node);
+            }
+            else
+            {
+                // Read edges
+                RoadMapChunk::EdgeLine edge;
+                if (!parseID(field[0], field_end[0], edge.from)) return;
+                if (!parseID(field[1], field_end[1], edge.to)) return;
+                if (!parseDouble(field[2], field_end[2], edge.cost)) return;
+                chunk->edges.push_back(edge);
+            }
+        }
+        p = next;
+    }
+    chunk->ok = true;
+}
+
+/**
+ * @brief The header of a binary road map file
+ */
+struct RoadMapBinaryHeader
+{
+    /** The magic string ("DGROAD") */
+    char magic[8];
+
+    /** The version of the file format */
+    uint32_t version;
+
+    /** The size of this header (Unit: [byte]) */
+    uint32_t header_size;
+
+    /** The number of nodes */
+    uint64_t n_nodes;
+
+    /** The number of edges */
+    uint64_t n_edges;
+};
+
+/**
+ * @brief A node record of a binary road map file
+ */
+struct RoadMapBinaryNode
+{
+    /** ID of the node */
+    uint64_t id;
+
+    /** X coordinate of the node */
+    double x;
+
+    /** Y coordinate of the node */
+    double y;
+};
+
+/**
+ * @brief An edge record of a binary road map file (version 1)
+ */
+struct RoadMapBinaryEdgeV1
+{
+    /** Index of the start node */
+    uint32_t from;
+
+    /** Index of the destination node */
+    uint32_t to;
+
+    /** Cost of the edge */
+    double cost;
+};
+
+/**
+ * @brief An edge record of a binary road map file
+ */
+struct RoadMapBinaryEdge
+{
+    /** Index of the start node */
+    uint32_t from;
+
+    /** Index of the destination node */
+    uint32_t to;
+
+    /** Length of the edge */
+    double length;
+
+    /** Slope of the edge */
+    double slope;
+
+    /** Type of the edge */
+    int32_t type;
+
+    /** Flags of the edge (1 if blocked) */
+    uint32_t flags;
+};
+
+static const char ROAD_MAP_MAGIC[8] = { 'D', 'G', 'R', 'O', 'A', 'D', '\0', '\0' };
+static const uint32_t ROAD_MAP_VERSION = 2;
+
 // 'RoadMap' class
-bool RoadMap::load(const char* filename)
+bool RoadMap::load(const char* filename, int n_threads /*= 0*/)
 {
     removeAll();
+    if (filename == nullptr) return false;
+
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    if (file.size() >= sizeof(RoadMapBinaryHeader) && memcmp(file.data(), ROAD_MAP_MAGIC, sizeof(ROAD_MAP_MAGIC)) == 0)
+        return loadBinary(file.data(), file.size());
+    return loadCSV(file.data(), file.size(), n_threads);
+}
+
+bool RoadMap::loadCSV(const char* data, size_t size, int n_threads)
+{
+    if (size == 0) return true;
 
-    FILE* fid = fopen(filename, "rt");
-    if (fid == nullptr) return false;
+    // Split the data into chunks at line boundaries
+    if (n_threads <= 0) n_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    size_t n_chunks = std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(n_threads), size / ROAD_MAP_MIN_CHUNK));
+    std::vector<const char*> bounds(n_chunks + 1, data);
+    bounds[n_chunks] = data + size;
+    for (size_t i = 1; i < n_chunks; i++)
+    {
+        const char* p = std::max(data + size * i / n_chunks, bounds[i - 1]);
+        const char* line_end = static_cast<const char*>(memchr(p, '\n', data + size - p));
+        bounds[i] = (line_end == nullptr) ? data + size : line_end + 1;
+    }
 
-    char buffer[ROAD_MAP_BUF_SIZE];
-    while (!feof(fid))
+    // Parse all chunks in parallel
+    std::vector<RoadMapChunk> chunks(n_chunks);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < n_chunks; i++) workers.push_back(std::thread(parseRoadMapChunk, bounds[i], bounds[i + 1], &chunks[i]));
+    parseRoadMapChunk(bounds[0], bounds[1], &chunks[0]);
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    workers.clear();
+    size_t n_nodes = 0;
+    for (size_t i = 0; i < n_chunks; i++)
     {
-        if (fgets(buffer, ROAD_MAP_BUF_SIZE, fid) == nullptr) break;
-        char* token;
-        if ((token = strtok(buffer, ",")) == nullptr) goto ROADMAP_LOADMAP_FAIL;
-        if (token[0] == 'N' || token[0] == 'n')
+        if (!chunks[i].ok) return false;
+        n_nodes += chunks[i].nodes.size();
+    }
+
+    // Add all nodes in order (the hash index is not thread-safe)
+    reserveNodes(n_nodes);
+    for (size_t i = 0; i < n_chunks; i++)
+    {
+        for (auto node = chunks[i].nodes.begin(); node != chunks[i].nodes.end(); node++)
         {
-            // Read nodes
-            if ((token = strtok(nullptr, ",")) == nullptr) goto ROADMAP_LOADMAP_FAIL;
-            ID id = strtoll(token, nullptr, 10);
-            if ((token = strtok(nullptr, ",")) == nullptr) goto ROADMAP_LOADMAP_FAIL;
-            double x = strtod(token, nullptr);
-            if ((token = strtok(nullptr, ",")) == nullptr) goto ROADMAP_LOADMAP_FAIL;
-            double y = strtod(token, nullptr);
-
-            if (addNode(Point2ID(id, x, y)) == nullptr) goto ROADMAP_LOADMAP_FAIL;
+            if (getNode(node->id) != nullptr)
+            {
+                // Reject duplicated IDs
+                removeAll();
+                return false;
+            }
+            addNode(*node);
         }
-        else if (token[0] == 'E' || token[0] == 'e')
+    }
+
+    // Find end nodes and cost of edges in parallel (finding nodes does not modify the graph)
+    auto resolve = [this](RoadMapChunk* chunk)
+    {
+        for (auto edge = chunk->edges.begin(); edge != chunk->edges.end(); edge++)
         {
-            // Read edges
-            if ((token = strtok(nullptr, ",")) == nullptr) goto ROADMAP_LOADMAP_FAIL;
-            ID id1 = strtoll(token, nullptr, 10);
-            if ((token = strtok(nullptr, ",")) == nullptr) goto ROADMAP_LOADMAP_FAIL;
-            ID id2 = strtoll(token, nullptr, 10);
-            if ((token = strtok(nullptr, ",")) == nullptr) goto ROADMAP_LOADMAP_FAIL;
-            double cost = strtod(token, nullptr);
-            Node* node1 = getNode(Point2ID(id1));
-            Node* node2 = getNode(Point2ID(id2));
-            if (node1 == nullptr || node2 == nullptr) goto ROADMAP_LOADMAP_FAIL;
-
-            if (cost < 0)
+            edge->from_ptr = getNode(edge->from);
+            edge->to_ptr = getNode(edge->to);
+            if (edge->from_ptr == nullptr || edge->to_ptr == nullptr)
             {
-                double dx = node2->data.x - node1->data.x;
-                double dy = node2->data.y - node1->data.y;
-                cost = sqrt(dx * dx + dy * dy);
+                chunk->ok = false;
+                return;
             }
-            if (addEdge(node1, node2, cost) == nullptr) goto ROADMAP_LOADMAP_FAIL;
+            if (edge->cost < 0)
+            {
+                double dx = edge->to_ptr->data.x - edge->from_ptr->data.x;
+                double dy = edge->to_ptr->data.y - edge->from_ptr->data.y;
+                edge->cost = sqrt(dx * dx + dy * dy);
+            }
+        }
+    };
+    for (size_t i = 1; i < n_chunks; i++) workers.push_back(std::thread(resolve, &chunks[i]));
+    resolve(&chunks[0]);
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    for (size_t i = 0; i < n_chunks; i++)
+    {
+        if (!chunks[i].ok)
+        {
+            removeAll();
+            return false;
         }
     }
-    fclose(fid);
+
+    // Add all edges in order
+    for (size_t i = 0; i < n_chunks; i++)
+        for (auto edge = chunks[i].edges.begin(); edge != chunks[i].edges.end(); edge++)
+            DirectedGraph<Point2ID, RoadCost, VectorStorage>::addEdge(edge->from_ptr, edge->to_ptr, RoadCost(edge->cost));
     return true;
+}
 
-ROADMAP_LOADMAP_FAIL:
-    removeAll();
-    fclose(fid);
-    return false;
+bool RoadMap::loadBinary(const char* data, size_t size)
+{
+    // Check the header and size of sections
+    RoadMapBinaryHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.version < 1 || header.version > ROAD_MAP_VERSION || header.header_size != sizeof(header)) return false;
+    const size_t edge_size = (header.version == 1) ? sizeof(RoadMapBinaryEdgeV1) : sizeof(RoadMapBinaryEdge);
+    if (header.n_nodes > (size - sizeof(header)) / sizeof(RoadMapBinaryNode)) return false;
+    size_t edge_offset = sizeof(header) + static_cast<size_t>(header.n_nodes) * sizeof(RoadMapBinaryNode);
+    if (header.n_edges > (size - edge_offset) / edge_size) return false;
+
+    // Add nodes and edges (edges refer nodes by their indices, so they are added without finding nodes)
+    std::vector<Node*> nodes(static_cast<size_t>(header.n_nodes));
+    reserveNodes(nodes.size());
+    const char* p = data + sizeof(header);
+    for (size_t i = 0; i < nodes.size(); i++, p += sizeof(RoadMapBinaryNode))
+    {
+        RoadMapBinaryNode record;
+        memcpy(&record, p, sizeof(record));
+        if (getNode(record.id) != nullptr)
+        {
+            // Reject duplicated IDs
+            removeAll();
+            return false;
+        }
+        nodes[i] = addNode(Point2ID(record.id, record.x, record.y));
+    }
+    for (uint64_t i = 0; i < header.n_edges; i++, p += edge_size)
+    {
+        RoadMapBinaryEdge record;
+        if (header.version == 1)
+        {
+            RoadMapBinaryEdgeV1 record_v1;
+            memcpy(&record_v1, p, sizeof(record_v1));
+            RoadMapBinaryEdge converted = { record_v1.from, record_v1.to, record_v1.cost, 0, dg::Edge::EDGE_SIDEWALK, 0 };
+            record = converted;
+        }
+        else memcpy(&record, p, sizeof(record));
+        if (record.from >= nodes.size() || record.to >= nodes.size())
+        {
+            removeAll();
+            return false;
+        }
+        RoadCost cost(record.length, record.type, record.slope, (record.flags & 1) != 0);
+        DirectedGraph<Point2ID, RoadCost, VectorStorage>::addEdge(nodes[record.from], nodes[record.to], cost);
+    }
+    return true;
 }
 
-bool RoadMap::save(const char* filename)
+bool RoadMap::save(const char* filename, bool binary /*= false*/)
 {
     if (isEmpty()) return false;
+    if (binary) return saveBinary(filename);
 
     FILE* file = fopen(filename, "wt");
     if (file == nullptr) return false;
@@ -81,39 +452,86 @@ bool RoadMap::save(const char* filename)
     {
         RoadMap::EdgeItr itr_edge;
         for (itr_edge = getHeadEdge(itr_node); itr_edge != getTailEdge(itr_node); itr_edge++)
-            fprintf(file, "EDGE, %zd, %zd, %lf\n", itr_node->data.id, itr_edge->to->data.id, itr_edge->cost);
+            fprintf(file, "EDGE, %zd, %zd, %lf\n", itr_node->data.id, itr_edge->to->data.id, itr_edge->cost.length);
     }
 
     fclose(file);
     return true;
 }
 
-bool RoadMap::addRoad(Node* node1, Node* node2, double cost /*= -1.0*/)
+bool RoadMap::saveBinary(const char* filename)
+{
+    // Give indices to nodes
+    if (countNodes() > UINT32_MAX) return false;
+    std::vector<RoadMapBinaryNode> nodes;
+    nodes.reserve(countNodes());
+    std::unordered_map<const Node*, uint32_t> node_indices;
+    node_indices.reserve(countNodes());
+    for (NodeItrConst node = getHeadNodeConst(); node != getTailNodeConst(); node++)
+    {
+        RoadMapBinaryNode record = { node->data.id, node->data.x, node->data.y };
+        node_indices.insert(std::make_pair(&(*node), static_cast<uint32_t>(nodes.size())));
+        nodes.push_back(record);
+    }
+    std::vector<RoadMapBinaryEdge> edges;
+    for (NodeItrConst node = getHeadNodeConst(); node != getTailNodeConst(); node++)
+    {
+        uint32_t from = node_indices[&(*node)];
+        for (EdgeItrConst edge = getHeadEdgeConst(node); edge != getTailEdgeConst(node); edge++)
+        {
+            RoadMapBinaryEdge record = { from, node_indices[edge->to], edge->cost.length, edge->cost.slope, edge->cost.type, edge->cost.blocked ? 1u : 0u };
+            edges.push_back(record);
+        }
+    }
+
+    RoadMapBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ROAD_MAP_MAGIC, sizeof(ROAD_MAP_MAGIC));
+    header.version = ROAD_MAP_VERSION;
+    header.header_size = sizeof(header);
+    header.n_nodes = nodes.size();
+    header.n_edges = edges.size();
+
+    FILE* file = fopen(filename, "wb");
+    if (file == nullptr) return false;
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+    if (ok && !nodes.empty()) ok = (fwrite(nodes.data(), sizeof(RoadMapBinaryNode), nodes.size(), file) == nodes.size());
+    if (ok && !edges.empty()) ok = (fwrite(edges.data(), sizeof(RoadMapBinaryEdge), edges.size(), file) == edges.size());
+    ok &= (fclose(file) == 0);
+    return ok;
+}
+
+bool RoadMap::addRoad(Node* node1, Node* node2, const RoadCost& cost)
 {
     if (node1 == nullptr || node2 == nullptr) return false;
 
-    if (cost < 0)
+    RoadCost forward = cost;
+    if (forward.length < 0)
     {
         double dx = node1->data.x - node2->data.x;
         double dy = node1->data.y - node2->data.y;
-        cost = sqrt(dx * dx + dy * dy);
+        forward.length = sqrt(dx * dx + dy * dy);
     }
-    Edge* edge1 = DirectedGraph<Point2ID, double>::addEdge(node1, node2, cost);
-    Edge* edge2 = DirectedGraph<Point2ID, double>::addEdge(node2, node1, cost);
+    RoadCost backward = forward;
+    backward.slope = -forward.slope;
+    Edge* edge1 = DirectedGraph<Point2ID, RoadCost, VectorStorage>::addEdge(node1, node2, forward);
+    Edge* edge2 = DirectedGraph<Point2ID, RoadCost, VectorStorage>::addEdge(node2, node1, backward);
     return (edge1 != nullptr) && (edge2 != nullptr);
 }
 
-RoadMap::Edge* RoadMap::addEdge(Node* from, Node* to, double cost /*= -1.0*/)
+RoadMap::Edge* RoadMap::addEdge(Node* from, Node* to, const RoadCost& cost)
 {
     if (from == nullptr || to == nullptr) return nullptr;
 
-    if (cost < 0)
+    if (cost.length < 0)
     {
         double dx = from->data.x - to->data.x;
         double dy = from->data.y - to->data.y;
-        cost = sqrt(dx * dx + dy * dy);
+        RoadCost assigned = cost;
+        assigned.length = sqrt(dx * dx + dy * dy);
+        return DirectedGraph<Point2ID, RoadCost, VectorStorage>::addEdge(from, to, assigned);
     }
-    return DirectedGraph<Point2ID, double>::addEdge(from, to, cost);
+    return DirectedGraph<Point2ID, RoadCost, VectorStorage>::addEdge(from, to, cost);
 }
 
 RoadMap::Edge* RoadMap::getEdge(ID from, ID to)
@@ -136,14 +554,48 @@ RoadMap::Edge* RoadMap::getEdge(Node* from, int edge_idx)
 
 bool RoadMap::copyTo(RoadMap* dest) const
 {
-    if (dest == nullptr) return false;
+    if (!DirectedGraph<Point2ID, RoadCost, VectorStorage>::copyTo(dest)) return false;
+    dest->m_profiles = m_profiles;
+    dest->m_profile = m_profile;
+    dest->m_next_slot = m_next_slot;
+    return true;
+}
 
-    dest->removeAll();
-    for (NodeItrConst node = getHeadNodeConst(); node != getTailNodeConst(); node++)
-        dest->addNode(node->data);
-    for (NodeItrConst from = getHeadNodeConst(); from != getTailNodeConst(); from++)
-        for (EdgeItrConst edge = getHeadEdgeConst(from); edge != getTailEdgeConst(from); edge++)
-            dest->addEdge(dest->getNode(from->data), dest->getNode(edge->to->data), edge->cost);
+bool RoadMap::setProfile(const RoadProfile& profile)
+{
+    // Reuse the cache slot of the same profile
+    for (size_t i = 0; i < m_profiles.size(); i++)
+    {
+        if (m_profiles[i] == profile)
+        {
+            m_profile = static_cast<int>(i);
+            return true;
+        }
+    }
+
+    // Add a new slot or replace the oldest slot except the current one
+    int slot = static_cast<int>(m_profiles.size());
+    if (slot < RoadCost::N_CACHES) m_profiles.push_back(profile);
+    else
+    {
+        slot = m_next_slot;
+        if (slot == m_profile) slot = (slot + 1) % RoadCost::N_CACHES;
+        m_next_slot = (slot + 1) % RoadCost::N_CACHES;
+        m_profiles[slot] = profile;
+        for (NodeItr node = getHeadNode(); node != getTailNode(); node++)
+            for (EdgeItr edge = getHeadEdge(node); edge != getTailEdge(node); edge++)
+                edge->cost.weights[slot] = std::numeric_limits<double>::quiet_NaN();
+    }
+    m_profile = slot;
+    return true;
+}
+
+bool RoadMap::setBlocked(ID from, ID to, bool blocked /*= true*/)
+{
+    Edge* edge = getEdge(from, to);
+    if (edge == nullptr) return false;
+    edge->cost.blocked = blocked;
+    edge->cost.invalidate();
     return true;
 }
 
@@ -3,16 +3,29 @@
 
 #include "core/basic_type.hpp"
 #include "localizer/directed_graph.hpp"
+#include "localizer/road_cost.hpp"
 #include "localizer/graph_painter.hpp"
-#include <map>
 
 namespace dg
 {
 
+/**
+ * @brief A hash function of Point2ID for DirectedGraph (consistent with its equality using only ID)
+ */
+template<>
+struct GraphHash<Point2ID>
+{
+    /** Calculate a hash value of the given data */
+    size_t operator()(const Point2ID& data) const { return std::hash<ID>()(data.id); }
+};
+
 /**
  * @brief Simple road map
  *
- * A <b>simple road map</b> is defined with its node as Point2ID and its edge with double-type cost.
+ * A <b>simple road map</b> is defined with its node as Point2ID and its edge with RoadCost.
+ * RoadCost keeps length, type, slope, and a blocking flag of each edge, and it is used as a scalar cost (its length) by default.
+ * Effective weights of edges for a query profile (e.g. RoadProfile::wheelchair()) are calculated lazily by getWeight(),
+ * and they are cached for each of the recently used profiles, so switching profiles does not rebuild the map.
  *
  * <b>File Format for RoadMap (CSV File)</b>
  *
@@ -30,14 +43,26 @@ namespace dg
  * When a road map needs to include a bi-directional road, the road map contains a pair of edges as follows.
  * - EDGE, 3, 4, 9.09
  * - EDGE, 4, 3, 9.09
+ * A CSV file is memory-mapped and parsed by multiple threads, so the order of nodes and edges in the file does not matter.
+ *
+ * <b>File Format for RoadMap (Binary File)</b>
+ *
+ * A binary file keeps exact values of coordinates and cost, and it is loaded much faster than a CSV file.
+ * All numbers are little-endian.
+ * - Header: magic ("DGROAD"), version, the size of the header, the number of nodes, and the number of edges (32 bytes)
+ * - Nodes: ID (64-bit integer), X, and Y (64-bit floating points) of each node
+ * - Edges: indices of the start and destination nodes (32-bit integers), length and slope (64-bit floating points), type (32-bit integer), and flags (32-bit integer; 1 if blocked) of each edge
+ * A CSV file keeps only length of edges as their cost.
+ *
+ * Its nodes and edges are stored in contiguous memory (VectorStorage) for fast traversal.
  */
-class RoadMap : public DirectedGraph<Point2ID, double>
+class RoadMap : public DirectedGraph<Point2ID, RoadCost, VectorStorage>
 {
 public:
     /**
      * The default constructor
      */
-    RoadMap() { }
+    RoadMap() : m_profiles(1), m_profile(0), m_next_slot(0) { }
 
     /**
      * The copy constructor
@@ -45,18 +70,31 @@ public:
     RoadMap(const RoadMap& graph) { graph.copyTo(this); }
 
     /**
-     * Read a map from the given file
+     * The move constructor (time complexity: O(1))
+     * @param graph The other map (empty after moving)
+     */
+    RoadMap(RoadMap&& graph) : DirectedGraph<Point2ID, RoadCost, VectorStorage>(std::move(graph)), m_profiles(std::move(graph.m_profiles)), m_profile(graph.m_profile), m_next_slot(graph.m_next_slot)
+    {
+        graph.m_profiles.assign(1, RoadProfile());
+        graph.m_profile = 0;
+        graph.m_next_slot = 0;
+    }
+
+    /**
+     * Read a map from the given file (a CSV or binary file distinguished by its content)
      * @param filename The filename to read a map
+     * @param n_threads The number of threads to parse a CSV file (default: 0, the number of hardware threads)
      * @return Result of success (true) or failure (false)
      */
-    bool load(const char* filename);
+    bool load(const char* filename, int n_threads = 0);
 
     /**
      * Write this map to the given file
      * @param filename The filename to write the map
+     * @param binary True to write a binary file (default: false, a CSV file)
      * @return Result of success (true) or failure (false)
      */
-    bool save(const char* filename);
+    bool save(const char* filename, bool binary = false);
 
     /**
      * Check whether this map is empty or not
@@ -64,36 +102,19 @@ public:
      */
     bool isEmpty() const { return (countNodes() <= 0); }
 
-    /**
-     * Add a node (time complexity: O(1))
-     * @param data Data to add
-     * @return A pointer to the added node
-     */
-    Node* addNode(const Point2ID& data)
-    {
-        Node* ptr = DirectedGraph<Point2ID, double>::addNode(data);
-        if (ptr != nullptr) m_node_lookup.insert(std::make_pair(data.id, ptr));
-        return ptr;
-    }
-
     /**
      * Find a node using its data (time complexity: O(1))
      * @param data Data to search
      * @return A pointer to the found node (nullptr if not exist)
      */
-    Node* getNode(const Point2ID& data) { return getNode(data.id); }
+    Node* getNode(const Point2ID& data) { return DirectedGraph<Point2ID, RoadCost, VectorStorage>::getNode(data); }
 
     /**
      * Find a node using its ID (time complexity: O(1))
      * @param id ID to search
      * @return A pointer to the found node (nullptr if not exist)
      */
-    Node* getNode(ID id)
-    {
-        auto found = m_node_lookup.find(id);
-        if (found == m_node_lookup.end()) return nullptr;
-        return found->second;
-    }
+    Node* getNode(ID id) { return DirectedGraph<Point2ID, RoadCost, VectorStorage>::getNode(Point2ID(id)); }
 
     /**
      * Add a directed edge between two nodes (time complexity: O(1))
@@ -104,7 +125,17 @@ public:
      * @return A pointer to the added edge
      * @see addRoad for adding a bi-directional edge
      */
-    Edge* addEdge(Node* from, Node* to, double cost = -1.0);
+    Edge* addEdge(Node* from, Node* to, double cost = -1.0) { return addEdge(from, to, RoadCost(cost)); }
+
+    /**
+     * Add a directed edge with its attributes between two nodes (time complexity: O(1))
+     * @param from A pointer to the start node
+     * @param to A pointer to the destination node
+     * @param cost Attributes of the edge<br>
+     *  If its length is given as a negative value, it is automatically assigned as Euclidean distance.
+     * @return A pointer to the added edge
+     */
+    Edge* addEdge(Node* from, Node* to, const RoadCost& cost);
 
     /**
      * Add a directed edge between two nodes (time complexity: O(1))
@@ -147,7 +178,17 @@ public:
      * @return True if successful (false if failed)
      * @see addEdge for adding a directional edge
      */
-    bool addRoad(Node* node1, Node* node2, double cost = -1.0);
+    bool addRoad(Node* node1, Node* node2, double cost = -1.0) { return addRoad(node1, node2, RoadCost(cost)); }
+
+    /**
+     * Add a bi-directional edge with its attributes between two nodes (time complexity: O(1))
+     * @param node1 A pointer to the first node
+     * @param node2 A pointer to the second node
+     * @param cost Attributes of the edge from the first to second nodes (the slope is reversed for the other direction)<br>
+     *  If its length is given as a negative value, it is automatically assigned as Euclidean distance.
+     * @return True if successful (false if failed)
+     */
+    bool addRoad(Node* node1, Node* node2, const RoadCost& cost);
 
     /**
      * Add a bi-directional edge between two nodes (time complexity: O(1))
@@ -208,34 +249,55 @@ public:
     Edge* getEdge(Node* from, int edge_idx);
 
     /**
-     * Remove a node (time complexity: O(|V| |E|))<br>
-     * This removes all edges connected from the node
-     * @param node A node pointer to remove
+     * Copy this to the other graph (time complexity: O(|N| + |E|))
+     * @param dest A pointer to the other graph
      * @return True if successful (false if failed)
      */
-    bool removeNode(Node* node)
-    {
-        if (node == nullptr) return false;
-        m_node_lookup.erase(node->data.id);
-        return DirectedGraph<Point2ID, double>::removeNode(node);
-    }
+    bool copyTo(RoadMap* dest) const;
 
     /**
-     * Remove all nodes and edges
+     * Select the query profile to calculate effective weights of edges<br>
+     * Weights are cached for RoadCost::N_CACHES profiles, so switching among them keeps the calculated weights.
+     * When a new profile is selected and all caches are used, the oldest profile is replaced (time complexity: O(|E|)).
+     * @param profile The query profile
      * @return True if successful (false if failed)
      */
-    bool removeAll()
+    bool setProfile(const RoadProfile& profile);
+
+    /**
+     * Get the current query profile
+     * @return The current query profile
+     */
+    const RoadProfile& getProfile() const { return m_profiles[m_profile]; }
+
+    /**
+     * Get the effective weight of the given edge with the current profile (time complexity: O(1))<br>
+     * The weight is calculated when it is requested for the first time, and it is cached in the edge.
+     * @param edge The given edge
+     * @return The effective weight (negative if impassable)
+     */
+    double getWeight(const Edge& edge) const
     {
-        m_node_lookup.clear();
-        return DirectedGraph<Point2ID, double>::removeAll();
+        double& weight = edge.cost.weights[m_profile];
+        if (std::isnan(weight)) weight = m_profiles[m_profile](edge.cost);
+        return weight;
     }
 
     /**
-     * Copy this to the other graph (time complexity: O(|N||E|))
-     * @param dest A pointer to the other graph
-     * @return True if successful (false if failed)
+     * Check whether the given edge is passable with the current profile (time complexity: O(1))
+     * @param edge The given edge
+     * @return True if passable (false if not)
      */
-    bool copyTo(RoadMap* dest) const;
+    bool isPassable(const Edge& edge) const { return getWeight(edge) >= 0; }
+
+    /**
+     * Block or unblock an edge using its connecting node IDs (time complexity: O(|E|) of the start node)
+     * @param from ID of the start node
+     * @param to ID of the destination node
+     * @param blocked True to block the edge (false to unblock)
+     * @return True if successful (false if the edge does not exist)
+     */
+    bool setBlocked(ID from, ID to, bool blocked = true);
 
     /**
      * Overriding the assignment operator
@@ -248,13 +310,60 @@ public:
         return *this;
     }
 
+    /**
+     * Overriding the move assignment operator
+     * @param rhs A directed graph in the right-hand side (empty after moving)
+     * @return This object
+     */
+    RoadMap& operator=(RoadMap&& rhs)
+    {
+        DirectedGraph<Point2ID, RoadCost, VectorStorage>::operator=(std::move(rhs));
+        m_profiles = std::move(rhs.m_profiles);
+        m_profile = rhs.m_profile;
+        m_next_slot = rhs.m_next_slot;
+        rhs.m_profiles.assign(1, RoadProfile());
+        rhs.m_profile = 0;
+        rhs.m_next_slot = 0;
+        return *this;
+    }
+
 protected:
-    /** A node lookup table whose key is 'ID' and value is the corresponding pointer to the node */
-    std::map<ID, Node*> m_node_lookup;
+    /**
+     * Read a map from the given CSV data (time complexity: O(|N| + |E|))
+     * @param data The CSV data
+     * @param size The size of the data (Unit: [byte])
+     * @param n_threads The number of threads to parse the data (0 for the number of hardware threads)
+     * @return Result of success (true) or failure (false)
+     */
+    bool loadCSV(const char* data, size_t size, int n_threads);
+
+    /**
+     * Read a map from the given binary data (time complexity: O(|N| + |E|))
+     * @param data The binary data
+     * @param size The size of the data (Unit: [byte])
+     * @return Result of success (true) or failure (false)
+     */
+    bool loadBinary(const char* data, size_t size);
+
+    /**
+     * Write this map to the given binary file (time complexity: O(|N| + |E|))
+     * @param filename The filename to write the map
+     * @return Result of success (true) or failure (false)
+     */
+    bool saveBinary(const char* filename);
+
+    /** Query profiles for each cache slot of RoadCost */
+    std::vector<RoadProfile> m_profiles;
+
+    /** The cache slot of the current profile */
+    int m_profile;
+
+    /** The cache slot to be replaced when a new profile is selected and all slots are used */
+    int m_next_slot;
 };
 
 /** A map visualizer for dg::RoadMap */
-typedef GraphPainter<Point2ID, double> SimpleRoadPainter;
+typedef GraphPainter<Point2ID, RoadCost, VectorStorage> SimpleRoadPainter;
 
 } // End of 'dg'
 
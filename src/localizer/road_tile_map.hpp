@@ -0,0 +1,338 @@
+#ifndef __ROAD_TILE_MAP__
+#define __ROAD_TILE_MAP__
+
+#include "localizer/road_map.hpp"
+#include <functional>
+#include <map>
+
+namespace dg
+{
+
+/**
+ * @brief A tile of RoadMap
+ *
+ * A <b>road tile</b> contains nodes within a geographic tile and edges which start from the nodes.
+ * Destinations of the edges can be in other tiles, and such border edges are connected when their neighbor tiles are loaded together.
+ */
+struct RoadTile
+{
+    /**
+     * @brief An edge of RoadTile, which refers its nodes with their IDs
+     */
+    struct EdgeInfo
+    {
+        /**
+         * A constructor with member initialization
+         * @param _from ID of the start node
+         * @param _to ID of the destination node
+         * @param _cost Attributes of the edge
+         */
+        EdgeInfo(ID _from = 0, ID _to = 0, const RoadCost& _cost = RoadCost()) : from(_from), to(_to), cost(_cost) { }
+
+        /** ID of the start node */
+        ID from;
+
+        /** ID of the destination node (possibly in other tiles) */
+        ID to;
+
+        /** Attributes of the edge (a negative length will be assigned as the Euclidean distance) */
+        RoadCost cost;
+    };
+
+    /**
+     * Remove all nodes and edges
+     */
+    void clear()
+    {
+        nodes.clear();
+        edges.clear();
+    }
+
+    /** Nodes within the tile */
+    std::vector<Point2ID> nodes;
+
+    /** Edges which start from the nodes (in the order of edges from each node) */
+    std::vector<EdgeInfo> edges;
+};
+
+/**
+ * @brief Tile-based RoadMap around a moving center
+ *
+ * A <b>road tile map</b> keeps a window of geographic tiles around the given center tile (e.g. the current pose),
+ * loads new tiles on demand using the given loader, and evicts tiles outside of the window.
+ * Loaded tiles are stitched into a single RoadMap, so its size is bounded by the window regardless of the whole covered area.
+ * The tile index, cv::Point2i, follows the convention of dg::MapManager::getMap(tile).
+ *
+ * Edges from a node are added in the order of the tile, so edge indices (e.g. TopometricPose::edge_idx) of nodes
+ * whose neighbor tiles are all loaded (e.g. nodes in the center tile) do not change even if the window moves.
+ * Border edges whose destinations are not loaded yet are skipped.
+ */
+class RoadTileMap
+{
+public:
+    /**
+     * A function to load a tile, which returns true if successful (false if failed)
+     */
+    typedef std::function<bool(const cv::Point2i& tile, RoadTile& data)> Loader;
+
+    /**
+     * @brief A comparator of tile indices (row-major order)
+     */
+    struct TileLess
+    {
+        bool operator()(const cv::Point2i& a, const cv::Point2i& b) const { return (a.y < b.y) || (a.y == b.y && a.x < b.x); }
+    };
+
+    /**
+     * A type of tiles indexed by their tile indices
+     */
+    typedef std::map<cv::Point2i, RoadTile, TileLess> Tiles;
+
+    /**
+     * The default constructor
+     */
+    RoadTileMap() : m_radius(1), m_has_center(false) { }
+
+    /**
+     * Assign a tile loader and remove all loaded tiles
+     * @param loader The tile loader (an empty function to disable tiles)
+     * @param radius The radius of the window in tiles (e.g. 1 for 3 x 3 tiles)
+     * @return True if successful (false if failed)
+     */
+    bool setLoader(const Loader& loader, int radius = 1)
+    {
+        if (radius < 0) return false;
+        m_loader = loader;
+        m_radius = radius;
+        clear();
+        return true;
+    }
+
+    /**
+     * Check whether a tile loader is assigned or not
+     * @return True if a loader is assigned (false if not)
+     */
+    bool isEnabled() const { return static_cast<bool>(m_loader); }
+
+    /**
+     * Get the tile loader
+     * @return The tile loader (an empty function if not assigned)
+     */
+    const Loader& getLoader() const { return m_loader; }
+
+    /**
+     * Remove all loaded tiles and the center (the loader is kept)
+     */
+    void clear()
+    {
+        m_tiles.clear();
+        m_has_center = false;
+    }
+
+    /**
+     * Move the window to the given center tile, load new tiles, evict tiles outside of the window, and stitch them into a map<br>
+     * The map is not modified if the center tile is same with the previous one.
+     * (time complexity: O(|V| + |E|) of the window if the center tile is changed)
+     * @param center The given center tile
+     * @param map The stitched map of the window (output)
+     * @return True if the map is updated (false if not changed or failed)
+     */
+    bool update(const cv::Point2i& center, RoadMap& map)
+    {
+        std::vector<cv::Point2i> missing;
+        if (!getMissingTiles(center, missing)) return false;
+
+        // Load new tiles (failed tiles are retried when the center is changed)
+        Tiles loaded = loadTiles(m_loader, missing);
+        return update(center, map, loaded);
+    }
+
+    /**
+     * Load the given tiles using the given loader, which does not access any tile map
+     * @param loader The tile loader
+     * @param indices Indices of tiles to load
+     * @return The loaded tiles (tiles failed to load are excluded)
+     */
+    static Tiles loadTiles(const Loader& loader, const std::vector<cv::Point2i>& indices)
+    {
+        Tiles loaded;
+        if (!loader) return loaded;
+        for (auto idx = indices.begin(); idx != indices.end(); idx++)
+        {
+            RoadTile tile;
+            if (loader(*idx, tile)) loaded[*idx] = std::move(tile);
+        }
+        return loaded;
+    }
+
+    /**
+     * Get tiles in the window of the given center tile which are not loaded yet<br>
+     * It is useful to load tiles without locking this tile map (e.g. on another thread), and the loaded tiles are given to update(center, map, loaded).
+     * @param center The given center tile
+     * @param missing Indices of tiles which are not loaded (output)
+     * @return True if the center tile is changed (false if not changed or no loader)
+     */
+    bool getMissingTiles(const cv::Point2i& center, std::vector<cv::Point2i>& missing) const
+    {
+        missing.clear();
+        if (!isEnabled()) return false;
+        if (m_has_center && center == m_center) return false;
+        for (int y = center.y - m_radius; y <= center.y + m_radius; y++)
+        {
+            for (int x = center.x - m_radius; x <= center.x + m_radius; x++)
+            {
+                cv::Point2i idx(x, y);
+                if (m_tiles.find(idx) == m_tiles.end()) missing.push_back(idx);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Move the window to the given center tile with tiles which are already loaded, evict tiles outside of the window, and stitch them into a map<br>
+     * The loader is not called, and tiles outside of the window are ignored. (time complexity: O(|V| + |E|) of the window if the center tile is changed)
+     * @param center The given center tile
+     * @param map The stitched map of the window (output)
+     * @param loaded The loaded tiles (e.g. tiles given by getMissingTiles(); moved into this tile map)
+     * @return True if the map is updated (false if not changed or failed)
+     */
+    bool update(const cv::Point2i& center, RoadMap& map, Tiles& loaded)
+    {
+        if (!isEnabled()) return false;
+        if (m_has_center && center == m_center) return false;
+
+        // Evict tiles outside of the window
+        for (auto tile = m_tiles.begin(); tile != m_tiles.end();)
+        {
+            if (abs(tile->first.x - center.x) > m_radius || abs(tile->first.y - center.y) > m_radius) tile = m_tiles.erase(tile);
+            else tile++;
+        }
+
+        // Add the loaded tiles in the window
+        for (auto tile = loaded.begin(); tile != loaded.end(); tile++)
+        {
+            if (abs(tile->first.x - center.x) > m_radius || abs(tile->first.y - center.y) > m_radius) continue;
+            if (m_tiles.find(tile->first) == m_tiles.end()) m_tiles[tile->first] = std::move(tile->second);
+        }
+        m_center = center;
+        m_has_center = true;
+
+        // Stitch the loaded tiles
+        RoadMap stitched;
+        if (!stitch(m_tiles, stitched)) return false;
+        map = std::move(stitched);
+        return true;
+    }
+
+    /**
+     * Get the current center tile
+     * @param center The current center tile (output)
+     * @return True if the center exists (false if no update yet)
+     */
+    bool getCenter(cv::Point2i& center) const
+    {
+        if (!m_has_center) return false;
+        center = m_center;
+        return true;
+    }
+
+    /**
+     * Get the loaded tiles
+     * @return The loaded tiles
+     */
+    const Tiles& getTiles() const { return m_tiles; }
+
+    /**
+     * Stitch the given tiles into a map (time complexity: O(|V| + |E|))
+     * @param tiles The given tiles
+     * @param map The stitched map (output)
+     * @return True if successful (false if failed)
+     */
+    static bool stitch(const Tiles& tiles, RoadMap& map)
+    {
+        map.removeAll();
+        size_t n_nodes = 0;
+        for (auto tile = tiles.begin(); tile != tiles.end(); tile++)
+            n_nodes += tile->second.nodes.size();
+        map.reserveNodes(n_nodes);
+
+        // Add all nodes first to connect border edges
+        for (auto tile = tiles.begin(); tile != tiles.end(); tile++)
+            for (auto node = tile->second.nodes.begin(); node != tile->second.nodes.end(); node++)
+                if (map.addNode(*node) == nullptr) goto STITCH_FAIL;
+
+        // Add edges whose destinations are loaded
+        for (auto tile = tiles.begin(); tile != tiles.end(); tile++)
+        {
+            for (auto edge = tile->second.edges.begin(); edge != tile->second.edges.end(); edge++)
+            {
+                RoadMap::Node* from = map.getNode(edge->from);
+                RoadMap::Node* to = map.getNode(edge->to);
+                if (from == nullptr) goto STITCH_FAIL;
+                if (to == nullptr) continue;
+                if (map.addEdge(from, to, edge->cost) == nullptr) goto STITCH_FAIL;
+            }
+        }
+        return true;
+
+    STITCH_FAIL:
+        map.removeAll();
+        return false;
+    }
+
+    /**
+     * Split the given map into tiles (time complexity: O(|V| + |E|))
+     * @param map The given map
+     * @param tile_of A function to get the tile index of a metric point
+     * @param tiles The split tiles (output)
+     * @return True if successful (false if failed)
+     */
+    static bool split(const RoadMap& map, const std::function<cv::Point2i(const Point2&)>& tile_of, Tiles& tiles)
+    {
+        tiles.clear();
+        if (!tile_of) return false;
+        for (auto from = map.getHeadNodeConst(); from != map.getTailNodeConst(); from++)
+        {
+            RoadTile& tile = tiles[tile_of(from->data)];
+            tile.nodes.push_back(from->data);
+            for (auto edge = map.getHeadEdgeConst(from); edge != map.getTailEdgeConst(from); edge++)
+                tile.edges.push_back(RoadTile::EdgeInfo(from->data.id, edge->to->data.id, edge->cost));
+        }
+        return true;
+    }
+
+    /**
+     * Convert a geodesic coordinate to its tile index in the Web Mercator tile system
+     * @param ll The given geodesic coordinate
+     * @param zoom The zoom level of tiles
+     * @return The tile index
+     */
+    static cv::Point2i cvtLatLon2Tile(const LatLon& ll, int zoom)
+    {
+        const double n = static_cast<double>(1 << zoom);
+        double lat_rad = ll.lat * CV_PI / 180;
+        int x = static_cast<int>(floor((ll.lon + 180) / 360 * n));
+        int y = static_cast<int>(floor((1 - log(tan(lat_rad) + 1 / cos(lat_rad)) / CV_PI) / 2 * n));
+        return cv::Point2i(x, y);
+    }
+
+protected:
+    /** The tile loader */
+    Loader m_loader;
+
+    /** The radius of the window in tiles */
+    int m_radius;
+
+    /** The loaded tiles */
+    Tiles m_tiles;
+
+    /** The current center tile */
+    cv::Point2i m_center;
+
+    /** A flag whether the center is assigned or not */
+    bool m_has_center;
+}; // End of 'RoadTileMap'
+
+} // End of 'dg'
+
+#endif // End of '__ROAD_TILE_MAP__'
@@ -0,0 +1,332 @@
+#ifndef __SEGMENT_KERNEL__
+#define __SEGMENT_KERNEL__
+
+#include "core/basic_type.hpp"
+#include "opencv2/opencv.hpp"
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SEGMENT_KERNEL_X86
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SEGMENT_KERNEL_SSE2 __attribute__((target("sse2")))
+#define SEGMENT_KERNEL_AVX2 __attribute__((target("avx2")))
+#else
+#define SEGMENT_KERNEL_SSE2
+#define SEGMENT_KERNEL_AVX2
+#endif
+#endif
+
+namespace dg
+{
+
+/**
+ * @brief Line segments stored as a structure of arrays (SoA)
+ *
+ * A <b>segment array</b> keeps the start point, the displacement, its squared length, and its heading of each line segment in separated contiguous arrays,
+ * so distances to many segments can be calculated with SIMD instructions.
+ */
+struct SegmentArray
+{
+    /**
+     * Add a line segment (time complexity: O(1))
+     * @param from The start point
+     * @param to The end point
+     */
+    void push_back(const Point2& from, const Point2& to)
+    {
+        double delta_x = to.x - from.x, delta_y = to.y - from.y;
+        x.push_back(from.x);
+        y.push_back(from.y);
+        dx.push_back(delta_x);
+        dy.push_back(delta_y);
+        l2.push_back(delta_x * delta_x + delta_y * delta_y);
+        heading.push_back(atan2(delta_y, delta_x));
+    }
+
+    /**
+     * Reserve memory for the given number of segments
+     * @param n The number of segments
+     */
+    void reserve(size_t n)
+    {
+        x.reserve(n);
+        y.reserve(n);
+        dx.reserve(n);
+        dy.reserve(n);
+        l2.reserve(n);
+        heading.reserve(n);
+    }
+
+    /**
+     * Remove all segments
+     */
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        dx.clear();
+        dy.clear();
+        l2.clear();
+        heading.clear();
+    }
+
+    /**
+     * Count the number of segments
+     * @return The number of segments
+     */
+    size_t size() const { return x.size(); }
+
+    /** X of the start points */
+    std::vector<double> x;
+
+    /** Y of the start points */
+    std::vector<double> y;
+
+    /** X of the displacements (the end point - the start point) */
+    std::vector<double> dx;
+
+    /** Y of the displacements (the end point - the start point) */
+    std::vector<double> dy;
+
+    /** Squared lengths */
+    std::vector<double> l2;
+
+    /** Headings of the displacements (Unit: [rad]) */
+    std::vector<double> heading;
+};
+
+/**
+ * @brief Batched distance calculation from a pose to line segments
+ *
+ * A <b>segment kernel</b> calculates the squared distance from a pose to each line segment with the heading penalty
+ * as like BaseLocalizer::calcDist2FromLineSeg, but for a block of segments at once.
+ * AVX2 (4 segments) and SSE2 (2 segments) versions are selected at runtime depending on the CPU, and the scalar version is used otherwise.
+ * All versions follow the same order of floating-point operations with calcDist2FromLineSeg, so their results are same.
+ */
+class SegmentKernel
+{
+public:
+    /**
+     * Types of kernels
+     */
+    enum
+    {
+        /** The scalar version */
+        KERNEL_SCALAR = 0,
+
+        /** The SSE2 version (2 segments at once) */
+        KERNEL_SSE2 = 1,
+
+        /** The AVX2 version (4 segments at once) */
+        KERNEL_AVX2 = 2
+    };
+
+    /**
+     * Get the best kernel supported by the CPU (detected once)
+     * @return The type of the best kernel
+     */
+    static int getBestKernel()
+    {
+        static const int best = detectKernel();
+        return best;
+    }
+
+    /**
+     * Check whether the given kernel is supported by the CPU or not
+     * @param kernel The type of kernel
+     * @return True if supported (false if not)
+     */
+    static bool isSupported(int kernel) { return kernel >= KERNEL_SCALAR && kernel <= getBestKernel(); }
+
+    /**
+     * Calculate squared distance from a pose to contiguous segments [begin, end)
+     * @param segs The given segments
+     * @param begin Index of the first segment
+     * @param end Index of the last segment + 1
+     * @param p The given pose
+     * @param turn_weight The weight of heading difference (0 to ignore heading)
+     * @param dist2 The squared distances with the heading penalty (output; size: end - begin)
+     * @param kernel The type of kernel (negative for the best kernel)
+     */
+    static void calcDist2(const SegmentArray& segs, size_t begin, size_t end, const Pose2& p, double turn_weight, double* dist2, int kernel = -1)
+    {
+        run(ContiguousLoader(begin), segs, end - begin, p, turn_weight, dist2, kernel);
+    }
+
+    /**
+     * Calculate squared distance from a pose to the given segments
+     * @param segs The given segments
+     * @param items Indices of the segments
+     * @param n The number of the segments
+     * @param p The given pose
+     * @param turn_weight The weight of heading difference (0 to ignore heading)
+     * @param dist2 The squared distances with the heading penalty (output; size: n)
+     * @param kernel The type of kernel (negative for the best kernel)
+     */
+    static void calcDist2Indexed(const SegmentArray& segs, const uint32_t* items, size_t n, const Pose2& p, double turn_weight, double* dist2, int kernel = -1)
+    {
+        run(IndexedLoader(items), segs, n, p, turn_weight, dist2, kernel);
+    }
+
+protected:
+    /**
+     * Detect the best kernel using OpenCV
+     */
+    static int detectKernel()
+    {
+#ifdef SEGMENT_KERNEL_X86
+        if (cv::checkHardwareSupport(CV_CPU_AVX2)) return KERNEL_AVX2;
+        if (cv::checkHardwareSupport(CV_CPU_SSE2)) return KERNEL_SSE2;
+#endif
+        return KERNEL_SCALAR;
+    }
+
+    /**
+     * A loader of contiguous segments
+     */
+    struct ContiguousLoader
+    {
+        ContiguousLoader(size_t _begin) : begin(_begin) { }
+        size_t index(size_t i) const { return begin + i; }
+#ifdef SEGMENT_KERNEL_X86
+        SEGMENT_KERNEL_SSE2 __m128d load2(const std::vector<double>& v, size_t i) const { return _mm_loadu_pd(&v[begin + i]); }
+        SEGMENT_KERNEL_AVX2 __m256d load4(const std::vector<double>& v, size_t i) const { return _mm256_loadu_pd(&v[begin + i]); }
+#endif
+        size_t begin;
+    };
+
+    /**
+     * A loader of indexed segments
+     */
+    struct IndexedLoader
+    {
+        IndexedLoader(const uint32_t* _items) : items(_items) { }
+        size_t index(size_t i) const { return items[i]; }
+#ifdef SEGMENT_KERNEL_X86
+        SEGMENT_KERNEL_SSE2 __m128d load2(const std::vector<double>& v, size_t i) const { return _mm_set_pd(v[items[i + 1]], v[items[i]]); }
+        SEGMENT_KERNEL_AVX2 __m256d load4(const std::vector<double>& v, size_t i) const
+        {
+            const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), v.data(), _mm_loadu_si128(reinterpret_cast<const __m128i*>(items + i)), all, 8);
+        }
+#endif
+        const uint32_t* items;
+    };
+
+    /**
+     * Dispatch the given kernel
+     */
+    template <typename Loader>
+    static void run(const Loader& loader, const SegmentArray& segs, size_t n, const Pose2& p, double turn_weight, double* dist2, int kernel)
+    {
+        if (kernel < 0 || !isSupported(kernel)) kernel = getBestKernel();
+        size_t i = 0;
+#ifdef SEGMENT_KERNEL_X86
+        if (kernel == KERNEL_AVX2) i = runAVX2(loader, segs, n, p, turn_weight, dist2);
+        else if (kernel == KERNEL_SSE2) i = runSSE2(loader, segs, n, p, turn_weight, dist2);
+#endif
+        for (; i < n; i++) dist2[i] = runScalar(segs, loader.index(i), p, turn_weight);
+    }
+
+    /**
+     * Calculate squared distance to a segment (the same with BaseLocalizer::calcDist2FromLineSeg)
+     */
+    static double runScalar(const SegmentArray& segs, size_t s, const Pose2& p, double turn_weight)
+    {
+        double px = p.x - segs.x[s], py = p.y - segs.y[s];
+        if (segs.l2[s] < DBL_EPSILON) return px * px + py * py;
+        double t = std::max(0., std::min(1., (px * segs.dx[s] + py * segs.dy[s]) / segs.l2[s]));
+        double qx = p.x - (segs.x[s] + t * segs.dx[s]), qy = p.y - (segs.y[s] + t * segs.dy[s]);
+        double d2 = qx * qx + qy * qy;
+        if (turn_weight > 0)
+        {
+            double dh = p.theta - segs.heading[s];
+            dh -= static_cast<int>(dh / (2 * CV_PI)) * (2 * CV_PI);
+            if (dh >= CV_PI) dh -= 2 * CV_PI;
+            if (dh < -CV_PI) dh += 2 * CV_PI;
+            d2 += turn_weight * dh * dh;
+        }
+        return d2;
+    }
+
+#ifdef SEGMENT_KERNEL_X86
+    /**
+     * Calculate squared distance to segments using SSE2 (2 segments at once)
+     * @return The number of processed segments
+     */
+    template <typename Loader>
+    SEGMENT_KERNEL_SSE2 static size_t runSSE2(const Loader& loader, const SegmentArray& segs, size_t n, const Pose2& p, double turn_weight, double* dist2)
+    {
+        const __m128d px = _mm_set1_pd(p.x), py = _mm_set1_pd(p.y), pt = _mm_set1_pd(p.theta), tw = _mm_set1_pd(turn_weight);
+        const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1), eps = _mm_set1_pd(DBL_EPSILON);
+        const __m128d pi = _mm_set1_pd(CV_PI), neg_pi = _mm_set1_pd(-CV_PI), two_pi = _mm_set1_pd(2 * CV_PI);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2)
+        {
+            __m128d x = loader.load2(segs.x, i), y = loader.load2(segs.y, i);
+            __m128d dx = loader.load2(segs.dx, i), dy = loader.load2(segs.dy, i), l2 = loader.load2(segs.l2, i);
+            __m128d wx = _mm_sub_pd(px, x), wy = _mm_sub_pd(py, y);
+            __m128d valid = _mm_cmpge_pd(l2, eps);
+            __m128d t = _mm_div_pd(_mm_add_pd(_mm_mul_pd(wx, dx), _mm_mul_pd(wy, dy)), l2);
+            t = _mm_and_pd(valid, _mm_max_pd(_mm_min_pd(t, one), zero));
+            __m128d qx = _mm_sub_pd(px, _mm_add_pd(x, _mm_mul_pd(t, dx)));
+            __m128d qy = _mm_sub_pd(py, _mm_add_pd(y, _mm_mul_pd(t, dy)));
+            __m128d d2 = _mm_add_pd(_mm_mul_pd(qx, qx), _mm_mul_pd(qy, qy));
+            if (turn_weight > 0)
+            {
+                __m128d dh = _mm_sub_pd(pt, loader.load2(segs.heading, i));
+                __m128d turns = _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_div_pd(dh, two_pi)));
+                dh = _mm_sub_pd(dh, _mm_mul_pd(turns, two_pi));
+                dh = _mm_sub_pd(dh, _mm_and_pd(_mm_cmpge_pd(dh, pi), two_pi));
+                dh = _mm_add_pd(dh, _mm_and_pd(_mm_cmplt_pd(dh, neg_pi), two_pi));
+                d2 = _mm_add_pd(d2, _mm_and_pd(valid, _mm_mul_pd(_mm_mul_pd(tw, dh), dh)));
+            }
+            _mm_storeu_pd(dist2 + i, d2);
+        }
+        return i;
+    }
+
+    /**
+     * Calculate squared distance to segments using AVX2 (4 segments at once)
+     * @return The number of processed segments
+     */
+    template <typename Loader>
+    SEGMENT_KERNEL_AVX2 static size_t runAVX2(const Loader& loader, const SegmentArray& segs, size_t n, const Pose2& p, double turn_weight, double* dist2)
+    {
+        const __m256d px = _mm256_set1_pd(p.x), py = _mm256_set1_pd(p.y), pt = _mm256_set1_pd(p.theta), tw = _mm256_set1_pd(turn_weight);
+        const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1), eps = _mm256_set1_pd(DBL_EPSILON);
+        const __m256d pi = _mm256_set1_pd(CV_PI), neg_pi = _mm256_set1_pd(-CV_PI), two_pi = _mm256_set1_pd(2 * CV_PI);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m256d x = loader.load4(segs.x, i), y = loader.load4(segs.y, i);
+            __m256d dx = loader.load4(segs.dx, i), dy = loader.load4(segs.dy, i), l2 = loader.load4(segs.l2, i);
+            __m256d wx = _mm256_sub_pd(px, x), wy = _mm256_sub_pd(py, y);
+            __m256d valid = _mm256_cmp_pd(l2, eps, _CMP_GE_OQ);
+            __m256d t = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(wx, dx), _mm256_mul_pd(wy, dy)), l2);
+            t = _mm256_and_pd(valid, _mm256_max_pd(_mm256_min_pd(t, one), zero));
+            __m256d qx = _mm256_sub_pd(px, _mm256_add_pd(x, _mm256_mul_pd(t, dx)));
+            __m256d qy = _mm256_sub_pd(py, _mm256_add_pd(y, _mm256_mul_pd(t, dy)));
+            __m256d d2 = _mm256_add_pd(_mm256_mul_pd(qx, qx), _mm256_mul_pd(qy, qy));
+            if (turn_weight > 0)
+            {
+                __m256d dh = _mm256_sub_pd(pt, loader.load4(segs.heading, i));
+                __m256d turns = _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(_mm256_div_pd(dh, two_pi)));
+                dh = _mm256_sub_pd(dh, _mm256_mul_pd(turns, two_pi));
+                dh = _mm256_sub_pd(dh, _mm256_and_pd(_mm256_cmp_pd(dh, pi, _CMP_GE_OQ), two_pi));
+                dh = _mm256_add_pd(dh, _mm256_and_pd(_mm256_cmp_pd(dh, neg_pi, _CMP_LT_OQ), two_pi));
+                d2 = _mm256_add_pd(d2, _mm256_and_pd(valid, _mm256_mul_pd(_mm256_mul_pd(tw, dh), dh)));
+            }
+            _mm256_storeu_pd(dist2 + i, d2);
+        }
+        return i;
+    }
+#endif
+}; // End of 'SegmentKernel'
+
+} // End of 'dg'
+
+#endif // End of '__SEGMENT_KERNEL__'
@@ -3,6 +3,19 @@
 namespace dg
 {
 
+/** The global state of libcurl, which is initialized at the first use and cleaned up at the exit of the process */
+struct CurlGlobal
+{
+	CurlGlobal() { ok = (curl_global_init(CURL_GLOBAL_ALL) == CURLE_OK); }
+	~CurlGlobal() { curl_global_cleanup(); }
+	bool ok;
+};
+
+bool MapManager::initCurl()
+{
+	static const CurlGlobal curl_global;	// Initialized only once even with multiple threads
+	return curl_global.ok;
+}
 
 bool MapManager::initialize()
 {
@@ -18,12 +31,13 @@ bool MapManager::initialize()
 
 		return false;
 	}	
+	m_poi_catalog.clearPOIs();
 	for (std::vector<POI>::iterator it = m_map->pois.begin(); it != m_map->pois.end(); ++it)
 	{
-		lookup_pois_name.insert(std::make_pair(it->name, LatLon(it->lat, it->lon)));
+		m_poi_catalog.addPOI(*it);
 		//lookup_pois_id.insert(std::make_pair(it->id, LatLon(it->lat, it->lon)));
 	}
-	m_map->pois.clear();
+	m_map->clearPOIs();
 
 	//std::vector<StreetView> sv_vec;
 	//ok = getStreetView(36.384063, 127.374733, 40000.0, sv_vec);	// Korea
@@ -38,7 +52,7 @@ bool MapManager::initialize()
 	//{
 	//	lookup_svs.insert(std::make_pair(it->id, LatLon(it->lat, it->lon)));
 	//}
-	//m_map->views.clear();
+	//m_map->clearViews();
 
 	return true;
 }
@@ -58,6 +72,18 @@ std::string MapManager::getIP()
 	return m_ip;
 }
 
+bool MapManager::setOffline(bool offline)
+{
+	m_offline = offline;
+
+	return true;
+}
+
+bool MapManager::isOffline()
+{
+	return m_offline;
+}
+
 //int MapManager::lat2tiley(double lat, int z)
 //{
 //	double latrad = lat * M_PI / 180.0;
@@ -93,18 +119,27 @@ size_t MapManager::write_callback(void* ptr, size_t size, size_t count, void* st
 	
 bool MapManager::query2server(std::string url)
 {
+	std::string response;
+	if (!query2server(url, response)) return false;
+	//fprintf(stdout, "%s\n", response.c_str());
+	m_json = response;
+	return true;
+}
+
+bool MapManager::query2server(const std::string& url, std::string& response)
+{
+	response.clear();
 #ifdef _WIN32
 	SetConsoleOutputCP(65001);
 #endif
 		
-	curl_global_init(CURL_GLOBAL_ALL);
+	if (!initCurl()) return false;
 	CURL* curl = curl_easy_init();
 	CURLcode res;
 
 	if (curl)
 	{
 		curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-		std::string response;
 		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
 		curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 		curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
@@ -114,7 +149,6 @@ bool MapManager::query2server(std::string url)
 
 		// Always cleanup.
 		curl_easy_cleanup(curl);
-		curl_global_cleanup();
 
 		// Check for errors.
 		if (res != CURLE_OK)
@@ -122,11 +156,6 @@ bool MapManager::query2server(std::string url)
 			fprintf(stderr, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
 			return false;
 		}
-		else
-		{
-			//fprintf(stdout, "%s\n", response.c_str());
-			m_json = response;
-		}
 	}
 
 	return true;
@@ -241,13 +270,29 @@ bool MapManager::downloadMap(ID node_id, double radius)
 
 bool MapManager::downloadMap(cv::Point2i tile)
 {
-	const std::string url_middle = ":21500/tile/";
-	std::string url = "http://" + m_ip + url_middle + std::to_string(tile.x) + "/" + std::to_string(tile.y);
+	return query2server(getMapTileURL(tile));
+}
 
-	return query2server(url);
+std::string MapManager::getMapTileURL(cv::Point2i tile) const
+{
+	const std::string url_middle = ":21500/tile/";
+	return "http://" + m_ip + url_middle + std::to_string(tile.x) + "/" + std::to_string(tile.y);
 }
 
 bool MapManager::parseMap(const char* json)
+{
+	m_map_index.clear();
+	m_path_finder.clear();
+	m_map_snapshot.clear();
+	if (!m_isMap)
+	{
+		m_map = new Map();
+		m_isMap = true;
+	}
+	return parseMap(json, *m_map, m_parse_arena);
+}
+
+bool MapManager::parseMap(const char* json, Map& map, MonotonicArena& arena)
 {
 	Document document;
 	document.Parse(json);
@@ -255,8 +300,16 @@ bool MapManager::parseMap(const char* json)
 	if(!document.IsObject()) return false;
 	const Value& features = document["features"];
 	if(!features.IsArray()) return false;
-
-	std::vector<EdgeTemp> temp_edge;
+	if (document.HasMember("version") && document["version"].IsUint64()) map.version = document["version"].GetUint64();
+
+	// Keep temporary data in the arena (a few large blocks instead of small allocations for each edge)
+	arena.release();
+	std::vector<Edge, ArenaAllocator<Edge>> temp_edge{ ArenaAllocator<Edge>(arena) };
+	temp_edge.reserve(features.Size());
+	LookupTable lookup_temp_edge;
+	lookup_temp_edge.reserve(features.Size());
+	size_t numNodes = 0;
+	size_t numLinks = 0;
 	for (SizeType i = 0; i < features.Size(); i++)
 	{
 		const Value& feature = features[i];
@@ -267,28 +320,23 @@ bool MapManager::parseMap(const char* json)
 		std::string name = properties["name"].GetString();
 		if (name == "edge") //continue; //TODO
 		{
-			EdgeTemp edge;
-			edge.id = properties["id"].GetUint64();
-			switch (properties["type"].GetInt())
-			{
-			/** Sidewalk */
-			case 0: edge.type = Edge::EDGE_SIDEWALK; break;
-			/** General road (e.g. roads shared by pedestrians and cars, street, alley, corridor, ...) */
-			case 1: edge.type = Edge::EDGE_ROAD; break;
-			/** Crosswalk */
-			case 2: edge.type = Edge::EDGE_CROSSWALK; break;
-			/** Elevator section */
-			case 3: edge.type = Edge::EDGE_ELEVATOR; break;
-			/** Escalator section */
-			case 4: edge.type = Edge::EDGE_ESCALATOR; break;
-			/** Stair section */
-			case 5: edge.type = Edge::EDGE_STAIR; break;
-			}
-			edge.length = properties["length"].GetDouble();
+			Edge edge;
+			if (!parseEdge(properties, edge)) return false;
+			lookup_temp_edge.insert(edge.id, temp_edge.size()); // The first one is used if duplicated
 			temp_edge.push_back(edge);
 		}
+		else if (name == "Node")
+		{
+			numNodes++;
+			numLinks += properties["edge_ids"].Size();
+		}
 	}
 
+	// Links between edges and their nodes (sorted by edges later)
+	std::vector<std::pair<size_t, ID>, ArenaAllocator<std::pair<size_t, ID>>> temp_link{ ArenaAllocator<std::pair<size_t, ID>>(arena) };
+	temp_link.reserve(numLinks);
+	map.reserve(map.nodes.size() + numNodes, map.edges.size(), map.pois.size(), map.views.size());
+
 	int numNonEdges = 0;
 	int numEdges = 0;
 	for (SizeType i = 0; i < features.Size(); i++)
@@ -302,62 +350,59 @@ bool MapManager::parseMap(const char* json)
 		if (name == "Node")
 		{
 			Node node;
-			node.id = properties["id"].GetUint64();
-			switch (properties["type"].GetInt())
-			{
-			/** Basic node */
-			case 0: node.type = Node::NODE_BASIC; break;
-			/** Junction node (e.g. intersecting point, corner point, and end point of the road) */
-			case 1: node.type = Node::NODE_JUNCTION; break;
-			/** Door node (e.g. exit and entrance) */
-			case 2: node.type = Node::NODE_DOOR; break;
-			/** Elevator node */
-			case 3: node.type = Node::NODE_ELEVATOR; break;
-			/** Escalator node */
-			case 4: node.type = Node::NODE_ESCALATOR; break;
-			}
-			node.floor = properties["floor"].GetInt();
-
-			// swapped lat and lon
-			if ((properties["latitude"].GetDouble()) > (properties["longitude"].GetDouble()))
-			{
-				node.lon = properties["latitude"].GetDouble();
-				node.lat = properties["longitude"].GetDouble();
-			}
-			else
-			{
-				node.lat = properties["latitude"].GetDouble();
-				node.lon = properties["longitude"].GetDouble();
-			}
+			if (!parseNode(properties, node)) return false;
 
 			const Value& edge_ids = properties["edge_ids"];
 
+			size_t degree = 0;
 			for (Value::ConstValueIterator edge_id = edge_ids.Begin(); edge_id != edge_ids.End(); ++edge_id)
 			{
-				ID id = edge_id->GetUint64();
-				std::vector<EdgeTemp>::iterator itr = std::find_if(temp_edge.begin(), temp_edge.end(), [id](EdgeTemp e) -> bool { return e.id == id; });
-				if (itr != temp_edge.end())
-					itr->node_ids.push_back(node.id);
+				size_t edge_idx = lookup_temp_edge.find(edge_id->GetUint64());
+				if (edge_idx != LookupTable::npos)
+				{
+					temp_link.push_back(std::make_pair(edge_idx, node.id));
+					degree++;
+				}
 				//#ifdef _DEBUG
 				//				else
 				//					fprintf(stdout, "%d %s\n", ++numNonEdges, "<=======================the number of the edge_ids without edgeinfo"); // the number of the edge_ids without edgeinfo
 				//#endif
 			}
-			m_map->addNode(node);
+
+			// Reserve adjacency of the node with its degree (usually filled without reallocation)
+			node.edge_ids.reserve(degree);
+			node.edge_idxs.reserve(degree);
+			node.adj_node_idxs.reserve(degree);
+			map.addNode(std::move(node));
 			//#ifdef _DEBUG
 			//			fprintf(stdout, "%d\n", i + 1); // the number of nodes
 			//#endif
 		}
 	}
 
-	for (std::vector<EdgeTemp>::iterator it = temp_edge.begin(); it < temp_edge.end(); it++)
+	// Group the links by edges (counting sort which keeps the order of nodes)
+	std::vector<size_t, ArenaAllocator<size_t>> link_offsets(temp_edge.size() + 1, 0, ArenaAllocator<size_t>(arena));
+	for (auto link = temp_link.begin(); link != temp_link.end(); link++) link_offsets[link->first + 1]++;
+	size_t numMapEdges = 0;
+	for (size_t e = 0; e < temp_edge.size(); e++)
 	{
-		for (auto i = (it->node_ids).begin(); i < (it->node_ids).end(); i++)
+		size_t n = link_offsets[e + 1];
+		numMapEdges += n * (n - std::min<size_t>(n, 1)) / 2;
+		link_offsets[e + 1] += link_offsets[e];
+	}
+	std::vector<ID, ArenaAllocator<ID>> link_nodes(temp_link.size(), 0, ArenaAllocator<ID>(arena));
+	std::vector<size_t, ArenaAllocator<size_t>> link_cursors(link_offsets.begin(), link_offsets.end() - 1, ArenaAllocator<size_t>(arena));
+	for (auto link = temp_link.begin(); link != temp_link.end(); link++) link_nodes[link_cursors[link->first]++] = link->second;
+	map.reserve(map.nodes.size(), map.edges.size() + numMapEdges, map.pois.size(), map.views.size());
+
+	for (size_t e = 0; e < temp_edge.size(); e++)
+	{
+		const Edge& edge = temp_edge[e];
+		for (size_t i = link_offsets[e]; i < link_offsets[e + 1]; i++)
 		{
-			for (auto j = i; j < it->node_ids.end(); j++)
+			for (size_t j = i + 1; j < link_offsets[e + 1]; j++)
 			{
-				if (i == j) continue;
-				m_map->addEdge(*i, *j, Edge(it->id, it->length, it->type));
+				map.addEdge(link_nodes[i], link_nodes[j], Edge(edge.id, edge.length, edge.type));
 				//m_map.addEdge(*j, *i, Edge(it->id, it->length, it->type));
 //#ifdef _DEBUG
 //					fprintf(stdout, "%d %s\n", ++numEdges, "<=======================the number of edges"); // the number of edges
@@ -368,6 +413,188 @@ bool MapManager::parseMap(const char* json)
 
 	return true;
 }
+
+bool MapManager::parseNode(const Value& properties, Node& node)
+{
+	if (!properties.IsObject() || !properties.HasMember("id")) return false;
+	node.id = properties["id"].GetUint64();
+	switch (properties["type"].GetInt())
+	{
+	/** Basic node */
+	case 0: node.type = Node::NODE_BASIC; break;
+	/** Junction node (e.g. intersecting point, corner point, and end point of the road) */
+	case 1: node.type = Node::NODE_JUNCTION; break;
+	/** Door node (e.g. exit and entrance) */
+	case 2: node.type = Node::NODE_DOOR; break;
+	/** Elevator node */
+	case 3: node.type = Node::NODE_ELEVATOR; break;
+	/** Escalator node */
+	case 4: node.type = Node::NODE_ESCALATOR; break;
+	}
+	node.floor = properties["floor"].GetInt();
+
+	// swapped lat and lon
+	if ((properties["latitude"].GetDouble()) > (properties["longitude"].GetDouble()))
+	{
+		node.lon = properties["latitude"].GetDouble();
+		node.lat = properties["longitude"].GetDouble();
+	}
+	else
+	{
+		node.lat = properties["latitude"].GetDouble();
+		node.lon = properties["longitude"].GetDouble();
+	}
+
+	return true;
+}
+
+bool MapManager::parseEdge(const Value& properties, Edge& edge)
+{
+	if (!properties.IsObject() || !properties.HasMember("id")) return false;
+	edge.id = properties["id"].GetUint64();
+	switch (properties["type"].GetInt())
+	{
+	/** Sidewalk */
+	case 0: edge.type = Edge::EDGE_SIDEWALK; break;
+	/** General road (e.g. roads shared by pedestrians and cars, street, alley, corridor, ...) */
+	case 1: edge.type = Edge::EDGE_ROAD; break;
+	/** Crosswalk */
+	case 2: edge.type = Edge::EDGE_CROSSWALK; break;
+	/** Elevator section */
+	case 3: edge.type = Edge::EDGE_ELEVATOR; break;
+	/** Escalator section */
+	case 4: edge.type = Edge::EDGE_ESCALATOR; break;
+	/** Stair section */
+	case 5: edge.type = Edge::EDGE_STAIR; break;
+	}
+	edge.length = properties["length"].GetDouble();
+
+	return true;
+}
+
+bool MapManager::downloadMapPatch(uint64_t version, double lat, double lon, double radius)
+{
+	const std::string url_middle = ":21500/patch/";
+	std::string url = "http://" + m_ip + url_middle + std::to_string(version) + "/" + std::to_string(lat) + "/" + std::to_string(lon) + "/" + std::to_string(radius);
+
+	return query2server(url);
+}
+
+bool MapManager::parseMapPatch(const char* json, MapPatch& patch)
+{
+	Document document;
+	document.Parse(json);
+
+	if (!document.IsObject()) return false;
+	if (!document.HasMember("base_version") || !document.HasMember("version")) return false;
+	patch = MapPatch();
+	patch.base_version = document["base_version"].GetUint64();
+	patch.version = document["version"].GetUint64();
+
+	const char* kinds[] = { "nodes", "edges", "pois", "streetviews" };
+	for (int k = 0; k < 4; k++)
+	{
+		if (!document.HasMember(kinds[k])) continue;
+		const Value& changes = document[kinds[k]];
+		if (!changes.IsObject()) return false;
+
+		// Parse the added and modified features
+		const char* types[] = { "added", "modified" };
+		for (int t = 0; t < 2; t++)
+		{
+			if (!changes.HasMember(types[t])) continue;
+			const Value& features = changes[types[t]];
+			if (!features.IsArray()) return false;
+			for (SizeType i = 0; i < features.Size(); i++)
+			{
+				const Value& feature = features[i];
+				if (!feature.IsObject() || !feature.HasMember("properties")) return false;
+				const Value& properties = feature["properties"];
+				if (k == 0)
+				{
+					Node node;
+					if (!parseNode(properties, node)) return false;
+					(t == 0 ? patch.nodes.added : patch.nodes.modified).push_back(node);
+				}
+				else if (k == 1)
+				{
+					Edge edge;
+					if (!parseEdge(properties, edge)) return false;
+					if (!properties.HasMember("node_ids") || !properties["node_ids"].IsArray() || properties["node_ids"].Size() != 2) return false;
+					edge.node_id1 = properties["node_ids"][0].GetUint64();
+					edge.node_id2 = properties["node_ids"][1].GetUint64();
+					(t == 0 ? patch.edges.added : patch.edges.modified).push_back(edge);
+				}
+				else if (k == 2)
+				{
+					POI poi;
+					if (!parsePOI(properties, poi)) return false;
+					(t == 0 ? patch.pois.added : patch.pois.modified).push_back(poi);
+				}
+				else
+				{
+					StreetView sv;
+					if (!parseStreetView(properties, sv)) return false;
+					(t == 0 ? patch.views.added : patch.views.modified).push_back(sv);
+				}
+			}
+		}
+
+		// Parse IDs of the removed elements
+		if (changes.HasMember("removed"))
+		{
+			const Value& ids = changes["removed"];
+			if (!ids.IsArray()) return false;
+			std::vector<ID>& removed = (k == 0) ? patch.nodes.removed : (k == 1) ? patch.edges.removed : (k == 2) ? patch.pois.removed : patch.views.removed;
+			for (SizeType i = 0; i < ids.Size(); i++)
+				removed.push_back(ids[i].IsString() ? std::strtoull(ids[i].GetString(), nullptr, 0) : ids[i].GetUint64());
+		}
+	}
+
+	return true;
+}
+
+bool MapManager::updateMap(double lat, double lon, double radius)
+{
+	if (!m_isMap) return false;
+	m_json = "";
+
+	// by communication
+	bool ok = downloadMapPatch(m_map->version, lat, lon, radius);
+	if (!ok) return false;
+	MapPatch patch;
+	ok = parseMapPatch(m_json.c_str(), patch);
+	if (!ok) return false;
+
+	ok = m_map->applyPatch(patch);
+	if (!ok) return false;
+	if (!patch.empty())
+	{
+		m_map_index.clear();
+		m_path_finder.clear();
+		m_map_snapshot.clear();
+	}
+	if (!patch.pois.empty()) return updatePOICatalog(patch);
+
+	return true;
+}
+
+bool MapManager::updatePOICatalog(const MapPatch& patch)
+{
+	MapPatch poi_patch;
+	poi_patch.base_version = m_poi_catalog.version;
+	poi_patch.version = m_poi_catalog.version;
+	for (auto id = patch.pois.removed.begin(); id != patch.pois.removed.end(); id++)
+		if (m_poi_catalog.findPOI(*id) != nullptr) poi_patch.pois.removed.push_back(*id);
+	for (int t = 0; t < 2; t++)
+	{
+		const std::vector<POI>& changed = (t == 0) ? patch.pois.added : patch.pois.modified;
+		for (auto poi = changed.begin(); poi != changed.end(); poi++)
+			(m_poi_catalog.findPOI(poi->id) == nullptr ? poi_patch.pois.added : poi_patch.pois.modified).push_back(*poi);
+	}
+
+	return m_poi_catalog.applyPatch(poi_patch);
+}
 //
 //bool MapManager::loadMap(double lat, double lon, double radius)
 //{
@@ -395,11 +622,36 @@ bool MapManager::parseMap(const char* json)
 //	return parseMap(json);
 //}
 
-Map& MapManager::getMap()
+const Map& MapManager::getMap() const
 {
 	return *m_map;
 }
 
+Map& MapManager::editMap()
+{
+	// The returned reference can modify the map, so derived data are regarded as out of date
+	m_map->touch();
+	return *m_map;
+}
+
+MapSnapshot MapManager::getMapSnapshot()
+{
+	if (!m_isMap) return MapSnapshot();
+	MapSnapshot snapshot = m_map_snapshot.get();
+	if (!snapshot || snapshot->getRevision() != m_map->getRevision())
+	{
+		snapshot = std::make_shared<const Map>(*m_map);
+		m_map_snapshot.set(snapshot);
+	}
+
+	return snapshot;
+}
+
+const SharedMap& MapManager::getSharedMap() const
+{
+	return m_map_snapshot;
+}
+
 bool MapManager::getMap(double lat, double lon, double radius, Map& map)
 {
 	if (m_isMap)
@@ -426,11 +678,44 @@ bool MapManager::getMap(double lat, double lon, double radius, Map& map)
 
 	ok = parseMap(json);
 	if (!ok) return false;
-	map = getMap();
+	map = *m_map;
+
+	return true;
+}
+
+bool MapManager::getMap(const char* filename, Map& map)
+{
+	if (m_isMap)
+	{
+		delete m_map;
+		m_isMap = false;
+	}
+	m_map = new Map();
+	m_isMap = true;
+	m_json = "";
+
+	m_map_index.clear();
+	m_path_finder.clear();
+	m_map_snapshot.clear();
+
+	// by memory-mapped file
+	MapFile file;
+	if (!file.open(filename)) return false;
+	bool ok = file.toMap(*m_map);
+	if (!ok) return false;
+	MapFile::loadOverlay(filename, *m_map, m_hierarchy); // Optional (built at saveMap() if not exist)
+	map = *m_map;
 
 	return true;
 }
 
+bool MapManager::saveMap(const char* filename)
+{
+	if (!m_isMap) return false;
+	if (!m_hierarchy.isBuilt(*m_map) && !m_hierarchy.build(*m_map)) return MapFile::save(filename, *m_map);
+	return MapFile::save(filename, *m_map, m_hierarchy);
+}
+
 bool MapManager::getMap(ID node_id, double radius, Map& map)
 {
 	if (m_isMap)
@@ -457,7 +742,7 @@ bool MapManager::getMap(ID node_id, double radius, Map& map)
 
 	ok = parseMap(json);
 	if (!ok) return false;
-	map = getMap();
+	map = *m_map;
 
 	return true;
 }
@@ -488,11 +773,21 @@ bool MapManager::getMap(cv::Point2i tile, Map& map)
 
 	ok = parseMap(json);
 	if (!ok) return false;
-	map = getMap();
+	map = *m_map;
 
 	return true;
 }
 
+bool MapManager::loadMapTile(cv::Point2i tile, Map& map) const
+{
+	// Parse into the given map with its own buffers, so it can be called while other threads use this manager
+	std::string json;
+	if (!query2server(getMapTileURL(tile), json) || json.empty()) return false;
+	MonotonicArena arena;
+	map = Map();
+	return parseMap(json.c_str(), map, arena);
+}
+
 bool MapManager::getMap(Path path, Map& map, double alpha)
 {
 	/*double lat = 36.38;
@@ -559,7 +854,7 @@ bool MapManager::getMap(Path path, Map& map, double alpha)
 	ok = parseMap(json);
 	if (!ok) return false;
 
-	map = getMap();
+	map = *m_map;
 
 	return true;
 }
@@ -652,7 +947,7 @@ bool MapManager::getMap_expansion(Path path, Map& map, double alpha)
 	ok = parseMap(json);
 	if (!ok) return false;
 
-	map = getMap();
+	map = *m_map;
 
 	return true;
 }
@@ -660,35 +955,32 @@ bool MapManager::getMap_expansion(Path path, Map& map, double alpha)
 std::vector<Node> MapManager::getMap_junction(LatLon cur_latlon, int top_n)
 {
 	std::vector<Node> node_vec;
+	if (top_n <= 0) return node_vec;
 
 	UTMConverter utm_conv;
 	Point2 cur_metric = utm_conv.toMetric(cur_latlon);
-	Point2 node_metric;
-	double dist_metric;
-	/** A hash table for finding junction nodes by distance */
-	std::map<double, Node> lookup_junc_dist;
+	const MapSpatialIndex& index = getMapIndex();
+	std::vector<size_t> found;
+	const std::vector<Node>& nodes = m_map->nodes;
+	index.nodes.queryNearest(cur_metric, top_n, found, [&nodes](size_t i) { return nodes[i].type == Node::NODE_JUNCTION; });
 
-	for (std::vector<Node>::iterator it = m_map->nodes.begin(); it != m_map->nodes.end(); ++it)
+	for (std::vector<size_t>::iterator it = found.begin(); it != found.end(); ++it)
 	{
-		if(it->type == Node::NODE_JUNCTION)
-		{
-			node_metric = utm_conv.toMetric(LatLon(it->lat, it->lon));
-			dist_metric = sqrt(pow((cur_metric.x - node_metric.x), 2) + pow((cur_metric.y - node_metric.y), 2));
-			lookup_junc_dist.insert(std::make_pair(dist_metric, *it));
-		}
+		node_vec.push_back(nodes[*it]);
 	}
-	
-	int num = 0;
-	for (std::map<double, Node>::iterator it = lookup_junc_dist.begin(); it != lookup_junc_dist.end(); ++it)
-	{
-		if (num >= top_n)
-			break;		
-		num++;
 
-		node_vec.push_back(it->second);
+	return node_vec;
+}
+
+const MapSpatialIndex& MapManager::getMapIndex()
+{
+	if (!m_map_index.isBuilt(*m_map))
+	{
+		UTMConverter utm_conv;
+		m_map_index.build(*m_map, utm_conv);
 	}
 
-	return node_vec;
+	return m_map_index;
 }
 
 bool MapManager::downloadPath(double start_lat, double start_lon, double dest_lat, double dest_lon, int num_paths)
@@ -931,6 +1223,8 @@ Path MapManager::getPath()
 
 bool MapManager::getPath(double start_lat, double start_lon, double dest_lat, double dest_lon, Path& path, int num_paths)
 {
+	if (m_offline) return findPath(start_lat, start_lon, dest_lat, dest_lon, path);
+
 	bool ok = generatePath(start_lat, start_lon, dest_lat, dest_lon, num_paths);
 	if (!ok) return false;
 
@@ -939,8 +1233,75 @@ bool MapManager::getPath(double start_lat, double start_lon, double dest_lat, do
 	return true;
 }
 
+bool MapManager::findPath(double start_lat, double start_lon, double dest_lat, double dest_lon, Path& path)
+{
+	ID start_id, dest_id;
+	if (!findEndNodes(start_lat, start_lon, dest_lat, dest_lon, start_id, dest_id)) return false;
+
+	m_path.pts.clear();
+	lookup_path.clear();
+	bool ok = false;
+	if (m_hierarchy.isBuilt(*m_map)) ok = m_hierarchy.findPath(start_id, dest_id, path);
+	else
+	{
+		if (!m_path_finder.isBuilt(*m_map) && !m_path_finder.build(*m_map)) return false;
+		ok = m_path_finder.findPath(start_id, dest_id, path);
+	}
+	if (!ok) return false;
+	setPath(path);
+
+	return true;
+}
+
+bool MapManager::findPaths(double start_lat, double start_lon, double dest_lat, double dest_lon, std::vector<Path>& paths, int num_paths, double max_overlap)
+{
+	paths.clear();
+	ID start_id, dest_id;
+	if (!findEndNodes(start_lat, start_lon, dest_lat, dest_lon, start_id, dest_id)) return false;
+	if (!m_path_finder.isBuilt(*m_map))
+	{
+		if (!m_path_finder.build(*m_map)) return false;
+	}
+
+	m_path.pts.clear();
+	lookup_path.clear();
+	bool ok = m_path_finder.findPaths(start_id, dest_id, num_paths, paths, max_overlap);
+	if (!ok) return false;
+	setPath(paths.front());
+
+	return true;
+}
+
+bool MapManager::findEndNodes(double start_lat, double start_lon, double dest_lat, double dest_lon, ID& start_id, ID& dest_id)
+{
+	if (m_map == nullptr || m_map->nodes.empty()) return false;
+
+	UTMConverter utm_conv;
+	const MapSpatialIndex& index = getMapIndex();
+	std::vector<size_t> start_found, dest_found;
+	if (index.nodes.queryNearest(utm_conv.toMetric(LatLon(start_lat, start_lon)), 1, start_found) < 1) return false;
+	if (index.nodes.queryNearest(utm_conv.toMetric(LatLon(dest_lat, dest_lon)), 1, dest_found) < 1) return false;
+	start_id = m_map->nodes[start_found.front()].id;
+	dest_id = m_map->nodes[dest_found.front()].id;
+
+	return true;
+}
+
+void MapManager::setPath(const Path& path)
+{
+	m_path = path;
+	lookup_path.clear();
+	for (std::vector<PathElement>::const_iterator it = m_path.pts.begin(); it != m_path.pts.end(); ++it)
+	{
+		const Node* node = m_map->findNode(it->node_id);
+		if (node != nullptr) lookup_path.insert(std::make_pair(node->id, LatLon(node->lat, node->lon)));
+	}
+}
+
 bool MapManager::getPath_expansion(double start_lat, double start_lon, double dest_lat, double dest_lon, Path& path, int num_paths)
 {
+	if (m_offline) return getPath(start_lat, start_lon, dest_lat, dest_lon, path, num_paths);
+
 	bool ok = generatePath_expansion(start_lat, start_lon, dest_lat, dest_lon, num_paths);
 	if (!ok) return false;
 
@@ -1014,6 +1375,9 @@ bool MapManager::downloadPOI_poi(ID poi_id, double radius)
 
 bool MapManager::parsePOI(const char* json)
 {
+	m_map_index.clear();
+	m_path_finder.clear();
+	m_map_snapshot.clear();
 	Document document;
 	document.Parse(json);
 
@@ -1029,12 +1393,7 @@ bool MapManager::parsePOI(const char* json)
 		const Value& properties = feature["properties"];
 		if(!properties.IsObject()) return false;
 		POI poi;
-		poi.id = properties["id"].GetUint64();
-		const char* utf8 = properties["name"].GetString();
-		utf8to16(utf8, poi.name);
-		poi.floor = properties["floor"].GetInt();
-		poi.lat = properties["latitude"].GetDouble();
-		poi.lon = properties["longitude"].GetDouble();
+		if (!parsePOI(properties, poi)) return false;
 
 		m_map->addPOI(poi);
 	}
@@ -1042,6 +1401,21 @@ bool MapManager::parsePOI(const char* json)
 	return true;
 }
 
+bool MapManager::parsePOI(const Value& properties, POI& poi)
+{
+	if (!properties.IsObject() || !properties.HasMember("id")) return false;
+	poi.id = properties["id"].GetUint64();
+	const char* utf8 = properties["name"].GetString();
+	std::wstring name;
+	utf8to16(utf8, name);
+	poi.name = name;
+	poi.floor = properties["floor"].GetInt();
+	poi.lat = properties["latitude"].GetDouble();
+	poi.lon = properties["longitude"].GetDouble();
+
+	return true;
+}
+
 std::vector<POI>& MapManager::getPOI()
 {
 	return m_map->pois;
@@ -1049,7 +1423,7 @@ std::vector<POI>& MapManager::getPOI()
 
 bool MapManager::getPOI(double lat, double lon, double radius, std::vector<POI>& poi_vec)
 {
-	m_map->pois.clear();
+	m_map->clearPOIs();
 	m_json = "";
 
 	// by communication
@@ -1068,7 +1442,7 @@ bool MapManager::getPOI(double lat, double lon, double radius, std::vector<POI>&
 	bool ok = parsePOI(json);
 	if (!ok)
 	{
-		m_map->pois.clear();
+		m_map->clearPOIs();
 
 		return false;
 	}
@@ -1080,7 +1454,7 @@ bool MapManager::getPOI(double lat, double lon, double radius, std::vector<POI>&
 
  bool MapManager::getPOI(ID node_id, double radius, std::vector<POI>& poi_vec)
 {
-	m_map->pois.clear();
+	m_map->clearPOIs();
 	m_json = "";
 
 	// by communication
@@ -1099,7 +1473,7 @@ bool MapManager::getPOI(double lat, double lon, double radius, std::vector<POI>&
 	bool ok = parsePOI(json);
 	if (!ok)
 	{
-		m_map->pois.clear();
+		m_map->clearPOIs();
 
 		return false;
 	}
@@ -1111,7 +1485,7 @@ bool MapManager::getPOI(double lat, double lon, double radius, std::vector<POI>&
 
 bool MapManager::getPOI(cv::Point2i tile, std::vector<POI>& poi_vec)
 {
-	m_map->pois.clear();
+	m_map->clearPOIs();
 	m_json = "";
 
 	// by communication
@@ -1130,7 +1504,7 @@ bool MapManager::getPOI(cv::Point2i tile, std::vector<POI>& poi_vec)
 	bool ok = parsePOI(json);
 	if (!ok)
 	{
-		m_map->pois.clear();
+		m_map->clearPOIs();
 
 		return false;
 	}
@@ -1168,7 +1542,7 @@ bool MapManager::getPOI(cv::Point2i tile, std::vector<POI>& poi_vec)
 //}
 std::vector<POI> MapManager::getPOI(ID poi_id, double radius)
 {
-	m_map->pois.clear();
+	m_map->clearPOIs();
 	m_json = "";
 
 	// by communication
@@ -1187,7 +1561,7 @@ std::vector<POI> MapManager::getPOI(ID poi_id, double radius)
 	bool ok = parsePOI(json);
 	if (!ok)
 	{
-		m_map->pois.clear();
+		m_map->clearPOIs();
 
 		return std::vector<POI>();
 	}
@@ -1204,11 +1578,12 @@ std::vector<POI> MapManager::getPOI(const std::string poi_name, LatLon latlon, d
 	poi_vec.clear();
 	std::wstring name;
 	utf8to16(poi_name.c_str(), name);
-	for (std::vector<POI>::iterator it = m_map->pois.begin(); it != m_map->pois.end(); ++it)
-	{		
-		if (it->name == name)
-			poi_vec.push_back(*it);
-	}	
+	std::vector<size_t> found;
+	m_map->findPOIs(name, found);
+	for (std::vector<size_t>::iterator it = found.begin(); it != found.end(); ++it)
+	{
+		poi_vec.push_back(m_map->pois[*it]);
+	}
 
 	return poi_vec;
 }
@@ -1225,24 +1600,19 @@ std::vector<POI> MapManager::getPOI_sorting(const std::string poi_name, LatLon l
 
 	UTMConverter utm_conv;
 	Point2 cur_metric = utm_conv.toMetric(cur_latlon);
-	Point2 poi_metric;
-	double dist_metric;
-	/** A hash table for finding POIs by distance */
-	std::map<double, POI> lookup_pois_dist;
-	
-	for (std::vector<POI>::iterator it = m_map->pois.begin(); it != m_map->pois.end(); ++it)
+	const MapSpatialIndex& index = getMapIndex();
+	std::vector<size_t> found;
+	m_map->findPOIs(name, found);
+	std::vector<std::pair<double, size_t> > sorted;
+	for (std::vector<size_t>::iterator it = found.begin(); it != found.end(); ++it)
 	{
-		if (it->name == name)
-		{
-			poi_metric = utm_conv.toMetric(LatLon(it->lat, it->lon));
-			dist_metric = sqrt(pow((cur_metric.x - poi_metric.x), 2) + pow((cur_metric.y - poi_metric.y), 2));
-			lookup_pois_dist.insert(std::make_pair(dist_metric, *it));
-		}
+		sorted.push_back(std::make_pair(index.pois.getDistance(cur_metric, *it), *it));
 	}
+	std::sort(sorted.begin(), sorted.end());
 
-	for (std::map<double, POI>::iterator it = lookup_pois_dist.begin(); it != lookup_pois_dist.end(); ++it)
+	for (std::vector<std::pair<double, size_t> >::iterator it = sorted.begin(); it != sorted.end(); ++it)
 	{
-		poi_vec.push_back(it->second);
+		poi_vec.push_back(m_map->pois[it->second]);
 	}
 
 	return poi_vec;
@@ -1252,22 +1622,24 @@ std::vector<POI> MapManager::getPOI(const std::string poi_name)
 {
 	std::wstring name;
 	utf8to16(poi_name.c_str(), name);
-	auto found = lookup_pois_name.find(name);
-	if (found == lookup_pois_name.end()) 
+	std::vector<size_t> found;
+	if (m_poi_catalog.findPOIs(name, found) == 0)
 		return std::vector<POI>();
+	const POI& poi = m_poi_catalog.pois[found.front()];
 
-	return getPOI(poi_name, found->second, 10.0);
+	return getPOI(poi_name, LatLon(poi.lat, poi.lon), 10.0);
 }
 
 std::vector<POI> MapManager::getPOI_sorting(const std::string poi_name, LatLon cur_latlon)
 {
 	std::wstring name;
 	utf8to16(poi_name.c_str(), name);
-	auto found = lookup_pois_name.find(name);
-	if (found == lookup_pois_name.end())
+	std::vector<size_t> found;
+	if (m_poi_catalog.findPOIs(name, found) == 0)
 		return std::vector<POI>();
+	const POI& poi = m_poi_catalog.pois[found.front()];
 
-	return getPOI_sorting(poi_name, found->second, 10.0, cur_latlon);
+	return getPOI_sorting(poi_name, LatLon(poi.lat, poi.lon), 10.0, cur_latlon);
 }
 
 bool MapManager::downloadStreetView(double lat, double lon, double radius)
@@ -1305,6 +1677,9 @@ bool MapManager::downloadStreetView_sv(ID sv_id, double radius)
 
 bool MapManager::parseStreetView(const char* json)
 {
+	m_map_index.clear();
+	m_path_finder.clear();
+	m_map_snapshot.clear();
 	Document document;
 	document.Parse(json);
 
@@ -1320,15 +1695,7 @@ bool MapManager::parseStreetView(const char* json)
 		const Value& properties = feature["properties"];
 		if (!properties.IsObject()) return false;
 		StreetView sv;
-		std::string id_str = properties["id"].GetString();
-		sv.id = std::strtoull(id_str.c_str(), nullptr, 0);
-		std::string name = properties["name"].GetString();
-		if (!(name == "streetview" || name == "StreetView")) return false;
-		sv.floor = properties["floor"].GetInt();
-		sv.date = properties["date"].GetString();
-		sv.heading = properties["heading"].GetDouble();
-		sv.lat = properties["latitude"].GetDouble();
-		sv.lon = properties["longitude"].GetDouble();
+		if (!parseStreetView(properties, sv)) return false;
 
 		m_map->addView(sv);
 	}
@@ -1336,6 +1703,22 @@ bool MapManager::parseStreetView(const char* json)
 	return true;
 }
 
+bool MapManager::parseStreetView(const Value& properties, StreetView& sv)
+{
+	if (!properties.IsObject() || !properties.HasMember("id")) return false;
+	std::string id_str = properties["id"].GetString();
+	sv.id = std::strtoull(id_str.c_str(), nullptr, 0);
+	std::string name = properties["name"].GetString();
+	if (!(name == "streetview" || name == "StreetView")) return false;
+	sv.floor = properties["floor"].GetInt();
+	sv.date = properties["date"].GetString();
+	sv.heading = properties["heading"].GetDouble();
+	sv.lat = properties["latitude"].GetDouble();
+	sv.lon = properties["longitude"].GetDouble();
+
+	return true;
+}
+
 std::vector<StreetView> MapManager::getStreetView()
 {
 	return m_map->views;
@@ -1343,7 +1726,7 @@ std::vector<StreetView> MapManager::getStreetView()
 
 bool MapManager::getStreetView(double lat, double lon, double radius, std::vector<StreetView>& sv_vec)
 {
-	m_map->views.clear();
+	m_map->clearViews();
 	m_json = "";
 
 	// by communication
@@ -1356,7 +1739,7 @@ bool MapManager::getStreetView(double lat, double lon, double radius, std::vecto
 	bool ok = parseStreetView(json);
 	if (!ok)
 	{
-		m_map->views.clear();
+		m_map->clearViews();
 
 		return false;
 	}
@@ -1368,7 +1751,7 @@ bool MapManager::getStreetView(double lat, double lon, double radius, std::vecto
 
 bool MapManager::getStreetView(ID node_id, double radius, std::vector<StreetView>& sv_vec)
 {
-	m_map->views.clear();
+	m_map->clearViews();
 	m_json = "";
 
 	// by communication
@@ -1381,7 +1764,7 @@ bool MapManager::getStreetView(ID node_id, double radius, std::vector<StreetView
 	bool ok = parseStreetView(json);
 	if (!ok)
 	{
-		m_map->views.clear();
+		m_map->clearViews();
 
 		return false;
 	}
@@ -1393,7 +1776,7 @@ bool MapManager::getStreetView(ID node_id, double radius, std::vector<StreetView
 
 bool MapManager::getStreetView(cv::Point2i tile, std::vector<StreetView>& sv_vec)
 {
-	m_map->views.clear();
+	m_map->clearViews();
 	m_json = "";
 
 	// by communication
@@ -1406,7 +1789,7 @@ bool MapManager::getStreetView(cv::Point2i tile, std::vector<StreetView>& sv_vec
 	bool ok = parseStreetView(json);
 	if (!ok)
 	{
-		m_map->views.clear();
+		m_map->clearViews();
 
 		return false;
 	}
@@ -1444,7 +1827,7 @@ bool MapManager::getStreetView(cv::Point2i tile, std::vector<StreetView>& sv_vec
 //}
 std::vector<StreetView> MapManager::getStreetView(ID sv_id, double radius)
 {
-	m_map->views.clear();
+	m_map->clearViews();
 	m_json = "";
 
 	// by communication
@@ -1457,7 +1840,7 @@ std::vector<StreetView> MapManager::getStreetView(ID sv_id, double radius)
 	bool ok = parseStreetView(json);
 	if (!ok)
 	{
-		m_map->views.clear();
+		m_map->clearViews();
 
 		return std::vector<StreetView>();
 	}
@@ -1480,7 +1863,7 @@ cv::Mat MapManager::queryImage2server(std::string url, int timeout)
 #endif
 
 	std::vector<uchar> stream;
-	curl_global_init(CURL_GLOBAL_ALL);
+	if (!initCurl()) return cv::Mat();
 	CURL* curl = curl_easy_init();
 	CURLcode res;
 
@@ -1496,7 +1879,6 @@ cv::Mat MapManager::queryImage2server(std::string url, int timeout)
 
 		// Always cleanup.
 		curl_easy_cleanup(curl);
-		curl_global_cleanup();
 
 		// Check for errors.
 		if (res == CURLE_OK && !stream.empty())
@@ -2,6 +2,8 @@
 #define __SIMPLE_MAP_MANAGER__
 
 #include "dg_core.hpp"
+#include "core/map_file.hpp"
+#include "core/arena.hpp"
 
 // rapidjson header files
 #include "rapidjson/document.h" 
@@ -52,6 +54,8 @@ public:
 		m_isMap = false;
 		m_ip = "localhost";
 		m_portErr = false;
+		m_offline = false;
+		initCurl();
 	}
 
 	/**
@@ -85,6 +89,20 @@ public:
 	 */
 	std::string getIP();
 
+	/**
+	 * Enable or disable the offline mode<br>
+	 * In the offline mode, paths are found on the current topological map without the routing server.
+	 * @param offline True to enable the offline mode
+	 * @return True if successful (false if failed)
+	 */
+	bool setOffline(bool offline);
+
+	/**
+	 * Check whether the offline mode is enabled or not
+	 * @return True if the offline mode is enabled (false if not)
+	 */
+	bool isOffline();
+
 	/**
 	 * Get the topological map within a certain radius based on latitude and longitude
 	 * @param lat The given latitude of this topological map (Unit: [deg])
@@ -112,6 +130,15 @@ public:
 	 */
 	bool getMap(cv::Point2i tile, Map& map);
 
+	/**
+	 * Load the topological map within a certain map tile without changing the current map (e.g. a tile loader of a localizer on its worker thread)
+	 * @param tile The given map tile of this topological map
+	 * @param map A reference to loaded topological map
+	 * @return True if successful (false if failed)
+	 * @see BaseLocalizer::setMapTileLoader
+	 */
+	bool loadMapTile(cv::Point2i tile, Map& map) const;
+
 	/**
 	 * Get the minimal topological map with a path
 	 * @param path The given path of this topological map
@@ -130,6 +157,35 @@ public:
 	 */
 	bool getMap_expansion(Path path, Map& map, double alpha = 50.0);
 
+	/**
+	 * Read the topological map from the given binary map file (*.dgmap)<br>
+	 * The overlay of its contraction hierarchy (*.dgch) is also read if it exists and matches with the map.
+	 * @param filename The filename to read a map
+	 * @param map A reference to gotten topological map
+	 * @return True if successful (false if failed)
+	 * @see MapFile
+	 */
+	bool getMap(const char* filename, Map& map);
+
+	/**
+	 * Write the current topological map to the given binary map file (*.dgmap)<br>
+	 * The overlay of its contraction hierarchy is also written alongside the map file (*.dgch), so it is built if not built yet.
+	 * @param filename The filename to write the map
+	 * @return True if successful (false if failed)
+	 * @see MapFile
+	 */
+	bool saveMap(const char* filename);
+
+	/**
+	 * Update the current topological map with its changes from the server (only changes are downloaded and applied)
+	 * @param lat The given latitude of this topological map (Unit: [deg])
+	 * @param lon The given longitude of this topological map (Unit: [deg])
+	 * @param radius The given radius of this topological map (Unit: [m])
+	 * @return True if successful (false if failed; the whole map should be downloaded again by getMap())
+	 * @see MapPatch
+	 */
+	bool updateMap(double lat, double lon, double radius);
+
 	/**
 	 * Get the junction nodes in the current topological map
 	 * @param cur_latlon The given latitude and longitude of current location (Unit: [deg])
@@ -139,10 +195,40 @@ public:
 	std::vector<Node> getMap_junction(LatLon cur_latlon, int top_n = 1);
 
 	/**
-	 * Get the current topological map
-	 * @return A reference to gotten topological map
+	 * Get spatial indices of the current topological map in UTM (built again only if the map is changed)
+	 * @return A reference to spatial indices of nodes, edges, POIs and StreetViews
+	 */
+	const MapSpatialIndex& getMapIndex();
+
+	/**
+	 * Get the current topological map for reading<br>
+	 * It does not change the revision of the map, so derived data (e.g. snapshots and path finders) are kept.
+	 * @return A read-only reference to the current topological map
 	 */
-	Map& getMap();
+	const Map& getMap() const;
+
+	/**
+	 * Get the current topological map for modification<br>
+	 * The map is marked as modified when this is called. Member functions of dg::Map also mark it by themselves,
+	 * but call Map::touch() after modifying elements directly through the returned reference afterwards.
+	 * @return A reference to the current topological map
+	 */
+	Map& editMap();
+
+	/**
+	 * Get a shared snapshot of the current topological map (copied only once after the map is changed)<br>
+	 * The snapshot is also published to getSharedMap().
+	 * @return The snapshot of the current map (`nullptr` if no map)
+	 * @see Map::getRevision
+	 */
+	MapSnapshot getMapSnapshot();
+
+	/**
+	 * Get the latest published snapshot of the current topological map<br>
+	 * It is thread-safe, so other threads can read the snapshot without locking this map manager.
+	 * @return A reference to the holder of the latest snapshot
+	 */
+	const SharedMap& getSharedMap() const;
 
 	/**
 	 * Get the path from the origin to the destination
@@ -151,11 +237,40 @@ public:
 	 * @param dest_lat The given destination latitude of this path (Unit: [deg])
 	 * @param dest_lon The given destination longitude of this path (Unit: [deg])
 	 * @param path A reference to gotten path
-	 * @param num_paths The number of paths requested (default: 2)
+	 * @param num_paths The number of paths requested from the routing server (default: 2, ignored in the offline mode)
 	 * @return True if successful (false if failed)
+	 * @see findPath in the offline mode, and findPaths to get alternative paths without the routing server
 	 */
 	bool getPath(double start_lat, double start_lon, double dest_lat, double dest_lon, Path& path, int num_paths = 2);
 
+	/**
+	 * Find the shortest path from the origin to the destination on the current topological map without the routing server<br>
+	 * The nearest nodes of the origin and destination are connected by the contraction hierarchy if it is loaded with the map (A* algorithm if not).
+	 * @param start_lat The given origin latitude of this path (Unit: [deg])
+	 * @param start_lon The given origin longitude of this path (Unit: [deg])
+	 * @param dest_lat The given destination latitude of this path (Unit: [deg])
+	 * @param dest_lon The given destination longitude of this path (Unit: [deg])
+	 * @param path A reference to found path
+	 * @return True if successful (false if failed)
+	 * @see ContractionHierarchy, PathFinder
+	 */
+	bool findPath(double start_lat, double start_lon, double dest_lat, double dest_lon, Path& path);
+
+	/**
+	 * Find the k shortest paths from the origin to the destination on the current topological map without the routing server<br>
+	 * The shortest one becomes the current path, and the others are alternative routes.
+	 * @param start_lat The given origin latitude of this path (Unit: [deg])
+	 * @param start_lon The given origin longitude of this path (Unit: [deg])
+	 * @param dest_lat The given destination latitude of this path (Unit: [deg])
+	 * @param dest_lon The given destination longitude of this path (Unit: [deg])
+	 * @param paths A reference to found paths in ascending order of their cost
+	 * @param num_paths The number of paths requested (default: 2)
+	 * @param max_overlap The maximum ratio of edges shared with each shorter path (default: 1, no constraint)
+	 * @return True if successful (false if failed)
+	 * @see PathFinder::findPaths
+	 */
+	bool findPaths(double start_lat, double start_lon, double dest_lat, double dest_lon, std::vector<Path>& paths, int num_paths = 2, double max_overlap = 1);
+
 	/**
 	 * Get the path(auto expansion topological map) from the origin to the destination
 	 * @param start_lat The given origin latitude of this path (Unit: [deg])
@@ -182,6 +297,12 @@ public:
 	 */
 	Path getPath();
 
+	/**
+	 * Set the given path found without the routing server (e.g. re-planned locally) as the current path
+	 * @param path The given path
+	 */
+	void setPath(const Path& path);
+
 	/**
 	 * Get the POIs within a certain radius based on latitude and longitude
 	 * @param lat The given latitude of these POIs (Unit: [deg])
@@ -332,8 +453,20 @@ protected:
 	std::string m_json;
 	/** A hash table for finding Path points */
 	std::map<ID, LatLon> lookup_path;
-	/** A hash table for finding POIs by name */
-	std::map<std::wstring, LatLon> lookup_pois_name;
+	/** All POIs for finding their locations by name */
+	Map m_poi_catalog;
+	/** Spatial indices of the current topological map */
+	MapSpatialIndex m_map_index;
+	/** A local path finder on the current topological map */
+	PathFinder m_path_finder;
+	/** A contraction hierarchy of the current topological map (loaded or saved with its map file) */
+	ContractionHierarchy m_hierarchy;
+	/** A flag to find paths without the routing server */
+	bool m_offline;
+	/** The latest shared snapshot of the current topological map */
+	SharedMap m_map_snapshot;
+	/** A memory arena for temporary data during parsing a map (reused for each parsing) */
+	MonotonicArena m_parse_arena;
 	///** A hash table for finding POIs by ID */
 	//std::map<ID, LatLon> lookup_pois_id;
 	///** A hash table for finding StreetViews */
@@ -355,6 +488,13 @@ protected:
 	 * @return The size of total data
 	 */
 	static size_t write_callback(void* ptr, size_t size, size_t count, void* stream);
+
+	/**
+	 * Initialize libcurl once for the whole process, which is cleaned up at the exit of the process<br>
+	 * curl_global_init() is not thread-safe, so it is called by the constructor before requests from other threads (e.g. tile loaders).
+	 * @return True if successful (false if failed)
+	 */
+	static bool initCurl();
 		
 	/**
 	 * Request to server and receive response
@@ -362,6 +502,14 @@ protected:
 	 * @return True if successful (false if failed)
 	 */
 	bool query2server(std::string url);
+
+	/**
+	 * Request to server and receive response without changing this manager
+	 * @param url A web address to request to the server
+	 * @param response A reference to the received response
+	 * @return True if successful (false if failed)
+	 */
+	static bool query2server(const std::string& url, std::string& response);
 	/*std::string to_utf8(uint32_t cp);
 	bool decodeUni();*/
 	
@@ -397,6 +545,13 @@ protected:
 	 */
 	bool downloadMap(cv::Point2i tile);
 
+	/**
+	 * Get a web address to request the topological map within a certain map tile
+	 * @param tile The given map tile of this topological map
+	 * @return The web address
+	 */
+	std::string getMapTileURL(cv::Point2i tile) const;
+
 	/**
 	 * Parse the topological map response received
 	 * @param json A response received
@@ -404,6 +559,88 @@ protected:
 	 */
 	bool parseMap(const char* json);
 
+	/**
+	 * Parse the topological map response received into the given map
+	 * @param json A response received
+	 * @param map A reference to the parsed topological map (added to its current data)
+	 * @param arena The arena to keep temporary data while parsing
+	 * @return True if successful (false if failed)
+	 */
+	static bool parseMap(const char* json, Map& map, MonotonicArena& arena);
+
+	/**
+	 * Request changes of the topological map from the given version to server and receive response
+	 * @param version The version of the current topological map
+	 * @param lat The given latitude of this topological map (Unit: [deg])
+	 * @param lon The given longitude of this topological map (Unit: [deg])
+	 * @param radius The given radius of this topological map (Unit: [m])
+	 * @return True if successful (false if failed)
+	 */
+	bool downloadMapPatch(uint64_t version, double lat, double lon, double radius);
+
+	/**
+	 * Parse the map patch response received<br>
+	 * The response contains 'base_version', 'version', and 'nodes', 'edges', 'pois', and 'streetviews'
+	 * which have 'added' and 'modified' features (same with the map, POI, and StreetView responses) and 'removed' IDs.
+	 * Each edge feature also has 'node_ids' with its two nodes.
+	 * @param json A response received
+	 * @param patch A reference to the parsed patch
+	 * @return True if successful (false if failed)
+	 */
+	bool parseMapPatch(const char* json, MapPatch& patch);
+
+	/**
+	 * Apply changes of POIs in the given patch to the POI catalog<br>
+	 * The catalog covers a wider region than the map, so modified POIs not in the catalog are added and removed POIs not in the catalog are ignored.
+	 * @param patch The given patch
+	 * @return True if successful (false if failed)
+	 */
+	bool updatePOICatalog(const MapPatch& patch);
+
+	/**
+	 * Find the nearest nodes of the origin and destination on the current topological map
+	 * @param start_lat The given origin latitude (Unit: [deg])
+	 * @param start_lon The given origin longitude (Unit: [deg])
+	 * @param dest_lat The given destination latitude (Unit: [deg])
+	 * @param dest_lon The given destination longitude (Unit: [deg])
+	 * @param start_id ID of the nearest node of the origin (return value)
+	 * @param dest_id ID of the nearest node of the destination (return value)
+	 * @return True if successful (false if the map is empty)
+	 */
+	bool findEndNodes(double start_lat, double start_lon, double dest_lat, double dest_lon, ID& start_id, ID& dest_id);
+
+	/**
+	 * Parse properties of a node feature
+	 * @param properties The properties of the feature
+	 * @param node A reference to the parsed node
+	 * @return True if successful (false if failed)
+	 */
+	static bool parseNode(const Value& properties, Node& node);
+
+	/**
+	 * Parse properties of an edge feature
+	 * @param properties The properties of the feature
+	 * @param edge A reference to the parsed edge
+	 * @return True if successful (false if failed)
+	 */
+	static bool parseEdge(const Value& properties, Edge& edge);
+
+	/**
+	 * Parse properties of a POI feature
+	 * @param properties The properties of the feature
+	 * @param poi A reference to the parsed POI
+	 * @return True if successful (false if failed)
+	 */
+	bool parsePOI(const Value& properties, POI& poi);
+
+	/**
+	 * Parse properties of a StreetView feature
+	 * @param properties The properties of the feature
+	 * @param sv A reference to the parsed StreetView
+	 * @return True if successful (false if failed)
+	 */
+	bool parseStreetView(const Value& properties, StreetView& sv);
+
 	/**
 	 * Request the path from the origin to the destination to server and receive response
 	 * @param start_lat The given origin latitude of this path (Unit: [deg])
@@ -557,13 +794,6 @@ private:
 	bool m_portErr;
 };
 
-class EdgeTemp : public Edge
-{
-public:
-	//ID id;
-	std::vector<ID> node_ids;
-};
-
 } // End of 'dg'
 
 #endif // End of '__SIMPLE_MAP_MANAGER__'
@@ -16,6 +16,9 @@
 #define __EKF__
 
 #include "opencv2/opencv.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 namespace cx
 {
@@ -202,6 +205,291 @@ namespace cx
         cv::Mat m_state_cov;
     }; // End of 'EKF'
 
+    /**
+     * Solve a linear system, A X = B, with a symmetric positive semi-definite matrix A using Cholesky decomposition<br>
+     * A zero pivot (e.g. a row and column of A which are all zero) gives zero in the solution as its pseudo-inverse does.
+     * @param A The given symmetric positive semi-definite matrix
+     * @param B The right-hand side, which is overwritten by the solution X
+     * @return True if successful (false if A is not positive semi-definite)
+     */
+    template<int M, int K>
+    bool solveCholesky(const cv::Matx<double, M, M>& A, cv::Matx<double, M, K>& B)
+    {
+        double tol = 0;
+        for (int i = 0; i < M; i++) tol = std::max(tol, std::fabs(A(i, i)));
+        tol *= M * DBL_EPSILON;
+
+        // Decompose A = L L^T
+        cv::Matx<double, M, M> L = cv::Matx<double, M, M>::zeros();
+        for (int j = 0; j < M; j++)
+        {
+            double d = A(j, j);
+            for (int k = 0; k < j; k++) d -= L(j, k) * L(j, k);
+            if (d < -tol) return false;
+            if (d <= tol) continue;
+            L(j, j) = std::sqrt(d);
+            for (int i = j + 1; i < M; i++)
+            {
+                double s = A(i, j);
+                for (int k = 0; k < j; k++) s -= L(i, k) * L(j, k);
+                L(i, j) = s / L(j, j);
+            }
+        }
+
+        // Solve L Y = B and L^T X = Y
+        for (int c = 0; c < K; c++)
+        {
+            for (int i = 0; i < M; i++)
+            {
+                if (L(i, i) == 0) { B(i, c) = 0; continue; }
+                double s = B(i, c);
+                for (int k = 0; k < i; k++) s -= L(i, k) * B(k, c);
+                B(i, c) = s / L(i, i);
+            }
+            for (int i = M - 1; i >= 0; i--)
+            {
+                if (L(i, i) == 0) { B(i, c) = 0; continue; }
+                double s = B(i, c);
+                for (int k = i + 1; k < M; k++) s -= L(k, i) * B(k, c);
+                B(i, c) = s / L(i, i);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Extended Kalman Filter (EKF) with fixed-size matrices
+     *
+     * This is the same EKF with cx::EKF, but its dimensions are given at compile time, so it keeps all matrices as cv::Matx and does not allocate memory during predict and correct.
+     * Its Kalman gain is calculated by Cholesky decomposition instead of explicit inversion.
+     * Control inputs and measurements whose dimensions vary (e.g. different sensors) are kept in vectors of their maximum dimension with their actual dimensions.
+     * Rows of a measurement beyond its actual dimension are ignored.
+     *
+     * @tparam N The dimension of the state variable
+     * @tparam U The maximum dimension of control inputs
+     * @tparam Z The maximum dimension of measurements
+     * @see EKF
+     */
+    template<int N, int U, int Z>
+    class FixedEKF
+    {
+    public:
+        /** The type of the state variable */
+        typedef cv::Matx<double, N, 1> StateVec;
+
+        /** The type of the state covariance and the transition Jacobian */
+        typedef cv::Matx<double, N, N> StateCov;
+
+        /** The type of control inputs */
+        typedef cv::Matx<double, U, 1> ControlVec;
+
+        /** The type of measurements */
+        typedef cv::Matx<double, Z, 1> MeasureVec;
+
+        /** The type of the observation Jacobian */
+        typedef cv::Matx<double, Z, N> MeasureJac;
+
+        /** The type of the observation noise */
+        typedef cv::Matx<double, Z, Z> MeasureCov;
+
+        /**
+         * The virtual destructor
+         */
+        virtual ~FixedEKF() { }
+
+        /**
+         * Initialize the state variable and covariance with the given values
+         * @param state_vec The given state variable (N x 1 or 1 x N)
+         * @param state_cov The given state covariance (N x N; identity if empty)
+         * @return True if successful (false if failed)
+         */
+        virtual bool initialize(cv::InputArray state_vec, cv::InputArray state_cov = cv::noArray())
+        {
+            cv::Mat x = state_vec.getMat();
+            if (x.rows < x.cols) x = x.t();
+            if (x.rows != N || x.cols != 1) return false;
+            StateCov P = StateCov::eye();
+            if (!state_cov.empty())
+            {
+                cv::Mat cov = state_cov.getMat();
+                if (cov.rows != N || cov.cols != N) return false;
+                P = cov;
+            }
+            m_state_vec = x;
+            m_state_cov = P;
+            return true;
+        }
+
+        /**
+         * Predict the state variable and covariance from the given control input (time complexity: O(N^3))
+         * @param control The given control input
+         * @param control_dim The actual dimension of the control input
+         * @return True if successful (false if failed)
+         */
+        bool predict(const ControlVec& control, int control_dim = U)
+        {
+            if (control_dim <= 0 || control_dim > U) return false;
+
+            // Predict the state
+            StateCov F = StateCov::eye(), Q = StateCov::zeros();
+            m_state_vec = transitFunc(m_state_vec, control, control_dim, F, Q);
+            m_state_cov = F * m_state_cov * F.t() + Q;
+
+            // Enforce the state covariance symmetric
+            m_state_cov = 0.5 * (m_state_cov + m_state_cov.t());
+            return true;
+        }
+
+        /**
+         * Correct the state variable and covariance with the given measurement (time complexity: O(N^3 + Z^3))
+         * @param measure The given measurement
+         * @param measure_dim The actual dimension of the measurement
+         * @return True if successful (false if failed)
+         */
+        bool correct(const MeasureVec& measure, int measure_dim = Z)
+        {
+            MeasureVec innovation;
+            MeasureJac H;
+            MeasureCov R;
+            if (!calcInnovation(measure, measure_dim, innovation, H, R)) return false;
+            return correctInnovation(innovation, H, R);
+        }
+
+        /**
+         * Calculate squared <a href="https://en.wikipedia.org/wiki/Mahalanobis_distance">Mahalanobis distance</a> of the given measurement with its innovation covariance
+         * @param measure The given measurement
+         * @param measure_dim The actual dimension of the measurement
+         * @return The squared Mahalanobis distance (negative if failed)
+         */
+        double checkMeasurement(const MeasureVec& measure, int measure_dim = Z)
+        {
+            MeasureVec innovation;
+            MeasureJac H;
+            MeasureCov R;
+            if (!calcInnovation(measure, measure_dim, innovation, H, R)) return -1;
+            MeasureCov S = H * m_state_cov * H.t() + R;
+            MeasureVec x = innovation;
+            if (!solveCholesky(S, x)) return -1;
+            return innovation.dot(x);
+        }
+
+        /**
+         * Assign the state variable with the given value
+         * @param state The given state variable
+         * @return True if successful (false if failed)
+         */
+        bool setState(const StateVec& state)
+        {
+            m_state_vec = state;
+            return true;
+        }
+
+        /**
+         * Get the current state variable
+         * @return The state variable
+         */
+        const cv::Mat getState() const { return cv::Mat(m_state_vec); }
+
+        /**
+         * Assign the state covariance with the given value
+         * @param covariance The given state covariance
+         * @return True if successful (false if failed)
+         */
+        bool setStateCov(const StateCov& covariance)
+        {
+            m_state_cov = covariance;
+            return true;
+        }
+
+        /**
+         * Get the current state covariance
+         * @return The state covariance
+         */
+        const cv::Mat getStateCov() const { return cv::Mat(m_state_cov); }
+
+    protected:
+        /**
+         * The state transition function, its Jacobian, and noise
+         * @param state The state variable
+         * @param control The given control input
+         * @param control_dim The actual dimension of the control input
+         * @param jacobian The state transition function's Jacobian (return value; identity by default)
+         * @param noise The state transition noise (return value; zero by default)
+         * @return The predicted state variable
+         */
+        virtual StateVec transitFunc(const StateVec& state, const ControlVec& control, int control_dim, StateCov& jacobian, StateCov& noise) = 0;
+
+        /**
+         * The state observation function, its Jacobian, and noise
+         * @param state The state variable
+         * @param measure The given measurement
+         * @param measure_dim The actual dimension of the measurement
+         * @param jacobian The state observation function's Jacobian (return value; zero by default)
+         * @param noise The state observation noise (return value; zero by default)
+         * @return The expected measurement
+         */
+        virtual MeasureVec observeFunc(const StateVec& state, const MeasureVec& measure, int measure_dim, MeasureJac& jacobian, MeasureCov& noise) = 0;
+
+        /**
+         * Correct the state variable and covariance with the given innovation, observation Jacobian, and noise (time complexity: O(N^3 + M^3))<br>
+         * Multiple measurements can be applied at once by stacking their innovations and Jacobians with their block-diagonal noise.
+         * Rows whose Jacobian and noise are all zero are ignored.
+         * @param innovation The innovation, the difference between measurements and their expectation
+         * @param H The observation Jacobian
+         * @param R The observation noise
+         * @return True if successful (false if failed)
+         */
+        template<int M>
+        bool correctInnovation(const cv::Matx<double, M, 1>& innovation, const cv::Matx<double, M, N>& H, const cv::Matx<double, M, M>& R)
+        {
+            // Calculate Kalman gain, K = P H^T S^-1, by solving S K^T = H P
+            cv::Matx<double, M, N> Kt = H * m_state_cov;
+            cv::Matx<double, M, M> S = Kt * H.t() + R;
+            if (!solveCholesky(S, Kt)) return false;
+            cv::Matx<double, N, M> K = Kt.t();
+
+            // Correct the state
+            m_state_vec = m_state_vec + K * innovation;
+            StateCov I_KH = StateCov::eye() - K * H;
+            m_state_cov = I_KH * m_state_cov * I_KH.t() + K * R * Kt; // Joseph form
+
+            // Enforce the state covariance symmetric
+            m_state_cov = 0.5 * (m_state_cov + m_state_cov.t());
+            return true;
+        }
+
+        /**
+         * Calculate the innovation of the given measurement and its observation Jacobian and noise<br>
+         * Rows beyond the actual dimension are cleared not to affect the state.
+         * @param measure The given measurement
+         * @param measure_dim The actual dimension of the measurement
+         * @param innovation The innovation (output)
+         * @param jacobian The observation Jacobian (output)
+         * @param noise The observation noise (output)
+         * @return True if successful (false if failed)
+         */
+        bool calcInnovation(const MeasureVec& measure, int measure_dim, MeasureVec& innovation, MeasureJac& jacobian, MeasureCov& noise)
+        {
+            if (measure_dim <= 0 || measure_dim > Z) return false;
+            jacobian = MeasureJac::zeros();
+            noise = MeasureCov::zeros();
+            innovation = measure - observeFunc(m_state_vec, measure, measure_dim, jacobian, noise);
+            for (int i = measure_dim; i < Z; i++)
+            {
+                innovation(i) = 0;
+                for (int j = 0; j < N; j++) jacobian(i, j) = 0;
+                for (int j = 0; j < Z; j++) noise(i, j) = noise(j, i) = 0;
+            }
+            return true;
+        }
+
+        /** The state variable */
+        StateVec m_state_vec;
+
+        /** The state covariance */
+        StateCov m_state_cov;
+    }; // End of 'FixedEKF'
+
 } // End of 'cx'
 
 #endif // End of '__EKF__'
@@ -139,7 +139,7 @@ public:
         return false;
     }
 
-    bool drawMap(cv::Mat& image, const MapCanvasInfo& info, dg::Map& map)
+    bool drawMap(cv::Mat& image, const MapCanvasInfo& info, const dg::Map& map)
     {
         drawGrid(image, info, m_grid_step, m_grid_color, m_grid_thickness, m_grid_unit_font_scale, m_grid_unit_color, m_grid_unit_pos);
         drawBox(image, info, m_box_color, m_box_thickness);
@@ -155,7 +155,7 @@ public:
         return false;
     }
 
-    bool drawMap(cv::Mat& image, dg::Map& map)
+    bool drawMap(cv::Mat& image, const dg::Map& map)
     {
         MapCanvasInfo info = getCanvasInfo(image);
         return drawMap(image, info, map);
@@ -276,13 +276,13 @@ public:
         return true;
     }
 
-    bool drawPath(cv::Mat& image, const MapCanvasInfo& info, dg::Map& map, const dg::Path& path, const cv::Vec3b& ecolor = cv::Vec3b(255, 0, 0), const cv::Vec3b& ncolor = cv::Vec3b(0, 255, 255), int nradius = 5, int ethickness = 2)
+    bool drawPath(cv::Mat& image, const MapCanvasInfo& info, const dg::Map& map, const dg::Path& path, const cv::Vec3b& ecolor = cv::Vec3b(255, 0, 0), const cv::Vec3b& ncolor = cv::Vec3b(0, 255, 255), int nradius = 5, int ethickness = 2)
     {
-        Node* node_prev = nullptr;
+        const Node* node_prev = nullptr;
         for (int idx = 0; idx < (int)path.pts.size(); idx++)
         {
             dg::ID node_id = path.pts[idx].node_id;
-            Node* node = map.findNode(node_id);
+            const Node* node = map.findNode(node_id);
             if (node) {
                 if (node_prev) drawEdge(image, info, node_prev, node, 0, ecolor, ethickness);
                 if (node_prev)
@@ -310,7 +310,7 @@ public:
         return true;
     }
 
-    bool drawNode(cv::Mat& image, const MapCanvasInfo& info, Node* node, double radius, double font_scale, const cv::Vec3b& color, int thickness = -1)
+    bool drawNode(cv::Mat& image, const MapCanvasInfo& info, const Node* node, double radius, double font_scale, const cv::Vec3b& color, int thickness = -1)
     {
         CV_DbgAssert(!image.empty());
 
@@ -326,7 +326,7 @@ public:
         return true;
     }
 
-    bool drawNodes(cv::Mat& image, const MapCanvasInfo& info, Map& map, double radius, double font_scale, const cv::Vec3b& color, int thickness = -1)
+    bool drawNodes(cv::Mat& image, const MapCanvasInfo& info, const Map& map, double radius, double font_scale, const cv::Vec3b& color, int thickness = -1)
     {
         CV_DbgAssert(!image.empty());
 
@@ -350,7 +350,7 @@ public:
         return true;
     }
 
-    bool drawEdge(cv::Mat& image, const MapCanvasInfo& info, Node* from, Node* to, double radius, const cv::Vec3b& color, int thickness = 1, double arrow_length = -1)
+    bool drawEdge(cv::Mat& image, const MapCanvasInfo& info, const Node* from, const Node* to, double radius, const cv::Vec3b& color, int thickness = 1, double arrow_length = -1)
     {
         CV_DbgAssert(!image.empty());
         if (thickness <= 0) return false;
@@ -381,7 +381,7 @@ public:
         return true;
     }
 
-    bool drawEdges(cv::Mat& image, const MapCanvasInfo& info, Map& map, double radius, const cv::Vec3b& color, int thickness = 1, double arrow_length = -1)
+    bool drawEdges(cv::Mat& image, const MapCanvasInfo& info, const Map& map, double radius, const cv::Vec3b& color, int thickness = 1, double arrow_length = -1)
     {
         CV_DbgAssert(!image.empty());
         if (thickness <= 0 ) return false;
@@ -390,8 +390,8 @@ public:
         const double a = arrow_length * info.ppm;
         for (size_t i=0; i<map.edges.size(); i++)
         {
-            Node* node1 = map.findNode(map.edges[i].node_id1);
-            Node* node2 = map.findNode(map.edges[i].node_id2);
+            const Node* node1 = map.findNode(map.edges[i].node_id1);
+            const Node* node2 = map.findNode(map.edges[i].node_id2);
             if (node1 == nullptr || node2 == nullptr) continue;
 
             // Draw an edge